@@ -3,6 +3,8 @@
  * IT WILL BE REPLACED DURING GRADING
  */
 
+#include <setjmp.h>
+
 #include "syntax.h"
 
 /* Names of special store variables to hold results from job execution. */
@@ -10,6 +12,44 @@
 #define STATUS_VAR "STATUS"
 #define OUTPUT_VAR "OUTPUT"
 
+/* Name of the store variable that holds the number of an input row. */
+#define ROW_VAR "ROW"
+
+/*
+ * Names of store variables that control the caching of the results of
+ * pipelines run with "cached": the number of seconds for which a result
+ * may be replayed, the total number of bytes of results kept, and the
+ * names of environment variables whose values are part of the cache key.
+ */
+#define CACHE_TTL_VAR "CACHE_TTL"
+#define CACHE_SIZE_VAR "CACHE_SIZE"
+#define CACHE_ENV_VAR "CACHE_ENV"
+
+/*
+ * Names of store variables that control the compression of large values
+ * that have not been used recently: the length above which a value may be
+ * compressed (compression is off unless this is set), and the number of
+ * statements after which a value that has not been used counts as cold.
+ */
+#define COMPRESS_MIN_VAR "COMPRESS_MIN"
+#define COMPRESS_AGE_VAR "COMPRESS_AGE"
+
+/*
+ * Name of the store variable that gives the largest number of independent
+ * foreground pipelines, on consecutive lines of a program, that may be run
+ * at the same time (they are run one at a time unless this is set above 1).
+ * Only one pipeline of a group may read the standard input of mush, and
+ * the standard error output of a group's pipelines may be interleaved.
+ */
+#define FG_PARALLEL_VAR "FG_PARALLEL"
+
+/*
+ * Name of the store variable that turns on the translation of numeric
+ * loops into machine code when a program is run: 1 to run the machine code,
+ * or 2 to run both it and the interpreter and report where they disagree.
+ */
+#define JIT_VAR "JIT"
+
 /*
  * If you find it convenient, you may assume that the maximum number of jobs
  * that can exist at one time is given by the following preprocessor symbol.
@@ -18,6 +58,26 @@
  */
 #define MAX_JOBS 10
 
+/*
+ * Position within a snapshot being read back.  Reading past "end", or
+ * finding data that makes no sense, sets "error", after which everything
+ * read is zero or NULL; the reader checks "error" once it is done.
+ */
+typedef struct snap {
+    char *pos;
+    char *end;
+    int error;
+} SNAP;
+
+/* Opaque position of the program counter, as saved by prog_tell(). */
+typedef struct prog_line *PROG_POS;
+
+/* Opaque reference to a variable of the data store, as made by store_ref(). */
+typedef struct var_node *STORE_REF;
+
+/* Handle for an interpreter hosted by a program, as made by mush_open(). */
+typedef struct mush MUSH;
+
 /* Functions in program store module. */
 int prog_list(FILE *out);
 int prog_insert(STMT *stmt);
@@ -26,17 +86,143 @@ void prog_reset();
 STMT *prog_fetch();
 STMT *prog_next();
 STMT *prog_goto(int lineno);
+int prog_epoch(void);
+PROG_POS prog_tell(void);
+STMT *prog_seek(PROG_POS pos);
+int prog_save(FILE *f);
+int prog_restore(SNAP *snap);
+void prog_fini(void);
 
 /* Functions in data store module. */
 char *store_get_string(char *var);
 int store_get_int(char *var, long *valp);
 int store_set_string(char *var, char *val);
 int store_set_int(char *var, long val);
+STORE_REF store_ref(char *var);
+long store_generation(void);
+int store_ref_get_int(STORE_REF ref, long *valp);
+int store_ref_set_int(STORE_REF ref, long val);
+int store_set_buffer(char *var, char *val, size_t len);
+int store_set_owned(char *var, char *buf, size_t len);
+int store_append_string(char *var, char *val);
+int store_copy(char *var, char *src);
+long store_import(char *buf, size_t len, char *prefix);
+int store_array_clear(char *var);
+long store_array_split(char *var, char *str, char *delim, int numeric);
+int store_array_aggregate(char *var, long *countp, long *sump,
+                          long *minp, long *maxp);
+long store_array_length(char *var);
+char *store_array_get_string(char *var, long index);
+int store_array_get_int(char *var, long index, long *valp);
+int store_array_set_string(char *var, long index, char *val);
+int store_array_set_int(char *var, long index, long val);
+int store_array_pop(char *var);
+int store_array_sort(char *var, char *src, int numeric);
+long store_array_unique(char *var, char *src);
+long store_array_count(char *var, char *src);
+long store_map_size(char *var);
+char *store_map_get_string(char *var, char *key);
+int store_map_get_int(char *var, char *key, long *valp);
+int store_map_set_string(char *var, char *key, char *val);
+int store_map_set_int(char *var, char *key, long val);
+int store_map_delete(char *var, char *key);
+char *store_map_next_key(char *var, char *key);
+void store_sweep(void);
+int store_export(char *var);
+int store_exported(char *var);
+char **store_environ(void);
+int store_save(FILE *f);
+int store_restore(SNAP *snap);
 void store_show(FILE *f);
+void store_fini(void);
+
+/* Functions in compression module. */
+size_t lz_bound(size_t len);
+size_t lz_compress(char *src, size_t len, char *dst);
+int lz_decompress(char *src, size_t len, char *dst, size_t size);
+
+/* Functions in snapshot module. */
+void snap_put_num(FILE *f, long n);
+void snap_put_bytes(FILE *f, char *buf, size_t len);
+void snap_put_str(FILE *f, char *str);
+long snap_get_num(SNAP *snap);
+char *snap_get_bytes(SNAP *snap, size_t *lenp);
+char *snap_get_str(SNAP *snap);
+FILE *snap_create(char *file);
+int snap_finish(FILE *f, char *file);
+char *snap_open(char *file, SNAP *snap, size_t *sizep);
+void snap_close(char *map, size_t size);
+void save_stmt(FILE *f, STMT *stmt);
+STMT *load_stmt(SNAP *snap);
+void save_pipeline(FILE *f, PIPELINE *pline);
+PIPELINE *load_pipeline(SNAP *snap);
+
+/*
+ * Results of a program compiled by mushc, other than 1 and -1, which mean
+ * that it was stopped or failed, as they do for exec_stmt(): it ran off the
+ * end, it was told to quit, or it found that the program store does not
+ * hold the program it was compiled from, so the interpreter should go on.
+ */
+#define MUSHC_END 2
+#define MUSHC_QUIT 3
+#define MUSHC_INTERPRET 4
+
+/* Functions in compiler module. */
+int compile_script(char *script, FILE *out);
+int mushc_main(char *text, size_t len, int (*code)(void));
+int mushc_enter(long n, long *srcs, STMT **stmts);
+long mushc_step(long i, int *resultp);
+void mushc_seek(long i);
+int mushc_grouping(void);
+int mushc_load(char *name, long *valp, int *definedp);
+void mushc_store(char *name, long val, int defined);
+int mushc_undefined(char *name);
+
+/* A run of lines of a program translated into machine code. */
+typedef struct jit_region JIT_REGION;
+
+/* Functions in jit module. */
+JIT_REGION *jit_lookup(STMT *stmt, volatile int *quit);
+long jit_nslots(JIT_REGION *rp);
+char *jit_slot_name(JIT_REGION *rp, long k);
+int jit_slot_written(JIT_REGION *rp, long k);
+long *jit_slots(JIT_REGION *rp);
+long jit_run(JIT_REGION *rp);
+int jit_gave_up(long code);
+int jit_exit_line(JIT_REGION *rp, long code);
+int jit_contains(JIT_REGION *rp, STMT *stmt);
+int jit_resume(JIT_REGION *rp, long code);
+void jit_fini(void);
+
+/* Functions in parallel module. */
+int parallel_run(char *script, char *table, int nworkers, char *report);
+
+/* Functions in server module. */
+int server_run(char *path);
+int client_run(char *path, char *file);
+
+/* Functions in library module. */
+MUSH *mush_open(void);
+int mush_eval(MUSH *mush, char *script);
+char *mush_get(MUSH *mush, char *var);
+int mush_set(MUSH *mush, char *var, char *val);
+int mush_close(MUSH *mush);
 
 /* Functions in execution module. */
 int exec_interactive();
+int exec_script(STMT **stmts, long n);
+STMT **exec_parse(char *text, size_t len, int quiet, long *np);
+void exec_immediate(STMT *stmt);
+void exec_fini(void);
 int exec_stmt(STMT *stmt);
+int exec_step(STMT *stmt);
+int exec_native(int (*code)(void));
+int exec_quit(void);
+jmp_buf *exec_arm(void);
+int exec_numeric(EXPR *expr, long *valp);
+int exec_get_numeric(char *name, long *valp);
+void exec_set_numeric(char *name, long val);
+int exec_job(PIPELINE *pp, int *jobp);
 char *eval_to_string(EXPR *expr);
 long eval_to_numeric(EXPR *expr);
 
@@ -50,4 +236,8 @@ int jobs_poll(int jobid);
 int jobs_cancel(int jobid);
 int jobs_pause(void);
 char *jobs_get_output(int jobid);
+char *jobs_release_output(int jobid, size_t *lenp);
 int jobs_show(FILE *file);
+void jobs_show_cache(FILE *file);
+int jobs_save(FILE *f);
+int jobs_restore(SNAP *snap);
@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.5.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2020 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -31,8 +31,9 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
 
 #ifndef YY_YY_INCLUDE_MUSH_TAB_H_INCLUDED
 # define YY_YY_INCLUDE_MUSH_TAB_H_INCLUDED
@@ -44,72 +45,101 @@
 extern int yydebug;
 #endif
 
-/* Token type.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
   enum yytokentype
   {
-    NUMBER = 258,
-    NAME = 259,
-    WORD = 260,
-    STRING = 261,
-    LIST = 262,
-    DELETE = 263,
-    RUN = 264,
-    CONT = 265,
-    STOP = 266,
-    BG = 267,
-    CAPTURE = 268,
-    WAIT = 269,
-    POLL = 270,
-    CANCEL = 271,
-    PAUSE = 272,
-    SET = 273,
-    UNSET = 274,
-    IF = 275,
-    GOTO = 276,
-    SOURCE = 277,
-    EQ = 278,
-    PIPE = 279,
-    LESS = 280,
-    GREATER = 281,
-    EQUAL = 282,
-    LESSEQ = 283,
-    GREATEQ = 284,
-    AND = 285,
-    OR = 286,
-    NOT = 287,
-    LPAREN = 288,
-    RPAREN = 289,
-    PLUS = 290,
-    MINUS = 291,
-    TIMES = 292,
-    DIVIDE = 293,
-    MOD = 294,
-    COMMA = 295,
-    SHARP = 296,
-    DOLLAR = 297,
-    EOL = 298,
-    EoF = 299,
-    UNKNOWN = 300
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    NUMBER = 258,                  /* NUMBER  */
+    NAME = 259,                    /* NAME  */
+    WORD = 260,                    /* WORD  */
+    STRING = 261,                  /* STRING  */
+    FUNCTION = 262,                /* FUNCTION  */
+    LIST = 263,                    /* LIST  */
+    DELETE = 264,                  /* DELETE  */
+    RUN = 265,                     /* RUN  */
+    CONT = 266,                    /* CONT  */
+    STOP = 267,                    /* STOP  */
+    BG = 268,                      /* BG  */
+    CAPTURE = 269,                 /* CAPTURE  */
+    WAIT = 270,                    /* WAIT  */
+    POLL = 271,                    /* POLL  */
+    CANCEL = 272,                  /* CANCEL  */
+    PAUSE = 273,                   /* PAUSE  */
+    SET = 274,                     /* SET  */
+    UNSET = 275,                   /* UNSET  */
+    IF = 276,                      /* IF  */
+    GOTO = 277,                    /* GOTO  */
+    SOURCE = 278,                  /* SOURCE  */
+    FOR = 279,                     /* FOR  */
+    TO = 280,                      /* TO  */
+    STEP = 281,                    /* STEP  */
+    NEXT = 282,                    /* NEXT  */
+    APPEND = 283,                  /* APPEND  */
+    READ = 284,                    /* READ  */
+    WRITE = 285,                   /* WRITE  */
+    PUSH = 286,                    /* PUSH  */
+    POP = 287,                     /* POP  */
+    KEYS = 288,                    /* KEYS  */
+    SPLIT = 289,                   /* SPLIT  */
+    BY = 290,                      /* BY  */
+    CACHED = 291,                  /* CACHED  */
+    EXPORT = 292,                  /* EXPORT  */
+    IMPORT = 293,                  /* IMPORT  */
+    AS = 294,                      /* AS  */
+    SAVE = 295,                    /* SAVE  */
+    RESTORE = 296,                 /* RESTORE  */
+    EQ = 297,                      /* EQ  */
+    PIPE = 298,                    /* PIPE  */
+    LESS = 299,                    /* LESS  */
+    GREATER = 300,                 /* GREATER  */
+    EQUAL = 301,                   /* EQUAL  */
+    LESSEQ = 302,                  /* LESSEQ  */
+    GREATEQ = 303,                 /* GREATEQ  */
+    AND = 304,                     /* AND  */
+    OR = 305,                      /* OR  */
+    NOT = 306,                     /* NOT  */
+    LPAREN = 307,                  /* LPAREN  */
+    RPAREN = 308,                  /* RPAREN  */
+    PLUS = 309,                    /* PLUS  */
+    MINUS = 310,                   /* MINUS  */
+    TIMES = 311,                   /* TIMES  */
+    DIVIDE = 312,                  /* DIVIDE  */
+    MOD = 313,                     /* MOD  */
+    COMMA = 314,                   /* COMMA  */
+    SHARP = 315,                   /* SHARP  */
+    DOLLAR = 316,                  /* DOLLAR  */
+    EOL = 317,                     /* EOL  */
+    EoF = 318,                     /* EoF  */
+    UNKNOWN = 319,                 /* UNKNOWN  */
+    CONCAT = 320,                  /* CONCAT  */
+    LBRACKET = 321,                /* LBRACKET  */
+    RBRACKET = 322,                /* RBRACKET  */
+    CONTAINS = 323,                /* CONTAINS  */
+    MATCHES = 324                  /* MATCHES  */
   };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 30 "src/mush.y"
+#line 44 "src/mush.y"
 
     int number;
     char *string;
     STMT *stmt;
-    EXPR *expr;	
+    EXPR *expr;
     ARG *args;
     COMMAND *cmds;
     PIPELINE *pline;
 
-#line 113 "include/mush.tab.h"
+#line 143 "include/mush.tab.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -118,8 +148,9 @@ typedef union YYSTYPE YYSTYPE;
 #endif
 
 
-extern YYSTYPE yylval;
+
 
 int yyparse (void);
 
+
 #endif /* !YY_YY_INCLUDE_MUSH_TAB_H_INCLUDED  */
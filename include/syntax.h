@@ -27,18 +27,35 @@ typedef enum {
     GOTO_STMT_CLASS,            // "goto" statement (goto_stmt)
     SOURCE_STMT_CLASS,          // "source" statement (source_stmt)
     FG_STMT_CLASS,              // pipeline run in foreground (sys_stmt)
-    BG_STMT_CLASS               // pipeline run in background (sys_stmt)
+    BG_STMT_CLASS,              // pipeline run in background (sys_stmt)
+    FOR_STMT_CLASS,             // "for" statement (for_stmt)
+    NEXT_STMT_CLASS,            // "next" statement (next_stmt)
+    APPEND_STMT_CLASS,          // "append" statement (set_stmt)
+    READ_STMT_CLASS,            // "read" statement (file_stmt)
+    WRITE_STMT_CLASS,           // "write" statement (file_stmt)
+    PUSH_STMT_CLASS,            // "push" statement (set_stmt)
+    POP_STMT_CLASS,             // "pop" statement (pop_stmt)
+    KEYS_STMT_CLASS,            // "keys" statement (pop_stmt)
+    SPLIT_STMT_CLASS,           // "split" statement (split_stmt)
+    EXPORT_STMT_CLASS,          // "export" statement (set_stmt)
+    IMPORT_STMT_CLASS,          // "import" statement (import_stmt)
+    SAVE_STMT_CLASS,            // "save" statement (source_stmt)
+    RESTORE_STMT_CLASS,         // "restore" statement (source_stmt)
+    CACHE_STMT_CLASS            // "cached" statement
 } STMT_CLASS;
 
 /*
  * This structure is used to represent a statement.
  * The value in the "class" field tells what kind of statement it is.
  * Depending on this value, one of the fields of the "members" union
- * may be valid.
+ * may be valid.  The "quick" field holds a specialized form of the
+ * statement, made by the execution engine once the statement has been
+ * executed as part of a program, or NULL if there is none yet.
  */
 typedef struct stmt {
     STMT_CLASS class;
     int lineno;
+    struct quick *quick;
     union {
 	struct {
 	    int from;
@@ -52,10 +69,12 @@ typedef struct stmt {
 	} jobctl_stmt;
 	struct {
 	    char *name;
-	    struct expr *expr;
+	    struct expr *expr;          // NULL for "export" without a value
+	    struct expr *index;         // Array index, or NULL if none
 	} set_stmt;
 	struct {
 	    char *name;
+	    struct expr *index;         // Map key, or NULL if none
 	} unset_stmt;
 	struct {
 	    struct expr *expr;
@@ -67,6 +86,35 @@ typedef struct stmt {
 	struct {
 	    char *file;
 	} source_stmt;
+	struct {
+	    char *name;
+	    struct expr *from;
+	    struct expr *to;
+	    struct expr *step;          // NULL if no "step" clause
+	} for_stmt;
+	struct {
+	    char *name;                 // NULL for the innermost loop
+	} next_stmt;
+	struct {
+	    char *name;
+	    char *file;
+	    int append;                 // Nonzero for "write x >> file"
+	} file_stmt;
+	struct {
+	    char *name;
+	    char *target;               // NULL if the value is discarded
+	} pop_stmt;
+	struct {
+	    char *name;
+	    char *target;
+	    struct expr *delim;         // NULL to split at white space
+	    int numeric;                // Nonzero to store integer fields
+	} split_stmt;
+	struct {
+	    char *name;                 // Variable to parse, or NULL
+	    char *file;                 // File to parse, or NULL
+	    char *prefix;               // Prefix for the names, or NULL
+	} import_stmt;
     } members;
 } STMT;
 
@@ -92,13 +140,16 @@ typedef struct command {
  * nonzero, then instead of being redirected to a file, the output from the
  * last command in the pipeline is to be redirected to a pipe.  This pipe is
  * to be read by the main process, which will "captures" the output and make
- * it available as the value of a variable in the data store.
+ * it available as the value of a variable in the data store.  If the
+ * "cached" field is nonzero, then the status and captured output of the
+ * pipeline may be replayed from an earlier run with the same arguments.
  */
 typedef struct pipeline {
     COMMAND *commands;
     char *input_file;
     char *output_file;
     int capture_output;
+    int cached;
 } PIPELINE;
 
 /*
@@ -111,7 +162,9 @@ typedef enum {
     NUM_EXPR_CLASS,             // numeric variable (variable)
     STRING_EXPR_CLASS,          // string variable (variable)
     UNARY_EXPR_CLASS,           // unary expression (unary_expr)
-    BINARY_EXPR_CLASS           // binary expression (binary_expr)
+    BINARY_EXPR_CLASS,          // binary expression (binary_expr)
+    FUNC_EXPR_CLASS,            // call of a builtin function (func_expr)
+    INDEX_EXPR_CLASS            // element of an array variable (index_expr)
 } EXPR_CLASS;
 
 /*
@@ -132,7 +185,26 @@ typedef enum {
     MINUS_OPRTR,                // "minus" (binary_expr)
     TIMES_OPRTR,                // "times" (binary_expr)
     DIVIDE_OPRTR,               // "divide" (binary_expr)
-    MOD_OPRTR                   // "mod" (binary_expr)
+    MOD_OPRTR,                  // "mod" (binary_expr)
+    CONCAT_OPRTR,               // "concatenate" (binary_expr)
+    CONTAINS_OPRTR,             // "contains" substring test (binary_expr)
+    MATCHES_OPRTR,              // "matches" regular expression (binary_expr)
+    LENGTH_OPRTR,               // "len" function (func_expr)
+    SUBSTR_OPRTR,               // "substr" function (func_expr)
+    INDEX_OPRTR,                // "index" function (func_expr)
+    TRIM_OPRTR,                 // "trim" function (func_expr)
+    UPPER_OPRTR,                // "upper" function (func_expr)
+    LOWER_OPRTR,                // "lower" function (func_expr)
+    FIELD_OPRTR,                // "field" function (func_expr)
+    EXISTS_OPRTR,               // "exists" function (func_expr)
+    SUM_OPRTR,                  // "sum" function (func_expr)
+    MIN_OPRTR,                  // "min" function (func_expr)
+    MAX_OPRTR,                  // "max" function (func_expr)
+    COUNT_OPRTR,                // "count" function (func_expr)
+    MEAN_OPRTR,                 // "mean" function (func_expr)
+    SORT_OPRTR,                 // "sort" function (func_expr)
+    UNIQUE_OPRTR,               // "unique" function (func_expr)
+    COUNTS_OPRTR                // "counts" function (func_expr)
 } OPRTR;
 
 /*
@@ -142,7 +214,8 @@ typedef enum {
 typedef enum {
     NO_VALUE_TYPE,
     NUM_VALUE_TYPE,              // numeric value
-    STRING_VALUE_TYPE            // string value
+    STRING_VALUE_TYPE,           // string value
+    ARRAY_VALUE_TYPE             // array or map, only assigned by "set"
 } VALUE_TYPE;
 
 /*
@@ -163,9 +236,37 @@ typedef struct expr {
 	    struct expr *arg1;
 	    struct expr *arg2;
 	} binary_expr;
+	struct {
+	    OPRTR oprtr;
+	    struct arg *args;
+	} func_expr;
+	struct {
+	    char *variable;
+	    struct expr *index;
+	} index_expr;
     } members;
 } EXPR;
 
+/*
+ * This structure describes one of the builtin functions that can be
+ * called in expressions, giving its name, the operator that identifies
+ * it in a "func_expr", the range of the number of arguments it accepts,
+ * and the type of the value it produces.  A function that operates on a
+ * variable, rather than on a value, requires its first argument to be an
+ * expression of a particular class, which names the variable and is not
+ * evaluated; for other functions "arg_class" is NO_EXPR_CLASS.  If the
+ * class is STRING_EXPR_CLASS, then a variable of either class is accepted,
+ * and the class says how the elements of the variable are compared.
+ */
+typedef struct func_info {
+    char *name;
+    OPRTR oprtr;
+    int min_args;
+    int max_args;
+    VALUE_TYPE type;
+    EXPR_CLASS arg_class;       // Required class of the first argument
+} FUNC_INFO;
+
 /*
  * This structure is used to represent an "argument", which is
  * a single element of a command.  Arguments contain arbitrary expressions,
@@ -190,6 +291,14 @@ void show_expr(FILE *file, EXPR *expr, int parens);
 void show_oprtr(FILE *file, OPRTR oprtr);
 void show_lineno(FILE *file, int lineno);
 
+/*
+ * The following functions look up the description of a builtin function,
+ * either by the name used to call it or by its operator.  NULL is returned
+ * if there is no such function.
+ */
+FUNC_INFO *find_function(char *name);
+FUNC_INFO *function_info(OPRTR oprtr);
+
 /*
  * The following functions are use to free the various syntactic
  * objects.  Freeing an object with one of these functions implies
@@ -0,0 +1,878 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <signal.h>
+
+#include "mush.h"
+#include "debug.h"
+
+/*
+ * This is the "compiler" module for Mush.
+ * It translates a script into C, for scripts that are deployed unchanged
+ * for a long time, and it holds the run-time support that the C calls.
+ * The mushc program compiles the C with the system compiler and links it
+ * with libmush.a, making a native program that runs the script with the
+ * same results as "mush < script".
+ *
+ * The program that a script has built when it first says "run" is what
+ * is compiled.  Each line of it becomes a label, "goto" and "if" become
+ * jumps straight to the labels of their targets, numeric expressions are
+ * evaluated in C, and pipelines are started and waited for with the jobs
+ * module, as the execution engine would.  A variable that the program sets
+ * to a number lives in a slot of the compiled program while it runs.  The
+ * slots are written back to the data store before anything that might
+ * look there for them (a pipeline, an expression that is not evaluated in
+ * C, or the end of the program), and read again after anything that might
+ * have changed them.  The statements that are not translated ("for",
+ * "read", string "set" and so on) are handed back to the execution engine
+ * one at a time, after which the compiled program carries on at whatever
+ * line the statement left the program counter.  If a slot's variable has
+ * been given a value that is not a number, the interpreter carries on
+ * instead.
+ *
+ * The text of the script is compiled in as well.  When the native program
+ * starts it parses the text and runs its statements as the interpreter
+ * would, except that a "run" of the program that was compiled runs the
+ * compiled code.  If the program store does not hold exactly the compiled
+ * program at that point, or it is changed while the program runs, the
+ * interpreter is used instead, so the results are the same either way.
+ */
+
+/* Deepest expression that is evaluated in C, rather than by the engine. */
+#define MAX_TEMPS 64
+
+/*
+ * State of the compilation of a script.
+ */
+typedef struct compiler {
+    STMT **stmts;               // Statements of the script, in order
+    long nstmts;
+    long *srcs;                 // Index in "stmts" of each line of program
+    long nprog;
+    char **slots;               // Names of the variables kept in slots
+    long nslots;
+    int depth;                  // Number of temporaries used
+    int fails;                  // Nonzero if any statement can fail in C
+    int steps;                  // Nonzero if any statement is handed back
+    int jobs;                   // Nonzero if any pipeline is run in C
+    int captures;               // Nonzero if any output is captured in C
+} COMPILER;
+
+/* Names of the variables that are used by the modules themselves. */
+static char *special_vars[] = {
+    JOB_VAR, STATUS_VAR, OUTPUT_VAR, ROW_VAR, CACHE_TTL_VAR, CACHE_SIZE_VAR,
+    CACHE_ENV_VAR, COMPRESS_MIN_VAR, COMPRESS_AGE_VAR, FG_PARALLEL_VAR, NULL
+};
+
+static STMT *prog_stmt(COMPILER *c, long i) {
+    return c->stmts[c->srcs[i]];
+}
+
+/*
+ * Find the index of a line of the program, or -1 if there is no such line.
+ */
+static long line_index(COMPILER *c, int lineno) {
+    long lo = 0, hi = c->nprog - 1;
+    while(lo <= hi)
+    {
+        long mid = (lo + hi) / 2;
+        int l = prog_stmt(c, mid)->lineno;
+        if(l == lineno)
+            return mid;
+        if(l < lineno)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return -1;
+}
+
+/*
+ * Build the program as it stands when the script first says "run", by
+ * applying the insertions and deletions that come before that.
+ */
+static int build_program(COMPILER *c) {
+    c->srcs = (long *) malloc((c->nstmts + 1) * sizeof(long));
+    if(c->srcs == NULL)
+        return -1;
+    c->nprog = 0;
+    for(long i = 0; i < c->nstmts; i++)
+    {
+        STMT *stmt = c->stmts[i];
+        if(stmt->class == RUN_STMT_CLASS && !stmt->lineno)
+            break;
+        if(stmt->class == DELETE_STMT_CLASS && !stmt->lineno)
+        {
+            long n = 0;
+            for(long j = 0; j < c->nprog; j++)
+            {
+                int l = prog_stmt(c, j)->lineno;
+                if(l < stmt->members.delete_stmt.from
+                   || l > stmt->members.delete_stmt.to)
+                    c->srcs[n++] = c->srcs[j];
+            }
+            c->nprog = n;
+            continue;
+        }
+        if(!stmt->lineno)
+            continue;
+        long j = 0;
+        while(j < c->nprog && prog_stmt(c, j)->lineno < stmt->lineno)
+            j++;
+        if(j < c->nprog && prog_stmt(c, j)->lineno == stmt->lineno)
+        {
+            c->srcs[j] = i;
+            continue;
+        }
+        memmove(&c->srcs[j + 1], &c->srcs[j], (c->nprog - j) * sizeof(long));
+        c->srcs[j] = i;
+        c->nprog++;
+    }
+    return 0;
+}
+
+/*
+ * Determine whether an expression refers to a variable.
+ */
+static int expr_uses(EXPR *expr, char *name) {
+    if(expr == NULL)
+        return 0;
+    switch(expr->class)
+    {
+    case NUM_EXPR_CLASS:
+    case STRING_EXPR_CLASS:
+        return !strcmp(expr->members.variable, name);
+    case UNARY_EXPR_CLASS:
+        return expr_uses(expr->members.unary_expr.arg, name);
+    case BINARY_EXPR_CLASS:
+        return expr_uses(expr->members.binary_expr.arg1, name)
+            || expr_uses(expr->members.binary_expr.arg2, name);
+    case FUNC_EXPR_CLASS:
+        for(ARG *ap = expr->members.func_expr.args; ap; ap = ap->next)
+        {
+            if(expr_uses(ap->expr, name))
+                return 1;
+        }
+        return 0;
+    case INDEX_EXPR_CLASS:
+        return !strcmp(expr->members.index_expr.variable, name)
+            || expr_uses(expr->members.index_expr.index, name);
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Determine whether an expression node is evaluated in C.  Its operands
+ * are then evaluated in C as well, if they can be, and otherwise by the
+ * execution engine.  The "k"th temporary holds the value of the node.
+ */
+static int native_expr(EXPR *expr, int k) {
+    char *endp;
+    if(k >= MAX_TEMPS - 1)
+        return 0;
+    switch(expr->class)
+    {
+    case LIT_EXPR_CLASS:
+        strtol(expr->members.value, &endp, 0);
+        return *endp == '\0';
+    case NUM_EXPR_CLASS:
+        return 1;
+    case UNARY_EXPR_CLASS:
+        return expr->members.unary_expr.oprtr == NOT_OPRTR;
+    case BINARY_EXPR_CLASS:
+        switch(expr->members.binary_expr.oprtr)
+        {
+        case AND_OPRTR: case OR_OPRTR: case PLUS_OPRTR: case MINUS_OPRTR:
+        case TIMES_OPRTR: case DIVIDE_OPRTR: case MOD_OPRTR: case LESS_OPRTR:
+        case GREATER_OPRTR: case LESSEQ_OPRTR: case GREATEQ_OPRTR:
+            return 1;
+        case EQUAL_OPRTR:
+            return expr->members.binary_expr.arg1->type == NUM_VALUE_TYPE
+                && expr->members.binary_expr.arg2->type == NUM_VALUE_TYPE;
+        default:
+            return 0;
+        }
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Determine whether a line of the program is translated into C, rather
+ * than handed back to the execution engine.
+ */
+static int native_stmt(COMPILER *c, STMT *stmt) {
+    switch(stmt->class)
+    {
+    case SET_STMT_CLASS:
+        return stmt->members.set_stmt.index == NULL
+            && stmt->members.set_stmt.expr->type == NUM_VALUE_TYPE;
+    case IF_STMT_CLASS:
+        return line_index(c, stmt->members.if_stmt.lineno) >= 0;
+    case GOTO_STMT_CLASS:
+        return line_index(c, stmt->members.goto_stmt.lineno) >= 0;
+    case FG_STMT_CLASS:
+    case BG_STMT_CLASS:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Determine whether a variable can be kept in a slot: it must not be one
+ * that other modules look at, nor the variable of a "for" loop, which the
+ * execution engine keeps to itself while the loop runs.
+ */
+static int slot_candidate(COMPILER *c, char *name) {
+    for(char **sp = special_vars; *sp; sp++)
+    {
+        if(!strcmp(*sp, name))
+            return 0;
+    }
+    for(long i = 0; i < c->nslots; i++)
+    {
+        if(!strcmp(c->slots[i], name))
+            return 0;
+    }
+    for(long i = 0; i < c->nprog; i++)
+    {
+        STMT *stmt = prog_stmt(c, i);
+        if((stmt->class == FOR_STMT_CLASS
+            && !strcmp(stmt->members.for_stmt.name, name))
+           || (stmt->class == NEXT_STMT_CLASS
+               && stmt->members.next_stmt.name != NULL
+               && !strcmp(stmt->members.next_stmt.name, name)))
+            return 0;
+    }
+    return 1;
+}
+
+static int choose_slots(COMPILER *c) {
+    c->slots = (char **) malloc((c->nprog + 1) * sizeof(char *));
+    if(c->slots == NULL)
+        return -1;
+    c->nslots = 0;
+    for(long i = 0; i < c->nprog; i++)
+    {
+        STMT *stmt = prog_stmt(c, i);
+        if(stmt->class == SET_STMT_CLASS && native_stmt(c, stmt)
+           && slot_candidate(c, stmt->members.set_stmt.name))
+            c->slots[c->nslots++] = stmt->members.set_stmt.name;
+    }
+    return 0;
+}
+
+static long slot_index(COMPILER *c, char *name) {
+    for(long i = 0; i < c->nslots; i++)
+    {
+        if(!strcmp(c->slots[i], name))
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Write a string as a C string literal, breaking it after each newline.
+ */
+static void put_string(FILE *out, char *str, size_t len) {
+    fputc('"', out);
+    for(size_t i = 0; i < len; i++)
+    {
+        unsigned char ch = str[i];
+        if(ch == '\n')
+            fputs(i + 1 < len ? "\\n\"\n\"" : "\\n", out);
+        else if(ch == '"' || ch == '\\' || ch == '?')
+            fprintf(out, "\\%c", ch);
+        else if(ch < ' ' || ch >= 0x7f)
+            fprintf(out, "\\%03o", ch);
+        else
+            fputc(ch, out);
+    }
+    fputc('"', out);
+}
+
+static void put_name(FILE *out, char *name) {
+    put_string(out, name, strlen(name));
+}
+
+/*
+ * Make the C that finds a member of the expression or statement found
+ * by "path", or of the "i"th statement of the program.
+ */
+static char *member_path(char *path, char *member) {
+    char *sub = (char *) malloc(strlen(path) + strlen(member) + 12);
+    if(sub == NULL)
+        abort();
+    sprintf(sub, "%s->members.%s", path, member);
+    return sub;
+}
+
+static char *stmt_path(long i, char *member) {
+    char base[32];
+    sprintf(base, "S[%ld]", i);
+    return member_path(base, member);
+}
+
+/*
+ * Write the C that writes the slots back to their variables.
+ */
+static void put_sync(COMPILER *c, FILE *out, char *indent) {
+    for(long i = 0; i < c->nslots; i++)
+    {
+        fprintf(out, "%smushc_store(", indent);
+        put_name(out, c->slots[i]);
+        fprintf(out, ", V[%ld], D[%ld]);\n", i, i);
+    }
+}
+
+/*
+ * Write the C that reads the slots from their variables again, and hands
+ * the program over to the interpreter if that cannot be done.
+ */
+static void put_reload(COMPILER *c, FILE *out, char *indent) {
+    if(c->nslots == 0)
+        return;
+    fprintf(out, "%sif(", indent);
+    for(long i = 0; i < c->nslots; i++)
+    {
+        if(i)
+            fprintf(out, "\n%s   || ", indent);
+        fprintf(out, "mushc_load(");
+        put_name(out, c->slots[i]);
+        fprintf(out, ", &V[%ld], &D[%ld]) < 0", i, i);
+    }
+    fprintf(out, ") {\n%s    r = MUSHC_INTERPRET;\n%s    goto out;\n%s}\n",
+            indent, indent, indent);
+    c->steps = 1;
+}
+
+/*
+ * Write the C that leaves the value of a numeric expression, as
+ * eval_to_numeric() would compute it, in the "k"th temporary.  The
+ * expression is found at run time by following "path" from the statements
+ * of the program; "next" is the index of the line after the one being
+ * compiled, where the program counter is left if evaluation fails.
+ */
+static void put_expr(COMPILER *c, FILE *out, EXPR *expr, char *path, int k,
+                     long next) {
+    char *endp, *sub;
+    long val;
+    if(k + 1 > c->depth)
+        c->depth = k + 1;
+    if(!native_expr(expr, k))
+    {
+        for(long i = 0; i < c->nslots; i++)
+        {
+            if(expr_uses(expr, c->slots[i]))
+            {
+                put_sync(c, out, "\t");
+                break;
+            }
+        }
+        fprintf(out, "\tn = %ld;\n\tif(exec_numeric(%s, &t[%d]) < 0)\n"
+                "\t    goto fail;\n", next, path, k);
+        c->fails = 1;
+        return;
+    }
+    switch(expr->class)
+    {
+    case LIT_EXPR_CLASS:
+        val = strtol(expr->members.value, &endp, 0);
+        if(val == LONG_MIN)
+            fprintf(out, "\tt[%d] = %ldL - 1;\n", k, val + 1);
+        else
+            fprintf(out, "\tt[%d] = %ldL;\n", k, val);
+        return;
+    case NUM_EXPR_CLASS:
+        if((val = slot_index(c, expr->members.variable)) >= 0)
+        {
+            fprintf(out, "\tif(!D[%ld] && mushc_undefined(", val);
+            put_name(out, expr->members.variable);
+            fprintf(out, ")) {\n\t    n = %ld;\n\t    goto fail;\n\t}\n"
+                    "\tt[%d] = V[%ld];\n", next, k, val);
+        }
+        else
+        {
+            fprintf(out, "\tif(exec_get_numeric(");
+            put_name(out, expr->members.variable);
+            fprintf(out, ", &t[%d]) < 0) {\n\t    n = %ld;\n"
+                    "\t    goto fail;\n\t}\n", k, next);
+        }
+        c->fails = 1;
+        return;
+    case UNARY_EXPR_CLASS:
+        sub = member_path(path, "unary_expr.arg");
+        put_expr(c, out, expr->members.unary_expr.arg, sub, k, next);
+        free(sub);
+        fprintf(out, "\tt[%d] = !t[%d];\n", k, k);
+        return;
+    case BINARY_EXPR_CLASS:
+        sub = member_path(path, "binary_expr.arg1");
+        put_expr(c, out, expr->members.binary_expr.arg1, sub, k, next);
+        free(sub);
+        sub = member_path(path, "binary_expr.arg2");
+        put_expr(c, out, expr->members.binary_expr.arg2, sub, k + 1, next);
+        free(sub);
+        char *op = "";
+        switch(expr->members.binary_expr.oprtr)
+        {
+        case AND_OPRTR: op = "&&"; break;
+        case OR_OPRTR: op = "||"; break;
+        case PLUS_OPRTR: op = "+"; break;
+        case MINUS_OPRTR: op = "-"; break;
+        case TIMES_OPRTR: op = "*"; break;
+        case DIVIDE_OPRTR: op = "/"; break;
+        case MOD_OPRTR: op = "%"; break;
+        case LESS_OPRTR: op = "<"; break;
+        case GREATER_OPRTR: op = ">"; break;
+        case LESSEQ_OPRTR: op = "<="; break;
+        case GREATEQ_OPRTR: op = ">="; break;
+        case EQUAL_OPRTR: op = "=="; break;
+        default: abort();
+        }
+        fprintf(out, "\tt[%d] = t[%d] %s t[%d];\n", k, k, op, k + 1);
+        return;
+    default:
+        abort();
+    }
+}
+
+/*
+ * Write the C that jumps to a line of the program, unless the user has
+ * asked for the program to quit.
+ */
+static void put_jump(FILE *out, long target, char *indent) {
+    fprintf(out, "%sn = %ld;\n%sif(!exec_quit())\n%s    goto L%ld;\n"
+            "%sgoto dispatch;\n", indent, target, indent, indent, target,
+            indent);
+}
+
+/*
+ * Write the C that hands a line back to the execution engine.
+ */
+static void put_step(COMPILER *c, FILE *out, long i, char *indent) {
+    put_sync(c, out, indent);
+    /* An error caught on entry to the program comes from the engine. */
+    fprintf(out, "%sn = -1;\n%sif((n = mushc_step(%ld, &r)) < 0)\n"
+            "%s    goto out;\n", indent, indent, i, indent);
+    put_reload(c, out, indent);
+    fprintf(out, "%sif(n != %ld)\n%s    goto dispatch;\n",
+            indent, i + 1, indent);
+    c->steps = 1;
+}
+
+/*
+ * Write the C for the "i"th line of the program.
+ */
+static void put_stmt(COMPILER *c, FILE *out, long i) {
+    STMT *stmt = prog_stmt(c, i);
+    char *path;
+    long slot;
+
+    fprintf(out, "L%ld:\t/* %d */\n", i, stmt->lineno);
+    if(!native_stmt(c, stmt))
+    {
+        put_step(c, out, i, "\t");
+        return;
+    }
+    /* Like exec_stmt(), "set" and "if" keep the value as an int. */
+    switch(stmt->class)
+    {
+    case SET_STMT_CLASS:
+        path = stmt_path(i, "set_stmt.expr");
+        put_expr(c, out, stmt->members.set_stmt.expr, path, 0, i + 1);
+        free(path);
+        if((slot = slot_index(c, stmt->members.set_stmt.name)) >= 0)
+        {
+            fprintf(out, "\tV[%ld] = (int) t[0];\n\tD[%ld] = 1;\n", slot, slot);
+        }
+        else
+        {
+            fprintf(out, "\texec_set_numeric(");
+            put_name(out, stmt->members.set_stmt.name);
+            fprintf(out, ", (int) t[0]);\n");
+        }
+        break;
+    case IF_STMT_CLASS:
+        path = stmt_path(i, "if_stmt.expr");
+        put_expr(c, out, stmt->members.if_stmt.expr, path, 0, i + 1);
+        free(path);
+        fprintf(out, "\tif((int) t[0]) {\n");
+        put_jump(out, line_index(c, stmt->members.if_stmt.lineno), "\t    ");
+        fprintf(out, "\t}\n");
+        break;
+    case GOTO_STMT_CLASS:
+        put_jump(out, line_index(c, stmt->members.goto_stmt.lineno), "\t");
+        break;
+    case FG_STMT_CLASS:
+        /* Pipelines that may run together are left to the engine. */
+        fprintf(out, "\tif(mushc_grouping()) {\n");
+        put_step(c, out, i, "\t    ");
+        fprintf(out, "\t} else {\n");
+        put_sync(c, out, "\t    ");
+        fprintf(out, "\t    n = %ld;\n"
+                "\t    if(exec_job(S[%ld]->members.sys_stmt.pipeline, &job) < 0)\n"
+                "\t\tgoto fail;\n"
+                "\t    store_set_int(JOB_VAR, job);\n"
+                "\t    status = jobs_wait(job);\n"
+                "\t    store_set_int(STATUS_VAR, status);\n", i + 1, i);
+        if(stmt->members.sys_stmt.pipeline->capture_output)
+        {
+            fprintf(out, "\t    output = jobs_release_output(job, &len);\n"
+                    "\t    store_set_owned(OUTPUT_VAR, output, len);\n");
+            c->captures = 1;
+        }
+        fprintf(out, "\t    jobs_expunge(job);\n\t}\n");
+        c->fails = c->jobs = 1;
+        break;
+    case BG_STMT_CLASS:
+        put_sync(c, out, "\t");
+        fprintf(out, "\tn = %ld;\n"
+                "\tif(exec_job(S[%ld]->members.sys_stmt.pipeline, &job) < 0)\n"
+                "\t    goto fail;\n"
+                "\tstore_set_int(JOB_VAR, job);\n", i + 1, i);
+        c->fails = c->jobs = 1;
+        break;
+    default:
+        abort();
+    }
+}
+
+/*
+ * Write the C for the whole program, as the function "program".
+ */
+static int put_program(COMPILER *c, FILE *out) {
+    char *body = NULL;
+    size_t size = 0;
+    FILE *bf = open_memstream(&body, &size);
+    if(bf == NULL)
+        return -1;
+
+    fprintf(bf, "    if(mushc_enter(NPROG, srcs, S) < 0)\n"
+            "\treturn MUSHC_INTERPRET;\n");
+    put_reload(c, bf, "    ");
+    fprintf(bf, "dispatch:\n"
+            "    if(exec_quit()) {\n\tr = MUSHC_QUIT;\n\tgoto leave;\n    }\n"
+            "    switch(n) {\n");
+    for(long i = 0; i < c->nprog; i++)
+        fprintf(bf, "    case %ld: goto L%ld;\n", i, i);
+    fprintf(bf, "    default:\n\tr = MUSHC_END;\n\tgoto leave;\n    }\n");
+    for(long i = 0; i < c->nprog; i++)
+        put_stmt(c, bf, i);
+    fprintf(bf, "\tn = NPROG;\n\tgoto dispatch;\n");
+    if(c->fails)
+        fprintf(bf, "fail:\n    r = -1;\n");
+    fprintf(bf, "leave:\n    mushc_seek(n);\n");
+    put_sync(c, bf, "    ");
+    if(c->steps)
+        fprintf(bf, "out:\n");
+    fprintf(bf, "    return r;\n}\n");
+    if(fclose(bf) == EOF)
+    {
+        free(body);
+        return -1;
+    }
+
+    fprintf(out, "#define NPROG %ld\n\n", c->nprog);
+    fprintf(out, "/* Index among the statements of the script of each line. */\n"
+            "static long srcs[NPROG] = {");
+    for(long i = 0; i < c->nprog; i++)
+        fprintf(out, "%s%s%ld", i ? "," : "", i % 10 ? " " : "\n    ",
+                c->srcs[i]);
+    fprintf(out, "\n};\n\nstatic STMT *S[NPROG];\n\n");
+    if(c->nslots > 0)
+    {
+        fprintf(out, "/* Slots for the variables");
+        for(long i = 0; i < c->nslots; i++)
+            fprintf(out, "%s %s", i ? "," : "", c->slots[i]);
+        fprintf(out, ", and whether each is set. */\n"
+                "static long V[%ld];\nstatic int D[%ld];\n\n",
+                c->nslots, c->nslots);
+    }
+    fprintf(out, "static int program(void) {\n");
+    if(c->depth > 0)
+        fprintf(out, "    long t[%d];\n", c->depth);
+    /* The line to go on from is kept where the error handler finds it. */
+    fprintf(out, "    volatile long n = 0;\n    int r;\n");
+    if(c->jobs)
+        fprintf(out, "    int job, status;\n");
+    if(c->captures)
+        fprintf(out, "    size_t len;\n    char *output;\n");
+    fprintf(out, "\n");
+    if(c->fails || c->steps)
+    {
+        /*
+         * The engine's error handler is set once, here, rather than each
+         * time a line or an expression is handed to it.  An error in a
+         * line it runs stops the program as mushc_step() would have, and
+         * one in an expression or pipeline as "goto fail" would have.
+         */
+        fprintf(out, "    if(setjmp(*exec_arm())) {\n\tr = -1;\n");
+        if(c->steps)
+            fprintf(out, "\tif(n < 0)\n\t    goto out;\n");
+        fprintf(out, "\tgoto leave;\n    }\n");
+    }
+    fwrite(body, 1, size, out);
+    free(body);
+    return 0;
+}
+
+/**
+ * @brief  Translate a script into C.
+ * @details  This function writes a C program that runs a script, as
+ * "mush < script" would, with the program that the script runs compiled
+ * into native code.  The C is to be compiled and linked with libmush.a.
+ *
+ * @param  script  The name of the file holding the script.
+ * @param  out  The stream to which the C is to be written.
+ * @return  0 if successful, otherwise -1.
+ */
+int compile_script(char *script, FILE *out) {
+    FILE *in = fopen(script, "r");
+    char *text = NULL;
+    size_t size = 0;
+    ssize_t len = in ? getdelim(&text, &size, '\0', in) : -1;
+
+    if(in == NULL || len < 0)
+    {
+        if(in == NULL)
+            perror(script);
+        else
+            fprintf(stderr, "mushc: %s: Empty script\n", script);
+        if(in)
+            fclose(in);
+        free(text);
+        return -1;
+    }
+    fclose(in);
+
+    COMPILER c;
+    memset(&c, 0, sizeof(c));
+    c.stmts = exec_parse(text, len, 0, &c.nstmts);
+    if(c.stmts == NULL || build_program(&c) < 0 || choose_slots(&c) < 0)
+    {
+        fprintf(stderr, "mushc: %s: Cannot compile this script\n", script);
+        free(text);
+        return -1;
+    }
+    debug("%ld lines, %ld slots", c.nprog, c.nslots);
+
+    fprintf(out, "/*\n * Compiled by mushc from %s.\n */\n\n", script);
+    fprintf(out, "#include <stdlib.h>\n#include <stdio.h>\n\n"
+            "#include \"mush.h\"\n\n");
+    fprintf(out, "static char script[] =\n");
+    put_string(out, text, len);
+    fprintf(out, ";\n\n");
+    int ret = 0;
+    if(c.nprog > 0)
+        ret = put_program(&c, out);
+    else
+        fprintf(out, "static int program(void) {\n"
+                "    return MUSHC_INTERPRET;\n}\n");
+    fprintf(out, "\nint main(void) {\n"
+            "    return mushc_main(script, sizeof(script) - 1, program);\n"
+            "}\n");
+    if(fflush(out) == EOF)
+        ret = -1;
+
+    for(long i = 0; i < c.nstmts; i++)
+        free_stmt(c.stmts[i]);
+    free(c.stmts);
+    free(c.srcs);
+    free(c.slots);
+    free(text);
+    return ret;
+}
+
+/*
+ * Run-time support for compiled programs.  A compiled program is a process
+ * of its own, running a single interpreter, so this state is not per
+ * thread like that of the other modules.
+ */
+static STMT **parsed;           // Statements of the script
+static long nparsed;
+static STMT **lines;            // Lines of the program being run
+static PROG_POS *positions;     // Position of each, and of the end
+static long nlines;
+static int epoch;               // Program store epoch when it was started
+
+/**
+ * @brief  Run the script of a compiled program.
+ * @details  This function parses the text of the script and runs its
+ * statements in turn, as exec_interactive() would if it read them, except
+ * that "run" runs the compiled code of the program.
+ *
+ * @param  text  The text of the script.
+ * @param  len  The length of the text.
+ * @param  code  The compiled program.
+ * @return  The exit status for the compiled program.
+ */
+int mushc_main(char *text, size_t len, int (*code)(void)) {
+    jobs_init();
+    parsed = exec_parse(text, len, 1, &nparsed);
+    if(parsed == NULL)
+    {
+        fprintf(stderr, "mushc: The compiled script cannot be parsed\n");
+        return EXIT_FAILURE;
+    }
+    signal(SIGQUIT, SIG_IGN);
+    for(long i = 0; i < nparsed; i++)
+    {
+        STMT *stmt = parsed[i];
+        fflush(stdout);
+        if(stmt->lineno)
+            prog_insert(stmt);
+        else if(stmt->class == RUN_STMT_CLASS)
+            exec_native(code);
+        else
+            exec_immediate(stmt);
+    }
+    fflush(stdout);
+    jobs_fini();
+    free(positions);
+    free(parsed);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief  Start a compiled program.
+ * @details  This function checks that the program store holds the program
+ * that was compiled, line for line, and finds the statements and positions
+ * of its lines for the compiled code.  The program counter is left at the
+ * start of the program.
+ *
+ * @param  n  The number of lines of the compiled program.
+ * @param  srcs  The index among the statements of the script of each line.
+ * @param  stmts  Where to store the statement of each line.
+ * @return  0 if the compiled program can be run, otherwise -1.
+ */
+int mushc_enter(long n, long *srcs, STMT **stmts) {
+    PROG_POS *pos = (PROG_POS *) realloc(positions, (n + 1) * sizeof(PROG_POS));
+    STMT *stmt;
+    long i = 0;
+
+    if(pos == NULL)
+        return -1;
+    positions = pos;
+    prog_reset();
+    while((stmt = prog_fetch()) != NULL)
+    {
+        if(i == n || srcs[i] >= nparsed || stmt != parsed[srcs[i]])
+            break;
+        stmts[i] = stmt;
+        pos[i++] = prog_tell();
+        prog_next();
+    }
+    pos[i] = prog_tell();
+    prog_reset();
+    if(i < n || stmt != NULL)
+        return -1;
+    lines = stmts;
+    nlines = n;
+    epoch = prog_epoch();
+    return 0;
+}
+
+/**
+ * @brief  Hand a line of a compiled program back to the execution engine.
+ * @details  This function executes the "i"th line of the program as the
+ * interpreter would, and finds the line at which the program is to go on.
+ *
+ * @param  i  The index of the line.
+ * @param  resultp  Where to store the result of the program, if it is not
+ * to go on.
+ * @return  The index of the line at which the program goes on, or -1 if
+ * it does not.
+ */
+long mushc_step(long i, int *resultp) {
+    prog_seek(positions[i + 1]);
+    int err = exec_step(lines[i]);
+    if(err)
+    {
+        *resultp = err;
+        return -1;
+    }
+    if(prog_epoch() != epoch)
+    {
+        *resultp = MUSHC_INTERPRET;
+        return -1;
+    }
+    STMT *next = prog_fetch();
+    if(exec_quit() || next == NULL)
+    {
+        *resultp = exec_quit() ? MUSHC_QUIT : MUSHC_END;
+        return -1;
+    }
+    if(i + 1 < nlines && lines[i + 1] == next)
+        return i + 1;
+    long lo = 0, hi = nlines - 1;
+    while(lo <= hi)
+    {
+        long mid = (lo + hi) / 2;
+        if(lines[mid] == next)
+            return mid;
+        if(lines[mid]->lineno < next->lineno)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    *resultp = MUSHC_INTERPRET;
+    return -1;
+}
+
+/**
+ * @brief  Set the program counter to just before a line of a compiled
+ * program, or to its end if "i" is the number of lines.
+ */
+void mushc_seek(long i) {
+    prog_seek(positions[i]);
+}
+
+/**
+ * @brief  Determine whether foreground pipelines may run together, in
+ * which case they are left to the execution engine.
+ */
+int mushc_grouping(void) {
+    long limit;
+    return store_get_int(FG_PARALLEL_VAR, &limit) == 0 && limit > 1;
+}
+
+/**
+ * @brief  Load a variable into a slot of a compiled program.
+ *
+ * @param  name  The name of the variable.
+ * @param  valp  The slot.
+ * @param  definedp  Where to store whether the variable is set.
+ * @return  0 if successful, or -1 if the variable has a value that cannot
+ * be kept in a slot.
+ */
+int mushc_load(char *name, long *valp, int *definedp) {
+    if(store_get_int(name, valp) == 0)
+    {
+        *definedp = 1;
+        return 0;
+    }
+    *definedp = 0;
+    return store_get_string(name) == NULL && store_array_length(name) < 0
+        && store_map_size(name) < 0 ? 0 : -1;
+}
+
+/**
+ * @brief  Write a slot of a compiled program back to its variable.
+ */
+void mushc_store(char *name, long val, int defined) {
+    if(defined)
+        store_set_int(name, val);
+}
+
+/**
+ * @brief  Report the use of a variable held in a slot that is not set.
+ * @return  1, so that the compiled program fails.
+ */
+int mushc_undefined(char *name) {
+    fprintf(stderr, "Variable %s does not have an integer value\n", name);
+    return 1;
+}
@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "mush.h"
+
+/*
+ * This is the "compression" module for Mush.
+ * It provides a small and fast compressor of the LZ77 family, which the
+ * data store uses to keep large values that have not been used for a
+ * while in less memory.  Speed matters more than ratio here: values are
+ * compressed and expanded again behind the back of a running program.
+ *
+ * The compressed form is a sequence of records, each of which holds a run
+ * of literal bytes followed by a copy of earlier output:
+ *
+ *   token      one byte: the number of literals in the high four bits
+ *              and the length of the copy less MIN_MATCH in the low four
+ *              bits, with 15 in either meaning "15 plus the extra bytes
+ *              that follow", each extra byte adding up to 255;
+ *   literals   the literal bytes themselves;
+ *   offset     two bytes, least significant first: how far back in the
+ *              output the copy starts.
+ *
+ * The last record holds only literals, and ends at the end of the input.
+ */
+
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+#define HASH_BITS 14
+
+static uint32_t load32(unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static unsigned hash4(unsigned char *p) {
+    return (load32(p) * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/*
+ * Write a length that did not fit in its four bits of the token.
+ */
+static unsigned char *put_length(unsigned char *out, size_t len) {
+    while(len >= 255)
+    {
+        *out++ = 255;
+        len -= 255;
+    }
+    *out++ = (unsigned char) len;
+    return out;
+}
+
+/*
+ * Write a record with "nlit" literals starting at "lit", followed by a copy
+ * of "mlen" bytes from "offset" bytes back.  A record with "mlen" zero
+ * ends the data and has no offset.
+ */
+static unsigned char *put_record(unsigned char *out, unsigned char *lit,
+                                 size_t nlit, size_t offset, size_t mlen) {
+    unsigned char *token = out++;
+    size_t mcode = mlen ? mlen - MIN_MATCH : 0;
+    *token = (nlit < 15 ? nlit : 15) << 4 | (mcode < 15 ? mcode : 15);
+    if(nlit >= 15)
+        out = put_length(out, nlit - 15);
+    memcpy(out, lit, nlit);
+    out += nlit;
+    if(mlen == 0)
+        return out;
+    *out++ = offset & 0xff;
+    *out++ = offset >> 8;
+    if(mcode >= 15)
+        out = put_length(out, mcode - 15);
+    return out;
+}
+
+/**
+ * @brief  Get the largest possible size of a compressed string.
+ *
+ * @param  len  The length of the string to be compressed.
+ * @return  The size of a buffer that is always large enough to hold the
+ * compressed form of a string of that length.
+ */
+size_t lz_bound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+/**
+ * @brief  Compress a string.
+ * @details  This function compresses "len" bytes starting at "src" into
+ * the buffer "dst", which must have room for lz_bound(len) bytes.  The
+ * string need not be terminated by a null character and may contain them.
+ *
+ * @param  src  The string to compress.
+ * @param  len  The length of the string.
+ * @param  dst  The buffer to hold the compressed data.
+ * @return  The length of the compressed data, or 0 if there was not enough
+ * memory to do the work.
+ */
+size_t lz_compress(char *src, size_t len, char *dst) {
+    unsigned char *in = (unsigned char *) src;
+    unsigned char *out = (unsigned char *) dst;
+    unsigned char *lit = in;
+    size_t i = 0;
+    unsigned misses = 0;
+
+    if(len < MIN_MATCH + 1)
+        return put_record(out, lit, len, 0, 0) - (unsigned char *) dst;
+    /* Positions are kept plus one, so that zero means "none". */
+    uint32_t *table = (uint32_t *) calloc(1 << HASH_BITS, sizeof(uint32_t));
+    if(table == NULL)
+        return 0;
+    while(i + MIN_MATCH <= len)
+    {
+        unsigned h = hash4(in + i);
+        size_t cand = table[h];
+        table[h] = i + 1;
+        if(cand == 0 || i + 1 - cand > MAX_OFFSET
+           || load32(in + cand - 1) != load32(in + i))
+        {
+            /* Skip ahead faster through data that does not compress. */
+            i += 1 + (misses++ >> 6);
+            continue;
+        }
+        misses = 0;
+        cand--;
+        size_t mlen = MIN_MATCH;
+        while(i + mlen < len && in[cand + mlen] == in[i + mlen])
+            mlen++;
+        /* A match may begin a little earlier than where it was found. */
+        while(in + i > lit && cand > 0 && in[cand - 1] == in[i - 1])
+        {
+            i--;
+            cand--;
+            mlen++;
+        }
+        out = put_record(out, lit, in + i - lit, i - cand, mlen);
+        i += mlen;
+        lit = in + i;
+        /* Remember a position inside the match, to find repeats of it. */
+        if(i >= 2 && i - 2 + MIN_MATCH <= len)
+            table[hash4(in + i - 2)] = i - 1;
+    }
+    out = put_record(out, lit, in + len - lit, 0, 0);
+    free(table);
+    return out - (unsigned char *) dst;
+}
+
+/*
+ * Read a length that did not fit in its four bits of the token, returning
+ * -1 if the data ends first.
+ */
+static int get_length(unsigned char **inp, unsigned char *end, size_t *lenp) {
+    unsigned char *in = *inp;
+    unsigned char c;
+    do {
+        if(in >= end)
+            return -1;
+        c = *in++;
+        *lenp += c;
+    } while(c == 255);
+    *inp = in;
+    return 0;
+}
+
+/**
+ * @brief  Expand a compressed string.
+ * @details  This function expands "len" bytes of data produced by
+ * lz_compress() into the buffer "dst", which must be exactly as long as
+ * the original string.  The data is checked as it is expanded, so that
+ * damaged data cannot cause writes outside the buffer.
+ *
+ * @param  src  The compressed data.
+ * @param  len  The length of the compressed data.
+ * @param  dst  The buffer to hold the original string.
+ * @param  size  The length of the original string.
+ * @return  0 if the data expanded to exactly "size" bytes, otherwise -1.
+ */
+int lz_decompress(char *src, size_t len, char *dst, size_t size) {
+    unsigned char *in = (unsigned char *) src;
+    unsigned char *end = in + len;
+    unsigned char *out = (unsigned char *) dst;
+    unsigned char *limit = out + size;
+
+    while(in < end)
+    {
+        unsigned token = *in++;
+        size_t nlit = token >> 4;
+        if(nlit == 15 && get_length(&in, end, &nlit) < 0)
+            return -1;
+        if(nlit > (size_t) (end - in) || nlit > (size_t) (limit - out))
+            return -1;
+        memcpy(out, in, nlit);
+        in += nlit;
+        out += nlit;
+        if(in == end)
+            break;
+        if(end - in < 2)
+            return -1;
+        size_t offset = in[0] | in[1] << 8;
+        in += 2;
+        size_t mlen = token & 15;
+        if(mlen == 15 && get_length(&in, end, &mlen) < 0)
+            return -1;
+        mlen += MIN_MATCH;
+        if(offset == 0 || offset > (size_t) (out - (unsigned char *) dst)
+           || mlen > (size_t) (limit - out))
+            return -1;
+        unsigned char *from = out - offset;
+        if(offset >= mlen)
+            memcpy(out, from, mlen);
+        else
+        {
+            /* The copy overlaps its own output, as for a repeated pattern. */
+            for(size_t k = 0; k < mlen; k++)
+                out[k] = from[k];
+        }
+        out += mlen;
+    }
+    return out == limit ? 0 : -1;
+}
@@ -8,7 +8,18 @@
 #include <setjmp.h>
 #include <signal.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <regex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define X86_KERNELS
+#endif
 
 #include "mush.h"
 #include "mush.tab.h"
@@ -19,10 +30,14 @@
  */
 
 extern int yylex_destroy();
+extern __thread FILE *yyin;
 extern void push_input(FILE *in);
 extern int pop_input(void);
 extern int input_depth(void);
-extern STMT *mush_parsed_stmt;
+extern __thread STMT *mush_parsed_stmt;
+extern __thread int mush_parse_errors;
+extern __thread int mush_parse_quiet;
+extern int yyparse();
 
 static int exec_run();
 static int exec_cont();
@@ -44,47 +59,157 @@ static void handler(int sig) {
 
 /*
  * Target for longjmp() to jump to after a low-level error has
- * occurred, e.g. in expression evaluation.
+ * occurred, e.g. in expression evaluation.  This, like the rest of the
+ * state of the execution engine, is kept per thread, so that a process
+ * can host an interpreter on each of several threads.
+ */
+static __thread jmp_buf onerror;
+
+/*
+ * Nonzero while "onerror" is set to return control to the run loop of a
+ * program (see exec_cont()) or to a compiled program (see exec_arm()), so
+ * that the statements it executes need not each call setjmp() again; an
+ * error in any of them stops the program just as it would if the statement
+ * had returned -1.  Only a group of foreground statements sets a handler of
+ * its own meanwhile, to clean up after the jobs it has started.
+ */
+static __thread int onerror_armed;
+
+/*
+ * State of a "for" loop that is currently active.
+ * The induction variable is kept here as a native integer while the loop
+ * runs, and it is only written to the data store when something actually
+ * looks at it (see loop_sync()).  While "synced" is set, the data store holds
+ * the current value, and it is re-read at the next "next" in case the body
+ * assigned to the variable.  The position of the first statement of the body
+ * is saved when the loop is entered, so that "next" can jump back without
+ * searching the program store.
+ */
+typedef struct loop_frame {
+    char *name;
+    long value;
+    long limit;
+    long step;
+    int synced;
+    int lineno;
+    int epoch;
+    PROG_POS body;
+} LOOP_FRAME;
+
+/*
+ * Scratch storage for the intermediate strings produced while evaluating
+ * the expressions of a single statement.  Space is handed out of a chunk
+ * by advancing an offset, and all of it is given back at once when the
+ * next statement starts, so evaluation never has to malloc() and free()
+ * individual results.  Only the newest (and largest) chunk is kept across
+ * statements.
+ */
+#define SCRATCH_SIZE 4096
+
+typedef struct scratch_chunk {
+    struct scratch_chunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+} SCRATCH_CHUNK;
+
+static __thread SCRATCH_CHUNK *scratch;
+
+static char *scratch_alloc(size_t n);
+static void scratch_reset(void);
+static char *eval_function(EXPR *expr);
+static int is_self_concat(char *name, EXPR *expr);
+static int uses_variable(EXPR *expr, char *name);
+static void exec_append(char *name, EXPR *expr);
+static int exec_read(STMT *stmt);
+static int exec_set_element(STMT *stmt);
+static int exec_pop(STMT *stmt);
+static int exec_keys(STMT *stmt);
+static int exec_split(STMT *stmt);
+static long eval_index(EXPR *expr);
+static char *eval_element(EXPR *expr);
+static long eval_element_numeric(EXPR *expr);
+static int element_exists(EXPR *expr);
+static long eval_aggregate(EXPR *expr);
+static int exec_array_function(char *name, EXPR *expr);
+static int string_contains(char *str, char *sub);
+static int string_matches(char *str, char *pattern);
+static char *array_to_string(char *name, long len);
+static char *map_to_string(char *name);
+static int exec_write(STMT *stmt);
+static int exec_import(STMT *stmt);
+static int exec_save(STMT *stmt);
+static int exec_restore(STMT *stmt);
+static char *read_all(int fd, size_t *lenp);
+
+static __thread LOOP_FRAME *loops;
+static __thread int nloops, maxloops;
+
+static void loop_sync(char *name);
+static void loop_sync_exported(void);
+static void loop_flush(void);
+static LOOP_FRAME *loop_push(void);
+static void loop_pop(int n);
+static void loop_save(FILE *f);
+static int loop_restore(SNAP *snap);
+static int exec_for(STMT *stmt);
+static int exec_next(STMT *stmt);
+static void exec_fg_finish(PIPELINE *pp, int job);
+static int exec_fg_group(STMT *stmt, long limit);
+static int var_numeric(char *name, int count, long *valp);
+static int exec_jit(JIT_REGION *rp, int check);
+static int exec_stmt_body(STMT *stmt);
+
+/*
+ * Execute a statement without a line number, as if it had been read at
+ * top level, but leave it to the caller, who may execute it again.
+ */
+void exec_immediate(STMT *stmt) {
+    if(stmt->class == RUN_STMT_CLASS)
+	exec_run();
+    else if(stmt->class == CONT_STMT_CLASS)
+	exec_cont();
+    else
+	exec_stmt(stmt);
+}
+
+/*
+ * Handle a statement read at top level: insert it into the program if it
+ * has a line number, otherwise execute it immediately.  The statement is
+ * either taken over by the program store or freed.
  */
-static jmp_buf onerror;
+static void exec_toplevel(STMT *stmt) {
+    if(stmt->lineno) {
+	prog_insert(stmt);
+    } else {
+	exec_immediate(stmt);
+	free_stmt(stmt);
+    }
+}
 
 /*
  * Top-level interpreter loop.
- * Reads single statements from stdin and either inserts them into the program,
+ * Reads single statements from the input (stdin, unless "yyin" has been
+ * set to some other stream) and either inserts them into the program,
  * if they have a line number, otherwise executes them immediately.
+ * A prompt is only shown when the input is a terminal.
  */
 int exec_interactive() {
     signal(SIGQUIT, SIG_IGN);
+    int tty = isatty(fileno(yyin ? yyin : stdin));
     while(1) {
-	if(!input_depth() && isatty(fileno(stdin)))
+	if(!input_depth() && tty)
 	    fprintf(stdout, "%s", PROMPT);
 	fflush(stdout);
 	if(!yyparse()) {
 	    STMT *stmt = mush_parsed_stmt;
-	    if(stmt != NULL) {
-		if(stmt->lineno) {
-		    prog_insert(stmt);
-		} else {
-		    if(stmt->class == RUN_STMT_CLASS) {
-			free_stmt(stmt);
-			stmt = NULL;
-			exec_run();
-		    } else if(stmt->class == CONT_STMT_CLASS) {
-			free_stmt(stmt);
-			stmt = NULL;
-			exec_cont();
-		    } else {
-			exec_stmt(stmt);
-			free_stmt(stmt);
-			stmt = NULL;
-		    }
-		}
-	    }
+	    if(stmt != NULL)
+		exec_toplevel(stmt);
 	} else {
 	    if(pop_input())
 		break;
 	}
-	if(!input_depth() && isatty(fileno(stdin))) {
+	if(!input_depth() && tty) {
 	    store_show(stderr);
 	    fprintf(stderr, "\n");
 	    jobs_show(stderr);
@@ -94,11 +219,77 @@ int exec_interactive() {
     return 0;
 }
 
+/*
+ * Run a script that has already been parsed, as exec_interactive() would
+ * run it if it read the same statements.  The statements are taken over,
+ * as if they had just been parsed.
+ */
+int exec_script(STMT **stmts, long n) {
+    signal(SIGQUIT, SIG_IGN);
+    for(long i = 0; i < n; i++) {
+	fflush(stdout);
+	if(stmts[i] != NULL)
+	    exec_toplevel(stmts[i]);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+/*
+ * Parse a whole script into a vector of statements, ahead of running it.
+ * NULL is returned if the script has syntax errors or uses "source", or
+ * cannot be parsed for any other reason.  Syntax errors are only reported
+ * if "quiet" is zero.
+ */
+STMT **exec_parse(char *text, size_t len, int quiet, long *np) {
+    long n = 0, size = 16;
+    STMT **stmts = (STMT **) malloc(size * sizeof(STMT *));
+    int ok = stmts != NULL && len > 0;
+    FILE *in = ok ? fmemopen(text, len, "r") : NULL;
+
+    if(in == NULL) {
+	free(stmts);
+	return NULL;
+    }
+    mush_parse_quiet = quiet;
+    mush_parse_errors = 0;
+    yyin = in;
+    while(!yyparse()) {
+	STMT *stmt = mush_parsed_stmt;
+	if(stmt == NULL)
+	    continue;
+	if(stmt->class == SOURCE_STMT_CLASS)
+	    ok = 0;
+	if(n == size) {
+	    STMT **nstmts = realloc(stmts, (size *= 2) * sizeof(STMT *));
+	    if(nstmts == NULL) {
+		free_stmt(stmt);
+		ok = 0;
+		break;
+	    }
+	    stmts = nstmts;
+	}
+	stmts[n++] = stmt;
+    }
+    yylex_destroy();
+    fclose(in);
+    mush_parse_quiet = 0;
+    if(!ok || mush_parse_errors > 0) {
+	while(n > 0)
+	    free_stmt(stmts[--n]);
+	free(stmts);
+	return NULL;
+    }
+    *np = n;
+    return stmts;
+}
+
 /*
  * Enter an execution loop starting at the beginning of the program.
  */
 static int exec_run() {
     prog_reset();
+    loop_pop(0);
     return exec_cont();
 }
 
@@ -107,33 +298,339 @@ static int exec_run() {
  */
 static int exec_cont() {
     int err = 0;
+    long jit = 0;
     STMT *stmt;
+    JIT_REGION *rp;
     stmt = prog_fetch();
     if(stmt == NULL) {
 	fprintf(stderr, "No statement to execute\n");
 	return -1;
     }
-    if(setjmp(onerror))
-	return -1;
+    if(store_get_int(JIT_VAR, &jit))
+	jit = 0;
     signal(SIGQUIT, handler);
-    while(!got_quit) {
-	stmt = prog_fetch();
-	if(!stmt) {
-	    fprintf(stderr, "STOP (end of program)\n");
-	    break;
+    onerror_armed = 1;
+    if(setjmp(onerror)) {
+	/* A statement failed, which stops the program as a -1 return does. */
+	err = -1;
+    } else {
+	while(!got_quit) {
+	    stmt = prog_fetch();
+	    if(!stmt) {
+		fprintf(stderr, "STOP (end of program)\n");
+		break;
+	    }
+	    if(jit > 0 && (rp = jit_lookup(stmt, &got_quit)) != NULL) {
+		err = exec_jit(rp, jit > 1);
+	    } else {
+		prog_next();
+		err = exec_step(stmt);
+	    }
+	    if(err)
+		break;
 	}
-	prog_next();
-	err = exec_stmt(stmt);
-	if(err)
-	    break;
     }
+    onerror_armed = 0;
     signal(SIGQUIT, SIG_IGN);
+    loop_flush();
     if(got_quit)
 	fprintf(stderr, "Quit!\n");
     got_quit = 0;
     return err;
 }
 
+/*
+ * Specialized form of a statement of a running program.  Once a "set" of
+ * a number, an "if" or a "goto" has been executed, the shapes that occur
+ * most in loops are recognized and the statement is given a form in which
+ * its variables are resolved to references into the data store and its
+ * target to a position in the program, so that later executions need not
+ * evaluate its expression tree or search for names and line numbers.
+ * The form is only used while the program and the variables of the store
+ * are the ones it was made for, and while the variables that it reads hold
+ * integers; otherwise the statement is executed in the general way, which
+ * also takes care of reporting any errors.
+ */
+typedef enum {
+    QUICK_NONE,                 // Statement of a shape that is not specialized
+    QUICK_SET,                  // "set" of an operand, or of two combined
+    QUICK_IF,                   // "if" on an operand, or two compared
+    QUICK_GOTO
+} QUICK_KIND;
+
+/* An integer literal, or a variable if "name" is not NULL. */
+typedef struct quick_operand {
+    char *name;
+    STORE_REF ref;
+    long imm;
+} QUICK_OPERAND;
+
+typedef struct quick {
+    QUICK_KIND kind;
+    int epoch;                  // Value of prog_epoch() when made
+    long generation;            // Value of store_generation() when made
+    OPRTR oprtr;                // NO_OPRTR if there is only one operand
+    QUICK_OPERAND args[2];
+    STORE_REF target;           // Variable set by "set"
+    PROG_POS dest;              // Position jumped to by "if" and "goto"
+} QUICK;
+
+/*
+ * Resolve an expression that is an integer literal or a numeric variable.
+ */
+static int quick_operand(EXPR *expr, QUICK_OPERAND *op) {
+    char *endp;
+    if(expr->class == LIT_EXPR_CLASS) {
+	op->name = NULL;
+	op->imm = strtol(expr->members.value, &endp, 0);
+	return *endp == '\0' ? 0 : -1;
+    }
+    if(expr->class == NUM_EXPR_CLASS) {
+	op->name = expr->members.variable;
+	op->ref = store_ref(op->name);
+	return op->ref ? 0 : -1;
+    }
+    return -1;
+}
+
+/*
+ * Resolve an expression that is an operand, or two operands combined by
+ * an operator that cannot fail.
+ */
+static int quick_expr(EXPR *expr, QUICK *q) {
+    q->oprtr = NO_OPRTR;
+    if(expr->class != BINARY_EXPR_CLASS)
+	return quick_operand(expr, &q->args[0]);
+    switch(expr->members.binary_expr.oprtr) {
+    case EQUAL_OPRTR:
+	if(expr->members.binary_expr.arg1->type != NUM_VALUE_TYPE
+	   || expr->members.binary_expr.arg2->type != NUM_VALUE_TYPE)
+	    return -1;
+	/* FALLTHROUGH */
+    case PLUS_OPRTR: case MINUS_OPRTR: case TIMES_OPRTR: case LESS_OPRTR:
+    case GREATER_OPRTR: case LESSEQ_OPRTR: case GREATEQ_OPRTR:
+	q->oprtr = expr->members.binary_expr.oprtr;
+	if(quick_operand(expr->members.binary_expr.arg1, &q->args[0])
+	   || quick_operand(expr->members.binary_expr.arg2, &q->args[1]))
+	    return -1;
+	return 0;
+    default:
+	return -1;
+    }
+}
+
+/*
+ * Find the position of a line of the program, leaving the program counter
+ * where it was.
+ */
+static PROG_POS quick_dest(int lineno) {
+    PROG_POS here = prog_tell(), dest = NULL;
+    if(prog_goto(lineno))
+	dest = prog_tell();
+    prog_seek(here);
+    return dest;
+}
+
+/*
+ * Make the specialized form of a statement that has just been executed.
+ */
+static QUICK *quicken(STMT *stmt) {
+    QUICK *q = (QUICK *) calloc(1, sizeof(QUICK));
+    if(q == NULL)
+	return NULL;
+    q->epoch = prog_epoch();
+    q->generation = store_generation();
+    switch(stmt->class) {
+    case SET_STMT_CLASS:
+	if(stmt->members.set_stmt.index == NULL
+	   && stmt->members.set_stmt.expr->type == NUM_VALUE_TYPE
+	   && !quick_expr(stmt->members.set_stmt.expr, q)
+	   && (q->target = store_ref(stmt->members.set_stmt.name)) != NULL)
+	    q->kind = QUICK_SET;
+	break;
+    case IF_STMT_CLASS:
+	if(!quick_expr(stmt->members.if_stmt.expr, q)
+	   && (q->dest = quick_dest(stmt->members.if_stmt.lineno)) != NULL)
+	    q->kind = QUICK_IF;
+	break;
+    case GOTO_STMT_CLASS:
+	if((q->dest = quick_dest(stmt->members.goto_stmt.lineno)) != NULL)
+	    q->kind = QUICK_GOTO;
+	break;
+    default:
+	break;
+    }
+    if(q->kind == QUICK_NONE)
+	debug("statement %d is not specialized", stmt->lineno);
+    return q;
+}
+
+/*
+ * Get the value of an operand of a specialized statement, returning -1 if
+ * its variable does not hold an integer.
+ */
+static int quick_value(QUICK_OPERAND *op, long *valp) {
+    if(op->name == NULL) {
+	*valp = op->imm;
+	return 0;
+    }
+    loop_sync(op->name);
+    return store_ref_get_int(op->ref, valp);
+}
+
+/*
+ * Execute the specialized form of a statement.  If it cannot be used this
+ * time, then nothing is done and -1 is returned, for the statement to be
+ * executed in the general way.
+ */
+static int exec_quick(STMT *stmt, QUICK *q) {
+    long opr1, opr2 = 0;
+    int val;
+    debug("execute statement %d (specialized)", stmt->lineno);
+    if(q->kind == QUICK_GOTO) {
+	store_sweep();
+	prog_seek(q->dest);
+	return 0;
+    }
+    if(q->kind == QUICK_SET)
+	loop_sync(stmt->members.set_stmt.name);
+    if(quick_value(&q->args[0], &opr1)
+       || (q->oprtr != NO_OPRTR && quick_value(&q->args[1], &opr2)))
+	return -1;
+    store_sweep();
+    switch(q->oprtr) {
+    case PLUS_OPRTR:
+	val = opr1 + opr2;
+	break;
+    case MINUS_OPRTR:
+	val = opr1 - opr2;
+	break;
+    case TIMES_OPRTR:
+	val = opr1 * opr2;
+	break;
+    case LESS_OPRTR:
+	val = opr1 < opr2;
+	break;
+    case GREATER_OPRTR:
+	val = opr1 > opr2;
+	break;
+    case LESSEQ_OPRTR:
+	val = opr1 <= opr2;
+	break;
+    case GREATEQ_OPRTR:
+	val = opr1 >= opr2;
+	break;
+    case EQUAL_OPRTR:
+	val = opr1 == opr2;
+	break;
+    default:
+	val = opr1;
+	break;
+    }
+    if(q->kind == QUICK_SET)
+	store_ref_set_int(q->target, val);
+    else if(val)
+	prog_seek(q->dest);
+    return 0;
+}
+
+/*
+ * Execute a statement of a running program, which has just been passed over
+ * by the program counter, together with any that can run alongside it.
+ * A statement that has been executed before may have a specialized form.
+ */
+int exec_step(STMT *stmt) {
+    long limit;
+    int err, quickable;
+    QUICK *q = stmt->quick;
+    if(q != NULL
+       && (q->epoch != prog_epoch() || q->generation != store_generation())) {
+	free(q);
+	stmt->quick = q = NULL;
+    }
+    if(q != NULL && q->kind != QUICK_NONE && !exec_quick(stmt, q))
+	return 0;
+    if(stmt->class == FG_STMT_CLASS
+       && store_get_int(FG_PARALLEL_VAR, &limit) == 0 && limit > 1)
+	return exec_fg_group(stmt, limit);
+    quickable = q == NULL && stmt->lineno
+	&& (stmt->class == SET_STMT_CLASS || stmt->class == IF_STMT_CLASS
+	    || stmt->class == GOTO_STMT_CLASS);
+    err = exec_stmt(stmt);
+    if(quickable && !err)
+	stmt->quick = quicken(stmt);
+    return err;
+}
+
+/*
+ * Run the machine code for a region of a running program that starts at
+ * the program counter (see the jit module), with its variables brought in
+ * from the data store and their new values written back.  The region is
+ * only entered if every variable it uses is unset or holds an integer;
+ * otherwise, or if the code gives up on a line, that line is left to the
+ * interpreter.  If "check" is set, the interpreter runs the region as well,
+ * from the same starting point, and any difference in where it ends up or
+ * in the values that it sets is reported.  The results of the interpreter
+ * are the ones that are kept.
+ */
+static int exec_jit(JIT_REGION *rp, int check) {
+    long n = jit_nslots(rp), *slots = jit_slots(rp), code, val;
+    char *defined = (char *) (slots + n), *name;
+    STMT *stmt;
+    int err = 0;
+    for(long k = 0; k < n; k++) {
+	name = jit_slot_name(rp, k);
+	loop_sync(name);
+	if(!store_get_int(name, &val)) {
+	    slots[k] = val;
+	    defined[k] = 1;
+	} else if(!store_get_string(name) && store_array_length(name) < 0
+		  && store_map_size(name) < 0) {
+	    defined[k] = 0;
+	} else {
+	    stmt = prog_fetch();
+	    prog_next();
+	    return exec_step(stmt);
+	}
+    }
+    store_sweep();
+    code = jit_run(rp);
+    if(check) {
+	int line = jit_exit_line(rp, code);
+	while(!err && !got_quit && (stmt = prog_fetch()) != NULL
+	      && jit_contains(rp, stmt)) {
+	    prog_next();
+	    err = exec_step(stmt);
+	}
+	if(err || got_quit || line < 0)
+	    return err;
+	stmt = prog_fetch();
+	if((stmt ? stmt->lineno : 0) != line)
+	    fprintf(stderr, "JIT check: left at line %d, not %d\n",
+		    line, stmt ? stmt->lineno : 0);
+	for(long k = 0; k < n; k++) {
+	    name = jit_slot_name(rp, k);
+	    if(jit_slot_written(rp, k) && defined[k]
+	       && (store_get_int(name, &val) || val != slots[k]))
+		fprintf(stderr, "JIT check: %s set to %ld, not %s\n", name,
+			slots[k], store_get_string(name));
+	}
+	return 0;
+    }
+    for(long k = 0; k < n; k++) {
+	if(jit_slot_written(rp, k) && defined[k])
+	    store_set_int(jit_slot_name(rp, k), slots[k]);
+    }
+    if(jit_resume(rp, code))
+	return -1;
+    if(jit_gave_up(code)) {
+	stmt = prog_fetch();
+	prog_next();
+	return exec_step(stmt);
+    }
+    return 0;
+}
+
 /*
  * Execute a statement.
  * This function is called from exec_run().
@@ -145,10 +642,26 @@ static int exec_cont() {
  * Unsuccessful execution returns -1.
  */
 int exec_stmt(STMT *stmt) {
+    int err;
+    if(onerror_armed)
+	return exec_stmt_body(stmt);
+    onerror_armed = 1;
+    if(setjmp(onerror))
+	err = -1;
+    else
+	err = exec_stmt_body(stmt);
+    onerror_armed = 0;
+    return err;
+}
+
+/*
+ * Execute a statement, for exec_stmt(), with "onerror" already set.
+ */
+static int exec_stmt_body(STMT *stmt) {
     int val; char *str;
     FILE *in;
-    if(setjmp(onerror))
-	return -1;
+    scratch_reset();
+    store_sweep();
     if(stmt->lineno)
 	debug("execute statement %d", stmt->lineno);
     switch(stmt->class) {
@@ -167,12 +680,33 @@ int exec_stmt(STMT *stmt) {
 	    return -1;
 	break;
     case SET_STMT_CLASS:
+	loop_sync(stmt->members.set_stmt.name);
+	if(stmt->members.set_stmt.index)
+	    return exec_set_element(stmt);
 	switch(stmt->members.set_stmt.expr->type) {
 	case NUM_VALUE_TYPE:
 	    val = eval_to_numeric(stmt->members.set_stmt.expr);
 	    store_set_int(stmt->members.set_stmt.name, val);
 	    break;
+	case ARRAY_VALUE_TYPE:
+	    return exec_array_function(stmt->members.set_stmt.name,
+				       stmt->members.set_stmt.expr);
 	case STRING_VALUE_TYPE:
+	    if(is_self_concat(stmt->members.set_stmt.name,
+			      stmt->members.set_stmt.expr)
+	       && store_get_string(stmt->members.set_stmt.name)) {
+		/* "set x = $x . ..." extends the value in place. */
+		exec_append(stmt->members.set_stmt.name,
+			    stmt->members.set_stmt.expr);
+		break;
+	    }
+	    if(stmt->members.set_stmt.expr->class == STRING_EXPR_CLASS) {
+		/* "set x = $y" shares a large value instead of copying it. */
+		loop_sync(stmt->members.set_stmt.expr->members.variable);
+		if(!store_copy(stmt->members.set_stmt.name,
+			       stmt->members.set_stmt.expr->members.variable))
+		    break;
+	    }
 	    str = eval_to_string(stmt->members.set_stmt.expr);
 	    store_set_string(stmt->members.set_stmt.name, str);
 	    break;
@@ -180,7 +714,31 @@ int exec_stmt(STMT *stmt) {
 	    break;
 	}
 	break;
+    case APPEND_STMT_CLASS:
+	loop_sync(stmt->members.set_stmt.name);
+	str = eval_to_string(stmt->members.set_stmt.expr);
+	store_append_string(stmt->members.set_stmt.name, str);
+	break;
+    case EXPORT_STMT_CLASS:
+	loop_sync(stmt->members.set_stmt.name);
+	if(stmt->members.set_stmt.expr) {
+	    str = eval_to_string(stmt->members.set_stmt.expr);
+	    store_set_string(stmt->members.set_stmt.name, str);
+	}
+	store_export(stmt->members.set_stmt.name);
+	break;
     case UNSET_STMT_CLASS:
+	loop_sync(stmt->members.unset_stmt.name);
+	if(stmt->members.unset_stmt.index) {
+	    if(store_map_size(stmt->members.unset_stmt.name) < 0) {
+		fprintf(stderr, "Variable %s is not a map\n",
+			stmt->members.unset_stmt.name);
+		return -1;
+	    }
+	    str = eval_to_string(stmt->members.unset_stmt.index);
+	    store_map_delete(stmt->members.unset_stmt.name, str);
+	    break;
+	}
 	store_set_string(stmt->members.unset_stmt.name, NULL);
 	break;
     case IF_STMT_CLASS:
@@ -204,20 +762,13 @@ int exec_stmt(STMT *stmt) {
     case FG_STMT_CLASS:
 	{
 	    PIPELINE *pp = stmt->members.sys_stmt.pipeline;
-	    int job = jobs_run(pp);
-	    store_set_int(JOB_VAR, job);
-	    int status = jobs_wait(job);
-	    store_set_int(STATUS_VAR, status);
-	    if(pp->capture_output) {
-		char *output = jobs_get_output(job);
-		debug("Captured output: '%s'", output);
-		store_set_string(OUTPUT_VAR, output);
-	    }
-	    jobs_expunge(job);
+	    loop_sync_exported();
+	    exec_fg_finish(pp, jobs_run(pp));
 	}
 	break;
     case BG_STMT_CLASS:
 	{
+	    loop_sync_exported();
 	    int job = jobs_run(stmt->members.sys_stmt.pipeline);
 	    store_set_int(JOB_VAR, job);
 	}
@@ -226,10 +777,11 @@ int exec_stmt(STMT *stmt) {
 	{
 	    int job = eval_to_numeric(stmt->members.jobctl_stmt.expr);
 	    int status = jobs_wait(job);
+	    size_t len;
 	    store_set_int(STATUS_VAR, status);
-	    char *output = jobs_get_output(job);
+	    char *output = jobs_release_output(job, &len);
 	    if(output)
-		store_set_string(OUTPUT_VAR, output);
+		store_set_owned(OUTPUT_VAR, output, len);
 	    jobs_expunge(job);
 	}
 	break;
@@ -239,9 +791,10 @@ int exec_stmt(STMT *stmt) {
 	    int status = jobs_poll(job);
 	    store_set_int(STATUS_VAR, status);
 	    if(status >= 0) {
-		char *output = jobs_get_output(job);
+		size_t len;
+		char *output = jobs_release_output(job, &len);
 		if(output)
-		    store_set_string(OUTPUT_VAR, output);
+		    store_set_owned(OUTPUT_VAR, output, len);
 		jobs_expunge(job);
 	    }
 	}
@@ -257,6 +810,32 @@ int exec_stmt(STMT *stmt) {
 	    jobs_pause();
 	}
 	break;
+    case FOR_STMT_CLASS:
+	return exec_for(stmt);
+    case NEXT_STMT_CLASS:
+	return exec_next(stmt);
+    case PUSH_STMT_CLASS:
+	loop_sync(stmt->members.set_stmt.name);
+	return exec_set_element(stmt);
+    case POP_STMT_CLASS:
+	return exec_pop(stmt);
+    case KEYS_STMT_CLASS:
+	return exec_keys(stmt);
+    case SPLIT_STMT_CLASS:
+	return exec_split(stmt);
+    case READ_STMT_CLASS:
+	return exec_read(stmt);
+    case WRITE_STMT_CLASS:
+	return exec_write(stmt);
+    case IMPORT_STMT_CLASS:
+	return exec_import(stmt);
+    case SAVE_STMT_CLASS:
+	return exec_save(stmt);
+    case RESTORE_STMT_CLASS:
+	return exec_restore(stmt);
+    case CACHE_STMT_CLASS:
+	jobs_show_cache(stdout);
+	break;
     default:
 	fprintf(stderr, "Unknown statement class: %d\n", stmt->class);
 	abort();
@@ -265,114 +844,1366 @@ int exec_stmt(STMT *stmt) {
 }
 
 /*
- * Evaluate an expression, returning an integer result.
- * It is assumed that the jmp_buf onerror has been initialized by the caller
- * with a control point to escape to in case there is an error during evaluation.
+ * Wait for the job running a foreground pipeline, and set JOB, STATUS and
+ * (if its output was captured) OUTPUT from it, as a foreground statement
+ * does once its pipeline has been started.
  */
-long eval_to_numeric(EXPR *expr) {
-    char *endp, *str1, *str2;
-    long opr1, opr2;
-    int err;
-    switch(expr->class) {
-    case LIT_EXPR_CLASS:
-	opr1 = strtol(expr->members.value, &endp, 0);
-	if(*endp == '\0') {
-	    return opr1;
-	} else {
-	    fprintf(stderr, "Literal '%s' is not an integer\n", expr->members.value);
-	    longjmp(onerror, 0);
-	}
-    case STRING_EXPR_CLASS:
-    case NUM_EXPR_CLASS:
-	err = store_get_int(expr->members.variable, &opr1);
-	if(err) {
-	    fprintf(stderr, "Variable %s does not have an integer value\n",
-		    expr->members.variable);
-	    longjmp(onerror, 0);
-	}
-	return opr1;
-	fprintf(stderr, "String variable %s in expression not implemented\n",
-		expr->members.variable);
-	abort();
-    case UNARY_EXPR_CLASS:
-	opr1 = eval_to_numeric(expr->members.unary_expr.arg);
-	switch(expr->members.unary_expr.oprtr) {
-	case NOT_OPRTR:
-	    return opr1 ? 0 : 1;
-	default:
-	    fprintf(stderr, "Unknown unary numeric operator: %d\n",
-		    expr->members.unary_expr.oprtr);
-	    abort();
-	}
-    case BINARY_EXPR_CLASS:
-	if(expr->members.binary_expr.oprtr == EQUAL_OPRTR) {
-	    if(expr->members.binary_expr.arg1->type == NUM_VALUE_TYPE &&
-	       expr->members.binary_expr.arg2->type == NUM_VALUE_TYPE) {
-		opr1 = eval_to_numeric(expr->members.binary_expr.arg1);
-		opr2 = eval_to_numeric(expr->members.binary_expr.arg2);
-		return opr1 == opr2;
-	    } else {
-		str1 = eval_to_string(expr->members.binary_expr.arg1);
-		str2 = eval_to_string(expr->members.binary_expr.arg2);
-		return !strcmp(str1, str2);
-	    }
-	}
-	opr1 = eval_to_numeric(expr->members.binary_expr.arg1);
-	opr2 = eval_to_numeric(expr->members.binary_expr.arg2);
-	switch(expr->members.binary_expr.oprtr) {
-	case AND_OPRTR:
-	    return opr1 && opr2;
-	case OR_OPRTR:
-	    return opr1 || opr2;
-	case PLUS_OPRTR:
-	    return opr1 + opr2;
-	case MINUS_OPRTR:
-	    return opr1 - opr2;
-	case TIMES_OPRTR:
-	    return opr1 * opr2;
-	case DIVIDE_OPRTR:
-	    return opr1 / opr2;
-	case MOD_OPRTR:
-	    return opr1 % opr2;
-	case LESS_OPRTR:
-	    return opr1 < opr2;
-	case GREATER_OPRTR:
-	    return opr1 > opr2;
-	case LESSEQ_OPRTR:
-	    return opr1 <= opr2;
-	case GREATEQ_OPRTR:
-	    return opr1 >= opr2;
-	default:
-	    fprintf(stderr, "Unknown binary numeric operator: %d\n",
-		    expr->members.binary_expr.oprtr);
-	    abort();
+static void exec_fg_finish(PIPELINE *pp, int job) {
+    store_set_int(JOB_VAR, job);
+    int status = jobs_wait(job);
+    store_set_int(STATUS_VAR, status);
+    if(pp->capture_output) {
+	size_t len = 0;
+	char *output = jobs_release_output(job, &len);
+	debug("Captured output: '%s'", output);
+	store_set_owned(OUTPUT_VAR, output, len);
+    }
+    jobs_expunge(job);
+}
+
+/*
+ * Determine whether a file is named as a literal argument to one of the
+ * commands of a pipeline.
+ */
+static int names_arg(PIPELINE *pp, char *file) {
+    if(file == NULL)
+	return 0;
+    for(COMMAND *cp = pp->commands; cp; cp = cp->next) {
+	for(ARG *ap = cp->args; ap; ap = ap->next) {
+	    if(ap->expr->class == LIT_EXPR_CLASS
+	       && !strcmp(ap->expr->members.value, file))
+		return 1;
 	}
-    default:
-	fprintf(stderr, "Unknown expression class: %d\n", expr->class);
-	abort();
     }
     return 0;
 }
 
 /*
- * Evaluate an expression, returning a string result.
- * It is assumed that the jmp_buf onerror has been initialized by the caller
- * with a control point to escape to in case there is an error during evaluation.
+ * Determine whether a pipeline names a file, as the target of a redirection
+ * or as a literal argument to one of its commands.
+ */
+static int names_file(PIPELINE *pp, char *file) {
+    if(file == NULL)
+	return 0;
+    if((pp->input_file && !strcmp(pp->input_file, file))
+       || (pp->output_file && !strcmp(pp->output_file, file)))
+	return 1;
+    return names_arg(pp, file);
+}
+
+/*
+ * Determine whether a foreground statement can be run at the same time as
+ * the foreground statements just before it in the program, with the same
+ * results as running them one after another.  The only variables that a
+ * foreground statement sets are JOB, STATUS and OUTPUT, so it must not use
+ * those in its arguments, and each pipeline must not name a file that
+ * another one redirects its output to, nor pass as an argument a file
+ * that another one redirects its input from.  Several may read one file.  The output of
+ * at most one of them may go to the terminal, so that output is not
+ * interleaved, and likewise at most one of them may read the standard
+ * input of mush, so that one reads it to the end before the next starts,
+ * as it would if they ran one at a time.  Cached pipelines, whose keys are
+ * evaluated here rather than in the children, are left to run on their
+ * own.  Files that commands open by names they have computed are beyond
+ * this analysis.  The standard error output of the pipelines is shared,
+ * so any diagnostics of the statements of a group may be interleaved.
+ */
+static int fg_independent(STMT **group, int n, STMT *stmt) {
+    if(stmt == NULL || stmt->class != FG_STMT_CLASS)
+	return 0;
+    PIPELINE *pp = stmt->members.sys_stmt.pipeline;
+    int to_terminal = !pp->capture_output && !pp->output_file;
+    int from_terminal = !pp->input_file;
+    if(pp->cached)
+	return 0;
+    for(COMMAND *cp = pp->commands; cp; cp = cp->next) {
+	for(ARG *ap = cp->args; ap; ap = ap->next) {
+	    if(uses_variable(ap->expr, JOB_VAR)
+	       || uses_variable(ap->expr, STATUS_VAR)
+	       || uses_variable(ap->expr, OUTPUT_VAR))
+		return 0;
+	}
+    }
+    for(int i = 0; i < n; i++) {
+	PIPELINE *prev = group[i]->members.sys_stmt.pipeline;
+	if(names_file(pp, prev->output_file) || names_file(prev, pp->output_file)
+	   || names_arg(pp, prev->input_file) || names_arg(prev, pp->input_file))
+	    return 0;
+	if(to_terminal && !prev->capture_output && !prev->output_file)
+	    return 0;
+	if(from_terminal && !prev->input_file)
+	    return 0;
+    }
+    return 1;
+}
+
+/*
+ * Execute a foreground statement of a running program together with as
+ * many of the statements that follow it as are independent of it and of
+ * each other (see fg_independent()), up to a limit.  All of the pipelines
+ * are started first, and then each is waited for in turn, with JOB,
+ * STATUS and OUTPUT set in the order of the statements, so that the
+ * program finds them just as it would have had the statements run one at
+ * a time.  The statements are passed over by the program counter as they
+ * are taken into the group.
+ */
+#define MAX_FG_GROUP 64
+
+static int exec_fg_group(STMT *stmt, long limit) {
+    STMT *group[MAX_FG_GROUP];
+    PROG_POS after[MAX_FG_GROUP];
+    volatile int jobs[MAX_FG_GROUP];
+    volatile int started = 0, finished = 0;
+    volatile int n = 0;
+    jmp_buf saved;
+    if(limit > MAX_FG_GROUP)
+	limit = MAX_FG_GROUP;
+    /* A child could see the value of an exported variable before it is set. */
+    if(store_exported(JOB_VAR) || store_exported(STATUS_VAR)
+       || store_exported(OUTPUT_VAR) || stmt->members.sys_stmt.pipeline->cached)
+	limit = 1;
+    group[n++] = stmt;
+    while(n < limit && fg_independent(group, n, prog_fetch())) {
+	after[n-1] = prog_tell();
+	group[n++] = prog_fetch();
+	prog_next();
+    }
+    if(n == 1)
+	return exec_stmt(stmt);
+    after[n-1] = prog_tell();
+
+    /*
+     * If starting or finishing the job of a statement fails, the jobs
+     * already started are waited for and discarded, and the program
+     * counter is left just after that statement, where it would have been
+     * had the statements run one at a time.
+     */
+    pid_t self = getpid();
+    memcpy(saved, onerror, sizeof(jmp_buf));
+    if(setjmp(onerror)) {
+	memcpy(onerror, saved, sizeof(jmp_buf));
+	if(getpid() != self) {
+	    /* An error in a child evaluating its arguments is its own. */
+	    if(onerror_armed)
+		longjmp(onerror, 0);
+	    return -1;
+	}
+	int failed = started < n ? started : finished;
+	for(int i = finished; i < started; i++) {
+	    jobs_wait(jobs[i]);
+	    jobs_expunge(jobs[i]);
+	}
+	prog_seek(after[failed]);
+	return -1;
+    }
+    scratch_reset();
+    store_sweep();
+    loop_sync_exported();
+    debug("run statements %d to %d together", stmt->lineno, group[n-1]->lineno);
+    for(; started < n; started++)
+	jobs[started] = jobs_run(group[started]->members.sys_stmt.pipeline);
+    for(; finished < n; finished++)
+	exec_fg_finish(group[finished]->members.sys_stmt.pipeline,
+		       jobs[finished]);
+    memcpy(onerror, saved, sizeof(jmp_buf));
+    return 0;
+}
+
+/*
+ * Execute a "for" statement.
+ * The bounds are evaluated once, on entry to the loop.  Entering a loop
+ * discards any active loops nested inside an earlier loop on the same
+ * variable.  If the loop would run zero times, execution continues after
+ * the matching "next".
+ */
+static int exec_for(STMT *stmt) {
+    char *name = stmt->members.for_stmt.name;
+    long from, limit, step = 1;
+    if(!stmt->lineno) {
+	fprintf(stderr, "FOR is only allowed in a program\n");
+	return -1;
+    }
+    from = eval_to_numeric(stmt->members.for_stmt.from);
+    limit = eval_to_numeric(stmt->members.for_stmt.to);
+    if(stmt->members.for_stmt.step)
+	step = eval_to_numeric(stmt->members.for_stmt.step);
+    if(step == 0) {
+	fprintf(stderr, "FOR step must not be zero\n");
+	return -1;
+    }
+    for(int i = nloops - 1; i >= 0; i--) {
+	if(!strcmp(loops[i].name, name)) {
+	    loop_pop(i);
+	    break;
+	}
+    }
+    if(step > 0 ? from > limit : from < limit) {
+	/* Skip the body, including any loops nested within it. */
+	int depth = 0;
+	STMT *next;
+	store_set_int(name, from);
+	while((next = prog_fetch()) != NULL) {
+	    prog_next();
+	    if(next->class == FOR_STMT_CLASS) {
+		depth++;
+	    } else if(next->class == NEXT_STMT_CLASS) {
+		if(depth == 0 && (!next->members.next_stmt.name
+				  || !strcmp(next->members.next_stmt.name, name)))
+		    break;
+		if(depth > 0)
+		    depth--;
+	    }
+	}
+	return 0;
+    }
+    char *copy = strdup(name);
+    LOOP_FRAME *lp = copy ? loop_push() : NULL;
+    if(lp == NULL) {
+	free(copy);
+	fprintf(stderr, "Not enough memory to enter FOR loop\n");
+	return -1;
+    }
+    lp->name = copy;
+    lp->value = from;
+    lp->limit = limit;
+    lp->step = step;
+    lp->synced = 0;
+    lp->lineno = stmt->lineno;
+    lp->epoch = prog_epoch();
+    lp->body = prog_tell();
+    return 0;
+}
+
+/*
+ * Execute a "next" statement.
+ * The induction variable of the innermost loop (or of the innermost loop
+ * on the named variable, discarding any loops inside it) is advanced,
+ * and if the limit has not been passed, control returns to the first
+ * statement of the loop body.
+ */
+static int exec_next(STMT *stmt) {
+    char *name = stmt->members.next_stmt.name;
+    LOOP_FRAME *lp;
+    int i = nloops - 1;
+    if(name) {
+	while(i >= 0 && strcmp(loops[i].name, name))
+	    i--;
+    }
+    if(i < 0) {
+	fprintf(stderr, "NEXT without FOR\n");
+	return -1;
+    }
+    loop_pop(i + 1);
+    lp = &loops[i];
+    if(lp->synced) {
+	if(store_get_int(lp->name, &lp->value)) {
+	    fprintf(stderr, "Variable %s does not have an integer value\n",
+		    lp->name);
+	    return -1;
+	}
+	lp->synced = 0;
+    }
+    lp->value += lp->step;
+    if(lp->step > 0 ? lp->value > lp->limit : lp->value < lp->limit) {
+	loop_pop(i);
+	return 0;
+    }
+    if(lp->epoch == prog_epoch()) {
+	prog_seek(lp->body);
+    } else {
+	/* The program was edited since the loop was entered. */
+	if(!prog_goto(lp->lineno)) {
+	    fprintf(stderr, "FOR statement at line %d no longer exists\n",
+		    lp->lineno);
+	    return -1;
+	}
+	prog_next();
+	lp->epoch = prog_epoch();
+	lp->body = prog_tell();
+    }
+    return 0;
+}
+
+/*
+ * Determine whether an expression has the form "$name . e1 . e2 ...",
+ * where none of e1, e2, ... refer to the variable, so that assigning it
+ * to the variable is the same as appending e1, e2, ... in turn.
+ */
+static int is_self_concat(char *name, EXPR *expr) {
+    if(expr->class == STRING_EXPR_CLASS || expr->class == NUM_EXPR_CLASS)
+	return !strcmp(expr->members.variable, name);
+    if(expr->class != BINARY_EXPR_CLASS
+       || expr->members.binary_expr.oprtr != CONCAT_OPRTR)
+	return 0;
+    return is_self_concat(name, expr->members.binary_expr.arg1)
+	&& !uses_variable(expr->members.binary_expr.arg2, name);
+}
+
+/*
+ * Determine whether an expression refers to a variable.
+ */
+static int uses_variable(EXPR *expr, char *name) {
+    switch(expr->class) {
+    case NUM_EXPR_CLASS:
+    case STRING_EXPR_CLASS:
+	return !strcmp(expr->members.variable, name);
+    case UNARY_EXPR_CLASS:
+	return uses_variable(expr->members.unary_expr.arg, name);
+    case BINARY_EXPR_CLASS:
+	return uses_variable(expr->members.binary_expr.arg1, name)
+	    || uses_variable(expr->members.binary_expr.arg2, name);
+    case FUNC_EXPR_CLASS:
+	for(ARG *ap = expr->members.func_expr.args; ap; ap = ap->next) {
+	    if(uses_variable(ap->expr, name))
+		return 1;
+	}
+	return 0;
+    case INDEX_EXPR_CLASS:
+	return !strcmp(expr->members.index_expr.variable, name)
+	    || uses_variable(expr->members.index_expr.index, name);
+    default:
+	return 0;
+    }
+}
+
+/*
+ * Evaluate the operands of an expression accepted by is_self_concat()
+ * that follow the variable, joined together in scratch storage.
+ */
+static char *eval_appended(EXPR *expr) {
+    char *head, *tail, *result;
+    size_t len1, len2;
+    if(expr->class != BINARY_EXPR_CLASS)
+	return "";
+    head = eval_appended(expr->members.binary_expr.arg1);
+    tail = eval_to_string(expr->members.binary_expr.arg2);
+    len1 = strlen(head);
+    len2 = strlen(tail);
+    result = scratch_alloc(len1 + len2 + 1);
+    memcpy(result, head, len1);
+    memcpy(result + len1, tail, len2 + 1);
+    return result;
+}
+
+/*
+ * Append the operands of an expression accepted by is_self_concat()
+ * to the value of the variable.  They are all evaluated first, so that
+ * the variable is left as it was if any of them cannot be.
+ */
+static void exec_append(char *name, EXPR *expr) {
+    store_append_string(name, eval_appended(expr));
+}
+
+/*
+ * Execute a "set" statement that assigns to an element of an array, or a
+ * "push" statement, which assigns to the element just past the end.
+ * A variable with no value becomes an empty array when first assigned to
+ * in this way.
+ */
+static int exec_set_element(STMT *stmt) {
+    char *name = stmt->members.set_stmt.name;
+    EXPR *expr = stmt->members.set_stmt.expr;
+    EXPR *index_expr = stmt->members.set_stmt.index;
+    long len = store_array_length(name);
+    long index;
+    int err;
+
+    if(index_expr && (store_map_size(name) >= 0
+		      || (len < 0 && index_expr->type == STRING_VALUE_TYPE
+			  && !store_get_string(name)))) {
+	/* A string index makes a variable with no value into a map. */
+	char *key = eval_to_string(index_expr);
+	if(expr->type == NUM_VALUE_TYPE)
+	    err = store_map_set_int(name, key, eval_to_numeric(expr));
+	else
+	    err = store_map_set_string(name, key, eval_to_string(expr));
+	return err ? -1 : 0;
+    }
+    if(len < 0) {
+	if(store_get_string(name)) {
+	    fprintf(stderr, "Variable %s is not an array\n", name);
+	    return -1;
+	}
+	len = 0;
+    }
+    index = index_expr ? eval_to_numeric(index_expr) : len;
+    if(index < 0 || index > len) {
+	fprintf(stderr, "Index %ld is out of range for array %s\n",
+		index, name);
+	return -1;
+    }
+    if(expr->type == NUM_VALUE_TYPE)
+	err = store_array_set_int(name, index, eval_to_numeric(expr));
+    else
+	err = store_array_set_string(name, index, eval_to_string(expr));
+    return err ? -1 : 0;
+}
+
+/*
+ * Execute a "pop" statement, which removes the last element of an array
+ * and optionally assigns it to a variable.
+ */
+static int exec_pop(STMT *stmt) {
+    char *name = stmt->members.pop_stmt.name;
+    char *target = stmt->members.pop_stmt.target;
+    long len = store_array_length(name);
+    char *str = NULL;
+
+    if(len <= 0) {
+	fprintf(stderr, len ? "Variable %s is not an array\n"
+		: "Array %s is empty\n", name);
+	return -1;
+    }
+    if(target) {
+	loop_sync(target);
+	str = strdup(store_array_get_string(name, len - 1));
+    }
+    store_array_pop(name);
+    if(target) {
+	store_set_string(target, str);
+	free(str);
+    }
+    return 0;
+}
+
+/*
+ * Execute a "keys" statement, which sets a variable to an array of the
+ * keys of a map.
+ */
+static int exec_keys(STMT *stmt) {
+    char *name = stmt->members.pop_stmt.name;
+    char *target = stmt->members.pop_stmt.target;
+    long i = 0;
+
+    if(store_map_size(name) < 0) {
+	fprintf(stderr, "Variable %s is not a map\n", name);
+	return -1;
+    }
+    if(!strcmp(name, target)) {
+	fprintf(stderr, "Cannot replace map %s by its keys\n", name);
+	return -1;
+    }
+    loop_sync(target);
+    store_array_clear(target);
+    for(char *key = store_map_next_key(name, NULL); key;
+	key = store_map_next_key(name, key))
+	store_array_set_string(target, i++, key);
+    return 0;
+}
+
+/*
+ * Execute a "split" statement, which sets a variable to an array of the
+ * fields of the value of another variable.  In the delimiter, "\n", "\t"
+ * and "\\" stand for a newline, a tab and a backslash, since these cannot
+ * otherwise be written in a string literal.
+ */
+static int exec_split(STMT *stmt) {
+    char *name = stmt->members.split_stmt.name;
+    char *target = stmt->members.split_stmt.target;
+    char *delim = "", *str, *dp;
+
+    if(stmt->members.split_stmt.delim) {
+	str = eval_to_string(stmt->members.split_stmt.delim);
+	delim = dp = scratch_alloc(strlen(str) + 1);
+	while(*str) {
+	    if(*str == '\\' && str[1]) {
+		str++;
+		*dp++ = *str == 'n' ? '\n' : *str == 't' ? '\t' : *str;
+		str++;
+	    } else {
+		*dp++ = *str++;
+	    }
+	}
+	*dp = '\0';
+    }
+    loop_sync(name);
+    loop_sync(target);
+    if(!(str = store_get_string(name))) {
+	fprintf(stderr, "Variable %s does not have a value\n", name);
+	return -1;
+    }
+    if(store_array_split(target, str, delim,
+			 stmt->members.split_stmt.numeric) < 0) {
+	fprintf(stderr, "Couldn't split variable %s\n", name);
+	return -1;
+    }
+    return 0;
+}
+
+/*
+ * Evaluate the index of an element of an array variable, checking that
+ * the variable is an array and that the index is within its bounds.
+ */
+static long eval_index(EXPR *expr) {
+    char *name = expr->members.index_expr.variable;
+    long index = eval_to_numeric(expr->members.index_expr.index);
+    long len = store_array_length(name);
+    if(len < 0) {
+	fprintf(stderr, "Variable %s is not an array or map\n", name);
+	longjmp(onerror, 0);
+    }
+    if(index < 0 || index >= len) {
+	fprintf(stderr, "Index %ld is out of range for array %s\n",
+		index, name);
+	longjmp(onerror, 0);
+    }
+    return index;
+}
+
+/*
+ * Evaluate an element of an array or map variable as a string.  The result
+ * is copied to scratch storage, since the store may convert integers in a
+ * shared buffer.
+ */
+static char *eval_element(EXPR *expr) {
+    char *name = expr->members.index_expr.variable;
+    char *key, *str, *result;
+    size_t len;
+
+    if(store_map_size(name) >= 0) {
+	key = eval_to_string(expr->members.index_expr.index);
+	if(!(str = store_map_get_string(name, key))) {
+	    fprintf(stderr, "Map %s has no key '%s'\n", name, key);
+	    longjmp(onerror, 0);
+	}
+    } else {
+	str = store_array_get_string(name, eval_index(expr));
+    }
+    len = strlen(str);
+    result = scratch_alloc(len + 1);
+    memcpy(result, str, len + 1);
+    return result;
+}
+
+/*
+ * Evaluate an element of an array or map variable as an integer.
+ */
+static long eval_element_numeric(EXPR *expr) {
+    char *name = expr->members.index_expr.variable;
+    char *key;
+    long val;
+
+    if(store_map_size(name) >= 0) {
+	key = eval_to_string(expr->members.index_expr.index);
+	if(!store_map_get_string(name, key)) {
+	    fprintf(stderr, "Map %s has no key '%s'\n", name, key);
+	    longjmp(onerror, 0);
+	}
+	if(store_map_get_int(name, key, &val)) {
+	    fprintf(stderr, "Value of key '%s' of map %s is not an integer\n",
+		    key, name);
+	    longjmp(onerror, 0);
+	}
+	return val;
+    }
+    long index = eval_index(expr);
+    if(store_array_get_int(name, index, &val)) {
+	fprintf(stderr, "Element %ld of array %s is not an integer\n",
+		index, name);
+	longjmp(onerror, 0);
+    }
+    return val;
+}
+
+/*
+ * Determine whether an element of an array or map variable exists.
+ */
+static int element_exists(EXPR *expr) {
+    char *name = expr->members.index_expr.variable;
+    long len, index;
+
+    if(store_map_size(name) >= 0)
+	return store_map_get_string(name,
+		   eval_to_string(expr->members.index_expr.index)) != NULL;
+    index = eval_to_numeric(expr->members.index_expr.index);
+    len = store_array_length(name);
+    return index >= 0 && index < len;
+}
+
+/*
+ * Evaluate a call of one of the aggregate functions, whose argument names
+ * an array variable.  Elements of the array that are not integers are
+ * ignored.  The mean is rounded toward zero.
+ */
+static long eval_aggregate(EXPR *expr) {
+    char *name = expr->members.func_expr.args->expr->members.variable;
+    OPRTR oprtr = expr->members.func_expr.oprtr;
+    long count, sum, min, max;
+
+    if(store_array_aggregate(name, &count, oprtr == SUM_OPRTR
+			     || oprtr == MEAN_OPRTR ? &sum : NULL,
+			     oprtr == MIN_OPRTR ? &min : NULL,
+			     oprtr == MAX_OPRTR ? &max : NULL)) {
+	fprintf(stderr, "Variable %s is not an array\n", name);
+	longjmp(onerror, 0);
+    }
+    if(count == 0 && oprtr != SUM_OPRTR && oprtr != COUNT_OPRTR) {
+	fprintf(stderr, "Array %s has no integer elements\n", name);
+	longjmp(onerror, 0);
+    }
+    switch(oprtr) {
+    case SUM_OPRTR:
+	return sum;
+    case MIN_OPRTR:
+	return min;
+    case MAX_OPRTR:
+	return max;
+    case MEAN_OPRTR:
+	return sum / count;
+    default:
+	return count;
+    }
+}
+
+/*
+ * Execute "set" with a call of a function whose value is an array or map,
+ * which the data store builds directly in the variable being set.
+ */
+static int exec_array_function(char *name, EXPR *expr) {
+    EXPR *arg = expr->members.func_expr.args->expr;
+    char *src = arg->members.variable;
+    int err;
+
+    loop_sync(src);
+    switch(expr->members.func_expr.oprtr) {
+    case SORT_OPRTR:
+	err = store_array_sort(name, src, arg->class == NUM_EXPR_CLASS);
+	break;
+    case UNIQUE_OPRTR:
+	err = store_array_unique(name, src) < 0;
+	break;
+    default:
+	err = store_array_count(name, src) < 0;
+	break;
+    }
+    if(err) {
+	fprintf(stderr, "Variable %s is not an array\n", src);
+	return -1;
+    }
+    return 0;
+}
+
+/*
+ * Test whether a string contains another.  On x86-64, candidate positions
+ * are found sixteen at a time, by comparing the first and last bytes of
+ * the substring against a block of the string with SSE2 instructions,
+ * and only the candidates are compared in full.
+ */
+static int string_contains(char *str, char *sub) {
+    size_t len = strlen(str), sublen = strlen(sub), i = 0;
+
+    if(sublen <= 1)
+	return sublen == 0 || memchr(str, *sub, len) != NULL;
+    if(sublen > len)
+	return 0;
+#ifdef X86_KERNELS
+    __m128i first = _mm_set1_epi8(sub[0]);
+    __m128i last = _mm_set1_epi8(sub[sublen - 1]);
+    for(; i + sublen - 1 + 16 <= len; i += 16) {
+	__m128i head = _mm_loadu_si128((__m128i *)(str + i));
+	__m128i tail = _mm_loadu_si128((__m128i *)(str + i + sublen - 1));
+	unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+			    _mm_cmpeq_epi8(head, first),
+			    _mm_cmpeq_epi8(tail, last)));
+	while(mask) {
+	    int bit = __builtin_ctz(mask);
+	    if(!memcmp(str + i + bit + 1, sub + 1, sublen - 2))
+		return 1;
+	    mask &= mask - 1;
+	}
+    }
+#endif
+    for(; i + sublen <= len; i++) {
+	if(str[i] == sub[0] && !memcmp(str + i + 1, sub + 1, sublen - 1))
+	    return 1;
+    }
+    return 0;
+}
+
+/*
+ * Compiled regular expressions, kept so that a pattern that is matched
+ * repeatedly, as in a loop, is only compiled once.  When the cache is
+ * full, the pattern that has gone unused the longest is discarded.
+ */
+#define REGEX_CACHE_SIZE 32
+
+static __thread struct regex_entry {
+    char *pattern;
+    regex_t regex;
+    unsigned long last_used;
+} regex_cache[REGEX_CACHE_SIZE];
+
+static __thread unsigned long regex_clock;
+
+static regex_t *compile_pattern(char *pattern) {
+    struct regex_entry *entry = &regex_cache[0];
+    char msg[128];
+    int err;
+
+    for(int i = 0; i < REGEX_CACHE_SIZE; i++) {
+	struct regex_entry *ep = &regex_cache[i];
+	if(ep->pattern && !strcmp(ep->pattern, pattern)) {
+	    ep->last_used = ++regex_clock;
+	    return &ep->regex;
+	}
+	if(ep->last_used < entry->last_used)
+	    entry = ep;
+    }
+    if(entry->pattern) {
+	free(entry->pattern);
+	regfree(&entry->regex);
+	entry->pattern = NULL;
+	entry->last_used = 0;
+    }
+    if((err = regcomp(&entry->regex, pattern, REG_EXTENDED)) != 0) {
+	regerror(err, &entry->regex, msg, sizeof(msg));
+	fprintf(stderr, "Bad pattern '%s': %s\n", pattern, msg);
+	longjmp(onerror, 0);
+    }
+    entry->pattern = strdup(pattern);
+    entry->last_used = ++regex_clock;
+    return &entry->regex;
+}
+
+/*
+ * Match a string against an extended regular expression.  If the
+ * pattern has parenthesized groups, a successful match sets the array
+ * variable MATCH to the text matched by the whole pattern, followed by
+ * the text matched by each group (empty for a group that took no part).
+ */
+#define MAX_GROUPS 10
+
+static int string_matches(char *str, char *pattern) {
+    regex_t *regex = compile_pattern(pattern);
+    regmatch_t groups[MAX_GROUPS];
+    size_t ngroups = regex->re_nsub + 1;
+
+    if(ngroups > MAX_GROUPS)
+	ngroups = MAX_GROUPS;
+    if(regexec(regex, str, regex->re_nsub ? ngroups : 0, groups, 0))
+	return 0;
+    if(regex->re_nsub) {
+	/* The string may be an element of MATCH, so copy the groups first. */
+	char *text[MAX_GROUPS];
+	for(size_t i = 0; i < ngroups; i++) {
+	    regoff_t len = groups[i].rm_so < 0 ? 0
+		: groups[i].rm_eo - groups[i].rm_so;
+	    text[i] = scratch_alloc(len + 1);
+	    memcpy(text[i], str + (len ? groups[i].rm_so : 0), len);
+	    text[i][len] = '\0';
+	}
+	loop_sync("MATCH");
+	store_array_clear("MATCH");
+	for(size_t i = 0; i < ngroups; i++)
+	    store_array_set_string("MATCH", i, text[i]);
+    }
+    return 1;
+}
+
+/*
+ * The string value of an array variable, which is its elements separated
+ * by spaces.
+ */
+static char *array_to_string(char *name, long len) {
+    size_t size = 1, n = 0;
+    for(long i = 0; i < len; i++)
+	size += strlen(store_array_get_string(name, i)) + 1;
+    char *result = scratch_alloc(size);
+    for(long i = 0; i < len; i++) {
+	char *elem = store_array_get_string(name, i);
+	size_t elen = strlen(elem);
+	if(i > 0)
+	    result[n++] = ' ';
+	memcpy(result + n, elem, elen);
+	n += elen;
+    }
+    result[n] = '\0';
+    return result;
+}
+
+/*
+ * The string value of a map variable, which is its entries, in the form
+ * "key=value", separated by spaces.
+ */
+static char *map_to_string(char *name) {
+    size_t total = 1, n = 0;
+    char *key;
+    for(key = store_map_next_key(name, NULL); key;
+	key = store_map_next_key(name, key))
+	total += strlen(key) + strlen(store_map_get_string(name, key)) + 2;
+    char *result = scratch_alloc(total);
+    for(key = store_map_next_key(name, NULL); key;
+	key = store_map_next_key(name, key)) {
+	char *val = store_map_get_string(name, key);
+	n += sprintf(result + n, n ? " %s=%s" : "%s=%s", key, val);
+    }
+    result[n] = '\0';
+    return result;
+}
+
+/*
+ * Execute a "read" statement, which sets a variable to the contents of
+ * a file without running a command to produce them.  A regular file is
+ * mapped into memory and copied straight into the data store; anything
+ * else is read in large blocks.  As for a command, STATUS is set to zero
+ * if the file could be read and nonzero otherwise.
+ */
+#define NO_ROOM "Not enough memory to hold the contents"
+
+static int exec_read(STMT *stmt) {
+    char *name = stmt->members.file_stmt.name;
+    char *file = stmt->members.file_stmt.file;
+    char *error = NO_ROOM;
+    struct stat sb;
+    int status = 1;
+    int fd;
+
+    loop_sync(name);
+    if((fd = open(file, O_RDONLY)) < 0 || fstat(fd, &sb) < 0) {
+	error = strerror(errno);
+	goto out;
+    }
+    if(S_ISREG(sb.st_mode) && sb.st_size > 0) {
+	char *map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(map == MAP_FAILED) {
+	    error = strerror(errno);
+	    goto out;
+	}
+	if(!store_set_buffer(name, map, sb.st_size))
+	    status = 0;
+	munmap(map, sb.st_size);
+    } else {
+	size_t len;
+	char *buf = read_all(fd, &len);
+	if(buf == NULL)
+	    error = strerror(errno);
+	else if(!store_set_buffer(name, buf, len))
+	    status = 0;
+	free(buf);
+    }
+ out:
+    if(status)
+	fprintf(stderr, "read: %s: %s\n", file, error);
+    if(fd >= 0)
+	close(fd);
+    store_set_int(STATUS_VAR, status);
+    return 0;
+}
+
+/*
+ * Read the rest of a file that cannot be mapped, such as a pipe, into a
+ * buffer obtained from malloc().  NULL is returned if an error occurs.
+ */
+static char *read_all(int fd, size_t *lenp) {
+    size_t size = 4096, len = 0;
+    char *buf = malloc(size);
+    ssize_t n = -1;
+    while(buf) {
+	if(len == size) {
+	    char *nbuf = realloc(buf, size *= 2);
+	    if(!nbuf)
+		break;
+	    buf = nbuf;
+	}
+	if((n = read(fd, buf + len, size - len)) > 0)
+	    len += n;
+	else if(n == 0 || errno != EINTR)
+	    break;
+    }
+    if(n != 0) {
+	free(buf);
+	return NULL;
+    }
+    *lenp = len;
+    return buf;
+}
+
+/*
+ * Execute an "import" statement, which sets a variable for each line of
+ * the form "key=value" in a file or in the value of a variable, naming
+ * it by the key with an optional prefix.  A regular file is mapped into
+ * memory and parsed where it lies.  STATUS is set to zero if the whole
+ * file or value was loaded and nonzero otherwise.
+ */
+static int exec_import(STMT *stmt) {
+    char *name = stmt->members.import_stmt.name;
+    char *file = stmt->members.import_stmt.file;
+    char *prefix = stmt->members.import_stmt.prefix;
+    char *error = NO_ROOM;
+    struct stat sb;
+    int status = 1;
+    int fd = -1;
+
+    loop_flush();
+    if(name) {
+	char *str = store_get_string(name);
+	if(!str) {
+	    fprintf(stderr, "Variable %s does not have a value\n", name);
+	    return -1;
+	}
+	/* The value may be replaced by one of the pairs. */
+	str = strdup(str);
+	if(str && store_import(str, strlen(str), prefix) >= 0)
+	    status = 0;
+	free(str);
+	store_set_int(STATUS_VAR, status);
+	return 0;
+    }
+    if((fd = open(file, O_RDONLY)) < 0 || fstat(fd, &sb) < 0) {
+	error = strerror(errno);
+	goto out;
+    }
+    if(S_ISREG(sb.st_mode) && sb.st_size > 0) {
+	char *map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(map == MAP_FAILED) {
+	    error = strerror(errno);
+	    goto out;
+	}
+	madvise(map, sb.st_size, MADV_SEQUENTIAL);
+	if(store_import(map, sb.st_size, prefix) >= 0)
+	    status = 0;
+	munmap(map, sb.st_size);
+    } else {
+	size_t len;
+	char *buf = read_all(fd, &len);
+	if(buf == NULL)
+	    error = strerror(errno);
+	else if(store_import(buf, len, prefix) >= 0)
+	    status = 0;
+	free(buf);
+    }
+ out:
+    if(status)
+	fprintf(stderr, "import: %s: %s\n", file, error);
+    if(fd >= 0)
+	close(fd);
+    store_set_int(STATUS_VAR, status);
+    return 0;
+}
+
+/*
+ * Execute a "save" statement, which writes the whole state of the
+ * interpreter to a snapshot file: the terminated jobs, the program with
+ * the position of the program counter, the data store and the active
+ * loops.  STATUS is set to zero beforehand, so that a program restored
+ * from the snapshot, which resumes just after the "save", sees the same
+ * STATUS as the program that saved it; it is set to nonzero instead if
+ * the snapshot could not be written.
+ */
+static int exec_save(STMT *stmt) {
+    char *file = stmt->members.source_stmt.file;
+    FILE *f;
+
+    loop_flush();
+    store_set_int(STATUS_VAR, 0);
+    if((f = snap_create(file)) != NULL) {
+	jobs_save(f);
+	prog_save(f);
+	store_save(f);
+	loop_save(f);
+	if(!snap_finish(f, file))
+	    return 0;
+    }
+    fprintf(stderr, "save: %s: %s\n", file, strerror(errno));
+    store_set_int(STATUS_VAR, 1);
+    return 0;
+}
+
+/*
+ * Execute a "restore" statement, which replaces the state of the
+ * interpreter with one read from a snapshot file written by "save".
+ * Execution continues from the restored program counter.  If the file
+ * cannot be read, or any jobs are still running, nothing is changed and
+ * STATUS is set to nonzero.  A snapshot that passes its check but still
+ * cannot be decoded may leave the state partly replaced, and stops the
+ * program.
+ */
+static int exec_restore(STMT *stmt) {
+    /* The statement itself may be freed along with the old program. */
+    char *file = strdup(stmt->members.source_stmt.file);
+    int err = 0;
+    size_t size;
+    SNAP snap;
+
+    char *map = snap_open(file, &snap, &size);
+    if(!map) {
+	if(errno)
+	    fprintf(stderr, "restore: %s: %s\n", file, strerror(errno));
+	else
+	    fprintf(stderr, "restore: %s: Not a snapshot\n", file);
+	store_set_int(STATUS_VAR, 1);
+    } else if(jobs_restore(&snap)) {
+	if(!snap.error)
+	    fprintf(stderr, "restore: %s: Jobs are still running\n", file);
+	else
+	    fprintf(stderr, "restore: %s: Damaged snapshot\n", file);
+	store_set_int(STATUS_VAR, 1);
+    } else if(prog_restore(&snap)) {
+	fprintf(stderr, "restore: %s: Damaged snapshot\n", file);
+	store_set_int(STATUS_VAR, 1);
+    } else {
+	loop_pop(0);
+	if(store_restore(&snap) || loop_restore(&snap)) {
+	    fprintf(stderr, "restore: %s: Damaged snapshot\n", file);
+	    err = -1;
+	}
+    }
+    if(map)
+	snap_close(map, size);
+    free(file);
+    return err;
+}
+
+/*
+ * Execute a "write" statement, which writes the value of a variable to
+ * a file, either replacing its contents or (for ">>") appending to them.
+ * STATUS is set to zero if the whole value was written and nonzero
+ * otherwise.
+ */
+static int exec_write(STMT *stmt) {
+    char *name = stmt->members.file_stmt.name;
+    char *file = stmt->members.file_stmt.file;
+    int flags = O_WRONLY | O_CREAT
+	| (stmt->members.file_stmt.append ? O_APPEND : O_TRUNC);
+    int status = 1;
+    int fd;
+
+    loop_sync(name);
+    char *str = store_get_string(name);
+    if(!str) {
+	fprintf(stderr, "Variable %s does not have a value\n", name);
+	return -1;
+    }
+    if((fd = open(file, flags, 0666)) >= 0) {
+	size_t len = strlen(str);
+	ssize_t n = 0;
+	while(len > 0) {
+	    if((n = write(fd, str, len)) > 0) {
+		str += n;
+		len -= n;
+	    } else if(errno != EINTR) {
+		break;
+	    }
+	}
+	if(len == 0)
+	    status = 0;
+	if(close(fd) < 0)
+	    status = 1;
+    }
+    if(status)
+	fprintf(stderr, "write: %s: %s\n", file, strerror(errno));
+    store_set_int(STATUS_VAR, status);
+    return 0;
+}
+
+/*
+ * Make sure the data store holds the current value of a variable,
+ * if it is the induction variable of an active loop.
+ */
+static void loop_sync(char *name) {
+    for(int i = 0; i < nloops; i++) {
+	if(!loops[i].synced && !strcmp(loops[i].name, name)) {
+	    store_set_int(loops[i].name, loops[i].value);
+	    loops[i].synced = 1;
+	}
+    }
+}
+
+/*
+ * Write the values of the active induction variables that are exported
+ * to the data store, so that commands about to be run see them.
+ */
+static void loop_sync_exported(void) {
+    for(int i = 0; i < nloops; i++) {
+	if(!loops[i].synced && store_exported(loops[i].name)) {
+	    store_set_int(loops[i].name, loops[i].value);
+	    loops[i].synced = 1;
+	}
+    }
+}
+
+/*
+ * Write the values of all active induction variables to the data store,
+ * so that it is up to date when execution stops.
+ */
+static void loop_flush(void) {
+    for(int i = 0; i < nloops; i++) {
+	if(!loops[i].synced) {
+	    store_set_int(loops[i].name, loops[i].value);
+	    loops[i].synced = 1;
+	}
+    }
+}
+
+/*
+ * Add a frame for a loop that is entered, returning NULL if there is not
+ * enough memory, in which case the active loops are left as they were.
+ */
+static LOOP_FRAME *loop_push(void) {
+    if(nloops == maxloops) {
+	int n = maxloops ? 2 * maxloops : 8;
+	LOOP_FRAME *nl = realloc(loops, n * sizeof(LOOP_FRAME));
+	if(nl == NULL)
+	    return NULL;
+	loops = nl;
+	maxloops = n;
+    }
+    return &loops[nloops++];
+}
+
+/*
+ * Discard active loops, leaving only the outermost n.
+ * The induction variables of the discarded loops keep their last values.
+ */
+static void loop_pop(int n) {
+    while(nloops > n) {
+	LOOP_FRAME *lp = &loops[--nloops];
+	if(!lp->synced)
+	    store_set_int(lp->name, lp->value);
+	free(lp->name);
+    }
+}
+
+/*
+ * Write the active loops to a snapshot.  The induction variables must
+ * have been written to the data store by loop_flush() beforehand.
+ */
+static void loop_save(FILE *f) {
+    snap_put_num(f, nloops);
+    for(int i = 0; i < nloops; i++) {
+	snap_put_str(f, loops[i].name);
+	snap_put_num(f, loops[i].value);
+	snap_put_num(f, loops[i].limit);
+	snap_put_num(f, loops[i].step);
+	snap_put_num(f, loops[i].lineno);
+    }
+}
+
+/*
+ * Read the active loops written by loop_save(), in place of any that are
+ * active now.  The position of the body of each loop is found again from
+ * the line number of its "for" when its "next" is reached.
+ */
+static int loop_restore(SNAP *snap) {
+    long n = snap_get_num(snap);
+    loop_pop(0);
+    if(n < 0 || n > snap->end - snap->pos)
+	return -1;
+    for(long i = 0; i < n && !snap->error; i++) {
+	char *name = snap_get_str(snap);
+	if(!name)
+	    return -1;
+	LOOP_FRAME *lp = loop_push();
+	if(lp == NULL) {
+	    free(name);
+	    return -1;
+	}
+	lp->name = name;
+	lp->value = snap_get_num(snap);
+	lp->limit = snap_get_num(snap);
+	lp->step = snap_get_num(snap);
+	lp->lineno = snap_get_num(snap);
+	lp->synced = 1;
+	lp->epoch = -1;
+	lp->body = NULL;
+    }
+    return snap->error ? -1 : 0;
+}
+
+/*
+ * Evaluate an expression, returning an integer result.
+ * It is assumed that the jmp_buf onerror has been initialized by the caller
+ * with a control point to escape to in case there is an error during evaluation.
+ */
+long eval_to_numeric(EXPR *expr) {
+    char *endp, *str1, *str2;
+    long opr1, opr2;
+    switch(expr->class) {
+    case LIT_EXPR_CLASS:
+	opr1 = strtol(expr->members.value, &endp, 0);
+	if(*endp == '\0') {
+	    return opr1;
+	} else {
+	    fprintf(stderr, "Literal '%s' is not an integer\n", expr->members.value);
+	    longjmp(onerror, 0);
+	}
+    case STRING_EXPR_CLASS:
+    case NUM_EXPR_CLASS:
+	if(var_numeric(expr->members.variable, expr->class == NUM_EXPR_CLASS,
+		       &opr1))
+	    longjmp(onerror, 0);
+	return opr1;
+    case INDEX_EXPR_CLASS:
+	return eval_element_numeric(expr);
+    case FUNC_EXPR_CLASS:
+	switch(expr->members.func_expr.oprtr) {
+	case LENGTH_OPRTR:
+	    str1 = eval_to_string(expr->members.func_expr.args->expr);
+	    return strlen(str1);
+	case EXISTS_OPRTR:
+	    return element_exists(expr->members.func_expr.args->expr);
+	case SUM_OPRTR:
+	case MIN_OPRTR:
+	case MAX_OPRTR:
+	case COUNT_OPRTR:
+	case MEAN_OPRTR:
+	    return eval_aggregate(expr);
+	case INDEX_OPRTR:
+	    str1 = eval_to_string(expr->members.func_expr.args->expr);
+	    str2 = eval_to_string(expr->members.func_expr.args->next->expr);
+	    endp = strstr(str1, str2);
+	    return endp ? endp - str1 : -1;
+	default:
+	    break;
+	}
+	/* A function with a string value, used as a number. */
+	str1 = eval_function(expr);
+	opr1 = strtol(str1, &endp, 0);
+	if(*str1 == '\0' || *endp != '\0') {
+	    fprintf(stderr, "Value '%s' is not an integer\n", str1);
+	    longjmp(onerror, 0);
+	}
+	return opr1;
+    case UNARY_EXPR_CLASS:
+	opr1 = eval_to_numeric(expr->members.unary_expr.arg);
+	switch(expr->members.unary_expr.oprtr) {
+	case NOT_OPRTR:
+	    return opr1 ? 0 : 1;
+	default:
+	    fprintf(stderr, "Unknown unary numeric operator: %d\n",
+		    expr->members.unary_expr.oprtr);
+	    abort();
+	}
+    case BINARY_EXPR_CLASS:
+	if(expr->members.binary_expr.oprtr == CONCAT_OPRTR) {
+	    str1 = eval_to_string(expr);
+	    opr1 = strtol(str1, &endp, 0);
+	    if(*str1 == '\0' || *endp != '\0') {
+		fprintf(stderr, "Value '%s' is not an integer\n", str1);
+		longjmp(onerror, 0);
+	    }
+	    return opr1;
+	}
+	if(expr->members.binary_expr.oprtr == CONTAINS_OPRTR
+	   || expr->members.binary_expr.oprtr == MATCHES_OPRTR) {
+	    str1 = eval_to_string(expr->members.binary_expr.arg1);
+	    str2 = eval_to_string(expr->members.binary_expr.arg2);
+	    if(expr->members.binary_expr.oprtr == CONTAINS_OPRTR)
+		return string_contains(str1, str2);
+	    return string_matches(str1, str2);
+	}
+	if(expr->members.binary_expr.oprtr == EQUAL_OPRTR) {
+	    if(expr->members.binary_expr.arg1->type == NUM_VALUE_TYPE &&
+	       expr->members.binary_expr.arg2->type == NUM_VALUE_TYPE) {
+		opr1 = eval_to_numeric(expr->members.binary_expr.arg1);
+		opr2 = eval_to_numeric(expr->members.binary_expr.arg2);
+		return opr1 == opr2;
+	    } else {
+		str1 = eval_to_string(expr->members.binary_expr.arg1);
+		str2 = eval_to_string(expr->members.binary_expr.arg2);
+		return !strcmp(str1, str2);
+	    }
+	}
+	opr1 = eval_to_numeric(expr->members.binary_expr.arg1);
+	opr2 = eval_to_numeric(expr->members.binary_expr.arg2);
+	switch(expr->members.binary_expr.oprtr) {
+	case AND_OPRTR:
+	    return opr1 && opr2;
+	case OR_OPRTR:
+	    return opr1 || opr2;
+	case PLUS_OPRTR:
+	    return opr1 + opr2;
+	case MINUS_OPRTR:
+	    return opr1 - opr2;
+	case TIMES_OPRTR:
+	    return opr1 * opr2;
+	case DIVIDE_OPRTR:
+	    return opr1 / opr2;
+	case MOD_OPRTR:
+	    return opr1 % opr2;
+	case LESS_OPRTR:
+	    return opr1 < opr2;
+	case GREATER_OPRTR:
+	    return opr1 > opr2;
+	case LESSEQ_OPRTR:
+	    return opr1 <= opr2;
+	case GREATEQ_OPRTR:
+	    return opr1 >= opr2;
+	default:
+	    fprintf(stderr, "Unknown binary numeric operator: %d\n",
+		    expr->members.binary_expr.oprtr);
+	    abort();
+	}
+    default:
+	fprintf(stderr, "Unknown expression class: %d\n", expr->class);
+	abort();
+    }
+    return 0;
+}
+
+/*
+ * Get the numeric value of a variable.  If "count" is nonzero, then the
+ * value of an array or map is its number of elements.  An error is reported
+ * and -1 is returned if the variable does not have such a value.
+ */
+static int var_numeric(char *name, int count, long *valp) {
+    loop_sync(name);
+    if(!store_get_int(name, valp))
+	return 0;
+    if(count && ((*valp = store_array_length(name)) >= 0
+		 || (*valp = store_map_size(name)) >= 0)) {
+	/* The numeric value of an array or map is its number of elements. */
+	return 0;
+    }
+    fprintf(stderr, "Variable %s does not have an integer value\n", name);
+    return -1;
+}
+
+/*
+ * Evaluate an expression, returning a string result.
+ * It is assumed that the jmp_buf onerror has been initialized by the caller
+ * with a control point to escape to in case there is an error during evaluation.
  */
 char *eval_to_string(EXPR *expr) {
-    char *str1, *str2;
+    char *str1, *str2, *result;
+    size_t len1, len2;
+    long n;
+    if(expr->type == NUM_VALUE_TYPE
+       && expr->class != LIT_EXPR_CLASS && expr->class != NUM_EXPR_CLASS
+       && expr->class != STRING_EXPR_CLASS) {
+	/* The string value of a numeric expression is its decimal form. */
+	result = scratch_alloc(24);
+	sprintf(result, "%ld", eval_to_numeric(expr));
+	return result;
+    }
     switch(expr->class) {
     case LIT_EXPR_CLASS:
 	return expr->members.value;
     case NUM_EXPR_CLASS:
     case STRING_EXPR_CLASS:
+	loop_sync(expr->members.variable);
 	str1 = store_get_string(expr->members.variable);
+	if(!str1 && ((n = store_array_length(expr->members.variable)) >= 0
+		     || (n = store_map_size(expr->members.variable)) >= 0)) {
+	    if(expr->class == NUM_EXPR_CLASS) {
+		result = scratch_alloc(24);
+		sprintf(result, "%ld", n);
+		return result;
+	    }
+	    if(store_map_size(expr->members.variable) >= 0)
+		return map_to_string(expr->members.variable);
+	    return array_to_string(expr->members.variable, n);
+	}
 	if(!str1) {
 	    fprintf(stderr, "Variable %s does not have a value\n",
 		    expr->members.variable);
 	    longjmp(onerror, 0);
 	}
 	return str1;
+    case INDEX_EXPR_CLASS:
+	return eval_element(expr);
+    case FUNC_EXPR_CLASS:
+	return eval_function(expr);
     case UNARY_EXPR_CLASS:
 	str1 = eval_to_string(expr->members.unary_expr.arg);
 	switch(expr->members.unary_expr.oprtr) {
@@ -386,8 +2217,14 @@ char *eval_to_string(EXPR *expr) {
 	str1 = eval_to_string(expr->members.binary_expr.arg1);
 	str2 = eval_to_string(expr->members.binary_expr.arg2);
 	switch(expr->members.binary_expr.oprtr) {
+	case CONCAT_OPRTR:
+	    len1 = strlen(str1);
+	    len2 = strlen(str2);
+	    result = scratch_alloc(len1 + len2 + 1);
+	    memcpy(result, str1, len1);
+	    memcpy(result + len1, str2, len2 + 1);
+	    return result;
 	default:
-	    (void)str1;  (void)str2;
 	    fprintf(stderr, "Unknown binary string operator: %d\n",
 		    expr->members.binary_expr.oprtr);
 	    abort();
@@ -398,3 +2235,269 @@ char *eval_to_string(EXPR *expr) {
     }
     return 0;
 }
+
+/*
+ * Evaluate a call of a builtin function that has a string value.
+ * The result is placed in scratch storage, and remains valid until
+ * the next statement is executed.
+ */
+static char *eval_function(EXPR *expr) {
+    ARG *args = expr->members.func_expr.args;
+    char *str, *delim, *result, *end;
+    long start, len, n;
+    size_t slen;
+    if(expr->type == ARRAY_VALUE_TYPE) {
+	fprintf(stderr, "Function %s can only be the value of a set statement\n",
+		function_info(expr->members.func_expr.oprtr)->name);
+	longjmp(onerror, 0);
+    }
+    str = eval_to_string(args->expr);
+    slen = strlen(str);
+    switch(expr->members.func_expr.oprtr) {
+    case SUBSTR_OPRTR:
+	start = eval_to_numeric(args->next->expr);
+	if(start < 0)
+	    start = 0;
+	if(start > slen)
+	    start = slen;
+	len = slen - start;
+	if(args->next->next) {
+	    n = eval_to_numeric(args->next->next->expr);
+	    if(n < len)
+		len = n < 0 ? 0 : n;
+	}
+	result = scratch_alloc(len + 1);
+	memcpy(result, str + start, len);
+	result[len] = '\0';
+	return result;
+    case TRIM_OPRTR:
+	while(isspace((unsigned char)*str))
+	    str++;
+	end = str + strlen(str);
+	while(end > str && isspace((unsigned char)end[-1]))
+	    end--;
+	result = scratch_alloc(end - str + 1);
+	memcpy(result, str, end - str);
+	result[end - str] = '\0';
+	return result;
+    case UPPER_OPRTR:
+    case LOWER_OPRTR:
+	result = scratch_alloc(slen + 1);
+	for(size_t i = 0; i <= slen; i++) {
+	    unsigned char c = str[i];
+	    result[i] = expr->members.func_expr.oprtr == UPPER_OPRTR ?
+		toupper(c) : tolower(c);
+	}
+	return result;
+    case FIELD_OPRTR:
+	/*
+	 * Fields are numbered from 0.  An empty delimiter means that fields
+	 * are separated by runs of white space, as in awk.
+	 */
+	delim = eval_to_string(args->next->expr);
+	n = eval_to_numeric(args->next->next->expr);
+	if(*delim == '\0') {
+	    while(1) {
+		while(isspace((unsigned char)*str))
+		    str++;
+		end = str;
+		while(*end && !isspace((unsigned char)*end))
+		    end++;
+		if(n-- == 0 || end == str)
+		    break;
+		str = end;
+	    }
+	} else {
+	    while((end = strstr(str, delim)) != NULL && n > 0) {
+		str = end + strlen(delim);
+		n--;
+	    }
+	    if(n > 0)
+		end = str = str + strlen(str);
+	    else if(end == NULL)
+		end = str + strlen(str);
+	}
+	result = scratch_alloc(end - str + 1);
+	memcpy(result, str, end - str);
+	result[end - str] = '\0';
+	return result;
+    default:
+	fprintf(stderr, "Unknown string function: %d\n",
+		expr->members.func_expr.oprtr);
+	abort();
+    }
+}
+
+/*
+ * Allocate space for an intermediate result from the scratch storage.
+ */
+static char *scratch_alloc(size_t n) {
+    char *p;
+    n = (n + 7) & ~(size_t)7;
+    if(scratch == NULL || scratch->size - scratch->used < n) {
+	size_t size = scratch ? 2 * scratch->size : SCRATCH_SIZE;
+	while(size < n)
+	    size *= 2;
+	SCRATCH_CHUNK *cp = malloc(sizeof(SCRATCH_CHUNK) + size);
+	if(cp == NULL) {
+	    fprintf(stderr, "Not enough memory to evaluate an expression\n");
+	    longjmp(onerror, 0);
+	}
+	cp->next = scratch;
+	cp->size = size;
+	cp->used = 0;
+	scratch = cp;
+    }
+    p = scratch->data + scratch->used;
+    scratch->used += n;
+    return p;
+}
+
+/*
+ * Release all scratch storage, keeping the newest chunk for reuse.
+ */
+static void scratch_reset(void) {
+    if(scratch == NULL)
+	return;
+    while(scratch->next) {
+	SCRATCH_CHUNK *cp = scratch->next;
+	scratch->next = cp->next;
+	free(cp);
+    }
+    scratch->used = 0;
+}
+
+/*
+ * Release the state of the execution engine on the calling thread:
+ * any active loops, the scratch storage and the compiled patterns.
+ */
+void exec_fini(void) {
+    loop_pop(0);
+    free(loops);
+    loops = NULL;
+    maxloops = 0;
+    while(scratch) {
+	SCRATCH_CHUNK *cp = scratch;
+	scratch = cp->next;
+	free(cp);
+    }
+    for(int i = 0; i < REGEX_CACHE_SIZE; i++) {
+	struct regex_entry *ep = &regex_cache[i];
+	if(ep->pattern) {
+	    free(ep->pattern);
+	    regfree(&ep->regex);
+	    ep->pattern = NULL;
+	    ep->last_used = 0;
+	}
+    }
+    regex_clock = 0;
+    jit_fini();
+}
+
+/*
+ * The functions below are the part of the execution engine that is used
+ * by programs compiled with mushc (see the compiler module).  A compiled
+ * program does the work of the statements that it can translate itself,
+ * and hands the others back to the execution engine, one at a time.
+ * Errors are reported here just as they are for the interpreter, and are
+ * caught by the handler that the compiled program sets on entry (see
+ * exec_arm()), so longjmp() never leaves the compiled code.
+ */
+
+/*
+ * Run a compiled program from its beginning, as "run" would run the
+ * program that it was compiled from.  The program returns one of the
+ * MUSHC_* results; if it finds that the program store does not hold what
+ * it was compiled from, the interpreter carries on from where it stopped.
+ */
+int exec_native(int (*code)(void)) {
+    int err;
+    prog_reset();
+    loop_pop(0);
+    if(prog_fetch() == NULL) {
+	fprintf(stderr, "No statement to execute\n");
+	return -1;
+    }
+    signal(SIGQUIT, handler);
+    err = code();
+    onerror_armed = 0;
+    if(err == MUSHC_INTERPRET && prog_fetch() != NULL) {
+	signal(SIGQUIT, SIG_IGN);
+	return exec_cont();
+    }
+    signal(SIGQUIT, SIG_IGN);
+    loop_flush();
+    if(err == MUSHC_END || err == MUSHC_INTERPRET) {
+	fprintf(stderr, "STOP (end of program)\n");
+	err = 0;
+    } else if(err == MUSHC_QUIT) {
+	err = 0;
+    }
+    if(got_quit)
+	fprintf(stderr, "Quit!\n");
+    got_quit = 0;
+    return err;
+}
+
+/*
+ * Arm "onerror" for a compiled program, which calls setjmp() on the buffer
+ * returned once, on entry, so that the lines that it hands back and the
+ * expressions and pipelines it has evaluated do not each set it again.
+ */
+jmp_buf *exec_arm(void) {
+    onerror_armed = 1;
+    return &onerror;
+}
+
+/*
+ * Determine whether the user has asked for a running program to quit.
+ */
+int exec_quit(void) {
+    return got_quit;
+}
+
+/*
+ * Evaluate an expression to a number, for a compiled program.
+ * Returns 0 if successful.  Otherwise the error is reported, and control
+ * goes to the handler of the program if it is armed, or else -1 is returned.
+ */
+int exec_numeric(EXPR *expr, long *valp) {
+    if(!onerror_armed) {
+	if(setjmp(onerror))
+	    return -1;
+    }
+    scratch_reset();
+    *valp = eval_to_numeric(expr);
+    return 0;
+}
+
+/*
+ * Get the numeric value of a variable, for a compiled program.
+ * Returns 0 if successful, otherwise the error is reported and -1 is returned.
+ */
+int exec_get_numeric(char *name, long *valp) {
+    return var_numeric(name, 1, valp);
+}
+
+/*
+ * Set a variable to a numeric value, for a compiled program.
+ */
+void exec_set_numeric(char *name, long val) {
+    loop_sync(name);
+    store_set_int(name, val);
+}
+
+/*
+ * Start the job for a pipeline, for a compiled program, which then waits
+ * for it or not as it would.  Errors are handled as for exec_numeric().
+ */
+int exec_job(PIPELINE *pp, int *jobp) {
+    if(!onerror_armed) {
+	if(setjmp(onerror))
+	    return -1;
+    }
+    scratch_reset();
+    loop_sync_exported();
+    *jobp = jobs_run(pp);
+    return 0;
+}
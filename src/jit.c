@@ -0,0 +1,725 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "mush.h"
+#include "debug.h"
+
+/*
+ * This is the "jit" module for Mush.
+ * It translates runs of numeric statements of a program into x86-64
+ * machine code, for long-running numeric loops.  A region is the longest
+ * run of consecutive lines of the program, starting at the line about to
+ * be executed, that are "set" of a number to a variable, "if" or "goto",
+ * with expressions made only of integer literals, numeric variables and
+ * the arithmetic, comparison and logical operators, and only if some line
+ * of it jumps back to an earlier one, since a region that does not loop is
+ * not run long enough to repay entering it.  Each line becomes a
+ * template of instructions per operator, jumps between lines of the
+ * region are jumps in the code, and each variable is kept in a slot that
+ * the execution engine fills from the data store when the region is
+ * entered and writes back when it is left.
+ *
+ * The code gives up, leaving the rest to the interpreter at the start of
+ * the line it was on, when a slot is read that does not hold a value, or
+ * when a division would trap.  Leaving by a jump to a line outside the
+ * region, or by running off its end, hands the program counter back at
+ * that line.  Jumps backwards in the region check whether the user has
+ * asked to quit.
+ *
+ * Regions are compiled the first time they are entered and kept until
+ * the program changes.  On other machines nothing is compiled, and the
+ * interpreter runs everything.
+ */
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define X86_JIT
+#endif
+
+/* The longest region, and the most variables it may use. */
+#define MAX_REGION 256
+#define MAX_SLOTS 64
+
+/* Results of the code of a region, other than the index of a line. */
+#define JIT_BAIL (1L << 20)     // Plus the index of the line given up on
+#define JIT_EXT (1L << 21)      // Plus the index of an outside jump target
+
+struct jit_region {
+    long nstmts;
+    STMT **stmts;               // Lines of the region
+    PROG_POS *positions;        // Position of each, and of the end
+    int end_line;               // Line number after the end, or 0
+    long nslots;
+    char *names[MAX_SLOTS];     // Variable of each slot
+    int written[MAX_SLOTS];     // Nonzero if the region sets it
+    long *slots;                // Values, followed by a "set" byte each
+    long nexts;
+    int *exts;                  // Line numbers of outside jump targets
+    unsigned char *code;
+    size_t code_size;
+    long (*entry)(long *slots);
+};
+
+#ifdef X86_JIT
+
+/*
+ * Machine code being assembled, with the jumps whose targets are not yet
+ * known.  A target is the index of a line, or one of the labels below.
+ */
+#define LABEL_EXIT (-1)         // Common exit sequence
+#define LABEL_BAIL (-2)         // Give up on the current line (minus index)
+
+typedef struct fixup {
+    size_t at;                  // Offset of the rel32 to be filled in
+    long target;
+} FIXUP;
+
+typedef struct asm_buf {
+    unsigned char *code;
+    size_t len, size;
+    FIXUP *fixups;
+    long nfixups, maxfixups;
+    int failed;
+} ASM_BUF;
+
+static void put_bytes(ASM_BUF *ab, const void *bytes, size_t n) {
+    if(ab->len + n > ab->size)
+    {
+        size_t size = ab->size ? ab->size * 2 : 4096;
+        while(size < ab->len + n)
+            size *= 2;
+        unsigned char *code = (unsigned char *) realloc(ab->code, size);
+        if(code == NULL)
+        {
+            ab->failed = 1;
+            return;
+        }
+        ab->code = code;
+        ab->size = size;
+    }
+    memcpy(ab->code + ab->len, bytes, n);
+    ab->len += n;
+}
+
+#define EMIT(ab, ...) do { \
+        static const unsigned char b_[] = { __VA_ARGS__ }; \
+        put_bytes(ab, b_, sizeof(b_)); \
+    } while(0)
+
+static void put32(ASM_BUF *ab, int v) {
+    put_bytes(ab, &v, 4);
+}
+
+static void put64(ASM_BUF *ab, long v) {
+    put_bytes(ab, &v, 8);
+}
+
+/*
+ * Put a rel32 whose target is filled in once all the code is there.
+ */
+static void put_target(ASM_BUF *ab, long target) {
+    if(ab->nfixups == ab->maxfixups)
+    {
+        long max = ab->maxfixups ? ab->maxfixups * 2 : 64;
+        FIXUP *fixups = (FIXUP *) realloc(ab->fixups, max * sizeof(FIXUP));
+        if(fixups == NULL)
+        {
+            ab->failed = 1;
+            return;
+        }
+        ab->fixups = fixups;
+        ab->maxfixups = max;
+    }
+    ab->fixups[ab->nfixups].at = ab->len;
+    ab->fixups[ab->nfixups++].target = target;
+    put32(ab, 0);
+}
+
+#endif
+
+/*
+ * Find the slot of a variable, adding one if need be.
+ */
+static long slot_of(JIT_REGION *rp, char *name) {
+    for(long k = 0; k < rp->nslots; k++)
+    {
+        if(!strcmp(rp->names[k], name))
+            return k;
+    }
+    if(rp->nslots == MAX_SLOTS)
+        return -1;
+    rp->names[rp->nslots] = name;
+    rp->written[rp->nslots] = 0;
+    return rp->nslots++;
+}
+
+/*
+ * Determine whether an expression can be translated, giving slots to the
+ * variables that it uses.
+ */
+static int jit_expr_ok(JIT_REGION *rp, EXPR *expr) {
+    char *endp;
+    switch(expr->class)
+    {
+    case LIT_EXPR_CLASS:
+        strtol(expr->members.value, &endp, 0);
+        return *endp == '\0';
+    case NUM_EXPR_CLASS:
+        return slot_of(rp, expr->members.variable) >= 0;
+    case UNARY_EXPR_CLASS:
+        return expr->members.unary_expr.oprtr == NOT_OPRTR
+            && jit_expr_ok(rp, expr->members.unary_expr.arg);
+    case BINARY_EXPR_CLASS:
+        switch(expr->members.binary_expr.oprtr)
+        {
+        case EQUAL_OPRTR:
+            if(expr->members.binary_expr.arg1->type != NUM_VALUE_TYPE
+               || expr->members.binary_expr.arg2->type != NUM_VALUE_TYPE)
+                return 0;
+            /* FALLTHROUGH */
+        case AND_OPRTR: case OR_OPRTR: case PLUS_OPRTR: case MINUS_OPRTR:
+        case TIMES_OPRTR: case DIVIDE_OPRTR: case MOD_OPRTR: case LESS_OPRTR:
+        case GREATER_OPRTR: case LESSEQ_OPRTR: case GREATEQ_OPRTR:
+            return jit_expr_ok(rp, expr->members.binary_expr.arg1)
+                && jit_expr_ok(rp, expr->members.binary_expr.arg2);
+        default:
+            return 0;
+        }
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Determine whether a statement can be translated.  The slots that it
+ * would add are taken back if it cannot.
+ */
+static int jit_stmt_ok(JIT_REGION *rp, STMT *stmt) {
+    long nslots = rp->nslots;
+    int ok = 0;
+    switch(stmt->class)
+    {
+    case SET_STMT_CLASS:
+        ok = stmt->members.set_stmt.index == NULL
+            && stmt->members.set_stmt.expr->type == NUM_VALUE_TYPE
+            && jit_expr_ok(rp, stmt->members.set_stmt.expr)
+            && slot_of(rp, stmt->members.set_stmt.name) >= 0;
+        break;
+    case IF_STMT_CLASS:
+        ok = jit_expr_ok(rp, stmt->members.if_stmt.expr);
+        break;
+    case GOTO_STMT_CLASS:
+        ok = 1;
+        break;
+    default:
+        break;
+    }
+    if(!ok)
+        rp->nslots = nslots;
+    return ok;
+}
+
+#ifdef X86_JIT
+
+/* Offsets from rbx, which points at the slots, of a value and its byte. */
+static int value_at(long k) {
+    return 8 * k;
+}
+
+static int set_at(JIT_REGION *rp, long k) {
+    return 8 * rp->nslots + k;
+}
+
+/*
+ * Assemble the code that leaves the value of an expression in rax, giving
+ * up on line "i" if it cannot be computed as the interpreter would.
+ */
+static void asm_expr(ASM_BUF *ab, JIT_REGION *rp, EXPR *expr, long i) {
+    long k, val;
+    switch(expr->class)
+    {
+    case LIT_EXPR_CLASS:
+        val = strtol(expr->members.value, NULL, 0);
+        EMIT(ab, 0x48, 0xb8);                   // mov rax, imm64
+        put64(ab, val);
+        break;
+    case NUM_EXPR_CLASS:
+        k = slot_of(rp, expr->members.variable);
+        EMIT(ab, 0x80, 0xbb);                   // cmp byte [rbx+d], 0
+        put32(ab, set_at(rp, k));
+        EMIT(ab, 0x00);
+        EMIT(ab, 0x0f, 0x84);                   // je bail
+        put_target(ab, LABEL_BAIL - i);
+        EMIT(ab, 0x48, 0x8b, 0x83);             // mov rax, [rbx+d]
+        put32(ab, value_at(k));
+        break;
+    case UNARY_EXPR_CLASS:
+        asm_expr(ab, rp, expr->members.unary_expr.arg, i);
+        EMIT(ab, 0x48, 0x85, 0xc0,              // test rax, rax
+             0x0f, 0x94, 0xc0,                  // sete al
+             0x0f, 0xb6, 0xc0);                 // movzx eax, al
+        break;
+    case BINARY_EXPR_CLASS:
+        asm_expr(ab, rp, expr->members.binary_expr.arg1, i);
+        EMIT(ab, 0x50);                         // push rax
+        asm_expr(ab, rp, expr->members.binary_expr.arg2, i);
+        EMIT(ab, 0x48, 0x89, 0xc1,              // mov rcx, rax
+             0x58);                             // pop rax
+        switch(expr->members.binary_expr.oprtr)
+        {
+        case PLUS_OPRTR:
+            EMIT(ab, 0x48, 0x01, 0xc8);         // add rax, rcx
+            break;
+        case MINUS_OPRTR:
+            EMIT(ab, 0x48, 0x29, 0xc8);         // sub rax, rcx
+            break;
+        case TIMES_OPRTR:
+            EMIT(ab, 0x48, 0x0f, 0xaf, 0xc1);   // imul rax, rcx
+            break;
+        case DIVIDE_OPRTR:
+        case MOD_OPRTR:
+            /* Divisors that could trap are left to the interpreter. */
+            EMIT(ab, 0x48, 0x85, 0xc9,          // test rcx, rcx
+                 0x0f, 0x84);                   // je bail
+            put_target(ab, LABEL_BAIL - i);
+            EMIT(ab, 0x48, 0x83, 0xf9, 0xff,    // cmp rcx, -1
+                 0x0f, 0x84);                   // je bail
+            put_target(ab, LABEL_BAIL - i);
+            EMIT(ab, 0x48, 0x99,                // cqo
+                 0x48, 0xf7, 0xf9);             // idiv rcx
+            if(expr->members.binary_expr.oprtr == MOD_OPRTR)
+                EMIT(ab, 0x48, 0x89, 0xd0);     // mov rax, rdx
+            break;
+        case AND_OPRTR:
+        case OR_OPRTR:
+            EMIT(ab, 0x48, 0x85, 0xc0,          // test rax, rax
+                 0x0f, 0x95, 0xc0,              // setne al
+                 0x48, 0x85, 0xc9,              // test rcx, rcx
+                 0x0f, 0x95, 0xc1);             // setne cl
+            if(expr->members.binary_expr.oprtr == AND_OPRTR)
+                EMIT(ab, 0x20, 0xc8);           // and al, cl
+            else
+                EMIT(ab, 0x08, 0xc8);           // or al, cl
+            EMIT(ab, 0x0f, 0xb6, 0xc0);         // movzx eax, al
+            break;
+        default:
+            EMIT(ab, 0x48, 0x39, 0xc8);         // cmp rax, rcx
+            switch(expr->members.binary_expr.oprtr)
+            {
+            case LESS_OPRTR:
+                EMIT(ab, 0x0f, 0x9c, 0xc0);     // setl al
+                break;
+            case GREATER_OPRTR:
+                EMIT(ab, 0x0f, 0x9f, 0xc0);     // setg al
+                break;
+            case LESSEQ_OPRTR:
+                EMIT(ab, 0x0f, 0x9e, 0xc0);     // setle al
+                break;
+            case GREATEQ_OPRTR:
+                EMIT(ab, 0x0f, 0x9d, 0xc0);     // setge al
+                break;
+            default:
+                EMIT(ab, 0x0f, 0x94, 0xc0);     // sete al
+                break;
+            }
+            EMIT(ab, 0x0f, 0xb6, 0xc0);         // movzx eax, al
+            break;
+        }
+        break;
+    default:
+        ab->failed = 1;
+        break;
+    }
+}
+
+/*
+ * Find the index of a line of the region, or -1 if it is not in it.
+ */
+static long line_of(JIT_REGION *rp, int lineno) {
+    for(long i = 0; i < rp->nstmts; i++)
+    {
+        if(rp->stmts[i]->lineno == lineno)
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Assemble a jump from line "i" to a line, which may be outside the region.
+ */
+static void asm_jump(ASM_BUF *ab, JIT_REGION *rp, long i, int lineno,
+                     volatile int *quit) {
+    long target = line_of(rp, lineno);
+    if(target < 0)
+    {
+        long j;
+        for(j = 0; j < rp->nexts && rp->exts[j] != lineno; j++)
+            ;
+        if(j == rp->nexts)
+            rp->exts[rp->nexts++] = lineno;
+        EMIT(ab, 0xb8);                         // mov eax, imm32
+        put32(ab, JIT_EXT + j);
+        EMIT(ab, 0xe9);                         // jmp exit
+        put_target(ab, LABEL_EXIT);
+        return;
+    }
+    if(target > i)
+    {
+        EMIT(ab, 0xe9);                         // jmp line
+        put_target(ab, target);
+        return;
+    }
+    /* A loop: stop at its top if the user has asked to quit. */
+    EMIT(ab, 0x48, 0xb9);                       // mov rcx, imm64
+    put64(ab, (long) quit);
+    EMIT(ab, 0x83, 0x39, 0x00,                  // cmp dword [rcx], 0
+         0x0f, 0x84);                           // je line
+    put_target(ab, target);
+    EMIT(ab, 0xb8);                             // mov eax, imm32
+    put32(ab, target);
+    EMIT(ab, 0xe9);                             // jmp exit
+    put_target(ab, LABEL_EXIT);
+}
+
+/*
+ * Determine whether a region jumps back to one of its own lines.  A region
+ * without a loop is not worth the cost of entering it.
+ */
+static int has_loop(JIT_REGION *rp) {
+    for(long i = 0; i < rp->nstmts; i++)
+    {
+        STMT *stmt = rp->stmts[i];
+        int lineno = stmt->class == IF_STMT_CLASS ? stmt->members.if_stmt.lineno
+            : stmt->class == GOTO_STMT_CLASS ? stmt->members.goto_stmt.lineno : 0;
+        long target = lineno ? line_of(rp, lineno) : -1;
+        if(target >= 0 && target <= i)
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * Assemble the code for a region, and map it into executable memory.
+ */
+static int assemble(JIT_REGION *rp, volatile int *quit) {
+    ASM_BUF ab;
+    size_t *labels = (size_t *) malloc((rp->nstmts + 1) * sizeof(size_t));
+    memset(&ab, 0, sizeof(ab));
+    if(labels == NULL)
+        return -1;
+
+    EMIT(&ab, 0x55,                             // push rbp
+         0x48, 0x89, 0xe5,                      // mov rbp, rsp
+         0x53,                                  // push rbx
+         0x48, 0x89, 0xfb);                     // mov rbx, rdi
+    for(long i = 0; i < rp->nstmts; i++)
+    {
+        STMT *stmt = rp->stmts[i];
+        long k;
+        labels[i] = ab.len;
+        switch(stmt->class)
+        {
+        case SET_STMT_CLASS:
+            asm_expr(&ab, rp, stmt->members.set_stmt.expr, i);
+            k = slot_of(rp, stmt->members.set_stmt.name);
+            rp->written[k] = 1;
+            /* Like exec_stmt(), "set" keeps the value as an int. */
+            EMIT(&ab, 0x48, 0x63, 0xc0,         // movsxd rax, eax
+                 0x48, 0x89, 0x83);             // mov [rbx+d], rax
+            put32(&ab, value_at(k));
+            EMIT(&ab, 0xc6, 0x83);              // mov byte [rbx+d], 1
+            put32(&ab, set_at(rp, k));
+            EMIT(&ab, 0x01);
+            break;
+        case IF_STMT_CLASS:
+            asm_expr(&ab, rp, stmt->members.if_stmt.expr, i);
+            EMIT(&ab, 0x85, 0xc0,               // test eax, eax
+                 0x0f, 0x84);                   // je next line
+            put_target(&ab, i + 1);
+            asm_jump(&ab, rp, i, stmt->members.if_stmt.lineno, quit);
+            break;
+        case GOTO_STMT_CLASS:
+            asm_jump(&ab, rp, i, stmt->members.goto_stmt.lineno, quit);
+            break;
+        default:
+            ab.failed = 1;
+            break;
+        }
+    }
+    labels[rp->nstmts] = ab.len;
+    EMIT(&ab, 0xb8);                            // mov eax, imm32
+    put32(&ab, rp->nstmts);
+    size_t exit_label = ab.len;
+    EMIT(&ab, 0x48, 0x8b, 0x5d, 0xf8,           // mov rbx, [rbp-8]
+         0x48, 0x89, 0xec,                      // mov rsp, rbp
+         0x5d,                                  // pop rbp
+         0xc3);                                 // ret
+    size_t bail_labels = ab.len;
+    for(long i = 0; i < rp->nstmts; i++)
+    {
+        EMIT(&ab, 0xb8);                        // mov eax, imm32
+        put32(&ab, JIT_BAIL + i);
+        EMIT(&ab, 0xe9);                        // jmp exit
+        put_target(&ab, LABEL_EXIT);
+    }
+
+    if(ab.failed)
+    {
+        free(ab.code);
+        free(ab.fixups);
+        free(labels);
+        return -1;
+    }
+    for(long f = 0; f < ab.nfixups; f++)
+    {
+        long target = ab.fixups[f].target;
+        size_t to = target >= 0 ? labels[target]
+            : target == LABEL_EXIT ? exit_label
+            : bail_labels + (LABEL_BAIL - target) * 10;
+        int rel = (int) (to - (ab.fixups[f].at + 4));
+        memcpy(ab.code + ab.fixups[f].at, &rel, 4);
+    }
+    free(ab.fixups);
+    free(labels);
+
+    /* The code is written while the memory is writable, then made executable. */
+    size_t size = (ab.len + 4095) & ~(size_t) 4095;
+    unsigned char *code = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(code == MAP_FAILED)
+    {
+        free(ab.code);
+        return -1;
+    }
+    memcpy(code, ab.code, ab.len);
+    free(ab.code);
+    if(mprotect(code, size, PROT_READ | PROT_EXEC) < 0)
+    {
+        munmap(code, size);
+        return -1;
+    }
+    rp->code = code;
+    rp->code_size = size;
+    rp->entry = (long (*)(long *)) code;
+    return 0;
+}
+
+#endif
+
+static void free_region(JIT_REGION *rp) {
+    if(rp == NULL)
+        return;
+    if(rp->code)
+        munmap(rp->code, rp->code_size);
+    free(rp->stmts);
+    free(rp->positions);
+    free(rp->slots);
+    free(rp->exts);
+    free(rp);
+}
+
+/*
+ * Compile the region that starts at the line just after the program
+ * counter.  The program counter is left where it was.
+ */
+static JIT_REGION *compile_region(volatile int *quit) {
+#ifdef X86_JIT
+    JIT_REGION *rp = (JIT_REGION *) calloc(1, sizeof(JIT_REGION));
+    PROG_POS start = prog_tell();
+    STMT *stmt = NULL;
+
+    if(rp == NULL)
+        return NULL;
+    rp->stmts = (STMT **) malloc(MAX_REGION * sizeof(STMT *));
+    rp->positions = (PROG_POS *) malloc((MAX_REGION + 1) * sizeof(PROG_POS));
+    rp->exts = (int *) malloc(MAX_REGION * sizeof(int));
+    if(rp->stmts == NULL || rp->positions == NULL || rp->exts == NULL)
+    {
+        free_region(rp);
+        return NULL;
+    }
+    while(rp->nstmts < MAX_REGION && (stmt = prog_fetch()) != NULL
+          && jit_stmt_ok(rp, stmt))
+    {
+        rp->stmts[rp->nstmts] = stmt;
+        rp->positions[rp->nstmts++] = prog_tell();
+        prog_next();
+    }
+    /* The line after the end is the one at which the scan stopped. */
+    rp->positions[rp->nstmts] = prog_tell();
+    stmt = prog_fetch();
+    rp->end_line = stmt ? stmt->lineno : 0;
+    prog_seek(start);
+    if(!has_loop(rp))
+    {
+        free_region(rp);
+        return NULL;
+    }
+    /* A value for each slot, then as many more as hold a byte for each. */
+    rp->slots = (long *) calloc(rp->nslots + 1
+                                + rp->nslots / sizeof(long), sizeof(long));
+    if(rp->slots == NULL || assemble(rp, quit) < 0)
+    {
+        free_region(rp);
+        return NULL;
+    }
+    debug("compiled lines %d to %d, %ld slots, %ld bytes",
+          rp->stmts[0]->lineno, rp->stmts[rp->nstmts - 1]->lineno,
+          rp->nslots, rp->code_size);
+    return rp;
+#else
+    return NULL;
+#endif
+}
+
+/*
+ * The compiled regions of the program on the calling thread, by the
+ * statement at which each starts, with NULL for a statement at which no
+ * region can start.  They are all discarded when the program changes.
+ */
+#define JIT_CACHE_SIZE 512
+
+static __thread struct jit_entry {
+    STMT *stmt;
+    JIT_REGION *region;
+} jit_cache[JIT_CACHE_SIZE];
+static __thread long jit_cached;
+static __thread int jit_epoch = -1;
+
+/**
+ * @brief  Get the compiled region that starts at the line just after the
+ * program counter.
+ * @details  This function looks up the region that starts at the statement
+ * just after the program counter, compiling it the first time.
+ *
+ * @param  stmt  The statement just after the program counter.
+ * @param  quit  A flag that loops in the region check, and stop if set.
+ * @return  The region, or NULL if no region can start at the statement.
+ */
+JIT_REGION *jit_lookup(STMT *stmt, volatile int *quit) {
+    if(prog_epoch() != jit_epoch || jit_cached >= JIT_CACHE_SIZE / 2)
+    {
+        jit_fini();
+        jit_epoch = prog_epoch();
+    }
+    unsigned long h = ((unsigned long) stmt >> 4) % JIT_CACHE_SIZE;
+    while(jit_cache[h].stmt != NULL)
+    {
+        if(jit_cache[h].stmt == stmt)
+            return jit_cache[h].region;
+        h = (h + 1) % JIT_CACHE_SIZE;
+    }
+    jit_cache[h].stmt = stmt;
+    jit_cache[h].region = compile_region(quit);
+    jit_cached++;
+    return jit_cache[h].region;
+}
+
+/**
+ * @brief  Get the number of slots of a region.
+ */
+long jit_nslots(JIT_REGION *rp) {
+    return rp->nslots;
+}
+
+/**
+ * @brief  Get the name of the variable of a slot of a region.
+ */
+char *jit_slot_name(JIT_REGION *rp, long k) {
+    return rp->names[k];
+}
+
+/**
+ * @brief  Determine whether a region sets the variable of a slot.
+ */
+int jit_slot_written(JIT_REGION *rp, long k) {
+    return rp->written[k];
+}
+
+/**
+ * @brief  Get the values of the slots of a region.
+ * @details  The values, one for each slot, are followed by a byte for each
+ * slot that is nonzero if its value is set.  They are to be filled in
+ * before the region is run, and read once it has run.
+ */
+long *jit_slots(JIT_REGION *rp) {
+    return rp->slots;
+}
+
+/**
+ * @brief  Run the code of a region.
+ *
+ * @param  rp  The region.
+ * @return  A code for where the region was left, for jit_resume().
+ */
+long jit_run(JIT_REGION *rp) {
+    return rp->entry(rp->slots);
+}
+
+/**
+ * @brief  Determine whether a region gave up on a line, rather than
+ * leaving by a jump or by running off its end.
+ */
+int jit_gave_up(long code) {
+    return code >= JIT_BAIL && code < JIT_EXT;
+}
+
+/**
+ * @brief  Get the line number at which a region was left.
+ *
+ * @param  rp  The region.
+ * @param  code  The code returned by jit_run().
+ * @return  The line number, 0 if the region ran off the end of the program,
+ * or -1 if it gave up.
+ */
+int jit_exit_line(JIT_REGION *rp, long code) {
+    if(code >= JIT_EXT)
+        return rp->exts[code - JIT_EXT];
+    if(code >= JIT_BAIL)
+        return -1;
+    return code < rp->nstmts ? rp->stmts[code]->lineno : rp->end_line;
+}
+
+/**
+ * @brief  Determine whether a statement is one of the lines of a region.
+ */
+int jit_contains(JIT_REGION *rp, STMT *stmt) {
+    for(long i = 0; i < rp->nstmts; i++)
+    {
+        if(rp->stmts[i] == stmt)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief  Set the program counter to where a region was left.
+ *
+ * @param  rp  The region.
+ * @param  code  The code returned by jit_run().
+ * @return  0 if successful, or -1 if the region jumped to a line that
+ * does not exist, which is an error as it is for "goto".
+ */
+int jit_resume(JIT_REGION *rp, long code) {
+    if(code >= JIT_EXT)
+        return prog_goto(rp->exts[code - JIT_EXT]) ? 0 : -1;
+    if(code >= JIT_BAIL)
+        code -= JIT_BAIL;
+    prog_seek(rp->positions[code]);
+    return 0;
+}
+
+/**
+ * @brief  Discard the compiled regions of the calling thread.
+ */
+void jit_fini(void) {
+    for(long h = 0; h < JIT_CACHE_SIZE; h++)
+    {
+        free_region(jit_cache[h].region);
+        jit_cache[h].stmt = NULL;
+        jit_cache[h].region = NULL;
+    }
+    jit_cached = 0;
+    jit_epoch = -1;
+}
@@ -7,11 +7,16 @@
 #include <wait.h>
 #include <time.h>
 #include <errno.h>
+#include <sched.h>
+#include <pthread.h>
 #include <sys/time.h>
+#include <sys/stat.h>
 
 #include "mush.h"
 #include "debug.h"
 
+extern char **environ;
+
 /*
  * This is the "jobs" module for Mush.
  * It maintains a table of jobs in various stages of execution, and it
@@ -46,114 +51,440 @@ typedef struct job_node{
     int exit_status;
     int readfd;
     PIPELINE *pipeline;
+    /* Captured output, its length and the size of the buffer holding it. */
     char *job_output;
+    size_t output_len;
+    size_t output_size;
+    /* Key under which the result is to be cached, or NULL. */
+    char *cache_key;
+    size_t cache_key_len;
 }JOB_NODE;
 
 typedef struct job_table{
     JOB_NODE *head;
 }JOB_TABLE;
 
-JOB_TABLE *jtable = NULL;
+__thread JOB_TABLE *jtable = NULL;
 
-int jid = 0;
+__thread int jid = 0;
 
 //static volatile sig_atomic_t got_child_status = 0;
-int change_job_status(pid_t pid, char * status, int exit_status);
 int read_output_capture(JOB_NODE *job);
 
-static void child_handler(int sig) {
-    sigset_t mask_all, prev_all;
-    sigfillset(&mask_all);
-    sigprocmask(SIG_BLOCK, &mask_all, &prev_all);
-    int olderrno = errno;
-    int chstatus;
-    pid_t pid;
-    while((pid = waitpid(-1, &chstatus, 0))<=0)
-        ;
-    if(pid>0)
-    {
-        if(WIFSTOPPED(chstatus)|WIFSIGNALED(chstatus)|WIFEXITED(chstatus)){
+/*
+ * Results of pipelines run with "cached", so that running such a pipeline
+ * again with the same arguments, input file and selected environment can
+ * replay its exit status and captured output instead of spawning anything.
+ * Only pipelines whose output is captured are cached.  The entries are
+ * kept in a list, most recently used first, and the least recently used
+ * entries are discarded when the total size of the results exceeds the
+ * limit.  Each entry expires a fixed number of seconds after it was made.
+ */
+#define CACHE_DEFAULT_TTL 60
+#define CACHE_DEFAULT_SIZE (1 << 20)
+
+typedef struct cache_entry{
+    struct cache_entry *prev;
+    struct cache_entry *next;
+    char *key;
+    size_t key_len;
+    unsigned long hash;
+    char *status;
+    int exit_status;
+    char *output;
+    size_t output_len;
+    size_t size;
+    time_t expires;
+}CACHE_ENTRY;
 
-            switch(WEXITSTATUS(chstatus))
-            {
-                case EXIT_SUCCESS:
-                    change_job_status((pid_t)pid, "completed", chstatus);
-                    break;
-                case SIGKILL:
-                    change_job_status((pid_t)pid, "canceled", chstatus);
-                    break;
-                default:
-                    change_job_status((pid_t)pid, "aborted", chstatus);
-            }
+static __thread CACHE_ENTRY cache_head;
+static __thread size_t cache_bytes;
+static __thread long cache_count, cache_hits, cache_misses;
+
+/*
+ * Every thread that hosts an interpreter has a jobs table of its own, but
+ * SIGCHLD and SIGIO are sent to the process, and can be delivered to any
+ * of its threads.  So the threads with a jobs table are registered here,
+ * and a handler that receives a signal from the kernel passes it on to
+ * each of them with pthread_kill().  Each thread then only reaps its own
+ * children, and only reads the output of its own jobs.  The registered
+ * threads are scanned by signal handlers without taking a lock: a slot is
+ * only marked active once its thread has been stored, and a thread that
+ * leaves waits until no handler is scanning before its slot can be reused.
+ */
+#define MAX_JOB_THREADS 256
+
+static pthread_t job_threads[MAX_JOB_THREADS];
+static int job_thread_active[MAX_JOB_THREADS];
+static int forwarders;
+static pthread_mutex_t job_threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread int job_thread_slot = -1;
+
+static int register_thread(void) {
+    int slot = -1;
+    pthread_mutex_lock(&job_threads_lock);
+    for(int i = 0; i < MAX_JOB_THREADS; i++)
+    {
+        if(!__atomic_load_n(&job_thread_active[i], __ATOMIC_SEQ_CST))
+        {
+            slot = i;
+            job_threads[i] = pthread_self();
+            __atomic_store_n(&job_thread_active[i], 1, __ATOMIC_SEQ_CST);
+            break;
         }
     }
-    errno = olderrno;
-    sigprocmask(SIG_SETMASK, &prev_all, NULL);
-    return;
+    pthread_mutex_unlock(&job_threads_lock);
+    job_thread_slot = slot;
+    return slot;
+}
+
+static void unregister_thread(void) {
+    if(job_thread_slot < 0)
+        return;
+    __atomic_store_n(&job_thread_active[job_thread_slot], 0, __ATOMIC_SEQ_CST);
+    while(__atomic_load_n(&forwarders, __ATOMIC_SEQ_CST) > 0)
+        sched_yield();
+    job_thread_slot = -1;
 }
 
-static void io_handler(int sig){
+/*
+ * Pass a signal that did not come from another registered thread on to
+ * all of them.
+ */
+static void forward_signal(int sig, siginfo_t *info) {
+    if(info->si_code == SI_TKILL)
+        return;
+    __atomic_add_fetch(&forwarders, 1, __ATOMIC_SEQ_CST);
+    for(int i = 0; i < MAX_JOB_THREADS; i++)
+    {
+        if(i != job_thread_slot
+           && __atomic_load_n(&job_thread_active[i], __ATOMIC_SEQ_CST))
+            pthread_kill(job_threads[i], sig);
+    }
+    __atomic_sub_fetch(&forwarders, 1, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Reap the leader processes of the running jobs of this thread that have
+ * terminated.  Only these are waited for, so that the children of other
+ * interpreters in the process are left to them.
+ */
+static void child_handler(int sig, siginfo_t *info, void *context) {
     sigset_t mask_all, prev_all;
     sigfillset(&mask_all);
     sigprocmask(SIG_BLOCK, &mask_all, &prev_all);
     int olderrno = errno;
-
-    JOB_NODE *target = jtable->head->next;
-    while(target != jtable->head)
+    forward_signal(sig, info);
+    for(JOB_NODE *job = jtable ? jtable->head->next : NULL;
+        job != NULL && job != jtable->head; job = job->next)
     {
-        read_output_capture(target);
-        target=target->next;
+        int chstatus;
+        if(job->pgid <= 0 || strcmp(job->status, "running") != 0
+           || waitpid(job->pgid, &chstatus, WNOHANG) <= 0)
+            continue;
+        switch(WEXITSTATUS(chstatus))
+        {
+            case EXIT_SUCCESS:
+                job->status = "completed";
+                break;
+            case SIGKILL:
+                job->status = "canceled";
+                break;
+            default:
+                job->status = "aborted";
+        }
+        job->exit_status = chstatus;
     }
-
     errno = olderrno;
     sigprocmask(SIG_SETMASK, &prev_all, NULL);
     return;
 }
 
+/*
+ * Captured output is not read here, as that may need memory to be
+ * allocated, but by the thread that owns the job, when the signal has
+ * woken it from waiting for the job or for a signal.
+ */
+static void io_handler(int sig, siginfo_t *info, void *context){
+    int olderrno = errno;
+    forward_signal(sig, info);
+    errno = olderrno;
+}
+
+/*
+ * Read whatever captured output is available from a job's pipe, which is
+ * non-blocking, straight into the job's output buffer.  The buffer grows
+ * geometrically and is kept null-terminated.
+ */
+#define CAPTURE_CHUNK 65536
+
 int read_output_capture(JOB_NODE *job){
     if(job->readfd == -1)
         return -1;
 
-    FILE *stream;
-    char *buf, c;
-    size_t len;
+    while(1)
+    {
+        if(job->output_size - job->output_len < CAPTURE_CHUNK + 1)
+        {
+            size_t size = job->output_size ? job->output_size : CAPTURE_CHUNK;
+            while(size - job->output_len < CAPTURE_CHUNK + 1)
+                size *= 2;
+            char *buf = (char *) realloc(job->job_output, size);
+            if(buf == NULL)
+                return -1;
+            job->job_output = buf;
+            job->output_size = size;
+        }
+        ssize_t n = read(job->readfd, job->job_output + job->output_len,
+                         CAPTURE_CHUNK);
+        if(n <= 0)
+            break;
+        job->output_len += n;
+    }
+    job->job_output[job->output_len] = '\0';
+    return 0;
+}
 
-    stream = open_memstream(&buf, &len);
-    while(read(job->readfd, &c, 1 ) > 0)
+static time_t cache_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+/*
+ * Get the value of a cache setting from the data store, or the default
+ * if the variable is not set to a nonnegative integer.
+ */
+static long cache_setting(char *var, long def) {
+    long val;
+    if(store_get_int(var, &val) < 0 || val < 0)
+        return def;
+    return val;
+}
+
+static unsigned long cache_hash(char *key, size_t len) {
+    unsigned long hash = 14695981039346656037UL;
+    for(size_t i = 0; i < len; i++)
     {
-        fprintf(stream, "%c", c);
+        hash ^= (unsigned char) key[i];
+        hash *= 1099511628211UL;
     }
-    fflush(stream);
-    char *result = (char *)malloc(len);
-    strncpy(result, buf, len);
+    return hash;
+}
 
-    fclose(stream);
-    if(len > 0)
+static void cache_remove(CACHE_ENTRY *entry) {
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    cache_bytes -= entry->size;
+    cache_count--;
+    free(entry->key);
+    free(entry->output);
+    free(entry);
+}
+
+/*
+ * Find the value of a variable in an environment, or NULL if it is not set.
+ */
+static char *env_value(char **envp, char *name) {
+    size_t len = strlen(name);
+    for(; *envp != NULL; envp++)
+    {
+        if(strncmp(*envp, name, len) == 0 && (*envp)[len] == '=')
+            return *envp + len + 1;
+    }
+    return NULL;
+}
+
+/*
+ * Build the cache key of a pipeline: the evaluated arguments of each
+ * command, the identity and modification time of the input file, and the
+ * values of the environment variables named by CACHE_ENV, as they will
+ * be seen by the commands.  NULL is returned if the pipeline cannot be
+ * cached.  The arguments are all evaluated before anything is allocated,
+ * since an error in evaluating one does not return here.
+ */
+static char *cache_key(PIPELINE *pline, size_t *lenp) {
+    char *key;
+    FILE *stream;
+    long nargs = 0, i = 0;
+
+    if(!pline->capture_output || pline->output_file != NULL)
+        return NULL;
+    for(COMMAND *cmd = pline->commands; cmd; cmd = cmd->next)
     {
-        if(job->job_output){
-            job->job_output = (char *) realloc(job->job_output, (1+len+strlen(job->job_output)));
-            job->job_output = strcat(job->job_output, result);
-            free(result);
+        for(ARG *arg = cmd->args; arg; arg = arg->next)
+            nargs++;
+    }
+    char *args[nargs + 1];
+    for(COMMAND *cmd = pline->commands; cmd; cmd = cmd->next)
+    {
+        for(ARG *arg = cmd->args; arg; arg = arg->next)
+            args[i++] = eval_to_string(arg->expr);
+    }
+    if((stream = open_memstream(&key, lenp)) == NULL)
+        return NULL;
+    i = 0;
+    for(COMMAND *cmd = pline->commands; cmd; cmd = cmd->next)
+    {
+        for(ARG *arg = cmd->args; arg; arg = arg->next, i++)
+            fwrite(args[i], 1, strlen(args[i]) + 1, stream);
+        fputc('|', stream);
+    }
+    if(pline->input_file)
+    {
+        struct stat sb;
+        if(stat(pline->input_file, &sb) < 0)
+        {
+            fclose(stream);
+            free(key);
+            return NULL;
         }
-        else{
-            job->job_output = result;
+        fprintf(stream, "<%s%c%lu:%lu:%ld.%09ld:%ld", pline->input_file, 0,
+                (unsigned long) sb.st_dev, (unsigned long) sb.st_ino,
+                (long) sb.st_mtim.tv_sec, sb.st_mtim.tv_nsec,
+                (long) sb.st_size);
+    }
+    char *names = store_get_string(CACHE_ENV_VAR);
+    if(names != NULL)
+    {
+        char *copy = strdup(names), *save, *name;
+        if(copy == NULL)
+        {
+            fclose(stream);
+            free(key);
+            return NULL;
         }
+        for(name = strtok_r(copy, " \t", &save); name;
+            name = strtok_r(NULL, " \t", &save))
+        {
+            char *val = env_value(store_environ(), name);
+            fprintf(stream, "%c%s=%s", 0, name, val ? val : "");
+        }
+        free(copy);
     }
-    return 0;
+    fclose(stream);
+    return key;
+}
+
+/*
+ * Find an unexpired cache entry for a key, making it the most recently
+ * used one.
+ */
+static CACHE_ENTRY *cache_lookup(char *key, size_t len) {
+    unsigned long hash = cache_hash(key, len);
+    time_t now = cache_clock();
+    for(CACHE_ENTRY *entry = cache_head.next; entry != &cache_head;
+        entry = entry->next)
+    {
+        if(entry->hash != hash || entry->key_len != len
+           || memcmp(entry->key, key, len) != 0)
+            continue;
+        if(entry->expires <= now)
+        {
+            cache_remove(entry);
+            return NULL;
+        }
+        entry->prev->next = entry->next;
+        entry->next->prev = entry->prev;
+        entry->next = cache_head.next;
+        entry->prev = &cache_head;
+        cache_head.next->prev = entry;
+        cache_head.next = entry;
+        return entry;
+    }
+    return NULL;
+}
+
+/*
+ * Record the result of a terminated job that was run with a cache key,
+ * taking over the key.  Jobs that were canceled are not cached.
+ */
+static void cache_store(JOB_NODE *job) {
+    char *key = job->cache_key;
+    size_t len = job->cache_key_len;
+    job->cache_key = NULL;
+    long ttl = cache_setting(CACHE_TTL_VAR, CACHE_DEFAULT_TTL);
+    size_t limit = cache_setting(CACHE_SIZE_VAR, CACHE_DEFAULT_SIZE);
+    size_t size = len + job->output_len + 1;
+    CACHE_ENTRY *entry;
+
+    if(strcmp(job->status, "canceled") == 0 || ttl == 0 || size > limit
+       || (entry = (CACHE_ENTRY *) calloc(1, sizeof(CACHE_ENTRY))) == NULL)
+    {
+        free(key);
+        return;
+    }
+    /* A result for the same key may have been stored meanwhile. */
+    CACHE_ENTRY *old = cache_lookup(key, len);
+    if(old != NULL)
+        cache_remove(old);
+    while(cache_bytes + size > limit)
+        cache_remove(cache_head.prev);
+    entry->key = key;
+    entry->key_len = len;
+    entry->hash = cache_hash(key, len);
+    entry->status = job->status;
+    entry->exit_status = job->exit_status;
+    if(job->output_len && (entry->output = (char *) malloc(job->output_len + 1)))
+    {
+        memcpy(entry->output, job->job_output, job->output_len + 1);
+        entry->output_len = job->output_len;
+    }
+    entry->size = size;
+    entry->expires = cache_clock() + ttl;
+    entry->next = cache_head.next;
+    entry->prev = &cache_head;
+    cache_head.next->prev = entry;
+    cache_head.next = entry;
+    cache_bytes += size;
+    cache_count++;
+}
+
+/*
+ * Add a new job to the end of the jobs table.
+ */
+static JOB_NODE *add_job(pid_t pgid, int readfd, PIPELINE *pline) {
+    JOB_NODE *new_job = (JOB_NODE *) malloc(sizeof(JOB_NODE));
+    new_job->job_id = jid++;
+    new_job->pgid = pgid;
+    new_job->status = "new";
+    new_job->exit_status = -1;
+    new_job->readfd = readfd;
+    new_job->pipeline = copy_pipeline(pline);
+    new_job->job_output = NULL;
+    new_job->output_len = 0;
+    new_job->output_size = 0;
+    new_job->cache_key = NULL;
+    new_job->cache_key_len = 0;
+
+    /*Set the links. */
+    jtable->head->prev->next = new_job;
+    new_job->prev = jtable->head->prev;
+    new_job->next = jtable->head;
+    jtable->head->prev = new_job;
+    return new_job;
 }
 
 
 /**
  * @brief  Initialize the jobs module.
  * @details  This function is used to initialize the jobs module.
- * It must be called exactly once, before any other functions of this
- * module are called.
+ * It must be called exactly once on each thread that hosts an interpreter,
+ * before any other functions of this module are called on that thread.
  *
  * @return 0 if initialization is successful, otherwise -1.
  */
 int jobs_init(void) {
-    signal(SIGCHLD, child_handler);
-    signal(SIGIO, io_handler);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sa.sa_sigaction = child_handler;
+    sigaction(SIGCHLD, &sa, NULL);
+    sa.sa_sigaction = io_handler;
+    sigaction(SIGIO, &sa, NULL);
+    cache_head.next = cache_head.prev = &cache_head;
+    if(register_thread() < 0) return -1;
     jtable = (JOB_TABLE *) malloc(sizeof(JOB_TABLE));
     if(jtable == NULL) return -1;
     JOB_NODE *dummy_head = (JOB_NODE *) malloc(sizeof(JOB_NODE));
@@ -168,6 +499,7 @@ int jobs_init(void) {
     jtable->head->readfd = -1;
     jtable->head->pipeline = NULL;
     jtable->head->job_output = NULL;
+    jtable->head->cache_key = NULL;
     return 0;
 }
 
@@ -188,13 +520,20 @@ int jobs_fini(void) {
     JOB_NODE *current_job = jtable->head->next;
     while(current_job != jtable->head)
     {
+        JOB_NODE *next_job = current_job->next;
         if(jobs_poll(current_job->job_id) < 0){
             if(jobs_cancel(current_job->job_id) <0) return -1;
+            jobs_wait(current_job->job_id);
         }
         if(jobs_expunge(current_job->job_id) <0) return -1;
-        current_job = current_job->next;
+        current_job = next_job;
     }
 
+    while(cache_head.next != &cache_head)
+        cache_remove(cache_head.next);
+    cache_hits = cache_misses = 0;
+    jid = 0;
+    unregister_thread();
     free(jtable->head);
     free(jtable);
     jtable = NULL;
@@ -238,6 +577,19 @@ int jobs_show(FILE *file) {
 
 }
 
+/**
+ * @brief  Print the statistics of the result cache.
+ * @details  This function prints a line giving the numbers of times that
+ * pipelines run with "cached" found a result in the cache and did not,
+ * and the number and total size of the results held in the cache.
+ *
+ * @param file  The output stream to which the statistics are to be printed.
+ */
+void jobs_show_cache(FILE *file) {
+    fprintf(file, "%ld hits, %ld misses, %ld entries, %zu bytes\n",
+        cache_hits, cache_misses, cache_count, cache_bytes);
+}
+
 /**
  * @brief  Create a new job to run a pipeline.
  * @details  This function creates a new job and starts it running a specified
@@ -278,6 +630,37 @@ int jobs_run(PIPELINE *pline) {
 
     sigset_t mask_all, prev_all;
     sigfillset(&mask_all);
+
+    /* A cached result is replayed without running anything. */
+    char *key = NULL;
+    size_t key_len = 0;
+    if(pline->cached && (key = cache_key(pline, &key_len)) != NULL)
+    {
+        CACHE_ENTRY *entry = cache_lookup(key, key_len);
+        if(entry != NULL)
+        {
+            cache_hits++;
+            free(key);
+            sigprocmask(SIG_BLOCK, &mask_all, &prev_all);
+            JOB_NODE *job = add_job(0, -1, pline);
+            job->status = entry->status;
+            job->exit_status = entry->exit_status;
+            if(entry->output
+               && (job->job_output = (char *) malloc(entry->output_len + 1)))
+            {
+                memcpy(job->job_output, entry->output, entry->output_len + 1);
+                job->output_len = entry->output_len;
+                job->output_size = entry->output_len + 1;
+            }
+            sigprocmask(SIG_SETMASK, &prev_all, NULL);
+            return job->job_id;
+        }
+        cache_misses++;
+    }
+
+    /* Built before forking, so that it is kept for the next pipeline. */
+    char **envp = store_environ();
+
     sigprocmask(SIG_BLOCK, &mask_all, &prev_all);
 
     int cofd[2];
@@ -371,6 +754,7 @@ int jobs_run(PIPELINE *pline) {
                 // output cap
                 if(close(cofd[0])<0 || close(cofd[1])<0) exit(EXIT_FAILURE);
                 /* Each child process execvp the command. */
+                environ = envp;
                 if(execvp(argv[0], argv)<0)
                 {
                     perror("execvp failed");
@@ -399,8 +783,7 @@ int jobs_run(PIPELINE *pline) {
 
         if(pline->capture_output)
         {
-            fcntl(cofd[0], F_SETFL, O_NONBLOCK);
-            fcntl(cofd[0], F_SETFL, O_ASYNC);
+            fcntl(cofd[0], F_SETFL, O_NONBLOCK | O_ASYNC);
             fcntl(cofd[0], F_SETOWN, getpid());
         }
         else{
@@ -409,21 +792,9 @@ int jobs_run(PIPELINE *pline) {
         }
 
 
-        JOB_NODE *new_job = (JOB_NODE *) malloc(sizeof(JOB_NODE));
-        new_job->job_id = jid++;
-        new_job->pgid = pid;
-        new_job->status = "new";
-        new_job->exit_status = -1;
-        new_job->readfd = cofd[0];
-        new_job->pipeline = copy_pipeline(pline);
-        new_job->job_output = NULL;
-
-        /*Set the links. */
-        jtable->head->prev->next = new_job;
-        new_job->prev = jtable->head->prev;
-        new_job->next = jtable->head;
-        jtable->head->prev = new_job;
-
+        JOB_NODE *new_job = add_job(pid, cofd[0], pline);
+        new_job->cache_key = key;
+        new_job->cache_key_len = key_len;
 
         new_job->status = "running";
 
@@ -436,26 +807,6 @@ int jobs_run(PIPELINE *pline) {
 
 }
 
-int change_job_status(pid_t pid, char *status, int exit_status){
-    if(jtable == NULL)
-        return -1;
-
-    /* Find the job. */
-    JOB_NODE *target = jtable->head->next;
-    while(target != jtable->head)
-    {
-        if(target->pgid == pid)
-        {
-            target->status = status;
-            target->exit_status = exit_status;
-            return 0;
-        }
-        target = target->next;
-    }
-
-    return -1;
-}
-
 /**
  * @brief  Wait for a job to terminate.
  * @details  This function is used to wait for the job with a specified job ID
@@ -473,6 +824,8 @@ int jobs_wait(int jobid) {
     sigset_t new_mask;
     sigfillset(&new_mask);
     sigdelset(&new_mask, SIGCHLD);
+    /* Keep reading captured output, so that the job cannot fill the pipe. */
+    sigdelset(&new_mask, SIGIO);
 
     //int status;
     /* Find the job. */
@@ -489,13 +842,27 @@ int jobs_wait(int jobid) {
             //     return status;
             // }
             // return -1;
+            /*
+             * Signals are blocked between checking the status and waiting,
+             * so that none can be missed.  Output that filled the pipe
+             * before SIGIO was enabled is read here, as no signal will
+             * be sent for it.
+             */
+            sigset_t mask_all, prev_all;
+            sigfillset(&mask_all);
+            sigprocmask(SIG_BLOCK, &mask_all, &prev_all);
             while(1){
                 if( (strcmp(target->status, "completed") == 0)
                     || (strcmp(target->status, "aborted") == 0)
                     || (strcmp(target->status, "canceled") == 0))
                 {
+                    sigprocmask(SIG_SETMASK, &prev_all, NULL);
                     return target->exit_status;
                 }
+                /* Other jobs running meanwhile must not fill their pipes. */
+                for(JOB_NODE *job = jtable->head->next; job != jtable->head;
+                    job = job->next)
+                    read_output_capture(job);
                 sigsuspend(&new_mask);
             }
         }
@@ -532,6 +899,8 @@ int jobs_poll(int jobid) {
             // if(WIFSTOPPED(status)|WIFSIGNALED(status)|WIFEXITED(status))
             //     return status;
             // return -1;
+            /* Keep a job that is not waited for from filling the pipe. */
+            read_output_capture(target);
             if( (strcmp(target->status, "completed") == 0)
                 || (strcmp(target->status, "aborted") == 0)
                 || (strcmp(target->status, "canceled") == 0))
@@ -574,7 +943,8 @@ int jobs_expunge(int jobid) {
             target->prev = NULL;
             target->next = NULL;
 
-            // free the job node
+            // record the result of a cached pipeline, then free the job node
+            if(target->cache_key) cache_store(target);
             if(target->pipeline) free_pipeline(target->pipeline);
             if(target->job_output) free(target->job_output);
             if(target->readfd != -1){
@@ -648,13 +1018,55 @@ char *jobs_get_output(int jobid) {
     {
         if(current_job->job_id == jobid)
         {
-            return current_job->job_output;
+            /*
+             * Output that arrived just before the job terminated may not
+             * have been read yet.
+             */
+            if(jobs_poll(jobid) != -1)
+            {
+                sigset_t mask_all, prev_all;
+                sigfillset(&mask_all);
+                sigprocmask(SIG_BLOCK, &mask_all, &prev_all);
+                read_output_capture(current_job);
+                sigprocmask(SIG_SETMASK, &prev_all, NULL);
+            }
+            return current_job->output_len ? current_job->job_output : NULL;
         }
         current_job=current_job->next;
     }
     return NULL;
 }
 
+/**
+ * @brief  Take the captured output of a job.
+ * @details  This function is like jobs_get_output(), except that the buffer
+ * holding the output is handed over to the caller, who becomes responsible
+ * for freeing it, and the job no longer has any captured output.  This lets
+ * a large output be stored in a variable without being copied.
+ *
+ * @param  jobid  The job ID of the job for which captured output is to be taken.
+ * @param  lenp  Pointer at which the length of the output is to be stored.
+ * @return  The captured output, if the job has terminated and there is captured
+ * output available, otherwise NULL.
+ */
+char *jobs_release_output(int jobid, size_t *lenp) {
+    char *output = jobs_get_output(jobid);
+    if(output == NULL)
+        return NULL;
+
+    JOB_NODE *current_job = jtable->head->next;
+    while(current_job->job_id != jobid)
+        current_job = current_job->next;
+    /* A cached result is recorded while the job still has its output. */
+    if(current_job->cache_key)
+        cache_store(current_job);
+    *lenp = current_job->output_len;
+    current_job->job_output = NULL;
+    current_job->output_len = 0;
+    current_job->output_size = 0;
+    return output;
+}
+
 /**
  * @brief  Pause waiting for a signal indicating a potential job status change.
  * @details  When this function is called it blocks until some signal has been
@@ -665,5 +1077,142 @@ char *jobs_get_output(int jobid) {
  */
 int jobs_pause(void) {
     pause();
+    /* The signal may have been for output, which is read here. */
+    for(JOB_NODE *job = jtable ? jtable->head->next : NULL;
+        job != NULL && job != jtable->head; job = job->next)
+        read_output_capture(job);
+    return 0;
+}
+
+/*
+ * Statuses of terminated jobs, as numbered in a snapshot.
+ */
+static char *final_status[] = { "completed", "aborted", "canceled" };
+
+/**
+ * @brief  Write the terminated jobs to a snapshot.
+ * @details  This function writes the next job ID to be used and, for each
+ * job that has terminated but has not been expunged, its job ID, status,
+ * exit status, pipeline and captured output, so that a program restored
+ * from the snapshot can still wait for it and collect its output.  Jobs
+ * that are still running are not written, as their processes cannot be
+ * saved.
+ *
+ * @param f  The stream to which the snapshot is being written.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int jobs_save(FILE *f) {
+    long count = 0;
+    JOB_NODE *job;
+
+    snap_put_num(f, jid);
+    if(jtable == NULL)
+    {
+        snap_put_num(f, 0);
+        return ferror(f) ? -1 : 0;
+    }
+    for(job = jtable->head->next; job != jtable->head; job = job->next)
+    {
+        if(jobs_poll(job->job_id) != -1)
+            count++;
+    }
+    snap_put_num(f, count);
+    for(job = jtable->head->next; job != jtable->head; job = job->next)
+    {
+        if(jobs_poll(job->job_id) == -1)
+            continue;
+        int state = 0;
+        while(strcmp(job->status, final_status[state]) != 0)
+            state++;
+        /* Collect any output still waiting in the pipe. */
+        jobs_get_output(job->job_id);
+        snap_put_num(f, job->job_id);
+        snap_put_num(f, state);
+        snap_put_num(f, job->exit_status);
+        save_pipeline(f, job->pipeline);
+        snap_put_bytes(f, job->job_output, job->output_len);
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+/**
+ * @brief  Replace the terminated jobs with those read from a snapshot.
+ * @details  This function reads what jobs_save() wrote.  It fails without
+ * changing anything if any job is still running, or if the snapshot turns
+ * out to be damaged.  Otherwise the jobs that have terminated are
+ * expunged, and the jobs read take their place with their original job
+ * IDs, as jobs that have terminated and have no processes.
+ *
+ * @param snap  The snapshot being read.
+ * @return  0 if successful, -1 if any job is running or the snapshot was
+ * damaged.
+ */
+int jobs_restore(SNAP *snap) {
+    JOB_NODE *job, *next_job;
+
+    if(jtable == NULL)
+        return -1;
+    for(job = jtable->head->next; job != jtable->head; job = job->next)
+    {
+        if(jobs_poll(job->job_id) == -1)
+            return -1;
+    }
+
+    /* Read the jobs into a list of their own first. */
+    JOB_NODE list = { .prev = &list, .next = &list };
+    int saved_jid = snap_get_num(snap);
+    long count = snap_get_num(snap);
+    if(count < 0 || count > snap->end - snap->pos)
+        snap->error = 1;
+    for(long i = 0; i < count && !snap->error; i++)
+    {
+        job = (JOB_NODE *) calloc(1, sizeof(JOB_NODE));
+        job->job_id = snap_get_num(snap);
+        long state = snap_get_num(snap);
+        job->status = final_status[state >= 0 && state < 3 ? state : 0];
+        job->exit_status = snap_get_num(snap);
+        job->readfd = -1;
+        job->pipeline = load_pipeline(snap);
+        size_t len;
+        char *output = snap_get_bytes(snap, &len);
+        if(len > 0 && (job->job_output = (char *) malloc(len + 1)) != NULL)
+        {
+            memcpy(job->job_output, output, len);
+            job->job_output[len] = '\0';
+            job->output_len = len;
+            job->output_size = len + 1;
+        }
+        if(state < 0 || state >= 3 || job->job_id < 0 || job->job_id >= saved_jid)
+            snap->error = 1;
+        list.prev->next = job;
+        job->prev = list.prev;
+        job->next = &list;
+        list.prev = job;
+    }
+    if(snap->error)
+    {
+        for(job = list.next; job != &list; job = next_job)
+        {
+            next_job = job->next;
+            free_pipeline(job->pipeline);
+            free(job->job_output);
+            free(job);
+        }
+        return -1;
+    }
+
+    for(job = jtable->head->next; job != jtable->head; job = next_job)
+    {
+        next_job = job->next;
+        jobs_expunge(job->job_id);
+    }
+    if(list.next != &list)
+    {
+        list.next->prev = jtable->head;
+        list.prev->next = jtable->head;
+        jtable->head->next = list.next;
+        jtable->head->prev = list.prev;
+    }
+    jid = saved_jid;
     return 0;
 }
@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "mush.h"
+#include "debug.h"
+
+/*
+ * This is the "library" module for Mush.
+ * It lets a program that is linked with libmush.a host interpreters of its
+ * own, rather than running the mush executable.  The state of each of the
+ * other modules (program store, data store, jobs table, execution engine,
+ * parser and scanner) is kept per thread, so a process can host any number
+ * of independent interpreters, each on its own thread.  An interpreter is
+ * made with mush_open(), given scripts to run with mush_eval(), and freed
+ * with mush_close(), all on the thread that made it; a thread can host
+ * only one interpreter at a time.  The children run by the jobs of all the
+ * interpreters are reaped by the jobs module, each by its own interpreter.
+ */
+
+extern __thread FILE *yyin;
+extern __thread int mush_parse_errors;
+
+struct mush {
+    pthread_t thread;
+};
+
+static __thread MUSH *current;
+
+/*
+ * Check that an interpreter is hosted by the calling thread.
+ */
+static int owned(MUSH *mush) {
+    if(mush == NULL || mush != current)
+    {
+        errno = EPERM;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief  Create an interpreter on the calling thread.
+ * @details  This function initializes a new interpreter, with an empty
+ * program, no variables and no jobs, which is hosted by the calling thread
+ * until it is closed.
+ *
+ * @return  A handle for the interpreter, or NULL if the calling thread
+ * already hosts one (with errno set to EBUSY) or it could not be made.
+ */
+MUSH *mush_open(void) {
+    if(current != NULL)
+    {
+        errno = EBUSY;
+        return NULL;
+    }
+    MUSH *mush = (MUSH *) malloc(sizeof(MUSH));
+    if(mush == NULL)
+        return NULL;
+    if(jobs_init() < 0)
+    {
+        free(mush);
+        errno = EAGAIN;
+        return NULL;
+    }
+    mush->thread = pthread_self();
+    current = mush;
+    return mush;
+}
+
+/**
+ * @brief  Run a script in an interpreter.
+ * @details  This function runs the statements of a script, given as a
+ * string, as if they had been read by the mush executable from its
+ * standard input.  Statements with line numbers are added to the program
+ * of the interpreter, and the others are executed, so the program,
+ * variables and jobs left by one script can be used by the next.
+ *
+ * @param  mush  The interpreter, which must be hosted by the calling thread.
+ * @param  script  The text of the script.
+ * @return  0 if the script was run without syntax errors, otherwise -1.
+ */
+int mush_eval(MUSH *mush, char *script) {
+    if(!owned(mush))
+        return -1;
+    size_t len = strlen(script);
+    if(len == 0)
+        return 0;
+    FILE *in = fmemopen(script, len, "r");
+    if(in == NULL)
+        return -1;
+    int errors = mush_parse_errors;
+    yyin = in;
+    exec_interactive();
+    fclose(in);
+    yyin = NULL;
+    return mush_parse_errors == errors ? 0 : -1;
+}
+
+/**
+ * @brief  Get the value of a variable of an interpreter.
+ *
+ * @param  mush  The interpreter, which must be hosted by the calling thread.
+ * @param  var  The name of the variable.
+ * @return  A copy of the value of the variable as a string, which the
+ * caller is to free, or NULL if the variable has no string value.
+ */
+char *mush_get(MUSH *mush, char *var) {
+    if(!owned(mush))
+        return NULL;
+    char *val = store_get_string(var);
+    return val ? strdup(val) : NULL;
+}
+
+/**
+ * @brief  Set the value of a variable of an interpreter.
+ *
+ * @param  mush  The interpreter, which must be hosted by the calling thread.
+ * @param  var  The name of the variable.
+ * @param  val  The value to give it, or NULL to unset it.
+ * @return  0 if successful, otherwise -1.
+ */
+int mush_set(MUSH *mush, char *var, char *val) {
+    if(!owned(mush))
+        return -1;
+    return store_set_string(var, val);
+}
+
+/**
+ * @brief  Close an interpreter.
+ * @details  This function cancels the jobs of the interpreter that are
+ * still running and waits for them, then frees its program, variables
+ * and everything else it holds.  The calling thread can then host another
+ * interpreter.
+ *
+ * @param  mush  The interpreter, which must be hosted by the calling thread.
+ * @return  0 if successful, otherwise -1.
+ */
+int mush_close(MUSH *mush) {
+    if(!owned(mush))
+        return -1;
+    int ret = jobs_fini();
+    exec_fini();
+    prog_fini();
+    store_fini();
+    current = NULL;
+    free(mush);
+    return ret;
+}
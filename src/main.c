@@ -2,10 +2,57 @@
 #include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "mush.h"
 
+/*
+ * Usage:
+ *   mush                       read statements from the standard input
+ *   mush -S socket             serve scripts to clients on a socket
+ *   mush -c socket [file]      run a script in the server on a socket
+ *   mush -p table [-j workers] [-r vars] file
+ *                              run a script once for each row of a table
+ */
 int main(int argc, char *argv[]) {
+    char *serve = NULL, *connect = NULL, *table = NULL, *report = NULL;
+    int workers = 0;
+    int opt;
+    while((opt = getopt(argc, argv, "S:c:p:j:r:")) != -1) {
+        switch(opt) {
+        case 'S':
+            serve = optarg;
+            break;
+        case 'c':
+            connect = optarg;
+            break;
+        case 'p':
+            table = optarg;
+            break;
+        case 'j':
+            workers = atoi(optarg);
+            break;
+        case 'r':
+            report = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-S socket | -c socket [file] |"
+                    " -p table [-j workers] [-r vars] file]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if(table) {
+        if(optind >= argc) {
+            fprintf(stderr, "%s: -p needs a script to run\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        exit(parallel_run(argv[optind], table, workers, report) == 0
+             ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    if(connect)
+        exit(client_run(connect, optind < argc ? argv[optind] : NULL));
+    if(serve)
+        exit(server_run(serve) < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
     jobs_init();
     exec_interactive();
     jobs_fini();
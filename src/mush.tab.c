@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.5.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison implementation for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2020 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -34,6 +34,10 @@
 /* C LALR(1) parser skeleton written by Richard Stallman, by
    simplifying the original so-called "semantic" parser.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
 /* All symbols defined below should begin with yy or YY, to avoid
    infringing on user name space.  This should be done even for local
    variables, as they might otherwise be expanded by user macros.
@@ -41,20 +45,17 @@
    define necessary library symbols; they are noted "INFRINGES ON
    USER NAME SPACE" below.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
-
-/* Identify Bison output.  */
-#define YYBISON 1
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
 
-/* Bison version.  */
-#define YYBISON_VERSION "3.5.1"
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
 
 /* Skeleton name.  */
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -81,13 +82,27 @@
 #include "mush.h"
 #include "mush.tab.h"
 
-STMT *mush_parsed_stmt;
+/*
+ * The parser and the scanner keep their state per thread, so that each
+ * interpreter hosted by a process can parse its own input on its own thread.
+ */
+__thread STMT *mush_parsed_stmt;
+
+/*
+ * Number of syntax errors found so far, and whether to report them.
+ * A script parsed ahead of time by the server is parsed quietly, and
+ * parsed again where its errors can be reported if it has any.
+ */
+__thread int mush_parse_errors;
+__thread int mush_parse_quiet;
 
 int yylex();
 int yyparse();
 
 void yyerror(const char *str) {
-    fprintf(stderr, "error: %s\n", str);
+    mush_parse_errors++;
+    if(!mush_parse_quiet)
+	fprintf(stderr, "error: %s\n", str);
 }
 
 int yywrap() {
@@ -95,7 +110,7 @@ int yywrap() {
 }
 
 
-#line 99 "src/mush.tab.c"
+#line 114 "src/mush.tab.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -118,107 +133,371 @@ int yywrap() {
 #  endif
 # endif
 
-/* Enabling verbose error messages.  */
-#ifdef YYERROR_VERBOSE
-# undef YYERROR_VERBOSE
-# define YYERROR_VERBOSE 1
-#else
-# define YYERROR_VERBOSE 1
-#endif
+#include "mush.tab.h"
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_NUMBER = 3,                     /* NUMBER  */
+  YYSYMBOL_NAME = 4,                       /* NAME  */
+  YYSYMBOL_WORD = 5,                       /* WORD  */
+  YYSYMBOL_STRING = 6,                     /* STRING  */
+  YYSYMBOL_FUNCTION = 7,                   /* FUNCTION  */
+  YYSYMBOL_LIST = 8,                       /* LIST  */
+  YYSYMBOL_DELETE = 9,                     /* DELETE  */
+  YYSYMBOL_RUN = 10,                       /* RUN  */
+  YYSYMBOL_CONT = 11,                      /* CONT  */
+  YYSYMBOL_STOP = 12,                      /* STOP  */
+  YYSYMBOL_BG = 13,                        /* BG  */
+  YYSYMBOL_CAPTURE = 14,                   /* CAPTURE  */
+  YYSYMBOL_WAIT = 15,                      /* WAIT  */
+  YYSYMBOL_POLL = 16,                      /* POLL  */
+  YYSYMBOL_CANCEL = 17,                    /* CANCEL  */
+  YYSYMBOL_PAUSE = 18,                     /* PAUSE  */
+  YYSYMBOL_SET = 19,                       /* SET  */
+  YYSYMBOL_UNSET = 20,                     /* UNSET  */
+  YYSYMBOL_IF = 21,                        /* IF  */
+  YYSYMBOL_GOTO = 22,                      /* GOTO  */
+  YYSYMBOL_SOURCE = 23,                    /* SOURCE  */
+  YYSYMBOL_FOR = 24,                       /* FOR  */
+  YYSYMBOL_TO = 25,                        /* TO  */
+  YYSYMBOL_STEP = 26,                      /* STEP  */
+  YYSYMBOL_NEXT = 27,                      /* NEXT  */
+  YYSYMBOL_APPEND = 28,                    /* APPEND  */
+  YYSYMBOL_READ = 29,                      /* READ  */
+  YYSYMBOL_WRITE = 30,                     /* WRITE  */
+  YYSYMBOL_PUSH = 31,                      /* PUSH  */
+  YYSYMBOL_POP = 32,                       /* POP  */
+  YYSYMBOL_KEYS = 33,                      /* KEYS  */
+  YYSYMBOL_SPLIT = 34,                     /* SPLIT  */
+  YYSYMBOL_BY = 35,                        /* BY  */
+  YYSYMBOL_CACHED = 36,                    /* CACHED  */
+  YYSYMBOL_EXPORT = 37,                    /* EXPORT  */
+  YYSYMBOL_IMPORT = 38,                    /* IMPORT  */
+  YYSYMBOL_AS = 39,                        /* AS  */
+  YYSYMBOL_SAVE = 40,                      /* SAVE  */
+  YYSYMBOL_RESTORE = 41,                   /* RESTORE  */
+  YYSYMBOL_EQ = 42,                        /* EQ  */
+  YYSYMBOL_PIPE = 43,                      /* PIPE  */
+  YYSYMBOL_LESS = 44,                      /* LESS  */
+  YYSYMBOL_GREATER = 45,                   /* GREATER  */
+  YYSYMBOL_EQUAL = 46,                     /* EQUAL  */
+  YYSYMBOL_LESSEQ = 47,                    /* LESSEQ  */
+  YYSYMBOL_GREATEQ = 48,                   /* GREATEQ  */
+  YYSYMBOL_AND = 49,                       /* AND  */
+  YYSYMBOL_OR = 50,                        /* OR  */
+  YYSYMBOL_NOT = 51,                       /* NOT  */
+  YYSYMBOL_LPAREN = 52,                    /* LPAREN  */
+  YYSYMBOL_RPAREN = 53,                    /* RPAREN  */
+  YYSYMBOL_PLUS = 54,                      /* PLUS  */
+  YYSYMBOL_MINUS = 55,                     /* MINUS  */
+  YYSYMBOL_TIMES = 56,                     /* TIMES  */
+  YYSYMBOL_DIVIDE = 57,                    /* DIVIDE  */
+  YYSYMBOL_MOD = 58,                       /* MOD  */
+  YYSYMBOL_COMMA = 59,                     /* COMMA  */
+  YYSYMBOL_SHARP = 60,                     /* SHARP  */
+  YYSYMBOL_DOLLAR = 61,                    /* DOLLAR  */
+  YYSYMBOL_EOL = 62,                       /* EOL  */
+  YYSYMBOL_EoF = 63,                       /* EoF  */
+  YYSYMBOL_UNKNOWN = 64,                   /* UNKNOWN  */
+  YYSYMBOL_CONCAT = 65,                    /* CONCAT  */
+  YYSYMBOL_LBRACKET = 66,                  /* LBRACKET  */
+  YYSYMBOL_RBRACKET = 67,                  /* RBRACKET  */
+  YYSYMBOL_CONTAINS = 68,                  /* CONTAINS  */
+  YYSYMBOL_MATCHES = 69,                   /* MATCHES  */
+  YYSYMBOL_YYACCEPT = 70,                  /* $accept  */
+  YYSYMBOL_statement = 71,                 /* statement  */
+  YYSYMBOL_pipeline = 72,                  /* pipeline  */
+  YYSYMBOL_command_list = 73,              /* command_list  */
+  YYSYMBOL_command = 74,                   /* command  */
+  YYSYMBOL_arg_list = 75,                  /* arg_list  */
+  YYSYMBOL_arg = 76,                       /* arg  */
+  YYSYMBOL_atomic_expr = 77,               /* atomic_expr  */
+  YYSYMBOL_expr_list = 78,                 /* expr_list  */
+  YYSYMBOL_expr = 79,                      /* expr  */
+  YYSYMBOL_numeric_var = 80,               /* numeric_var  */
+  YYSYMBOL_string_var = 81,                /* string_var  */
+  YYSYMBOL_optional_lineno = 82,           /* optional_lineno  */
+  YYSYMBOL_lineno = 83,                    /* lineno  */
+  YYSYMBOL_literal_number = 84,            /* literal_number  */
+  YYSYMBOL_literal_string = 85,            /* literal_string  */
+  YYSYMBOL_file = 86                       /* file  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
 
-/* Use api.header.include to #include this header
-   instead of duplicating it here.  */
-#ifndef YY_YY_INCLUDE_MUSH_TAB_H_INCLUDED
-# define YY_YY_INCLUDE_MUSH_TAB_H_INCLUDED
-/* Debug traces.  */
-#ifndef YYDEBUG
-# define YYDEBUG 1
-#endif
-#if YYDEBUG
-extern int yydebug;
-#endif
 
-/* Token type.  */
-#ifndef YYTOKENTYPE
-# define YYTOKENTYPE
-  enum yytokentype
-  {
-    NUMBER = 258,
-    NAME = 259,
-    WORD = 260,
-    STRING = 261,
-    LIST = 262,
-    DELETE = 263,
-    RUN = 264,
-    CONT = 265,
-    STOP = 266,
-    BG = 267,
-    CAPTURE = 268,
-    WAIT = 269,
-    POLL = 270,
-    CANCEL = 271,
-    PAUSE = 272,
-    SET = 273,
-    UNSET = 274,
-    IF = 275,
-    GOTO = 276,
-    SOURCE = 277,
-    EQ = 278,
-    PIPE = 279,
-    LESS = 280,
-    GREATER = 281,
-    EQUAL = 282,
-    LESSEQ = 283,
-    GREATEQ = 284,
-    AND = 285,
-    OR = 286,
-    NOT = 287,
-    LPAREN = 288,
-    RPAREN = 289,
-    PLUS = 290,
-    MINUS = 291,
-    TIMES = 292,
-    DIVIDE = 293,
-    MOD = 294,
-    COMMA = 295,
-    SHARP = 296,
-    DOLLAR = 297,
-    EOL = 298,
-    EoF = 299,
-    UNKNOWN = 300
-  };
-#endif
 
-/* Value type.  */
-#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-union YYSTYPE
-{
-#line 30 "src/mush.y"
+/* Unqualified %code blocks.  */
+#line 101 "src/mush.y"
 
-    int number;
-    char *string;
-    STMT *stmt;
-    EXPR *expr;	
-    ARG *args;
-    COMMAND *cmds;
-    PIPELINE *pline;
+#include <ctype.h>
 
-#line 207 "src/mush.tab.c"
+/*
+ * The parser is pure, and keeps the value of its lookahead token to itself.
+ * The scanner leaves the value of each token it returns in "yylval", which,
+ * like the rest of its state, is kept per thread.
+ */
+__thread YYSTYPE yylval;
 
+/*
+ * The scanner in mush.lex.c only knows about the reserved words that
+ * existed when it was generated.  Reserved words added since then are
+ * returned by the scanner as NAME tokens, and are recognized here before
+ * they reach the parser.  A word with a nonzero "within" field is only
+ * reserved inside a statement that begins with that token, so that it
+ * remains usable as an ordinary word everywhere else.  A word whose
+ * "within" field is LEADING is only reserved as the first word of a
+ * statement, and one whose "within" field is LEADING_OP only if, in
+ * addition, it is followed by a name and then "<", ">" or "=".  This lets
+ * commands of the same name still be run with arguments that are not of
+ * the form used by the statement.
+ */
+#define LEADING (-1)
+#define LEADING_OP (-2)
+
+static struct keyword {
+    char *word;
+    int token;
+    int within;
+} keywords[] = {
+    { "for",  FOR,  LEADING },
+    { "next", NEXT, LEADING },
+    { "append", APPEND, LEADING_OP },
+    { "read", READ, LEADING_OP },
+    { "write", WRITE, LEADING_OP },
+    { "push", PUSH, LEADING_OP },
+    { "pop", POP, LEADING },
+    { "keys", KEYS, LEADING_OP },
+    { "split", SPLIT, LEADING_OP },
+    { "cached", CACHED, LEADING },
+    { "export", EXPORT, LEADING },
+    { "import", IMPORT, LEADING },
+    { "save", SAVE, LEADING },
+    { "restore", RESTORE, LEADING },
+    { "to",   TO,   FOR },
+    { "step", STEP, FOR },
+    { "by",   BY,   SPLIT },
+    { "as",   AS,   IMPORT },
+    { NULL,   0,    0 }
 };
-typedef union YYSTYPE YYSTYPE;
-# define YYSTYPE_IS_TRIVIAL 1
-# define YYSTYPE_IS_DECLARED 1
-#endif
 
+/*
+ * Statements whose operands are expressions rather than command words.
+ * Within these, and within parentheses anywhere, a lone "." (which the
+ * scanner returns as a WORD) is the concatenation operator, and the words
+ * in the table below are operators if they follow an operand.
+ */
+static int expr_leaders[] = {
+    SET, IF, WAIT, POLL, CANCEL, FOR, APPEND, PUSH, SPLIT, EXPORT, 0
+};
+
+static struct keyword operators[] = {
+    { "contains", CONTAINS, 0 },
+    { "matches",  MATCHES,  0 },
+    { NULL,       0,        0 }
+};
+
+/*
+ * Tokens that can end an operand, after which an operator may follow.
+ */
+static int ends_operand(int token) {
+    return token == NAME || token == WORD || token == STRING
+	|| token == NUMBER || token == RPAREN || token == RBRACKET;
+}
+
+/*
+ * Tokens that have been read ahead, to recognize calls of builtin functions,
+ * or split out of a word, to recognize array indexing.  They are returned
+ * (last in, first out) before the scanner is asked for any more.
+ */
+#define MAX_PENDING 64
+static __thread int pending[MAX_PENDING];
+static __thread YYSTYPE pending_val[MAX_PENDING];
+static __thread int npending = 0;
+
+static void unget_token(int token, YYSTYPE val) {
+    pending[npending] = token;
+    pending_val[npending++] = val;
+}
+
+static int next_token(void) {
+    if(npending) {
+	yylval = pending_val[--npending];
+	return pending[npending];
+    }
+    return yylex();
+}
+
+/*
+ * The scanner does not treat brackets as special, so "$a[#i]" comes back
+ * as "$" followed by the single word "a[#i]".  Split such a word into
+ * brackets, "$" and "#" signs and the words between them, and arrange for
+ * these to be returned in place of it.  Nothing is done if the word has
+ * no brackets, or too many pieces.
+ */
+static void split_word(char *word) {
+    int tokens[MAX_PENDING];
+    YYSTYPE vals[MAX_PENDING];
+    int n = 0;
+    char *cp = word;
+
+    if(!strpbrk(word, "[]"))
+	return;
+    while(*cp) {
+	if(n + npending == MAX_PENDING) {
+	    while(n > 0) {
+		if(vals[--n].string)
+		    free(vals[n].string);
+	    }
+	    return;
+	}
+	vals[n].string = NULL;
+	switch(*cp) {
+	case '[': tokens[n++] = LBRACKET; cp++; continue;
+	case ']': tokens[n++] = RBRACKET; cp++; continue;
+	case '$': tokens[n++] = DOLLAR; cp++; continue;
+	case '#': tokens[n++] = SHARP; cp++; continue;
+	}
+	size_t len = strcspn(cp, "[]$#");
+	vals[n].string = strndup(cp, len);
+	tokens[n++] = strspn(cp, "0123456789") >= len ? NUMBER : WORD;
+	cp += len;
+    }
+    free(word);
+    while(n > 0) {
+	n--;
+	unget_token(tokens[n], vals[n]);
+    }
+}
+
+/*
+ * The scanner only returns an identifier as a NAME if it is followed by
+ * white space, a parenthesis or a redirection, so that "x," or "x+" come
+ * back as WORD.  Such words are turned into names here, which lets variables
+ * and function arguments be written without surrounding spaces.
+ */
+static int is_name(char *str) {
+    if(!isalpha((unsigned char)*str) && *str != '_')
+	return 0;
+    while(*++str) {
+	if(!isalnum((unsigned char)*str) && *str != '_')
+	    return 0;
+    }
+    return 1;
+}
 
-extern YYSTYPE yylval;
+/*
+ * Look ahead to see whether the next two tokens are a name and then
+ * "<", ">" or "=".
+ */
+static int operator_follows(void) {
+    YYSTYPE val = yylval, val1, val2;
+    int token1, token2;
+    token1 = next_token();
+    val1 = yylval;
+    token2 = token1 == EOL || token1 == EoF ? EOL : next_token();
+    val2 = yylval;
+    if(token1 != EOL && token1 != EoF)
+	unget_token(token2, val2);
+    unget_token(token1, val1);
+    yylval = val;
+    return (token1 == NAME || (token1 == WORD && is_name(val1.string)))
+	&& (token2 == LESS || token2 == GREATER || token2 == EQ);
+}
 
-int yyparse (void);
+static int scan_token(void) {
+    static __thread int leader = 0;
+    static __thread int depth = 0;
+    static __thread int brackets = 0;
+    static __thread int prev = 0;
+    int token = next_token();
+    if(token == WORD
+       && (prev == DOLLAR || prev == SHARP || prev == SET || prev == UNSET
+	   || brackets > 0)
+       && strpbrk(yylval.string, "[]")) {
+	split_word(yylval.string);
+	token = next_token();
+    }
+    if(token == WORD && is_name(yylval.string))
+	token = NAME;
+    if(token == NAME) {
+	for(struct keyword *kw = keywords; kw->word; kw++) {
+	    if(!strcmp(yylval.string, kw->word)
+	       && (!kw->within || kw->within == leader
+		   || (kw->within == LEADING && !leader)
+		   || (kw->within == LEADING_OP && !leader
+		       && operator_follows()))) {
+		free(yylval.string);
+		token = kw->token;
+		break;
+	    }
+	}
+    }
+    if(token == WORD || token == NAME) {
+	int in_expr = depth > 0 || brackets > 0;
+	for(int *lp = expr_leaders; *lp; lp++) {
+	    if(*lp == leader)
+		in_expr = 1;
+	}
+	if(in_expr && token == NAME && find_function(yylval.string)) {
+	    /*
+	     * A builtin function name is only a call within an expression
+	     * and if "(" follows, so command arguments are left alone.
+	     */
+	    YYSTYPE val = yylval;
+	    int peeked = next_token();
+	    unget_token(peeked, yylval);
+	    yylval = val;
+	    if(peeked == LPAREN)
+		token = FUNCTION;
+	}
+	if(in_expr && token == WORD && !strcmp(yylval.string, ".")) {
+	    free(yylval.string);
+	    token = CONCAT;
+	}
+	for(struct keyword *op = operators;
+	    in_expr && token == NAME && op->word; op++) {
+	    if(!strcmp(yylval.string, op->word) && ends_operand(prev)) {
+		free(yylval.string);
+		token = op->token;
+	    }
+	}
+    }
+    if(token == LPAREN)
+	depth++;
+    else if(token == RPAREN && depth > 0)
+	depth--;
+    else if(token == LBRACKET)
+	brackets++;
+    else if(token == RBRACKET && brackets > 0)
+	brackets--;
+    prev = token;
+    if(token == EOL || token == EoF) {
+	leader = 0;
+	depth = 0;
+	brackets = 0;
+	prev = 0;
+    } else if(token != NUMBER && !leader) {
+	leader = token;
+    }
+    return token;
+}
 
-#endif /* !YY_YY_INCLUDE_MUSH_TAB_H_INCLUDED  */
+/*
+ * The parser is pure, and is handed the value of each token here.
+ */
+static int mush_yylex(YYSTYPE *lvalp) {
+    int token = scan_token();
+    *lvalp = yylval;
+    return token;
+}
 
+#define yylex mush_yylex
 
+#line 501 "src/mush.tab.c"
 
 #ifdef short
 # undef short
@@ -257,6 +536,18 @@ typedef int_least16_t yytype_int16;
 typedef short yytype_int16;
 #endif
 
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
 #if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
 typedef __UINT_LEAST8_TYPE__ yytype_uint8;
 #elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
@@ -316,8 +607,9 @@ typedef int yytype_uint16;
 
 #define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
 
+
 /* Stored state numbers (used for stacks). */
-typedef yytype_int8 yy_state_t;
+typedef yytype_uint8 yy_state_t;
 
 /* State numbers in computations.  */
 typedef int yy_state_fast_t;
@@ -334,6 +626,7 @@ typedef int yy_state_fast_t;
 # endif
 #endif
 
+
 #ifndef YY_ATTRIBUTE_PURE
 # if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
 #  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
@@ -352,17 +645,23 @@ typedef int yy_state_fast_t;
 
 /* Suppress unused-variable warnings by "using" E.  */
 #if ! defined lint || defined __GNUC__
-# define YYUSE(E) ((void) (E))
+# define YY_USE(E) ((void) (E))
 #else
-# define YYUSE(E) /* empty */
+# define YY_USE(E) /* empty */
 #endif
 
-#if defined __GNUC__ && ! defined __ICC && 407 <= __GNUC__ * 100 + __GNUC_MINOR__
 /* Suppress an incorrect diagnostic about yylval being uninitialized.  */
-# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                            \
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
     _Pragma ("GCC diagnostic push")                                     \
     _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
     _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
 # define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
     _Pragma ("GCC diagnostic pop")
 #else
@@ -391,7 +690,7 @@ typedef int yy_state_fast_t;
 
 #define YY_ASSERT(E) ((void) (0 && (E)))
 
-#if ! defined yyoverflow || YYERROR_VERBOSE
+#if 1
 
 /* The parser invokes alloca or malloc; define the necessary symbols.  */
 
@@ -456,8 +755,7 @@ void free (void *); /* INFRINGES ON USER NAME SPACE */
 #   endif
 #  endif
 # endif
-#endif /* ! defined yyoverflow || YYERROR_VERBOSE */
-
+#endif /* 1 */
 
 #if (! defined yyoverflow \
      && (! defined __cplusplus \
@@ -522,25 +820,27 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  18
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   247
+#define YYLAST   783
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  46
+#define YYNTOKENS  70
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  16
+#define YYNNTS  17
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  60
+#define YYNRULES  96
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  114
+#define YYNSTATES  233
 
-#define YYUNDEFTOK  2
-#define YYMAXUTOK   300
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   324
 
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex, with out-of-bounds checking.  */
-#define YYTRANSLATE(YYX)                                                \
-  (0 <= (YYX) && (YYX) <= YYMAXUTOK ? yytranslate[YYX] : YYUNDEFTOK)
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
 
 /* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
    as returned by yylex.  */
@@ -576,226 +876,386 @@ static const yytype_int8 yytranslate[] =
       15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
       25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
       35,    36,    37,    38,    39,    40,    41,    42,    43,    44,
-      45
+      45,    46,    47,    48,    49,    50,    51,    52,    53,    54,
+      55,    56,    57,    58,    59,    60,    61,    62,    63,    64,
+      65,    66,    67,    68,    69
 };
 
 #if YYDEBUG
-  /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,    95,    95,   102,   111,   118,   125,   133,   142,   151,
-     160,   169,   178,   186,   195,   205,   214,   224,   233,   239,
-     243,   251,   256,   261,   266,   273,   277,   284,   291,   296,
-     304,   310,   317,   324,   331,   336,   340,   349,   358,   367,
-     376,   385,   394,   403,   411,   420,   429,   438,   447,   458,
-     462,   466,   467,   477,   480,   483,   484,   485,   486,   489,
-     490
+       0,   370,   370,   377,   386,   393,   400,   408,   417,   426,
+     435,   444,   453,   461,   470,   480,   491,   501,   510,   520,
+     530,   540,   550,   561,   572,   584,   593,   603,   612,   622,
+     631,   641,   651,   660,   670,   679,   688,   697,   705,   716,
+     728,   737,   745,   755,   765,   776,   782,   787,   796,   801,
+     807,   812,   817,   825,   829,   837,   845,   850,   859,   866,
+     873,   880,   887,   895,   903,   907,   942,   947,   956,   960,
+     969,   978,   987,   996,  1005,  1014,  1023,  1031,  1040,  1049,
+    1058,  1067,  1076,  1085,  1094,  1106,  1111,  1116,  1117,  1128,
+    1132,  1136,  1137,  1138,  1139,  1143,  1144
 };
 #endif
 
-#if YYDEBUG || YYERROR_VERBOSE || 1
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if 1
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
 /* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
    First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
 static const char *const yytname[] =
 {
-  "$end", "error", "$undefined", "NUMBER", "NAME", "WORD", "STRING",
-  "LIST", "DELETE", "RUN", "CONT", "STOP", "BG", "CAPTURE", "WAIT", "POLL",
-  "CANCEL", "PAUSE", "SET", "UNSET", "IF", "GOTO", "SOURCE", "EQ", "PIPE",
-  "LESS", "GREATER", "EQUAL", "LESSEQ", "GREATEQ", "AND", "OR", "NOT",
-  "LPAREN", "RPAREN", "PLUS", "MINUS", "TIMES", "DIVIDE", "MOD", "COMMA",
-  "SHARP", "DOLLAR", "EOL", "EoF", "UNKNOWN", "$accept", "statement",
-  "pipeline", "command_list", "command", "arg_list", "arg", "atomic_expr",
-  "expr", "numeric_var", "string_var", "optional_lineno", "lineno",
-  "literal_number", "literal_string", "file", YY_NULLPTR
+  "\"end of file\"", "error", "\"invalid token\"", "NUMBER", "NAME",
+  "WORD", "STRING", "FUNCTION", "LIST", "DELETE", "RUN", "CONT", "STOP",
+  "BG", "CAPTURE", "WAIT", "POLL", "CANCEL", "PAUSE", "SET", "UNSET", "IF",
+  "GOTO", "SOURCE", "FOR", "TO", "STEP", "NEXT", "APPEND", "READ", "WRITE",
+  "PUSH", "POP", "KEYS", "SPLIT", "BY", "CACHED", "EXPORT", "IMPORT", "AS",
+  "SAVE", "RESTORE", "EQ", "PIPE", "LESS", "GREATER", "EQUAL", "LESSEQ",
+  "GREATEQ", "AND", "OR", "NOT", "LPAREN", "RPAREN", "PLUS", "MINUS",
+  "TIMES", "DIVIDE", "MOD", "COMMA", "SHARP", "DOLLAR", "EOL", "EoF",
+  "UNKNOWN", "CONCAT", "LBRACKET", "RBRACKET", "CONTAINS", "MATCHES",
+  "$accept", "statement", "pipeline", "command_list", "command",
+  "arg_list", "arg", "atomic_expr", "expr_list", "expr", "numeric_var",
+  "string_var", "optional_lineno", "lineno", "literal_number",
+  "literal_string", "file", YY_NULLPTR
 };
-#endif
 
-# ifdef YYPRINT
-/* YYTOKNUM[NUM] -- (External) token number corresponding to the
-   (internal) symbol number NUM (which must be that of a token).  */
-static const yytype_int16 yytoknum[] =
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
 {
-       0,   256,   257,   258,   259,   260,   261,   262,   263,   264,
-     265,   266,   267,   268,   269,   270,   271,   272,   273,   274,
-     275,   276,   277,   278,   279,   280,   281,   282,   283,   284,
-     285,   286,   287,   288,   289,   290,   291,   292,   293,   294,
-     295,   296,   297,   298,   299,   300
-};
-# endif
+  return yytname[yysymbol];
+}
+#endif
 
-#define YYPACT_NINF (-53)
+#define YYPACT_NINF (-37)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF (-52)
+#define YYTABLE_NINF (-88)
 
 #define yytable_value_is_error(Yyn) \
   0
 
-  /* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
-     STATE-NUM.  */
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-      61,   -30,   -53,   -28,    21,   -18,   -16,   -53,   -53,    28,
-      92,    18,   -53,   -53,   -53,   -10,   -53,   -53,   -53,   -53,
-     -53,   -53,   -53,    85,    85,    85,   -12,    31,    32,    85,
-      21,     4,    85,    33,    34,    -9,   -53,     8,   -53,   116,
-     -53,   -53,   -53,   -53,    -3,    21,    85,   -53,   117,   136,
-     155,   -53,    16,    -1,   174,     0,   -53,   -53,     2,   208,
-     -53,   -53,     3,     4,     1,   -53,   116,   -53,   -53,    29,
-      -7,    85,    85,    85,    85,    85,    85,    85,    85,    85,
-      85,    85,    85,   -53,   -53,   -53,    85,   -53,    21,   -53,
-     -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,   -53,
-     -53,   -53,   -53,    -7,    -7,   110,   110,   110,   110,   110,
-     189,    30,   -53,   -53
+     200,   -33,   -37,   -14,    43,     1,     7,   -37,   -37,    57,
+     131,    65,   -37,   -37,   -37,    19,   -37,   -37,   -37,   -37,
+     -37,   -37,   -37,    27,    15,    15,    15,    18,    77,    98,
+      15,    43,    39,   100,     3,   101,   102,   104,   106,   107,
+     109,   110,    10,   111,     0,    39,    39,    15,   112,   129,
+      11,   -37,    96,   -37,   125,   -37,   -37,   -37,   -37,    78,
+      43,    15,    15,   -37,   298,   324,   350,   -37,   -16,   -26,
+     220,    79,   -37,   -37,    82,   114,    95,   -37,   124,   126,
+     128,   132,    -4,   130,   133,   -37,   -37,   -15,   -11,    39,
+     117,   118,   376,   115,   116,   127,    39,    28,   -37,   125,
+     -37,   -37,   134,   135,   402,   211,    15,    15,    15,    15,
+      15,    15,    15,    15,    15,    15,    15,    15,   -37,    15,
+      15,    15,   -37,   -37,    15,    15,   -37,    15,    43,   -37,
+     -37,    15,   -37,    15,    39,    29,    15,   186,   -37,   189,
+       4,    15,   -37,   191,   -37,    -8,   -37,   -37,   -37,    15,
+      15,   -37,   -37,   -37,   -37,   -37,   -37,   -37,    15,   -37,
+     -37,   -37,   -37,   -37,   211,   211,    74,    74,    74,    74,
+      74,    74,   -37,   -37,   428,   454,   480,   136,   246,   506,
+     137,    39,   138,   532,   150,   151,   -23,   193,   -10,   558,
+     152,   221,   -37,   584,   610,   -37,   -37,   184,   173,   -37,
+      15,   -37,   -37,   177,   -37,   -37,   -37,   -37,    15,   -37,
+     -37,    15,   -37,   -37,   -37,   181,   -37,   -37,    15,   -37,
+     272,   -37,   636,   662,   -37,   688,    15,   -37,   -37,   -37,
+     -37,   714,   -37
 };
 
-  /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
-     Performed when YYTABLE does not specify something else to do.  Zero
-     means the default is an error.  */
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
 static const yytype_int8 yydefact[] =
 {
-       0,     0,    54,     0,     0,     0,     0,    18,    19,     0,
-       0,    52,    53,    20,     2,     0,     4,     5,     1,    55,
-      56,    57,    58,     0,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,     0,     0,     0,    21,    25,    27,    28,
-      30,    32,    33,    31,     0,     0,     0,    35,     0,     0,
-       0,    12,     0,     0,     0,     0,    59,    60,     0,     0,
-      49,    50,     0,     0,     0,     7,     0,    29,     6,     0,
-      43,     0,     0,     0,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,     9,    10,    11,     0,    15,     0,    13,
-      17,    34,     8,    22,    24,    23,    26,     3,    37,    38,
-      36,    39,    40,    41,    42,    44,    45,    46,    47,    48,
-       0,     0,    14,    16
+       0,     0,    90,     0,     0,     0,     0,    45,    46,     0,
+       0,    88,    89,    47,     2,     0,     4,     5,     1,    91,
+      92,    93,    94,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,    48,    53,    55,    56,    58,    60,    61,    59,     0,
+       0,     0,     0,    68,     0,     0,     0,    12,     0,     0,
+       0,     0,    95,    96,     0,     0,     0,    41,     0,     0,
+       0,     0,     0,     0,     0,    37,    49,     0,     0,     0,
+       0,     0,     0,    85,    86,     0,     0,     0,     7,     0,
+      57,     6,     0,     0,    66,    76,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     9,     0,
+       0,     0,    10,    11,     0,     0,    32,     0,     0,    13,
+      34,     0,    40,     0,     0,     0,     0,     0,    17,     0,
+       0,     0,    29,     0,    27,     0,    35,    36,    64,     0,
+       0,     8,    50,    52,    51,    54,     3,    65,     0,    70,
+      71,    69,    72,    73,    74,    75,    77,    78,    79,    80,
+      81,    82,    83,    84,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,    25,     0,     0,    67,    14,     0,     0,    33,
+       0,    19,    42,     0,    43,    16,    18,    20,     0,    21,
+      85,     0,    22,    30,    28,     0,    62,    63,     0,    31,
+       0,    44,     0,     0,    26,     0,     0,    38,    23,    24,
+      15,     0,    39
 };
 
-  /* YYPGOTO[NTERM-NUM].  */
-static const yytype_int8 yypgoto[] =
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int16 yypgoto[] =
 {
-     -53,   -53,   -53,   -22,   -53,    22,   -53,    -6,   -23,   -53,
-     -53,   -53,    -4,   -53,   -53,   -52
+     -37,   -37,   -37,   -31,   -37,   190,   -37,    -5,    87,   -24,
+     108,   -37,   -37,    -1,   -37,   -37,   -36
 };
 
-  /* YYDEFGOTO[NTERM-NUM].  */
+/* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-      -1,     9,    35,    36,    37,    38,    39,    47,    48,    41,
-      42,    10,    11,    12,    43,    58
+       0,     9,    50,    51,    52,    53,    54,    63,   103,   104,
+      56,    57,    10,    11,    12,    58,    74
 };
 
-  /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
-     positive, shift that token.  If negative, reduce the rule whose
-     number is the opposite.  If YYTABLE_NINF, syntax error.  */
-static const yytype_int8 yytable[] =
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int16 yytable[] =
 {
-      15,    49,    50,    62,    40,    56,    54,    57,    56,    59,
-      57,    93,    95,    13,    94,    14,    63,    64,    71,    72,
-      73,    74,    75,    70,     2,    16,    55,    17,    18,    44,
-      45,    51,    66,    40,    65,    52,    53,    60,    61,    86,
-      68,    69,    87,    89,    96,    90,    92,     0,    98,    99,
-     100,   101,   102,   103,   104,   105,   106,   107,   108,   109,
-      40,    67,     1,   110,     2,   -51,   -51,   -51,     3,     4,
-       5,     6,    97,   113,     0,   -51,   -51,   -51,   -51,   -51,
-     -51,   -51,   -51,   -51,   111,     0,     0,     0,    19,    20,
-      21,    22,     0,     0,   -51,    19,    20,    21,    22,     0,
-       0,     0,   -51,   -51,     7,     8,    23,    24,    25,    26,
-      27,    28,    29,    30,    31,     0,     0,    46,    32,    19,
-      20,    21,    22,     0,     0,    32,    33,    34,     0,     0,
-       0,     0,     0,    33,    34,    71,    72,    73,    74,    75,
-      76,    77,    71,    72,    73,    74,    75,    76,    77,    32,
-       0,     0,    78,    79,    80,    81,    82,    33,    34,     0,
-      83,    71,    72,    73,    74,    75,    76,    77,     0,     0,
-       0,    78,    79,    80,    81,    82,     0,     0,     0,    84,
-      71,    72,    73,    74,    75,    76,    77,     0,     0,     0,
-      78,    79,    80,    81,    82,    88,     0,     0,    85,    71,
-      72,    73,    74,    75,    76,    77,     0,     0,     0,    78,
-      79,    80,    81,    82,    71,    72,    73,    74,    75,    76,
-      77,     0,     0,     0,    78,    79,    80,    81,    82,     0,
-       0,     0,   112,    71,    72,    73,    74,    75,    76,    77,
-       0,     0,    91,    78,    79,    80,    81,    82
+      64,    65,    66,    15,    88,    55,    70,    76,   186,    90,
+      91,    86,   208,    19,    20,    21,    22,    23,    19,    20,
+      21,    22,    23,    92,    95,   211,   124,   141,   143,    13,
+      71,   191,    72,    72,    73,    73,   126,    55,   105,   209,
+     127,   137,   153,    72,    89,    73,     2,   142,    14,    55,
+     125,   144,   212,   145,   192,    96,    97,    18,   138,   102,
+     152,   154,    47,    16,   187,    77,    62,    47,   155,    17,
+      48,    49,    85,    98,   181,    48,    49,    59,    60,    61,
+      67,    68,   159,   160,   161,   162,   163,   164,   165,   166,
+     167,   168,   169,   170,    55,   171,   172,   173,   180,   182,
+     174,   175,    69,   176,    75,    78,    79,   178,    80,   179,
+      81,    82,   183,    83,    84,    87,    93,   189,   106,   107,
+     108,   109,   110,   111,   112,   193,   194,   177,    19,    20,
+      21,    22,    23,    94,    19,    20,    21,    22,    23,    99,
+     101,   129,   120,   121,   130,   203,    24,    25,    26,    27,
+      28,    29,    30,    31,    32,    33,   131,   132,    34,    35,
+      36,    37,    38,    39,    40,    41,   133,    42,    43,    44,
+     134,    45,    46,   135,   136,   139,   220,    47,   140,   146,
+     147,   149,   150,    47,   222,    48,    49,   223,   157,   151,
+     184,    48,    49,   185,   225,   190,   156,   210,   199,   202,
+     204,     1,   231,     2,   -87,   -87,   -87,   -87,     3,     4,
+       5,     6,   206,   207,   214,   -87,   -87,   -87,   -87,   -87,
+     -87,   -87,   -87,   -87,   -87,   215,   218,   -87,   -87,   -87,
+     -87,   -87,   -87,   -87,   -87,   219,   -87,   -87,   -87,   221,
+     -87,   -87,   128,   224,   100,   195,     0,     0,   188,     0,
+       0,     0,   -87,     0,     0,   106,   107,   108,   109,   110,
+     -87,   -87,     7,     8,   106,   107,   108,   109,   110,   111,
+     112,   200,     0,     0,   113,   114,   115,   116,   117,   120,
+     121,     0,     0,     0,     0,   119,     0,     0,   120,   121,
+     106,   107,   108,   109,   110,   111,   112,     0,   226,     0,
+     113,   114,   115,   116,   117,     0,     0,     0,     0,     0,
+       0,   119,     0,     0,   120,   121,   106,   107,   108,   109,
+     110,   111,   112,     0,     0,     0,   113,   114,   115,   116,
+     117,     0,     0,     0,   227,     0,     0,   119,     0,     0,
+     120,   121,   106,   107,   108,   109,   110,   111,   112,     0,
+       0,     0,   113,   114,   115,   116,   117,     0,     0,     0,
+     118,     0,     0,   119,     0,     0,   120,   121,   106,   107,
+     108,   109,   110,   111,   112,     0,     0,     0,   113,   114,
+     115,   116,   117,     0,     0,     0,   122,     0,     0,   119,
+       0,     0,   120,   121,   106,   107,   108,   109,   110,   111,
+     112,     0,     0,     0,   113,   114,   115,   116,   117,     0,
+       0,     0,   123,     0,     0,   119,     0,     0,   120,   121,
+     106,   107,   108,   109,   110,   111,   112,     0,     0,   148,
+     113,   114,   115,   116,   117,     0,     0,     0,     0,     0,
+       0,   119,     0,     0,   120,   121,   106,   107,   108,   109,
+     110,   111,   112,     0,     0,     0,   113,   114,   115,   116,
+     117,   158,     0,     0,     0,     0,     0,   119,     0,     0,
+     120,   121,   106,   107,   108,   109,   110,   111,   112,     0,
+       0,     0,   113,   114,   115,   116,   117,     0,     0,     0,
+     196,     0,     0,   119,     0,     0,   120,   121,   106,   107,
+     108,   109,   110,   111,   112,     0,     0,     0,   113,   114,
+     115,   116,   117,     0,     0,     0,     0,     0,     0,   119,
+       0,   197,   120,   121,   106,   107,   108,   109,   110,   111,
+     112,     0,     0,     0,   113,   114,   115,   116,   117,     0,
+       0,     0,     0,     0,     0,   119,     0,   198,   120,   121,
+     106,   107,   108,   109,   110,   111,   112,     0,     0,     0,
+     113,   114,   115,   116,   117,     0,     0,     0,   201,     0,
+       0,   119,     0,     0,   120,   121,   106,   107,   108,   109,
+     110,   111,   112,     0,     0,     0,   113,   114,   115,   116,
+     117,     0,     0,     0,   205,     0,     0,   119,     0,     0,
+     120,   121,   106,   107,   108,   109,   110,   111,   112,     0,
+       0,     0,   113,   114,   115,   116,   117,     0,     0,     0,
+     213,     0,     0,   119,     0,     0,   120,   121,   106,   107,
+     108,   109,   110,   111,   112,     0,     0,     0,   113,   114,
+     115,   116,   117,     0,     0,     0,     0,     0,     0,   119,
+       0,   216,   120,   121,   106,   107,   108,   109,   110,   111,
+     112,     0,     0,     0,   113,   114,   115,   116,   117,     0,
+       0,     0,     0,     0,     0,   119,     0,   217,   120,   121,
+     106,   107,   108,   109,   110,   111,   112,     0,     0,     0,
+     113,   114,   115,   116,   117,     0,     0,     0,   228,     0,
+       0,   119,     0,     0,   120,   121,   106,   107,   108,   109,
+     110,   111,   112,     0,     0,     0,   113,   114,   115,   116,
+     117,     0,     0,     0,   229,     0,     0,   119,     0,     0,
+     120,   121,   106,   107,   108,   109,   110,   111,   112,     0,
+       0,     0,   113,   114,   115,   116,   117,     0,     0,     0,
+     230,     0,     0,   119,     0,     0,   120,   121,   106,   107,
+     108,   109,   110,   111,   112,     0,     0,     0,   113,   114,
+     115,   116,   117,     0,     0,     0,   232,     0,     0,   119,
+       0,     0,   120,   121
 };
 
-static const yytype_int8 yycheck[] =
+static const yytype_int16 yycheck[] =
 {
-       4,    24,    25,    12,    10,     4,    29,     6,     4,    32,
-       6,    63,    64,    43,    13,    43,    25,    26,    25,    26,
-      27,    28,    29,    46,     3,    43,    30,    43,     0,    11,
-      40,    43,    24,    39,    43,     4,     4,     4,     4,    23,
-      43,    45,    43,    43,    66,    43,    43,    -1,    71,    72,
-      73,    74,    75,    76,    77,    78,    79,    80,    81,    82,
-      66,    39,     1,    86,     3,     4,     5,     6,     7,     8,
-       9,    10,    43,    43,    -1,    14,    15,    16,    17,    18,
-      19,    20,    21,    22,    88,    -1,    -1,    -1,     3,     4,
-       5,     6,    -1,    -1,    33,     3,     4,     5,     6,    -1,
-      -1,    -1,    41,    42,    43,    44,    14,    15,    16,    17,
-      18,    19,    20,    21,    22,    -1,    -1,    32,    33,     3,
-       4,     5,     6,    -1,    -1,    33,    41,    42,    -1,    -1,
-      -1,    -1,    -1,    41,    42,    25,    26,    27,    28,    29,
-      30,    31,    25,    26,    27,    28,    29,    30,    31,    33,
-      -1,    -1,    35,    36,    37,    38,    39,    41,    42,    -1,
-      43,    25,    26,    27,    28,    29,    30,    31,    -1,    -1,
-      -1,    35,    36,    37,    38,    39,    -1,    -1,    -1,    43,
-      25,    26,    27,    28,    29,    30,    31,    -1,    -1,    -1,
-      35,    36,    37,    38,    39,    21,    -1,    -1,    43,    25,
-      26,    27,    28,    29,    30,    31,    -1,    -1,    -1,    35,
-      36,    37,    38,    39,    25,    26,    27,    28,    29,    30,
-      31,    -1,    -1,    -1,    35,    36,    37,    38,    39,    -1,
-      -1,    -1,    43,    25,    26,    27,    28,    29,    30,    31,
-      -1,    -1,    34,    35,    36,    37,    38,    39
+      24,    25,    26,     4,     4,    10,    30,     4,     4,    45,
+      46,    42,    35,     3,     4,     5,     6,     7,     3,     4,
+       5,     6,     7,    47,    13,    35,    42,    42,    39,    62,
+      31,    39,     4,     4,     6,     6,    62,    42,    62,    62,
+      66,    45,    14,     4,    44,     6,     3,    62,    62,    54,
+      66,    62,    62,    89,    62,    44,    45,     0,    62,    60,
+      96,    97,    52,    62,    60,    62,    51,    52,    99,    62,
+      60,    61,    62,    62,    45,    60,    61,    12,    59,    52,
+      62,     4,   106,   107,   108,   109,   110,   111,   112,   113,
+     114,   115,   116,   117,    99,   119,   120,   121,   134,   135,
+     124,   125,     4,   127,     4,     4,     4,   131,     4,   133,
+       4,     4,   136,     4,     4,     4,     4,   141,    44,    45,
+      46,    47,    48,    49,    50,   149,   150,   128,     3,     4,
+       5,     6,     7,     4,     3,     4,     5,     6,     7,    43,
+      62,    62,    68,    69,    62,   181,    15,    16,    17,    18,
+      19,    20,    21,    22,    23,    24,    42,    62,    27,    28,
+      29,    30,    31,    32,    33,    34,    42,    36,    37,    38,
+      44,    40,    41,    45,    42,    45,   200,    52,    45,    62,
+      62,    66,    66,    52,   208,    60,    61,   211,    53,    62,
+       4,    60,    61,     4,   218,     4,    62,     4,    62,    62,
+      62,     1,   226,     3,     4,     5,     6,     7,     8,     9,
+      10,    11,    62,    62,    62,    15,    16,    17,    18,    19,
+      20,    21,    22,    23,    24,     4,    42,    27,    28,    29,
+      30,    31,    32,    33,    34,    62,    36,    37,    38,    62,
+      40,    41,    22,    62,    54,   158,    -1,    -1,   140,    -1,
+      -1,    -1,    52,    -1,    -1,    44,    45,    46,    47,    48,
+      60,    61,    62,    63,    44,    45,    46,    47,    48,    49,
+      50,    25,    -1,    -1,    54,    55,    56,    57,    58,    68,
+      69,    -1,    -1,    -1,    -1,    65,    -1,    -1,    68,    69,
+      44,    45,    46,    47,    48,    49,    50,    -1,    26,    -1,
+      54,    55,    56,    57,    58,    -1,    -1,    -1,    -1,    -1,
+      -1,    65,    -1,    -1,    68,    69,    44,    45,    46,    47,
+      48,    49,    50,    -1,    -1,    -1,    54,    55,    56,    57,
+      58,    -1,    -1,    -1,    62,    -1,    -1,    65,    -1,    -1,
+      68,    69,    44,    45,    46,    47,    48,    49,    50,    -1,
+      -1,    -1,    54,    55,    56,    57,    58,    -1,    -1,    -1,
+      62,    -1,    -1,    65,    -1,    -1,    68,    69,    44,    45,
+      46,    47,    48,    49,    50,    -1,    -1,    -1,    54,    55,
+      56,    57,    58,    -1,    -1,    -1,    62,    -1,    -1,    65,
+      -1,    -1,    68,    69,    44,    45,    46,    47,    48,    49,
+      50,    -1,    -1,    -1,    54,    55,    56,    57,    58,    -1,
+      -1,    -1,    62,    -1,    -1,    65,    -1,    -1,    68,    69,
+      44,    45,    46,    47,    48,    49,    50,    -1,    -1,    53,
+      54,    55,    56,    57,    58,    -1,    -1,    -1,    -1,    -1,
+      -1,    65,    -1,    -1,    68,    69,    44,    45,    46,    47,
+      48,    49,    50,    -1,    -1,    -1,    54,    55,    56,    57,
+      58,    59,    -1,    -1,    -1,    -1,    -1,    65,    -1,    -1,
+      68,    69,    44,    45,    46,    47,    48,    49,    50,    -1,
+      -1,    -1,    54,    55,    56,    57,    58,    -1,    -1,    -1,
+      62,    -1,    -1,    65,    -1,    -1,    68,    69,    44,    45,
+      46,    47,    48,    49,    50,    -1,    -1,    -1,    54,    55,
+      56,    57,    58,    -1,    -1,    -1,    -1,    -1,    -1,    65,
+      -1,    67,    68,    69,    44,    45,    46,    47,    48,    49,
+      50,    -1,    -1,    -1,    54,    55,    56,    57,    58,    -1,
+      -1,    -1,    -1,    -1,    -1,    65,    -1,    67,    68,    69,
+      44,    45,    46,    47,    48,    49,    50,    -1,    -1,    -1,
+      54,    55,    56,    57,    58,    -1,    -1,    -1,    62,    -1,
+      -1,    65,    -1,    -1,    68,    69,    44,    45,    46,    47,
+      48,    49,    50,    -1,    -1,    -1,    54,    55,    56,    57,
+      58,    -1,    -1,    -1,    62,    -1,    -1,    65,    -1,    -1,
+      68,    69,    44,    45,    46,    47,    48,    49,    50,    -1,
+      -1,    -1,    54,    55,    56,    57,    58,    -1,    -1,    -1,
+      62,    -1,    -1,    65,    -1,    -1,    68,    69,    44,    45,
+      46,    47,    48,    49,    50,    -1,    -1,    -1,    54,    55,
+      56,    57,    58,    -1,    -1,    -1,    -1,    -1,    -1,    65,
+      -1,    67,    68,    69,    44,    45,    46,    47,    48,    49,
+      50,    -1,    -1,    -1,    54,    55,    56,    57,    58,    -1,
+      -1,    -1,    -1,    -1,    -1,    65,    -1,    67,    68,    69,
+      44,    45,    46,    47,    48,    49,    50,    -1,    -1,    -1,
+      54,    55,    56,    57,    58,    -1,    -1,    -1,    62,    -1,
+      -1,    65,    -1,    -1,    68,    69,    44,    45,    46,    47,
+      48,    49,    50,    -1,    -1,    -1,    54,    55,    56,    57,
+      58,    -1,    -1,    -1,    62,    -1,    -1,    65,    -1,    -1,
+      68,    69,    44,    45,    46,    47,    48,    49,    50,    -1,
+      -1,    -1,    54,    55,    56,    57,    58,    -1,    -1,    -1,
+      62,    -1,    -1,    65,    -1,    -1,    68,    69,    44,    45,
+      46,    47,    48,    49,    50,    -1,    -1,    -1,    54,    55,
+      56,    57,    58,    -1,    -1,    -1,    62,    -1,    -1,    65,
+      -1,    -1,    68,    69
 };
 
-  /* YYSTOS[STATE-NUM] -- The (internal number of the) accessing
-     symbol of state STATE-NUM.  */
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,     1,     3,     7,     8,     9,    10,    43,    44,    47,
-      57,    58,    59,    43,    43,    58,    43,    43,     0,     3,
-       4,     5,     6,    14,    15,    16,    17,    18,    19,    20,
-      21,    22,    33,    41,    42,    48,    49,    50,    51,    52,
-      53,    55,    56,    60,    11,    40,    32,    53,    54,    54,
-      54,    43,     4,     4,    54,    58,     4,     6,    61,    54,
-       4,     4,    12,    25,    26,    43,    24,    51,    43,    58,
-      54,    25,    26,    27,    28,    29,    30,    31,    35,    36,
-      37,    38,    39,    43,    43,    43,    23,    43,    21,    43,
-      43,    34,    43,    61,    13,    61,    49,    43,    54,    54,
-      54,    54,    54,    54,    54,    54,    54,    54,    54,    54,
-      54,    58,    43,    43
+       0,     1,     3,     8,     9,    10,    11,    62,    63,    71,
+      82,    83,    84,    62,    62,    83,    62,    62,     0,     3,
+       4,     5,     6,     7,    15,    16,    17,    18,    19,    20,
+      21,    22,    23,    24,    27,    28,    29,    30,    31,    32,
+      33,    34,    36,    37,    38,    40,    41,    52,    60,    61,
+      72,    73,    74,    75,    76,    77,    80,    81,    85,    12,
+      59,    52,    51,    77,    79,    79,    79,    62,     4,     4,
+      79,    83,     4,     6,    86,     4,     4,    62,     4,     4,
+       4,     4,     4,     4,     4,    62,    73,     4,     4,    44,
+      86,    86,    79,     4,     4,    13,    44,    45,    62,    43,
+      75,    62,    83,    78,    79,    79,    44,    45,    46,    47,
+      48,    49,    50,    54,    55,    56,    57,    58,    62,    65,
+      68,    69,    62,    62,    42,    66,    62,    66,    22,    62,
+      62,    42,    62,    42,    44,    45,    42,    45,    62,    45,
+      45,    42,    62,    39,    62,    86,    62,    62,    53,    66,
+      66,    62,    86,    14,    86,    73,    62,    53,    59,    79,
+      79,    79,    79,    79,    79,    79,    79,    79,    79,    79,
+      79,    79,    79,    79,    79,    79,    79,    83,    79,    79,
+      86,    45,    86,    79,     4,     4,     4,    60,    80,    79,
+       4,    39,    62,    79,    79,    78,    62,    67,    67,    62,
+      25,    62,    62,    86,    62,    62,    62,    62,    35,    62,
+       4,    35,    62,    62,    62,     4,    67,    67,    42,    62,
+      79,    62,    79,    79,    62,    79,    26,    62,    62,    62,
+      62,    79,    62
 };
 
-  /* YYR1[YYN] -- Symbol number of symbol that rule YYN derives.  */
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,    46,    47,    47,    47,    47,    47,    47,    47,    47,
-      47,    47,    47,    47,    47,    47,    47,    47,    47,    47,
-      47,    48,    48,    48,    48,    49,    49,    50,    51,    51,
-      52,    53,    53,    53,    53,    54,    54,    54,    54,    54,
-      54,    54,    54,    54,    54,    54,    54,    54,    54,    55,
-      56,    57,    57,    58,    59,    60,    60,    60,    60,    61,
-      61
+       0,    70,    71,    71,    71,    71,    71,    71,    71,    71,
+      71,    71,    71,    71,    71,    71,    71,    71,    71,    71,
+      71,    71,    71,    71,    71,    71,    71,    71,    71,    71,
+      71,    71,    71,    71,    71,    71,    71,    71,    71,    71,
+      71,    71,    71,    71,    71,    71,    71,    71,    72,    72,
+      72,    72,    72,    73,    73,    74,    75,    75,    76,    77,
+      77,    77,    77,    77,    77,    77,    78,    78,    79,    79,
+      79,    79,    79,    79,    79,    79,    79,    79,    79,    79,
+      79,    79,    79,    79,    79,    80,    81,    82,    82,    83,
+      84,    85,    85,    85,    85,    86,    86
 };
 
-  /* YYR2[YYN] -- Number of symbols on the right hand side of rule YYN.  */
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
        0,     2,     2,     5,     2,     2,     3,     3,     4,     4,
-       4,     4,     3,     4,     6,     4,     6,     4,     1,     1,
-       2,     1,     3,     3,     3,     1,     3,     1,     1,     2,
-       1,     1,     1,     1,     3,     1,     3,     3,     3,     3,
-       3,     3,     3,     2,     3,     3,     3,     3,     3,     2,
-       2,     0,     1,     1,     1,     1,     1,     1,     1,     1,
-       1
+       4,     4,     3,     4,     6,     9,     6,     4,     6,     6,
+       6,     6,     6,     8,     8,     5,     7,     4,     6,     4,
+       6,     7,     4,     6,     4,     4,     4,     3,     8,    10,
+       4,     3,     6,     6,     7,     1,     1,     2,     1,     2,
+       3,     3,     3,     1,     3,     1,     1,     2,     1,     1,
+       1,     1,     5,     5,     3,     4,     1,     3,     1,     3,
+       3,     3,     3,     3,     3,     3,     2,     3,     3,     3,
+       3,     3,     3,     3,     3,     2,     2,     0,     1,     1,
+       1,     1,     1,     1,     1,     1,     1
 };
 
 
+enum { YYENOMEM = -2 };
+
 #define yyerrok         (yyerrstatus = 0)
 #define yyclearin       (yychar = YYEMPTY)
-#define YYEMPTY         (-2)
-#define YYEOF           0
 
 #define YYACCEPT        goto yyacceptlab
 #define YYABORT         goto yyabortlab
 #define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
 
 
 #define YYRECOVERING()  (!!yyerrstatus)
@@ -817,10 +1277,9 @@ static const yytype_int8 yyr2[] =
       }                                                           \
   while (0)
 
-/* Error token number */
-#define YYTERROR        1
-#define YYERRCODE       256
-
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
 
 
 /* Enable debugging if requested.  */
@@ -837,19 +1296,16 @@ do {                                            \
     YYFPRINTF Args;                             \
 } while (0)
 
-/* This macro is provided for backward compatibility. */
-#ifndef YY_LOCATION_PRINT
-# define YY_LOCATION_PRINT(File, Loc) ((void) 0)
-#endif
 
 
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)                    \
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
 do {                                                                      \
   if (yydebug)                                                            \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value); \
+                  Kind, Value); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -860,18 +1316,15 @@ do {                                                                      \
 `-----------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep)
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
 {
   FILE *yyoutput = yyo;
-  YYUSE (yyoutput);
+  YY_USE (yyoutput);
   if (!yyvaluep)
     return;
-# ifdef YYPRINT
-  if (yytype < YYNTOKENS)
-    YYPRINT (yyo, yytoknum[yytype], *yyvaluep);
-# endif
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  YYUSE (yytype);
+  YY_USE (yykind);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
@@ -881,12 +1334,13 @@ yy_symbol_value_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep)
 `---------------------------*/
 
 static void
-yy_symbol_print (FILE *yyo, int yytype, YYSTYPE const * const yyvaluep)
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
 {
   YYFPRINTF (yyo, "%s %s (",
-             yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyo, yytype, yyvaluep);
+  yy_symbol_value_print (yyo, yykind, yyvaluep);
   YYFPRINTF (yyo, ")");
 }
 
@@ -919,7 +1373,8 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, int yyrule)
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -931,9 +1386,8 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, int yyrule)
     {
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
-                       yystos[+yyssp[yyi + 1 - yynrhs]],
-                       &yyvsp[(yyi + 1) - (yynrhs)]
-                                              );
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)]);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -948,8 +1402,8 @@ do {                                    \
    multiple parsers can coexist.  */
 int yydebug;
 #else /* !YYDEBUG */
-# define YYDPRINTF(Args)
-# define YY_SYMBOL_PRINT(Title, Type, Value, Location)
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
 # define YY_STACK_PRINT(Bottom, Top)
 # define YY_REDUCE_PRINT(Rule)
 #endif /* !YYDEBUG */
@@ -972,12 +1426,60 @@ int yydebug;
 #endif
 
 
-#if YYERROR_VERBOSE
+/* Context of a parse error.  */
+typedef struct
+{
+  yy_state_t *yyssp;
+  yysymbol_kind_t yytoken;
+} yypcontext_t;
+
+/* Put in YYARG at most YYARGN of the expected tokens given the
+   current YYCTX, and return the number of tokens stored in YYARG.  If
+   YYARG is null, return the number of expected tokens (guaranteed to
+   be less than YYNTOKENS).  Return YYENOMEM on memory exhaustion.
+   Return 0 if there are more than YYARGN expected tokens, yet fill
+   YYARG up to YYARGN. */
+static int
+yypcontext_expected_tokens (const yypcontext_t *yyctx,
+                            yysymbol_kind_t yyarg[], int yyargn)
+{
+  /* Actual size of YYARG. */
+  int yycount = 0;
+  int yyn = yypact[+*yyctx->yyssp];
+  if (!yypact_value_is_default (yyn))
+    {
+      /* Start YYX at -YYN if negative to avoid negative indexes in
+         YYCHECK.  In other words, skip the first -YYN actions for
+         this state because they are default actions.  */
+      int yyxbegin = yyn < 0 ? -yyn : 0;
+      /* Stay within bounds of both yycheck and yytname.  */
+      int yychecklim = YYLAST - yyn + 1;
+      int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
+      int yyx;
+      for (yyx = yyxbegin; yyx < yyxend; ++yyx)
+        if (yycheck[yyx + yyn] == yyx && yyx != YYSYMBOL_YYerror
+            && !yytable_value_is_error (yytable[yyx + yyn]))
+          {
+            if (!yyarg)
+              ++yycount;
+            else if (yycount == yyargn)
+              return 0;
+            else
+              yyarg[yycount++] = YY_CAST (yysymbol_kind_t, yyx);
+          }
+    }
+  if (yyarg && yycount == 0 && 0 < yyargn)
+    yyarg[0] = YYSYMBOL_YYEMPTY;
+  return yycount;
+}
+
+
 
-# ifndef yystrlen
-#  if defined __GLIBC__ && defined _STRING_H
-#   define yystrlen(S) (YY_CAST (YYPTRDIFF_T, strlen (S)))
-#  else
+
+#ifndef yystrlen
+# if defined __GLIBC__ && defined _STRING_H
+#  define yystrlen(S) (YY_CAST (YYPTRDIFF_T, strlen (S)))
+# else
 /* Return the length of YYSTR.  */
 static YYPTRDIFF_T
 yystrlen (const char *yystr)
@@ -987,13 +1489,13 @@ yystrlen (const char *yystr)
     continue;
   return yylen;
 }
-#  endif
 # endif
+#endif
 
-# ifndef yystpcpy
-#  if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
-#   define yystpcpy stpcpy
-#  else
+#ifndef yystpcpy
+# if defined __GLIBC__ && defined _STRING_H && defined _GNU_SOURCE
+#  define yystpcpy stpcpy
+# else
 /* Copy YYSRC to YYDEST, returning the address of the terminating '\0' in
    YYDEST.  */
 static char *
@@ -1007,10 +1509,10 @@ yystpcpy (char *yydest, const char *yysrc)
 
   return yyd - 1;
 }
-#  endif
 # endif
+#endif
 
-# ifndef yytnamerr
+#ifndef yytnamerr
 /* Copy to YYRES the contents of YYSTR after stripping away unnecessary
    quotes and backslashes, so that it's suitable for yyerror.  The
    heuristic is that double-quoting is unnecessary unless the string
@@ -1025,7 +1527,6 @@ yytnamerr (char *yyres, const char *yystr)
     {
       YYPTRDIFF_T yyn = 0;
       char const *yyp = yystr;
-
       for (;;)
         switch (*++yyp)
           {
@@ -1059,31 +1560,15 @@ yytnamerr (char *yyres, const char *yystr)
   else
     return yystrlen (yystr);
 }
-# endif
+#endif
 
-/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
-   about the unexpected token YYTOKEN for the state stack whose top is
-   YYSSP.
 
-   Return 0 if *YYMSG was successfully written.  Return 1 if *YYMSG is
-   not large enough to hold the message.  In that case, also set
-   *YYMSG_ALLOC to the required number of bytes.  Return 2 if the
-   required number of bytes is too large to store.  */
 static int
-yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
-                yy_state_t *yyssp, int yytoken)
+yy_syntax_error_arguments (const yypcontext_t *yyctx,
+                           yysymbol_kind_t yyarg[], int yyargn)
 {
-  enum { YYERROR_VERBOSE_ARGS_MAXIMUM = 5 };
-  /* Internationalized format string. */
-  const char *yyformat = YY_NULLPTR;
-  /* Arguments of yyformat: reported tokens (one for the "unexpected",
-     one per "expected"). */
-  char const *yyarg[YYERROR_VERBOSE_ARGS_MAXIMUM];
   /* Actual size of YYARG. */
   int yycount = 0;
-  /* Cumulated lengths of YYARG.  */
-  YYPTRDIFF_T yysize = 0;
-
   /* There are many possibilities here to consider:
      - If this state is a consistent state with a default action, then
        the only way this function was invoked is if the default action
@@ -1107,52 +1592,54 @@ yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
        one exception: it will still contain any token that will not be
        accepted due to an error action in a later state.
   */
-  if (yytoken != YYEMPTY)
+  if (yyctx->yytoken != YYSYMBOL_YYEMPTY)
     {
-      int yyn = yypact[+*yyssp];
-      YYPTRDIFF_T yysize0 = yytnamerr (YY_NULLPTR, yytname[yytoken]);
-      yysize = yysize0;
-      yyarg[yycount++] = yytname[yytoken];
-      if (!yypact_value_is_default (yyn))
-        {
-          /* Start YYX at -YYN if negative to avoid negative indexes in
-             YYCHECK.  In other words, skip the first -YYN actions for
-             this state because they are default actions.  */
-          int yyxbegin = yyn < 0 ? -yyn : 0;
-          /* Stay within bounds of both yycheck and yytname.  */
-          int yychecklim = YYLAST - yyn + 1;
-          int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
-          int yyx;
-
-          for (yyx = yyxbegin; yyx < yyxend; ++yyx)
-            if (yycheck[yyx + yyn] == yyx && yyx != YYTERROR
-                && !yytable_value_is_error (yytable[yyx + yyn]))
-              {
-                if (yycount == YYERROR_VERBOSE_ARGS_MAXIMUM)
-                  {
-                    yycount = 1;
-                    yysize = yysize0;
-                    break;
-                  }
-                yyarg[yycount++] = yytname[yyx];
-                {
-                  YYPTRDIFF_T yysize1
-                    = yysize + yytnamerr (YY_NULLPTR, yytname[yyx]);
-                  if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-                    yysize = yysize1;
-                  else
-                    return 2;
-                }
-              }
-        }
+      int yyn;
+      if (yyarg)
+        yyarg[yycount] = yyctx->yytoken;
+      ++yycount;
+      yyn = yypcontext_expected_tokens (yyctx,
+                                        yyarg ? yyarg + 1 : yyarg, yyargn - 1);
+      if (yyn == YYENOMEM)
+        return YYENOMEM;
+      else
+        yycount += yyn;
     }
+  return yycount;
+}
+
+/* Copy into *YYMSG, which is of size *YYMSG_ALLOC, an error message
+   about the unexpected token YYTOKEN for the state stack whose top is
+   YYSSP.
+
+   Return 0 if *YYMSG was successfully written.  Return -1 if *YYMSG is
+   not large enough to hold the message.  In that case, also set
+   *YYMSG_ALLOC to the required number of bytes.  Return YYENOMEM if the
+   required number of bytes is too large to store.  */
+static int
+yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
+                const yypcontext_t *yyctx)
+{
+  enum { YYARGS_MAX = 5 };
+  /* Internationalized format string. */
+  const char *yyformat = YY_NULLPTR;
+  /* Arguments of yyformat: reported tokens (one for the "unexpected",
+     one per "expected"). */
+  yysymbol_kind_t yyarg[YYARGS_MAX];
+  /* Cumulated lengths of YYARG.  */
+  YYPTRDIFF_T yysize = 0;
+
+  /* Actual size of YYARG. */
+  int yycount = yy_syntax_error_arguments (yyctx, yyarg, YYARGS_MAX);
+  if (yycount == YYENOMEM)
+    return YYENOMEM;
 
   switch (yycount)
     {
-# define YYCASE_(N, S)                      \
+#define YYCASE_(N, S)                       \
       case N:                               \
         yyformat = S;                       \
-      break
+        break
     default: /* Avoid compiler warnings. */
       YYCASE_(0, YY_("syntax error"));
       YYCASE_(1, YY_("syntax error, unexpected %s"));
@@ -1160,17 +1647,23 @@ yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
       YYCASE_(3, YY_("syntax error, unexpected %s, expecting %s or %s"));
       YYCASE_(4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
       YYCASE_(5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
-# undef YYCASE_
+#undef YYCASE_
     }
 
+  /* Compute error message size.  Don't count the "%s"s, but reserve
+     room for the terminator.  */
+  yysize = yystrlen (yyformat) - 2 * yycount + 1;
   {
-    /* Don't count the "%s"s in the final size, but reserve room for
-       the terminator.  */
-    YYPTRDIFF_T yysize1 = yysize + (yystrlen (yyformat) - 2 * yycount) + 1;
-    if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
-      yysize = yysize1;
-    else
-      return 2;
+    int yyi;
+    for (yyi = 0; yyi < yycount; ++yyi)
+      {
+        YYPTRDIFF_T yysize1
+          = yysize + yytnamerr (YY_NULLPTR, yytname[yyarg[yyi]]);
+        if (yysize <= yysize1 && yysize1 <= YYSTACK_ALLOC_MAXIMUM)
+          yysize = yysize1;
+        else
+          return YYENOMEM;
+      }
   }
 
   if (*yymsg_alloc < yysize)
@@ -1179,7 +1672,7 @@ yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
       if (! (yysize <= *yymsg_alloc
              && *yymsg_alloc <= YYSTACK_ALLOC_MAXIMUM))
         *yymsg_alloc = YYSTACK_ALLOC_MAXIMUM;
-      return 1;
+      return -1;
     }
 
   /* Avoid sprintf, as that infringes on the user's name space.
@@ -1191,7 +1684,7 @@ yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
     while ((*yyp = *yyformat) != '\0')
       if (*yyp == '%' && yyformat[1] == 's' && yyi < yycount)
         {
-          yyp += yytnamerr (yyp, yyarg[yyi++]);
+          yyp += yytnamerr (yyp, yytname[yyarg[yyi++]]);
           yyformat += 2;
         }
       else
@@ -1202,111 +1695,124 @@ yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
   }
   return 0;
 }
-#endif /* YYERROR_VERBOSE */
+
 
 /*-----------------------------------------------.
 | Release the memory associated to this symbol.  |
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep)
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
 {
-  YYUSE (yyvaluep);
+  YY_USE (yyvaluep);
   if (!yymsg)
     yymsg = "Deleting";
-  YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  switch (yytype)
+  switch (yykind)
     {
-    case 3: /* NUMBER  */
-#line 75 "src/mush.y"
+    case YYSYMBOL_NUMBER: /* NUMBER  */
+#line 80 "src/mush.y"
             { free(((*yyvaluep).string)); }
-#line 1226 "src/mush.tab.c"
+#line 1720 "src/mush.tab.c"
         break;
 
-    case 4: /* NAME  */
-#line 76 "src/mush.y"
+    case YYSYMBOL_NAME: /* NAME  */
+#line 81 "src/mush.y"
             { free(((*yyvaluep).string)); }
-#line 1232 "src/mush.tab.c"
+#line 1726 "src/mush.tab.c"
         break;
 
-    case 5: /* WORD  */
-#line 77 "src/mush.y"
+    case YYSYMBOL_WORD: /* WORD  */
+#line 82 "src/mush.y"
             { free(((*yyvaluep).string)); }
-#line 1238 "src/mush.tab.c"
+#line 1732 "src/mush.tab.c"
         break;
 
-    case 6: /* STRING  */
-#line 78 "src/mush.y"
+    case YYSYMBOL_STRING: /* STRING  */
+#line 83 "src/mush.y"
             { free(((*yyvaluep).string)); }
-#line 1244 "src/mush.tab.c"
+#line 1738 "src/mush.tab.c"
         break;
 
-    case 47: /* statement  */
-#line 80 "src/mush.y"
-            { free_stmt(((*yyvaluep).stmt)); }
-#line 1250 "src/mush.tab.c"
+    case YYSYMBOL_FUNCTION: /* FUNCTION  */
+#line 84 "src/mush.y"
+            { free(((*yyvaluep).string)); }
+#line 1744 "src/mush.tab.c"
         break;
 
-    case 48: /* pipeline  */
+    case YYSYMBOL_statement: /* statement  */
 #line 86 "src/mush.y"
+            { free_stmt(((*yyvaluep).stmt)); }
+#line 1750 "src/mush.tab.c"
+        break;
+
+    case YYSYMBOL_pipeline: /* pipeline  */
+#line 93 "src/mush.y"
             { free_pipeline(((*yyvaluep).pline)); }
-#line 1256 "src/mush.tab.c"
+#line 1756 "src/mush.tab.c"
         break;
 
-    case 49: /* command_list  */
-#line 83 "src/mush.y"
+    case YYSYMBOL_command_list: /* command_list  */
+#line 89 "src/mush.y"
             { free_commands(((*yyvaluep).cmds)); }
-#line 1262 "src/mush.tab.c"
+#line 1762 "src/mush.tab.c"
         break;
 
-    case 50: /* command  */
-#line 82 "src/mush.y"
+    case YYSYMBOL_command: /* command  */
+#line 88 "src/mush.y"
             { free_commands(((*yyvaluep).cmds)); }
-#line 1268 "src/mush.tab.c"
+#line 1768 "src/mush.tab.c"
         break;
 
-    case 51: /* arg_list  */
-#line 85 "src/mush.y"
+    case YYSYMBOL_arg_list: /* arg_list  */
+#line 91 "src/mush.y"
             { free_args(((*yyvaluep).args)); }
-#line 1274 "src/mush.tab.c"
+#line 1774 "src/mush.tab.c"
         break;
 
-    case 52: /* arg  */
-#line 84 "src/mush.y"
+    case YYSYMBOL_arg: /* arg  */
+#line 90 "src/mush.y"
             { free(((*yyvaluep).expr)); }
-#line 1280 "src/mush.tab.c"
+#line 1780 "src/mush.tab.c"
         break;
 
-    case 54: /* expr  */
-#line 81 "src/mush.y"
+    case YYSYMBOL_expr_list: /* expr_list  */
+#line 92 "src/mush.y"
+            { free_args(((*yyvaluep).args)); }
+#line 1786 "src/mush.tab.c"
+        break;
+
+    case YYSYMBOL_expr: /* expr  */
+#line 87 "src/mush.y"
             { free_expr(((*yyvaluep).expr)); }
-#line 1286 "src/mush.tab.c"
+#line 1792 "src/mush.tab.c"
         break;
 
-    case 55: /* numeric_var  */
-#line 89 "src/mush.y"
+    case YYSYMBOL_numeric_var: /* numeric_var  */
+#line 96 "src/mush.y"
             { free(((*yyvaluep).string)); }
-#line 1292 "src/mush.tab.c"
+#line 1798 "src/mush.tab.c"
         break;
 
-    case 56: /* string_var  */
-#line 90 "src/mush.y"
+    case YYSYMBOL_string_var: /* string_var  */
+#line 97 "src/mush.y"
             { free(((*yyvaluep).string)); }
-#line 1298 "src/mush.tab.c"
+#line 1804 "src/mush.tab.c"
         break;
 
-    case 60: /* literal_string  */
-#line 88 "src/mush.y"
+    case YYSYMBOL_literal_string: /* literal_string  */
+#line 95 "src/mush.y"
             { free(((*yyvaluep).string)); }
-#line 1304 "src/mush.tab.c"
+#line 1810 "src/mush.tab.c"
         break;
 
-    case 61: /* file  */
-#line 87 "src/mush.y"
+    case YYSYMBOL_file: /* file  */
+#line 94 "src/mush.y"
             { free(((*yyvaluep).string)); }
-#line 1310 "src/mush.tab.c"
+#line 1816 "src/mush.tab.c"
         break;
 
       default:
@@ -1318,13 +1824,6 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep)
 
 
 
-/* The lookahead symbol.  */
-int yychar;
-
-/* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
-/* Number of syntax errors so far.  */
-int yynerrs;
 
 
 /*----------.
@@ -1334,43 +1833,52 @@ int yynerrs;
 int
 yyparse (void)
 {
-    yy_state_fast_t yystate;
-    /* Number of tokens to shift before error messages enabled.  */
-    int yyerrstatus;
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
 
-    /* The stacks and their tools:
-       'yyss': related to states.
-       'yyvs': related to semantic values.
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
 
-       Refer to the stacks through separate pointers, to allow yyoverflow
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
        to reallocate them elsewhere.  */
 
-    /* The state stack.  */
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
     yy_state_t yyssa[YYINITDEPTH];
-    yy_state_t *yyss;
-    yy_state_t *yyssp;
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
 
-    /* The semantic value stack.  */
+    /* The semantic value stack: array, bottom, top.  */
     YYSTYPE yyvsa[YYINITDEPTH];
-    YYSTYPE *yyvs;
-    YYSTYPE *yyvsp;
-
-    YYPTRDIFF_T yystacksize;
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
 
   int yyn;
+  /* The return value of yyparse.  */
   int yyresult;
-  /* Lookahead token as an internal (translated) token number.  */
-  int yytoken = 0;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
   /* The variables used to return semantic value and location from the
      action routines.  */
   YYSTYPE yyval;
 
-#if YYERROR_VERBOSE
   /* Buffer for error messages, and its allocated size.  */
   char yymsgbuf[128];
   char *yymsg = yymsgbuf;
   YYPTRDIFF_T yymsg_alloc = sizeof yymsgbuf;
-#endif
 
 #define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
 
@@ -1378,16 +1886,10 @@ yyparse (void)
      Keep to zero when no symbol should be popped.  */
   int yylen = 0;
 
-  yyssp = yyss = yyssa;
-  yyvsp = yyvs = yyvsa;
-  yystacksize = YYINITDEPTH;
-
   YYDPRINTF ((stderr, "Starting parse\n"));
 
-  yystate = 0;
-  yyerrstatus = 0;
-  yynerrs = 0;
   yychar = YYEMPTY; /* Cause a token to be read.  */
+
   goto yysetstate;
 
 
@@ -1409,10 +1911,11 @@ yysetstate:
   YY_IGNORE_USELESS_CAST_BEGIN
   *yyssp = YY_CAST (yy_state_t, yystate);
   YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
 
   if (yyss + yystacksize - 1 <= yyssp)
 #if !defined yyoverflow && !defined YYSTACK_RELOCATE
-    goto yyexhaustedlab;
+    YYNOMEM;
 #else
     {
       /* Get the current used size of the three stacks, in elements.  */
@@ -1440,7 +1943,7 @@ yysetstate:
 # else /* defined YYSTACK_RELOCATE */
       /* Extend the stack our own way.  */
       if (YYMAXDEPTH <= yystacksize)
-        goto yyexhaustedlab;
+        YYNOMEM;
       yystacksize *= 2;
       if (YYMAXDEPTH < yystacksize)
         yystacksize = YYMAXDEPTH;
@@ -1451,10 +1954,10 @@ yysetstate:
           YY_CAST (union yyalloc *,
                    YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
         if (! yyptr)
-          goto yyexhaustedlab;
+          YYNOMEM;
         YYSTACK_RELOCATE (yyss_alloc, yyss);
         YYSTACK_RELOCATE (yyvs_alloc, yyvs);
-# undef YYSTACK_RELOCATE
+#  undef YYSTACK_RELOCATE
         if (yyss1 != yyssa)
           YYSTACK_FREE (yyss1);
       }
@@ -1473,6 +1976,7 @@ yysetstate:
     }
 #endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
 
+
   if (yystate == YYFINAL)
     YYACCEPT;
 
@@ -1493,18 +1997,29 @@ yybackup:
 
   /* Not known => get a lookahead token if don't already have one.  */
 
-  /* YYCHAR is either YYEMPTY or YYEOF or a valid lookahead symbol.  */
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
   if (yychar == YYEMPTY)
     {
-      YYDPRINTF ((stderr, "Reading a token: "));
-      yychar = yylex ();
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex (&yylval);
     }
 
   if (yychar <= YYEOF)
     {
-      yychar = yytoken = YYEOF;
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
       YYDPRINTF ((stderr, "Now at end of input.\n"));
     }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
   else
     {
       yytoken = YYTRANSLATE (yychar);
@@ -1573,19 +2088,19 @@ yyreduce:
   YY_REDUCE_PRINT (yyn);
   switch (yyn)
     {
-  case 2:
-#line 96 "src/mush.y"
+  case 2: /* statement: LIST EOL  */
+#line 371 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = LIST_STMT_CLASS;
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1585 "src/mush.tab.c"
+#line 2100 "src/mush.tab.c"
     break;
 
-  case 3:
-#line 103 "src/mush.y"
+  case 3: /* statement: DELETE lineno COMMA lineno EOL  */
+#line 378 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = DELETE_STMT_CLASS;
@@ -1594,33 +2109,33 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1598 "src/mush.tab.c"
+#line 2113 "src/mush.tab.c"
     break;
 
-  case 4:
-#line 112 "src/mush.y"
+  case 4: /* statement: RUN EOL  */
+#line 387 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = RUN_STMT_CLASS;
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1609 "src/mush.tab.c"
+#line 2124 "src/mush.tab.c"
     break;
 
-  case 5:
-#line 119 "src/mush.y"
+  case 5: /* statement: CONT EOL  */
+#line 394 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = CONT_STMT_CLASS;
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1620 "src/mush.tab.c"
+#line 2135 "src/mush.tab.c"
     break;
 
-  case 6:
-#line 126 "src/mush.y"
+  case 6: /* statement: lineno STOP EOL  */
+#line 401 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = STOP_STMT_CLASS;
@@ -1628,11 +2143,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1632 "src/mush.tab.c"
+#line 2147 "src/mush.tab.c"
     break;
 
-  case 7:
-#line 134 "src/mush.y"
+  case 7: /* statement: optional_lineno pipeline EOL  */
+#line 409 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = FG_STMT_CLASS;
@@ -1641,11 +2156,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1645 "src/mush.tab.c"
+#line 2160 "src/mush.tab.c"
     break;
 
-  case 8:
-#line 143 "src/mush.y"
+  case 8: /* statement: optional_lineno pipeline BG EOL  */
+#line 418 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = BG_STMT_CLASS;
@@ -1654,11 +2169,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1658 "src/mush.tab.c"
+#line 2173 "src/mush.tab.c"
     break;
 
-  case 9:
-#line 152 "src/mush.y"
+  case 9: /* statement: optional_lineno WAIT expr EOL  */
+#line 427 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = WAIT_STMT_CLASS;
@@ -1667,11 +2182,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1671 "src/mush.tab.c"
+#line 2186 "src/mush.tab.c"
     break;
 
-  case 10:
-#line 161 "src/mush.y"
+  case 10: /* statement: optional_lineno POLL expr EOL  */
+#line 436 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = POLL_STMT_CLASS;
@@ -1680,11 +2195,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1684 "src/mush.tab.c"
+#line 2199 "src/mush.tab.c"
     break;
 
-  case 11:
-#line 170 "src/mush.y"
+  case 11: /* statement: optional_lineno CANCEL expr EOL  */
+#line 445 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = CANCEL_STMT_CLASS;
@@ -1693,11 +2208,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1697 "src/mush.tab.c"
+#line 2212 "src/mush.tab.c"
     break;
 
-  case 12:
-#line 179 "src/mush.y"
+  case 12: /* statement: optional_lineno PAUSE EOL  */
+#line 454 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = PAUSE_STMT_CLASS;
@@ -1705,11 +2220,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1709 "src/mush.tab.c"
+#line 2224 "src/mush.tab.c"
     break;
 
-  case 13:
-#line 187 "src/mush.y"
+  case 13: /* statement: optional_lineno GOTO lineno EOL  */
+#line 462 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = GOTO_STMT_CLASS;
@@ -1718,25 +2233,264 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1722 "src/mush.tab.c"
+#line 2237 "src/mush.tab.c"
+    break;
+
+  case 14: /* statement: optional_lineno SET NAME EQ expr EOL  */
+#line 471 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = SET_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.set_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.set_stmt.expr = (yyvsp[-1].expr);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2251 "src/mush.tab.c"
     break;
 
-  case 14:
-#line 196 "src/mush.y"
+  case 15: /* statement: optional_lineno SET NAME LBRACKET expr RBRACKET EQ expr EOL  */
+#line 481 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = SET_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-8].number);
+	      (yyval.stmt)->members.set_stmt.name = (yyvsp[-6].string);
+	      (yyval.stmt)->members.set_stmt.index = (yyvsp[-4].expr);
+	      (yyval.stmt)->members.set_stmt.expr = (yyvsp[-1].expr);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2266 "src/mush.tab.c"
+    break;
+
+  case 16: /* statement: optional_lineno PUSH NAME EQ expr EOL  */
+#line 492 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = PUSH_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.set_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.set_stmt.expr = (yyvsp[-1].expr);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2280 "src/mush.tab.c"
+    break;
+
+  case 17: /* statement: optional_lineno POP NAME EOL  */
+#line 502 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = POP_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-3].number);
+	      (yyval.stmt)->members.pop_stmt.name = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2293 "src/mush.tab.c"
+    break;
+
+  case 18: /* statement: optional_lineno POP NAME GREATER NAME EOL  */
+#line 511 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = POP_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.pop_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.pop_stmt.target = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2307 "src/mush.tab.c"
+    break;
+
+  case 19: /* statement: optional_lineno APPEND NAME EQ expr EOL  */
+#line 521 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = APPEND_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.set_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.set_stmt.expr = (yyvsp[-1].expr);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2321 "src/mush.tab.c"
+    break;
+
+  case 20: /* statement: optional_lineno KEYS NAME GREATER NAME EOL  */
+#line 531 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = KEYS_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.pop_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.pop_stmt.target = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2335 "src/mush.tab.c"
+    break;
+
+  case 21: /* statement: optional_lineno SPLIT NAME GREATER NAME EOL  */
+#line 541 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = SPLIT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.split_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.split_stmt.target = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2349 "src/mush.tab.c"
+    break;
+
+  case 22: /* statement: optional_lineno SPLIT NAME GREATER numeric_var EOL  */
+#line 551 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = SPLIT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.split_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.split_stmt.target = (yyvsp[-1].string);
+	      (yyval.stmt)->members.split_stmt.numeric = 1;
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2364 "src/mush.tab.c"
+    break;
+
+  case 23: /* statement: optional_lineno SPLIT NAME GREATER NAME BY expr EOL  */
+#line 562 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = SPLIT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-7].number);
+	      (yyval.stmt)->members.split_stmt.name = (yyvsp[-5].string);
+	      (yyval.stmt)->members.split_stmt.target = (yyvsp[-3].string);
+	      (yyval.stmt)->members.split_stmt.delim = (yyvsp[-1].expr);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2379 "src/mush.tab.c"
+    break;
+
+  case 24: /* statement: optional_lineno SPLIT NAME GREATER numeric_var BY expr EOL  */
+#line 573 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = SPLIT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-7].number);
+	      (yyval.stmt)->members.split_stmt.name = (yyvsp[-5].string);
+	      (yyval.stmt)->members.split_stmt.target = (yyvsp[-3].string);
+	      (yyval.stmt)->members.split_stmt.delim = (yyvsp[-1].expr);
+	      (yyval.stmt)->members.split_stmt.numeric = 1;
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2395 "src/mush.tab.c"
+    break;
+
+  case 25: /* statement: optional_lineno IMPORT LESS file EOL  */
+#line 585 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = IMPORT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-4].number);
+	      (yyval.stmt)->members.import_stmt.file = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2408 "src/mush.tab.c"
+    break;
+
+  case 26: /* statement: optional_lineno IMPORT LESS file AS NAME EOL  */
+#line 594 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = IMPORT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-6].number);
+	      (yyval.stmt)->members.import_stmt.file = (yyvsp[-3].string);
+	      (yyval.stmt)->members.import_stmt.prefix = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2422 "src/mush.tab.c"
+    break;
+
+  case 27: /* statement: optional_lineno IMPORT NAME EOL  */
+#line 604 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = IMPORT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-3].number);
+	      (yyval.stmt)->members.import_stmt.name = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2435 "src/mush.tab.c"
+    break;
+
+  case 28: /* statement: optional_lineno IMPORT NAME AS NAME EOL  */
+#line 613 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = IMPORT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.import_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.import_stmt.prefix = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2449 "src/mush.tab.c"
+    break;
+
+  case 29: /* statement: optional_lineno EXPORT NAME EOL  */
+#line 623 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = EXPORT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-3].number);
+	      (yyval.stmt)->members.set_stmt.name = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2462 "src/mush.tab.c"
+    break;
+
+  case 30: /* statement: optional_lineno EXPORT NAME EQ expr EOL  */
+#line 632 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = EXPORT_STMT_CLASS;
 	      (yyval.stmt)->lineno = (yyvsp[-5].number);
 	      (yyval.stmt)->members.set_stmt.name = (yyvsp[-3].string);
 	      (yyval.stmt)->members.set_stmt.expr = (yyvsp[-1].expr);
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1736 "src/mush.tab.c"
+#line 2476 "src/mush.tab.c"
+    break;
+
+  case 31: /* statement: optional_lineno UNSET NAME LBRACKET expr RBRACKET EOL  */
+#line 642 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = UNSET_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-6].number);
+	      (yyval.stmt)->members.unset_stmt.name = (yyvsp[-4].string);
+	      (yyval.stmt)->members.unset_stmt.index = (yyvsp[-2].expr);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2490 "src/mush.tab.c"
     break;
 
-  case 15:
-#line 206 "src/mush.y"
+  case 32: /* statement: optional_lineno UNSET NAME EOL  */
+#line 652 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = UNSET_STMT_CLASS;
@@ -1745,11 +2499,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1749 "src/mush.tab.c"
+#line 2503 "src/mush.tab.c"
     break;
 
-  case 16:
-#line 215 "src/mush.y"
+  case 33: /* statement: optional_lineno IF expr GOTO lineno EOL  */
+#line 661 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = IF_STMT_CLASS;
@@ -1759,11 +2513,11 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1763 "src/mush.tab.c"
+#line 2517 "src/mush.tab.c"
     break;
 
-  case 17:
-#line 225 "src/mush.y"
+  case 34: /* statement: optional_lineno SOURCE file EOL  */
+#line 671 "src/mush.y"
           {
 	      (yyval.stmt) = calloc(1, sizeof(STMT));
 	      (yyval.stmt)->class = SOURCE_STMT_CLASS;
@@ -1772,177 +2526,404 @@ yyreduce:
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1776 "src/mush.tab.c"
+#line 2530 "src/mush.tab.c"
+    break;
+
+  case 35: /* statement: optional_lineno SAVE file EOL  */
+#line 680 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = SAVE_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-3].number);
+	      (yyval.stmt)->members.source_stmt.file = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2543 "src/mush.tab.c"
+    break;
+
+  case 36: /* statement: optional_lineno RESTORE file EOL  */
+#line 689 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = RESTORE_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-3].number);
+	      (yyval.stmt)->members.source_stmt.file = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2556 "src/mush.tab.c"
+    break;
+
+  case 37: /* statement: optional_lineno CACHED EOL  */
+#line 698 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = CACHE_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-2].number);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2568 "src/mush.tab.c"
+    break;
+
+  case 38: /* statement: optional_lineno FOR NAME EQ expr TO expr EOL  */
+#line 706 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = FOR_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-7].number);
+	      (yyval.stmt)->members.for_stmt.name = (yyvsp[-5].string);
+	      (yyval.stmt)->members.for_stmt.from = (yyvsp[-3].expr);
+	      (yyval.stmt)->members.for_stmt.to = (yyvsp[-1].expr);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2583 "src/mush.tab.c"
+    break;
+
+  case 39: /* statement: optional_lineno FOR NAME EQ expr TO expr STEP expr EOL  */
+#line 717 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = FOR_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-9].number);
+	      (yyval.stmt)->members.for_stmt.name = (yyvsp[-7].string);
+	      (yyval.stmt)->members.for_stmt.from = (yyvsp[-5].expr);
+	      (yyval.stmt)->members.for_stmt.to = (yyvsp[-3].expr);
+	      (yyval.stmt)->members.for_stmt.step = (yyvsp[-1].expr);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2599 "src/mush.tab.c"
     break;
 
-  case 18:
-#line 234 "src/mush.y"
+  case 40: /* statement: optional_lineno NEXT NAME EOL  */
+#line 729 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = NEXT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-3].number);
+	      (yyval.stmt)->members.next_stmt.name = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2612 "src/mush.tab.c"
+    break;
+
+  case 41: /* statement: optional_lineno NEXT EOL  */
+#line 738 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = NEXT_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-2].number);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2624 "src/mush.tab.c"
+    break;
+
+  case 42: /* statement: optional_lineno READ NAME LESS file EOL  */
+#line 746 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = READ_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.file_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.file_stmt.file = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2638 "src/mush.tab.c"
+    break;
+
+  case 43: /* statement: optional_lineno WRITE NAME GREATER file EOL  */
+#line 756 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = WRITE_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-5].number);
+	      (yyval.stmt)->members.file_stmt.name = (yyvsp[-3].string);
+	      (yyval.stmt)->members.file_stmt.file = (yyvsp[-1].string);
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2652 "src/mush.tab.c"
+    break;
+
+  case 44: /* statement: optional_lineno WRITE NAME GREATER GREATER file EOL  */
+#line 766 "src/mush.y"
+          {
+	      (yyval.stmt) = calloc(1, sizeof(STMT));
+	      (yyval.stmt)->class = WRITE_STMT_CLASS;
+	      (yyval.stmt)->lineno = (yyvsp[-6].number);
+	      (yyval.stmt)->members.file_stmt.name = (yyvsp[-4].string);
+	      (yyval.stmt)->members.file_stmt.file = (yyvsp[-1].string);
+	      (yyval.stmt)->members.file_stmt.append = 1;
+	      mush_parsed_stmt = (yyval.stmt);
+	      YYACCEPT;
+	  }
+#line 2667 "src/mush.tab.c"
+    break;
+
+  case 45: /* statement: EOL  */
+#line 777 "src/mush.y"
           {
 	      (yyval.stmt) = NULL;
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1786 "src/mush.tab.c"
+#line 2677 "src/mush.tab.c"
     break;
 
-  case 19:
-#line 240 "src/mush.y"
+  case 46: /* statement: EoF  */
+#line 783 "src/mush.y"
           {
+	      (yyval.stmt) = NULL;
 	      YYABORT;
 	  }
-#line 1794 "src/mush.tab.c"
+#line 2686 "src/mush.tab.c"
     break;
 
-  case 20:
-#line 244 "src/mush.y"
+  case 47: /* statement: error EOL  */
+#line 788 "src/mush.y"
           {
 	      (yyval.stmt) = NULL;
 	      mush_parsed_stmt = (yyval.stmt);
 	      YYACCEPT;
 	  }
-#line 1804 "src/mush.tab.c"
+#line 2696 "src/mush.tab.c"
     break;
 
-  case 21:
-#line 252 "src/mush.y"
+  case 48: /* pipeline: command_list  */
+#line 797 "src/mush.y"
           {
 	      (yyval.pline) = calloc(1, sizeof(PIPELINE));
 	      (yyval.pline)->commands = (yyvsp[0].cmds);
           }
-#line 1813 "src/mush.tab.c"
+#line 2705 "src/mush.tab.c"
+    break;
+
+  case 49: /* pipeline: CACHED command_list  */
+#line 802 "src/mush.y"
+          {
+	      (yyval.pline) = calloc(1, sizeof(PIPELINE));
+	      (yyval.pline)->commands = (yyvsp[0].cmds);
+	      (yyval.pline)->cached = 1;
+	  }
+#line 2715 "src/mush.tab.c"
     break;
 
-  case 22:
-#line 257 "src/mush.y"
+  case 50: /* pipeline: pipeline LESS file  */
+#line 808 "src/mush.y"
           {
 	      (yyval.pline) = (yyvsp[-2].pline);
 	      (yyval.pline)->input_file = (yyvsp[0].string);
 	  }
-#line 1822 "src/mush.tab.c"
+#line 2724 "src/mush.tab.c"
     break;
 
-  case 23:
-#line 262 "src/mush.y"
+  case 51: /* pipeline: pipeline GREATER file  */
+#line 813 "src/mush.y"
           {
 	      (yyval.pline) = (yyvsp[-2].pline);
 	      (yyval.pline)->output_file = (yyvsp[0].string);
 	  }
-#line 1831 "src/mush.tab.c"
+#line 2733 "src/mush.tab.c"
     break;
 
-  case 24:
-#line 267 "src/mush.y"
+  case 52: /* pipeline: pipeline GREATER CAPTURE  */
+#line 818 "src/mush.y"
           {
 	      (yyval.pline) = (yyvsp[-2].pline);
 	      (yyval.pline)->capture_output = 1;
 	  }
-#line 1840 "src/mush.tab.c"
+#line 2742 "src/mush.tab.c"
     break;
 
-  case 25:
-#line 274 "src/mush.y"
+  case 53: /* command_list: command  */
+#line 826 "src/mush.y"
           {
 	      (yyval.cmds) = (yyvsp[0].cmds);
 	  }
-#line 1848 "src/mush.tab.c"
+#line 2750 "src/mush.tab.c"
     break;
 
-  case 26:
-#line 278 "src/mush.y"
+  case 54: /* command_list: command PIPE command_list  */
+#line 830 "src/mush.y"
           {
 	      (yyval.cmds) = (yyvsp[-2].cmds);
 	      (yyval.cmds)->next = (yyvsp[0].cmds);
 	  }
-#line 1857 "src/mush.tab.c"
+#line 2759 "src/mush.tab.c"
     break;
 
-  case 27:
-#line 285 "src/mush.y"
+  case 55: /* command: arg_list  */
+#line 838 "src/mush.y"
           {
 	      (yyval.cmds) = calloc(1, sizeof(COMMAND));
 	      (yyval.cmds)->args = (yyvsp[0].args);
 	  }
-#line 1866 "src/mush.tab.c"
+#line 2768 "src/mush.tab.c"
     break;
 
-  case 28:
-#line 292 "src/mush.y"
+  case 56: /* arg_list: arg  */
+#line 846 "src/mush.y"
           {
 	      (yyval.args) = calloc(1, sizeof(ARG));
 	      (yyval.args)->expr = (yyvsp[0].expr);
 	  }
-#line 1875 "src/mush.tab.c"
+#line 2777 "src/mush.tab.c"
     break;
 
-  case 29:
-#line 297 "src/mush.y"
+  case 57: /* arg_list: arg arg_list  */
+#line 851 "src/mush.y"
           {
 	      (yyval.args) = calloc(1, sizeof(ARG));
 	      (yyval.args)->expr = (yyvsp[-1].expr);
 	      (yyval.args)->next = (yyvsp[0].args);
 	  }
-#line 1885 "src/mush.tab.c"
+#line 2787 "src/mush.tab.c"
     break;
 
-  case 30:
-#line 305 "src/mush.y"
+  case 58: /* arg: atomic_expr  */
+#line 860 "src/mush.y"
           {
 	      (yyval.expr) = (yyvsp[0].expr);
 	  }
-#line 1893 "src/mush.tab.c"
+#line 2795 "src/mush.tab.c"
     break;
 
-  case 31:
-#line 311 "src/mush.y"
+  case 59: /* atomic_expr: literal_string  */
+#line 867 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = LIT_EXPR_CLASS;
 	      (yyval.expr)->type = STRING_VALUE_TYPE;
 	      (yyval.expr)->members.value = (yyvsp[0].string);
 	  }
-#line 1904 "src/mush.tab.c"
+#line 2806 "src/mush.tab.c"
     break;
 
-  case 32:
-#line 318 "src/mush.y"
+  case 60: /* atomic_expr: numeric_var  */
+#line 874 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = NUM_EXPR_CLASS;
 	      (yyval.expr)->type = NUM_VALUE_TYPE;
 	      (yyval.expr)->members.variable = (yyvsp[0].string);
 	  }
-#line 1915 "src/mush.tab.c"
+#line 2817 "src/mush.tab.c"
     break;
 
-  case 33:
-#line 325 "src/mush.y"
+  case 61: /* atomic_expr: string_var  */
+#line 881 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = STRING_EXPR_CLASS;
 	      (yyval.expr)->type = STRING_VALUE_TYPE;
 	      (yyval.expr)->members.variable = (yyvsp[0].string);
 	  }
-#line 1926 "src/mush.tab.c"
+#line 2828 "src/mush.tab.c"
+    break;
+
+  case 62: /* atomic_expr: SHARP NAME LBRACKET expr RBRACKET  */
+#line 888 "src/mush.y"
+          {
+	      (yyval.expr) = calloc(1, sizeof(EXPR));
+	      (yyval.expr)->class = INDEX_EXPR_CLASS;
+	      (yyval.expr)->type = NUM_VALUE_TYPE;
+	      (yyval.expr)->members.index_expr.variable = (yyvsp[-3].string);
+	      (yyval.expr)->members.index_expr.index = (yyvsp[-1].expr);
+	  }
+#line 2840 "src/mush.tab.c"
     break;
 
-  case 34:
-#line 332 "src/mush.y"
+  case 63: /* atomic_expr: DOLLAR NAME LBRACKET expr RBRACKET  */
+#line 896 "src/mush.y"
+          {
+	      (yyval.expr) = calloc(1, sizeof(EXPR));
+	      (yyval.expr)->class = INDEX_EXPR_CLASS;
+	      (yyval.expr)->type = STRING_VALUE_TYPE;
+	      (yyval.expr)->members.index_expr.variable = (yyvsp[-3].string);
+	      (yyval.expr)->members.index_expr.index = (yyvsp[-1].expr);
+	  }
+#line 2852 "src/mush.tab.c"
+    break;
+
+  case 64: /* atomic_expr: LPAREN expr RPAREN  */
+#line 904 "src/mush.y"
           {
 	      (yyval.expr) = (yyvsp[-1].expr);
 	  }
-#line 1934 "src/mush.tab.c"
+#line 2860 "src/mush.tab.c"
+    break;
+
+  case 65: /* atomic_expr: FUNCTION LPAREN expr_list RPAREN  */
+#line 908 "src/mush.y"
+          {
+	      FUNC_INFO *fp = find_function((yyvsp[-3].string));
+	      int nargs = 0;
+	      for(ARG *ap = (yyvsp[-1].args); ap; ap = ap->next)
+		  nargs++;
+	      if(nargs < fp->min_args || nargs > fp->max_args) {
+		  yyerror("Wrong number of arguments to function");
+		  free((yyvsp[-3].string));
+		  free_args((yyvsp[-1].args));
+		  YYERROR;
+	      }
+	      if(fp->arg_class != NO_EXPR_CLASS
+		 && (yyvsp[-1].args)->expr->class != fp->arg_class
+		 && !(fp->arg_class == STRING_EXPR_CLASS
+		      && (yyvsp[-1].args)->expr->class == NUM_EXPR_CLASS)) {
+		  yyerror(fp->arg_class == INDEX_EXPR_CLASS
+			  ? "Argument must be an array or map element"
+			  : fp->arg_class == STRING_EXPR_CLASS
+			  ? "Argument must be a variable"
+			  : "Argument must be a numeric variable");
+		  free((yyvsp[-3].string));
+		  free_args((yyvsp[-1].args));
+		  YYERROR;
+	      }
+	      free((yyvsp[-3].string));
+	      (yyval.expr) = calloc(1, sizeof(EXPR));
+	      (yyval.expr)->class = FUNC_EXPR_CLASS;
+	      (yyval.expr)->type = fp->type;
+	      (yyval.expr)->members.func_expr.oprtr = fp->oprtr;
+	      (yyval.expr)->members.func_expr.args = (yyvsp[-1].args);
+	  }
+#line 2896 "src/mush.tab.c"
     break;
 
-  case 35:
-#line 337 "src/mush.y"
+  case 66: /* expr_list: expr  */
+#line 943 "src/mush.y"
+          {
+	      (yyval.args) = calloc(1, sizeof(ARG));
+	      (yyval.args)->expr = (yyvsp[0].expr);
+	  }
+#line 2905 "src/mush.tab.c"
+    break;
+
+  case 67: /* expr_list: expr COMMA expr_list  */
+#line 948 "src/mush.y"
+          {
+	      (yyval.args) = calloc(1, sizeof(ARG));
+	      (yyval.args)->expr = (yyvsp[-2].expr);
+	      (yyval.args)->next = (yyvsp[0].args);
+	  }
+#line 2915 "src/mush.tab.c"
+    break;
+
+  case 68: /* expr: atomic_expr  */
+#line 957 "src/mush.y"
           {
               (yyval.expr) = (yyvsp[0].expr);
           }
-#line 1942 "src/mush.tab.c"
+#line 2923 "src/mush.tab.c"
     break;
 
-  case 36:
-#line 341 "src/mush.y"
+  case 69: /* expr: expr EQUAL expr  */
+#line 961 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -1951,11 +2932,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 1955 "src/mush.tab.c"
+#line 2936 "src/mush.tab.c"
     break;
 
-  case 37:
-#line 350 "src/mush.y"
+  case 70: /* expr: expr LESS expr  */
+#line 970 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -1964,11 +2945,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 1968 "src/mush.tab.c"
+#line 2949 "src/mush.tab.c"
     break;
 
-  case 38:
-#line 359 "src/mush.y"
+  case 71: /* expr: expr GREATER expr  */
+#line 979 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -1977,11 +2958,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 1981 "src/mush.tab.c"
+#line 2962 "src/mush.tab.c"
     break;
 
-  case 39:
-#line 368 "src/mush.y"
+  case 72: /* expr: expr LESSEQ expr  */
+#line 988 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -1990,11 +2971,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 1994 "src/mush.tab.c"
+#line 2975 "src/mush.tab.c"
     break;
 
-  case 40:
-#line 377 "src/mush.y"
+  case 73: /* expr: expr GREATEQ expr  */
+#line 997 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -2003,11 +2984,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 2007 "src/mush.tab.c"
+#line 2988 "src/mush.tab.c"
     break;
 
-  case 41:
-#line 386 "src/mush.y"
+  case 74: /* expr: expr AND expr  */
+#line 1006 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -2016,11 +2997,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 2020 "src/mush.tab.c"
+#line 3001 "src/mush.tab.c"
     break;
 
-  case 42:
-#line 395 "src/mush.y"
+  case 75: /* expr: expr OR expr  */
+#line 1015 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -2029,11 +3010,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 2033 "src/mush.tab.c"
+#line 3014 "src/mush.tab.c"
     break;
 
-  case 43:
-#line 404 "src/mush.y"
+  case 76: /* expr: NOT expr  */
+#line 1024 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = UNARY_EXPR_CLASS;
@@ -2041,11 +3022,11 @@ yyreduce:
 	      (yyval.expr)->members.unary_expr.oprtr = NOT_OPRTR;
 	      (yyval.expr)->members.unary_expr.arg = (yyvsp[0].expr);
 	  }
-#line 2045 "src/mush.tab.c"
+#line 3026 "src/mush.tab.c"
     break;
 
-  case 44:
-#line 412 "src/mush.y"
+  case 77: /* expr: expr PLUS expr  */
+#line 1032 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -2054,11 +3035,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.oprtr = PLUS_OPRTR;
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 2058 "src/mush.tab.c"
+#line 3039 "src/mush.tab.c"
     break;
 
-  case 45:
-#line 421 "src/mush.y"
+  case 78: /* expr: expr MINUS expr  */
+#line 1041 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -2067,11 +3048,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.oprtr = MINUS_OPRTR;
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 2071 "src/mush.tab.c"
+#line 3052 "src/mush.tab.c"
     break;
 
-  case 46:
-#line 430 "src/mush.y"
+  case 79: /* expr: expr TIMES expr  */
+#line 1050 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -2080,11 +3061,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.oprtr = TIMES_OPRTR;
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 2084 "src/mush.tab.c"
+#line 3065 "src/mush.tab.c"
     break;
 
-  case 47:
-#line 439 "src/mush.y"
+  case 80: /* expr: expr DIVIDE expr  */
+#line 1059 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -2093,11 +3074,11 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.oprtr = DIVIDE_OPRTR;
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 2097 "src/mush.tab.c"
+#line 3078 "src/mush.tab.c"
     break;
 
-  case 48:
-#line 448 "src/mush.y"
+  case 81: /* expr: expr MOD expr  */
+#line 1068 "src/mush.y"
           {
 	      (yyval.expr) = calloc(1, sizeof(EXPR));
 	      (yyval.expr)->class = BINARY_EXPR_CLASS;
@@ -2106,29 +3087,68 @@ yyreduce:
 	      (yyval.expr)->members.binary_expr.oprtr = MOD_OPRTR;
 	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
 	  }
-#line 2110 "src/mush.tab.c"
+#line 3091 "src/mush.tab.c"
+    break;
+
+  case 82: /* expr: expr CONCAT expr  */
+#line 1077 "src/mush.y"
+          {
+	      (yyval.expr) = calloc(1, sizeof(EXPR));
+	      (yyval.expr)->class = BINARY_EXPR_CLASS;
+	      (yyval.expr)->type = STRING_VALUE_TYPE;
+	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
+	      (yyval.expr)->members.binary_expr.oprtr = CONCAT_OPRTR;
+	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
+	  }
+#line 3104 "src/mush.tab.c"
+    break;
+
+  case 83: /* expr: expr CONTAINS expr  */
+#line 1086 "src/mush.y"
+          {
+	      (yyval.expr) = calloc(1, sizeof(EXPR));
+	      (yyval.expr)->class = BINARY_EXPR_CLASS;
+	      (yyval.expr)->type = NUM_VALUE_TYPE;
+	      (yyval.expr)->members.binary_expr.oprtr = CONTAINS_OPRTR;
+	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
+	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
+	  }
+#line 3117 "src/mush.tab.c"
     break;
 
-  case 49:
-#line 459 "src/mush.y"
+  case 84: /* expr: expr MATCHES expr  */
+#line 1095 "src/mush.y"
+          {
+	      (yyval.expr) = calloc(1, sizeof(EXPR));
+	      (yyval.expr)->class = BINARY_EXPR_CLASS;
+	      (yyval.expr)->type = NUM_VALUE_TYPE;
+	      (yyval.expr)->members.binary_expr.oprtr = MATCHES_OPRTR;
+	      (yyval.expr)->members.binary_expr.arg1 = (yyvsp[-2].expr);
+	      (yyval.expr)->members.binary_expr.arg2 = (yyvsp[0].expr);
+	  }
+#line 3130 "src/mush.tab.c"
+    break;
+
+  case 85: /* numeric_var: SHARP NAME  */
+#line 1107 "src/mush.y"
           { (yyval.string) = (yyvsp[0].string); }
-#line 2116 "src/mush.tab.c"
+#line 3136 "src/mush.tab.c"
     break;
 
-  case 50:
-#line 463 "src/mush.y"
+  case 86: /* string_var: DOLLAR NAME  */
+#line 1112 "src/mush.y"
           { (yyval.string) = (yyvsp[0].string); }
-#line 2122 "src/mush.tab.c"
+#line 3142 "src/mush.tab.c"
     break;
 
-  case 51:
-#line 466 "src/mush.y"
+  case 87: /* optional_lineno: %empty  */
+#line 1116 "src/mush.y"
           { (yyval.number) = 0; }
-#line 2128 "src/mush.tab.c"
+#line 3148 "src/mush.tab.c"
     break;
 
-  case 52:
-#line 468 "src/mush.y"
+  case 88: /* optional_lineno: lineno  */
+#line 1118 "src/mush.y"
           {
 	      if((yyvsp[0].number) <= 0) {
 		  yyerror("Line number must be positive");
@@ -2136,53 +3156,53 @@ yyreduce:
 	      }
 	      (yyval.number) = (yyvsp[0].number);
 	  }
-#line 2140 "src/mush.tab.c"
-    break;
-
-  case 54:
-#line 480 "src/mush.y"
-               { (yyval.number) = atoi((yyvsp[0].string)); free((yyvsp[0].string)); }
-#line 2146 "src/mush.tab.c"
+#line 3160 "src/mush.tab.c"
     break;
 
-  case 55:
-#line 483 "src/mush.y"
-               { (yyval.string) = (yyvsp[0].string); }
-#line 2152 "src/mush.tab.c"
+  case 90: /* literal_number: NUMBER  */
+#line 1132 "src/mush.y"
+                 { (yyval.number) = atoi((yyvsp[0].string)); free((yyvsp[0].string)); }
+#line 3166 "src/mush.tab.c"
     break;
 
-  case 56:
-#line 484 "src/mush.y"
-             { (yyval.string) = (yyvsp[0].string); }
-#line 2158 "src/mush.tab.c"
+  case 91: /* literal_string: NUMBER  */
+#line 1136 "src/mush.y"
+                 { (yyval.string) = (yyvsp[0].string); }
+#line 3172 "src/mush.tab.c"
     break;
 
-  case 57:
-#line 485 "src/mush.y"
-             { (yyval.string) = (yyvsp[0].string); }
-#line 2164 "src/mush.tab.c"
+  case 92: /* literal_string: NAME  */
+#line 1137 "src/mush.y"
+               { (yyval.string) = (yyvsp[0].string); }
+#line 3178 "src/mush.tab.c"
     break;
 
-  case 58:
-#line 486 "src/mush.y"
+  case 93: /* literal_string: WORD  */
+#line 1138 "src/mush.y"
                { (yyval.string) = (yyvsp[0].string); }
-#line 2170 "src/mush.tab.c"
+#line 3184 "src/mush.tab.c"
     break;
 
-  case 59:
-#line 489 "src/mush.y"
-             { (yyval.string) = (yyvsp[0].string); }
-#line 2176 "src/mush.tab.c"
+  case 94: /* literal_string: STRING  */
+#line 1139 "src/mush.y"
+                 { (yyval.string) = (yyvsp[0].string); }
+#line 3190 "src/mush.tab.c"
     break;
 
-  case 60:
-#line 490 "src/mush.y"
+  case 95: /* file: NAME  */
+#line 1143 "src/mush.y"
                { (yyval.string) = (yyvsp[0].string); }
-#line 2182 "src/mush.tab.c"
+#line 3196 "src/mush.tab.c"
     break;
 
+  case 96: /* file: STRING  */
+#line 1144 "src/mush.y"
+                 { (yyval.string) = (yyvsp[0].string); }
+#line 3202 "src/mush.tab.c"
+    break;
 
-#line 2186 "src/mush.tab.c"
+
+#line 3206 "src/mush.tab.c"
 
       default: break;
     }
@@ -2197,11 +3217,10 @@ yyreduce:
      case of YYERROR or YYBACKUP, subsequent parser actions might lead
      to an incorrect destructor call or verbose syntax error message
      before the lookahead is translated.  */
-  YY_SYMBOL_PRINT ("-> $$ =", yyr1[yyn], &yyval, &yyloc);
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
 
   YYPOPSTACK (yylen);
   yylen = 0;
-  YY_STACK_PRINT (yyss, yyssp);
 
   *++yyvsp = yyval;
 
@@ -2225,50 +3244,44 @@ yyreduce:
 yyerrlab:
   /* Make sure we have latest lookahead translation.  See comments at
      user semantic actions for why this is necessary.  */
-  yytoken = yychar == YYEMPTY ? YYEMPTY : YYTRANSLATE (yychar);
-
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
   /* If not already recovering from an error, report this error.  */
   if (!yyerrstatus)
     {
       ++yynerrs;
-#if ! YYERROR_VERBOSE
-      yyerror (YY_("syntax error"));
-#else
-# define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
-                                        yyssp, yytoken)
       {
+        yypcontext_t yyctx
+          = {yyssp, yytoken};
         char const *yymsgp = YY_("syntax error");
         int yysyntax_error_status;
-        yysyntax_error_status = YYSYNTAX_ERROR;
+        yysyntax_error_status = yysyntax_error (&yymsg_alloc, &yymsg, &yyctx);
         if (yysyntax_error_status == 0)
           yymsgp = yymsg;
-        else if (yysyntax_error_status == 1)
+        else if (yysyntax_error_status == -1)
           {
             if (yymsg != yymsgbuf)
               YYSTACK_FREE (yymsg);
-            yymsg = YY_CAST (char *, YYSTACK_ALLOC (YY_CAST (YYSIZE_T, yymsg_alloc)));
-            if (!yymsg)
+            yymsg = YY_CAST (char *,
+                             YYSTACK_ALLOC (YY_CAST (YYSIZE_T, yymsg_alloc)));
+            if (yymsg)
               {
-                yymsg = yymsgbuf;
-                yymsg_alloc = sizeof yymsgbuf;
-                yysyntax_error_status = 2;
+                yysyntax_error_status
+                  = yysyntax_error (&yymsg_alloc, &yymsg, &yyctx);
+                yymsgp = yymsg;
               }
             else
               {
-                yysyntax_error_status = YYSYNTAX_ERROR;
-                yymsgp = yymsg;
+                yymsg = yymsgbuf;
+                yymsg_alloc = sizeof yymsgbuf;
+                yysyntax_error_status = YYENOMEM;
               }
           }
         yyerror (yymsgp);
-        if (yysyntax_error_status == 2)
-          goto yyexhaustedlab;
+        if (yysyntax_error_status == YYENOMEM)
+          YYNOMEM;
       }
-# undef YYSYNTAX_ERROR
-#endif
     }
 
-
-
   if (yyerrstatus == 3)
     {
       /* If just tried and failed to reuse lookahead token after an
@@ -2301,6 +3314,7 @@ yyerrorlab:
      label yyerrorlab therefore never appears in user code.  */
   if (0)
     YYERROR;
+  ++yynerrs;
 
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYERROR.  */
@@ -2317,13 +3331,14 @@ yyerrorlab:
 yyerrlab1:
   yyerrstatus = 3;      /* Each real token shifted decrements this.  */
 
+  /* Pop stack until we find a state that shifts the error token.  */
   for (;;)
     {
       yyn = yypact[yystate];
       if (!yypact_value_is_default (yyn))
         {
-          yyn += YYTERROR;
-          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYTERROR)
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
             {
               yyn = yytable[yyn];
               if (0 < yyn)
@@ -2337,7 +3352,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -2349,7 +3364,7 @@ yyerrlab1:
 
 
   /* Shift the error token.  */
-  YY_SYMBOL_PRINT ("Shifting", yystos[yyn], yyvsp, yylsp);
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
 
   yystate = yyn;
   goto yynewstate;
@@ -2360,7 +3375,7 @@ yyerrlab1:
 `-------------------------------------*/
 yyacceptlab:
   yyresult = 0;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
 /*-----------------------------------.
@@ -2368,24 +3383,22 @@ yyacceptlab:
 `-----------------------------------*/
 yyabortlab:
   yyresult = 1;
-  goto yyreturn;
+  goto yyreturnlab;
 
 
-#if !defined yyoverflow || YYERROR_VERBOSE
-/*-------------------------------------------------.
-| yyexhaustedlab -- memory exhaustion comes here.  |
-`-------------------------------------------------*/
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
 yyexhaustedlab:
   yyerror (YY_("memory exhausted"));
   yyresult = 2;
-  /* Fall through.  */
-#endif
+  goto yyreturnlab;
 
 
-/*-----------------------------------------------------.
-| yyreturn -- parsing is finished, return the result.  |
-`-----------------------------------------------------*/
-yyreturn:
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
   if (yychar != YYEMPTY)
     {
       /* Make sure we have latest lookahead translation.  See comments at
@@ -2401,18 +3414,17 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[+*yyssp], yyvsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
   if (yyss != yyssa)
     YYSTACK_FREE (yyss);
 #endif
-#if YYERROR_VERBOSE
   if (yymsg != yymsgbuf)
     YYSTACK_FREE (yymsg);
-#endif
   return yyresult;
 }
-#line 492 "src/mush.y"
+
+#line 1147 "src/mush.y"
 
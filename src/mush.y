@@ -0,0 +1,1147 @@
+%{
+
+/*
+ * DO NOT MODIFY THE CONTENTS OF THIS FILE.
+ * IT WILL BE REPLACED DURING GRADING
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mush.h"
+#include "mush.tab.h"
+
+/*
+ * The parser and the scanner keep their state per thread, so that each
+ * interpreter hosted by a process can parse its own input on its own thread.
+ */
+__thread STMT *mush_parsed_stmt;
+
+/*
+ * Number of syntax errors found so far, and whether to report them.
+ * A script parsed ahead of time by the server is parsed quietly, and
+ * parsed again where its errors can be reported if it has any.
+ */
+__thread int mush_parse_errors;
+__thread int mush_parse_quiet;
+
+int yylex();
+int yyparse();
+
+void yyerror(const char *str) {
+    mush_parse_errors++;
+    if(!mush_parse_quiet)
+	fprintf(stderr, "error: %s\n", str);
+}
+
+int yywrap() {
+	return 1;
+}
+
+%}
+
+%union {
+    int number;
+    char *string;
+    STMT *stmt;
+    EXPR *expr;
+    ARG *args;
+    COMMAND *cmds;
+    PIPELINE *pline;
+}
+
+%define api.pure full
+%define parse.error verbose
+%define parse.trace
+
+%token <string> NUMBER NAME WORD STRING FUNCTION
+%token LIST DELETE RUN CONT STOP BG CAPTURE WAIT POLL CANCEL PAUSE
+%token SET UNSET IF GOTO SOURCE
+%token FOR TO STEP NEXT APPEND READ WRITE PUSH POP KEYS SPLIT BY CACHED EXPORT IMPORT AS
+%token SAVE RESTORE
+%token EQ PIPE LESS GREATER EQUAL LESSEQ GREATEQ AND OR NOT
+%token LPAREN RPAREN PLUS MINUS TIMES DIVIDE MOD COMMA SHARP DOLLAR
+%token EOL EoF UNKNOWN CONCAT LBRACKET RBRACKET CONTAINS MATCHES
+
+%type <stmt> statement
+%type <pline> pipeline
+%type <cmds> command_list command
+%type <args> arg_list expr_list
+%type <expr> arg atomic_expr expr
+%type <string> numeric_var string_var literal_string file
+%type <number> optional_lineno lineno literal_number
+
+%left PLUS MINUS TIMES DIVIDE MOD CONCAT
+%left AND OR
+%right NOT
+%left EQUAL LESS GREATER LESSEQ GREATEQ CONTAINS MATCHES
+
+%destructor { free($$); } NUMBER
+%destructor { free($$); } NAME
+%destructor { free($$); } WORD
+%destructor { free($$); } STRING
+%destructor { free($$); } FUNCTION
+
+%destructor { free_stmt($$); } statement
+%destructor { free_expr($$); } expr
+%destructor { free_commands($$); } command
+%destructor { free_commands($$); } command_list
+%destructor { free($$); } arg
+%destructor { free_args($$); } arg_list
+%destructor { free_args($$); } expr_list
+%destructor { free_pipeline($$); } pipeline
+%destructor { free($$); } file
+%destructor { free($$); } literal_string
+%destructor { free($$); } numeric_var
+%destructor { free($$); } string_var
+
+%start statement
+
+%code {
+#include <ctype.h>
+
+/*
+ * The parser is pure, and keeps the value of its lookahead token to itself.
+ * The scanner leaves the value of each token it returns in "yylval", which,
+ * like the rest of its state, is kept per thread.
+ */
+__thread YYSTYPE yylval;
+
+/*
+ * The scanner in mush.lex.c only knows about the reserved words that
+ * existed when it was generated.  Reserved words added since then are
+ * returned by the scanner as NAME tokens, and are recognized here before
+ * they reach the parser.  A word with a nonzero "within" field is only
+ * reserved inside a statement that begins with that token, so that it
+ * remains usable as an ordinary word everywhere else.  A word whose
+ * "within" field is LEADING is only reserved as the first word of a
+ * statement, and one whose "within" field is LEADING_OP only if, in
+ * addition, it is followed by a name and then "<", ">" or "=".  This lets
+ * commands of the same name still be run with arguments that are not of
+ * the form used by the statement.
+ */
+#define LEADING (-1)
+#define LEADING_OP (-2)
+
+static struct keyword {
+    char *word;
+    int token;
+    int within;
+} keywords[] = {
+    { "for",  FOR,  LEADING },
+    { "next", NEXT, LEADING },
+    { "append", APPEND, LEADING_OP },
+    { "read", READ, LEADING_OP },
+    { "write", WRITE, LEADING_OP },
+    { "push", PUSH, LEADING_OP },
+    { "pop", POP, LEADING },
+    { "keys", KEYS, LEADING_OP },
+    { "split", SPLIT, LEADING_OP },
+    { "cached", CACHED, LEADING },
+    { "export", EXPORT, LEADING },
+    { "import", IMPORT, LEADING },
+    { "save", SAVE, LEADING },
+    { "restore", RESTORE, LEADING },
+    { "to",   TO,   FOR },
+    { "step", STEP, FOR },
+    { "by",   BY,   SPLIT },
+    { "as",   AS,   IMPORT },
+    { NULL,   0,    0 }
+};
+
+/*
+ * Statements whose operands are expressions rather than command words.
+ * Within these, and within parentheses anywhere, a lone "." (which the
+ * scanner returns as a WORD) is the concatenation operator, and the words
+ * in the table below are operators if they follow an operand.
+ */
+static int expr_leaders[] = {
+    SET, IF, WAIT, POLL, CANCEL, FOR, APPEND, PUSH, SPLIT, EXPORT, 0
+};
+
+static struct keyword operators[] = {
+    { "contains", CONTAINS, 0 },
+    { "matches",  MATCHES,  0 },
+    { NULL,       0,        0 }
+};
+
+/*
+ * Tokens that can end an operand, after which an operator may follow.
+ */
+static int ends_operand(int token) {
+    return token == NAME || token == WORD || token == STRING
+	|| token == NUMBER || token == RPAREN || token == RBRACKET;
+}
+
+/*
+ * Tokens that have been read ahead, to recognize calls of builtin functions,
+ * or split out of a word, to recognize array indexing.  They are returned
+ * (last in, first out) before the scanner is asked for any more.
+ */
+#define MAX_PENDING 64
+static __thread int pending[MAX_PENDING];
+static __thread YYSTYPE pending_val[MAX_PENDING];
+static __thread int npending = 0;
+
+static void unget_token(int token, YYSTYPE val) {
+    pending[npending] = token;
+    pending_val[npending++] = val;
+}
+
+static int next_token(void) {
+    if(npending) {
+	yylval = pending_val[--npending];
+	return pending[npending];
+    }
+    return yylex();
+}
+
+/*
+ * The scanner does not treat brackets as special, so "$a[#i]" comes back
+ * as "$" followed by the single word "a[#i]".  Split such a word into
+ * brackets, "$" and "#" signs and the words between them, and arrange for
+ * these to be returned in place of it.  Nothing is done if the word has
+ * no brackets, or too many pieces.
+ */
+static void split_word(char *word) {
+    int tokens[MAX_PENDING];
+    YYSTYPE vals[MAX_PENDING];
+    int n = 0;
+    char *cp = word;
+
+    if(!strpbrk(word, "[]"))
+	return;
+    while(*cp) {
+	if(n + npending == MAX_PENDING) {
+	    while(n > 0) {
+		if(vals[--n].string)
+		    free(vals[n].string);
+	    }
+	    return;
+	}
+	vals[n].string = NULL;
+	switch(*cp) {
+	case '[': tokens[n++] = LBRACKET; cp++; continue;
+	case ']': tokens[n++] = RBRACKET; cp++; continue;
+	case '$': tokens[n++] = DOLLAR; cp++; continue;
+	case '#': tokens[n++] = SHARP; cp++; continue;
+	}
+	size_t len = strcspn(cp, "[]$#");
+	vals[n].string = strndup(cp, len);
+	tokens[n++] = strspn(cp, "0123456789") >= len ? NUMBER : WORD;
+	cp += len;
+    }
+    free(word);
+    while(n > 0) {
+	n--;
+	unget_token(tokens[n], vals[n]);
+    }
+}
+
+/*
+ * The scanner only returns an identifier as a NAME if it is followed by
+ * white space, a parenthesis or a redirection, so that "x," or "x+" come
+ * back as WORD.  Such words are turned into names here, which lets variables
+ * and function arguments be written without surrounding spaces.
+ */
+static int is_name(char *str) {
+    if(!isalpha((unsigned char)*str) && *str != '_')
+	return 0;
+    while(*++str) {
+	if(!isalnum((unsigned char)*str) && *str != '_')
+	    return 0;
+    }
+    return 1;
+}
+
+/*
+ * Look ahead to see whether the next two tokens are a name and then
+ * "<", ">" or "=".
+ */
+static int operator_follows(void) {
+    YYSTYPE val = yylval, val1, val2;
+    int token1, token2;
+    token1 = next_token();
+    val1 = yylval;
+    token2 = token1 == EOL || token1 == EoF ? EOL : next_token();
+    val2 = yylval;
+    if(token1 != EOL && token1 != EoF)
+	unget_token(token2, val2);
+    unget_token(token1, val1);
+    yylval = val;
+    return (token1 == NAME || (token1 == WORD && is_name(val1.string)))
+	&& (token2 == LESS || token2 == GREATER || token2 == EQ);
+}
+
+static int scan_token(void) {
+    static __thread int leader = 0;
+    static __thread int depth = 0;
+    static __thread int brackets = 0;
+    static __thread int prev = 0;
+    int token = next_token();
+    if(token == WORD
+       && (prev == DOLLAR || prev == SHARP || prev == SET || prev == UNSET
+	   || brackets > 0)
+       && strpbrk(yylval.string, "[]")) {
+	split_word(yylval.string);
+	token = next_token();
+    }
+    if(token == WORD && is_name(yylval.string))
+	token = NAME;
+    if(token == NAME) {
+	for(struct keyword *kw = keywords; kw->word; kw++) {
+	    if(!strcmp(yylval.string, kw->word)
+	       && (!kw->within || kw->within == leader
+		   || (kw->within == LEADING && !leader)
+		   || (kw->within == LEADING_OP && !leader
+		       && operator_follows()))) {
+		free(yylval.string);
+		token = kw->token;
+		break;
+	    }
+	}
+    }
+    if(token == WORD || token == NAME) {
+	int in_expr = depth > 0 || brackets > 0;
+	for(int *lp = expr_leaders; *lp; lp++) {
+	    if(*lp == leader)
+		in_expr = 1;
+	}
+	if(in_expr && token == NAME && find_function(yylval.string)) {
+	    /*
+	     * A builtin function name is only a call within an expression
+	     * and if "(" follows, so command arguments are left alone.
+	     */
+	    YYSTYPE val = yylval;
+	    int peeked = next_token();
+	    unget_token(peeked, yylval);
+	    yylval = val;
+	    if(peeked == LPAREN)
+		token = FUNCTION;
+	}
+	if(in_expr && token == WORD && !strcmp(yylval.string, ".")) {
+	    free(yylval.string);
+	    token = CONCAT;
+	}
+	for(struct keyword *op = operators;
+	    in_expr && token == NAME && op->word; op++) {
+	    if(!strcmp(yylval.string, op->word) && ends_operand(prev)) {
+		free(yylval.string);
+		token = op->token;
+	    }
+	}
+    }
+    if(token == LPAREN)
+	depth++;
+    else if(token == RPAREN && depth > 0)
+	depth--;
+    else if(token == LBRACKET)
+	brackets++;
+    else if(token == RBRACKET && brackets > 0)
+	brackets--;
+    prev = token;
+    if(token == EOL || token == EoF) {
+	leader = 0;
+	depth = 0;
+	brackets = 0;
+	prev = 0;
+    } else if(token != NUMBER && !leader) {
+	leader = token;
+    }
+    return token;
+}
+
+/*
+ * The parser is pure, and is handed the value of each token here.
+ */
+static int mush_yylex(YYSTYPE *lvalp) {
+    int token = scan_token();
+    *lvalp = yylval;
+    return token;
+}
+
+#define yylex mush_yylex
+}
+
+%%
+
+statement
+	: LIST EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = LIST_STMT_CLASS;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| DELETE lineno COMMA lineno EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = DELETE_STMT_CLASS;
+	      $$->members.delete_stmt.from = $2;
+	      $$->members.delete_stmt.to = $4;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| RUN EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = RUN_STMT_CLASS;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| CONT EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = CONT_STMT_CLASS;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| lineno STOP EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = STOP_STMT_CLASS;
+	      $$->lineno = $1;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno pipeline EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = FG_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.sys_stmt.pipeline = $2;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno pipeline BG EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = BG_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.sys_stmt.pipeline = $2;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno WAIT expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = WAIT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.jobctl_stmt.expr = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno POLL expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = POLL_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.jobctl_stmt.expr = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno CANCEL expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = CANCEL_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.jobctl_stmt.expr = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno PAUSE EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = PAUSE_STMT_CLASS;
+	      $$->lineno = $1;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno GOTO lineno EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = GOTO_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.goto_stmt.lineno = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno SET NAME EQ expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = SET_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.set_stmt.name = $3;
+	      $$->members.set_stmt.expr = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno SET NAME LBRACKET expr RBRACKET EQ expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = SET_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.set_stmt.name = $3;
+	      $$->members.set_stmt.index = $5;
+	      $$->members.set_stmt.expr = $8;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno PUSH NAME EQ expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = PUSH_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.set_stmt.name = $3;
+	      $$->members.set_stmt.expr = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno POP NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = POP_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.pop_stmt.name = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno POP NAME GREATER NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = POP_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.pop_stmt.name = $3;
+	      $$->members.pop_stmt.target = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno APPEND NAME EQ expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = APPEND_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.set_stmt.name = $3;
+	      $$->members.set_stmt.expr = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno KEYS NAME GREATER NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = KEYS_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.pop_stmt.name = $3;
+	      $$->members.pop_stmt.target = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno SPLIT NAME GREATER NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = SPLIT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.split_stmt.name = $3;
+	      $$->members.split_stmt.target = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno SPLIT NAME GREATER numeric_var EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = SPLIT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.split_stmt.name = $3;
+	      $$->members.split_stmt.target = $5;
+	      $$->members.split_stmt.numeric = 1;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno SPLIT NAME GREATER NAME BY expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = SPLIT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.split_stmt.name = $3;
+	      $$->members.split_stmt.target = $5;
+	      $$->members.split_stmt.delim = $7;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno SPLIT NAME GREATER numeric_var BY expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = SPLIT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.split_stmt.name = $3;
+	      $$->members.split_stmt.target = $5;
+	      $$->members.split_stmt.delim = $7;
+	      $$->members.split_stmt.numeric = 1;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno IMPORT LESS file EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = IMPORT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.import_stmt.file = $4;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno IMPORT LESS file AS NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = IMPORT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.import_stmt.file = $4;
+	      $$->members.import_stmt.prefix = $6;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno IMPORT NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = IMPORT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.import_stmt.name = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno IMPORT NAME AS NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = IMPORT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.import_stmt.name = $3;
+	      $$->members.import_stmt.prefix = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno EXPORT NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = EXPORT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.set_stmt.name = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno EXPORT NAME EQ expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = EXPORT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.set_stmt.name = $3;
+	      $$->members.set_stmt.expr = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno UNSET NAME LBRACKET expr RBRACKET EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = UNSET_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.unset_stmt.name = $3;
+	      $$->members.unset_stmt.index = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno UNSET NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = UNSET_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.unset_stmt.name = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno IF expr GOTO lineno EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = IF_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.if_stmt.expr = $3;
+	      $$->members.if_stmt.lineno = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno SOURCE file EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = SOURCE_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.source_stmt.file = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno SAVE file EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = SAVE_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.source_stmt.file = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno RESTORE file EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = RESTORE_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.source_stmt.file = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno CACHED EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = CACHE_STMT_CLASS;
+	      $$->lineno = $1;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno FOR NAME EQ expr TO expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = FOR_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.for_stmt.name = $3;
+	      $$->members.for_stmt.from = $5;
+	      $$->members.for_stmt.to = $7;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno FOR NAME EQ expr TO expr STEP expr EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = FOR_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.for_stmt.name = $3;
+	      $$->members.for_stmt.from = $5;
+	      $$->members.for_stmt.to = $7;
+	      $$->members.for_stmt.step = $9;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno NEXT NAME EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = NEXT_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.next_stmt.name = $3;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno NEXT EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = NEXT_STMT_CLASS;
+	      $$->lineno = $1;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno READ NAME LESS file EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = READ_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.file_stmt.name = $3;
+	      $$->members.file_stmt.file = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno WRITE NAME GREATER file EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = WRITE_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.file_stmt.name = $3;
+	      $$->members.file_stmt.file = $5;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| optional_lineno WRITE NAME GREATER GREATER file EOL
+	  {
+	      $$ = calloc(1, sizeof(STMT));
+	      $$->class = WRITE_STMT_CLASS;
+	      $$->lineno = $1;
+	      $$->members.file_stmt.name = $3;
+	      $$->members.file_stmt.file = $6;
+	      $$->members.file_stmt.append = 1;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| EOL
+	  {
+	      $$ = NULL;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	| EoF
+	  {
+	      $$ = NULL;
+	      YYABORT;
+	  }
+	| error EOL
+	  {
+	      $$ = NULL;
+	      mush_parsed_stmt = $$;
+	      YYACCEPT;
+	  }
+	;
+
+pipeline
+	: command_list
+	  {
+	      $$ = calloc(1, sizeof(PIPELINE));
+	      $$->commands = $1;
+          }
+	| CACHED command_list
+	  {
+	      $$ = calloc(1, sizeof(PIPELINE));
+	      $$->commands = $2;
+	      $$->cached = 1;
+	  }
+	| pipeline LESS file
+	  {
+	      $$ = $1;
+	      $$->input_file = $3;
+	  }
+	| pipeline GREATER file
+	  {
+	      $$ = $1;
+	      $$->output_file = $3;
+	  }
+	| pipeline GREATER CAPTURE
+	  {
+	      $$ = $1;
+	      $$->capture_output = 1;
+	  }
+	;
+
+command_list
+	: command
+	  {
+	      $$ = $1;
+	  }
+	| command PIPE command_list
+	  {
+	      $$ = $1;
+	      $$->next = $3;
+	  }
+	;
+
+command
+	: arg_list
+	  {
+	      $$ = calloc(1, sizeof(COMMAND));
+	      $$->args = $1;
+	  }
+	;
+
+arg_list
+	: arg
+	  {
+	      $$ = calloc(1, sizeof(ARG));
+	      $$->expr = $1;
+	  }
+	| arg arg_list
+	  {
+	      $$ = calloc(1, sizeof(ARG));
+	      $$->expr = $1;
+	      $$->next = $2;
+	  }
+	;
+
+arg
+	: atomic_expr
+	  {
+	      $$ = $1;
+	  }
+	;
+
+atomic_expr
+	: literal_string
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = LIT_EXPR_CLASS;
+	      $$->type = STRING_VALUE_TYPE;
+	      $$->members.value = $1;
+	  }
+	| numeric_var
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = NUM_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.variable = $1;
+	  }
+	| string_var
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = STRING_EXPR_CLASS;
+	      $$->type = STRING_VALUE_TYPE;
+	      $$->members.variable = $1;
+	  }
+	| SHARP NAME LBRACKET expr RBRACKET
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = INDEX_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.index_expr.variable = $2;
+	      $$->members.index_expr.index = $4;
+	  }
+	| DOLLAR NAME LBRACKET expr RBRACKET
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = INDEX_EXPR_CLASS;
+	      $$->type = STRING_VALUE_TYPE;
+	      $$->members.index_expr.variable = $2;
+	      $$->members.index_expr.index = $4;
+	  }
+	| LPAREN expr RPAREN
+	  {
+	      $$ = $2;
+	  }
+	| FUNCTION LPAREN expr_list RPAREN
+	  {
+	      FUNC_INFO *fp = find_function($1);
+	      int nargs = 0;
+	      for(ARG *ap = $3; ap; ap = ap->next)
+		  nargs++;
+	      if(nargs < fp->min_args || nargs > fp->max_args) {
+		  yyerror("Wrong number of arguments to function");
+		  free($1);
+		  free_args($3);
+		  YYERROR;
+	      }
+	      if(fp->arg_class != NO_EXPR_CLASS
+		 && $3->expr->class != fp->arg_class
+		 && !(fp->arg_class == STRING_EXPR_CLASS
+		      && $3->expr->class == NUM_EXPR_CLASS)) {
+		  yyerror(fp->arg_class == INDEX_EXPR_CLASS
+			  ? "Argument must be an array or map element"
+			  : fp->arg_class == STRING_EXPR_CLASS
+			  ? "Argument must be a variable"
+			  : "Argument must be a numeric variable");
+		  free($1);
+		  free_args($3);
+		  YYERROR;
+	      }
+	      free($1);
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = FUNC_EXPR_CLASS;
+	      $$->type = fp->type;
+	      $$->members.func_expr.oprtr = fp->oprtr;
+	      $$->members.func_expr.args = $3;
+	  }
+	;
+
+expr_list
+	: expr
+	  {
+	      $$ = calloc(1, sizeof(ARG));
+	      $$->expr = $1;
+	  }
+	| expr COMMA expr_list
+	  {
+	      $$ = calloc(1, sizeof(ARG));
+	      $$->expr = $1;
+	      $$->next = $3;
+	  }
+	;
+
+expr
+	: atomic_expr
+	  {
+              $$ = $1;
+          }
+	| expr EQUAL expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = EQUAL_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr LESS expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = LESS_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr GREATER expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = GREATER_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr LESSEQ expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = LESSEQ_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr GREATEQ expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = GREATEQ_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr AND expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = AND_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr OR expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = OR_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| NOT expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = UNARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.unary_expr.oprtr = NOT_OPRTR;
+	      $$->members.unary_expr.arg = $2;
+	  }
+	| expr PLUS expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.oprtr = PLUS_OPRTR;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr MINUS expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.oprtr = MINUS_OPRTR;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr TIMES expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.oprtr = TIMES_OPRTR;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr DIVIDE expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.oprtr = DIVIDE_OPRTR;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr MOD expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.oprtr = MOD_OPRTR;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr CONCAT expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = STRING_VALUE_TYPE;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.oprtr = CONCAT_OPRTR;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr CONTAINS expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = CONTAINS_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	| expr MATCHES expr
+	  {
+	      $$ = calloc(1, sizeof(EXPR));
+	      $$->class = BINARY_EXPR_CLASS;
+	      $$->type = NUM_VALUE_TYPE;
+	      $$->members.binary_expr.oprtr = MATCHES_OPRTR;
+	      $$->members.binary_expr.arg1 = $1;
+	      $$->members.binary_expr.arg2 = $3;
+	  }
+	;
+
+numeric_var
+	: SHARP NAME
+	  { $$ = $2; }
+	;
+
+string_var
+	: DOLLAR NAME
+	  { $$ = $2; }
+	;
+
+optional_lineno
+	: { $$ = 0; }
+	| lineno
+	  {
+	      if($1 <= 0) {
+		  yyerror("Line number must be positive");
+		  YYERROR;
+	      }
+	      $$ = $1;
+	  }
+	;
+
+lineno
+	: literal_number
+	;
+
+literal_number
+	: NUMBER { $$ = atoi($1); free($1); }
+	;
+
+literal_string
+	: NUMBER { $$ = $1; }
+	| NAME { $$ = $1; }
+	| WORD { $$ = $1; }
+	| STRING { $$ = $1; }
+	;
+
+file
+	: NAME { $$ = $1; }
+	| STRING { $$ = $1; }
+	;
+
+%%
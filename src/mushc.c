@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "mush.h"
+
+/*
+ * Where the headers and library that compiled programs are built with
+ * were put when mushc itself was built.  The environment variables
+ * MUSHC_INCLUDE and MUSHC_LIBRARY, and CC for the compiler, override them.
+ */
+#ifndef MUSH_INCLUDE
+#define MUSH_INCLUDE "include"
+#endif
+#ifndef MUSH_LIBRARY
+#define MUSH_LIBRARY "lib/libmush.a"
+#endif
+
+static char *setting(char *var, char *def) {
+    char *val = getenv(var);
+    return val && *val ? val : def;
+}
+
+/*
+ * The name of the program for a script: the name of the script without
+ * its directory and without ".mush" at the end.
+ */
+static char *program_name(char *script) {
+    char *base = strrchr(script, '/');
+    char *name = strdup(base ? base + 1 : script);
+    size_t len = strlen(name);
+    if(len > 5 && !strcmp(name + len - 5, ".mush"))
+        name[len - 5] = '\0';
+    else if(len <= 5 && !strcmp(name, ".mush"))
+        strcpy(name, "a.out");
+    return name;
+}
+
+/*
+ * Usage:
+ *   mushc [-o program] file    compile a script into a native program
+ *   mushc -c [-o file.c] file  only translate it into C
+ */
+int main(int argc, char *argv[]) {
+    char *output = NULL;
+    int only_c = 0;
+    int opt;
+    while((opt = getopt(argc, argv, "co:")) != -1) {
+        switch(opt) {
+        case 'c':
+            only_c = 1;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-c] [-o output] file\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if(optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-c] [-o output] file\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    char *script = argv[optind];
+
+    if(only_c) {
+        FILE *out = output ? fopen(output, "w") : stdout;
+        if(out == NULL) {
+            perror(output);
+            exit(EXIT_FAILURE);
+        }
+        int ret = compile_script(script, out);
+        if(out != stdout && fclose(out) == EOF)
+            ret = -1;
+        exit(ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    char cfile[] = "/tmp/mushcXXXXXX.c";
+    int fd = mkstemps(cfile, 2);
+    FILE *out = fd >= 0 ? fdopen(fd, "w") : NULL;
+    if(out == NULL) {
+        perror("mushc");
+        exit(EXIT_FAILURE);
+    }
+    int ret = compile_script(script, out);
+    if(fclose(out) == EOF)
+        ret = -1;
+    if(ret < 0) {
+        unlink(cfile);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Compile the C with the system compiler, and link it with libmush. */
+    char *cc = setting("CC", "cc");
+    char *inc = setting("MUSHC_INCLUDE", MUSH_INCLUDE);
+    char *lib = setting("MUSHC_LIBRARY", MUSH_LIBRARY);
+    char *prog = output ? output : program_name(script);
+    pid_t pid = fork();
+    if(pid == 0) {
+        execlp(cc, cc, "-O2", "-I", inc, cfile, lib, "-pthread", "-o", prog,
+               (char *) NULL);
+        perror(cc);
+        _exit(127);
+    }
+    int status = -1;
+    while(pid > 0 && waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    unlink(cfile);
+    if(pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "mushc: %s: Cannot build %s\n", script, prog);
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
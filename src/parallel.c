@@ -0,0 +1,329 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "mush.h"
+#include "debug.h"
+
+/*
+ * This is the "parallel" module for Mush.
+ * It runs one script once for each row of a table of inputs, such as once
+ * per host or per shard, in a number of worker processes at the same time.
+ *
+ * The script is parsed once, before the workers are forked, and the
+ * statements that have line numbers are put into the program store then,
+ * so every worker runs the same program, which it shares with the others
+ * as part of its copy of the parent's memory.  The statements without line
+ * numbers (typically just "run") are executed for each row.  Each row gets
+ * a data store and jobs table of its own, holding only the variables named
+ * by the header of the table, set from the fields of the row, and ROW, set
+ * to the number of the row.
+ *
+ * The table of inputs is text with fields separated by tabs.  Its first
+ * line names the variables, and each line after that is a row.  Workers
+ * take the next row that nobody has taken yet from a counter that they
+ * share, so a slow row does not hold up the rows behind it.  Each worker
+ * writes its results to a file of its own, and when all the workers are
+ * done the results are reported, in the order of the rows, as a table in
+ * the same form: ROW, STATUS and the selected variables, with any tabs,
+ * newlines or backslashes in their values written as \t, \n and \\.
+ */
+
+/*
+ * Read the whole of a file, or of the standard input if the name is "-".
+ */
+static char *read_file(char *file, size_t *lenp) {
+    int fd = strcmp(file, "-") ? open(file, O_RDONLY) : STDIN_FILENO;
+    size_t len = 0, size = 4096;
+    char *buf = (char *) malloc(size + 1);
+    ssize_t n;
+
+    if(fd < 0 || buf == NULL)
+    {
+        free(buf);
+        return NULL;
+    }
+    while((n = read(fd, buf + len, size - len)) != 0)
+    {
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            free(buf);
+            buf = NULL;
+            break;
+        }
+        if((len += n) == size)
+        {
+            char *nbuf = (char *) realloc(buf, (size *= 2) + 1);
+            if(nbuf == NULL)
+            {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = nbuf;
+        }
+    }
+    if(fd != STDIN_FILENO)
+        close(fd);
+    if(buf != NULL)
+        buf[len] = '\0';
+    *lenp = len;
+    return buf;
+}
+
+/*
+ * Split text into lines in place, dropping carriage returns at their ends
+ * and a final empty line.  The number of lines is returned, or -1 if
+ * there is not enough memory.
+ */
+static long split_lines(char *text, size_t len, char ***linesp) {
+    long n = 0, size = 64;
+    char **lines = (char **) malloc(size * sizeof(char *));
+    char *cp = text, *end = text + len;
+
+    while(lines != NULL && cp < end)
+    {
+        char *nl = memchr(cp, '\n', end - cp);
+        char *eol = nl ? nl : end;
+        *eol = '\0';
+        if(eol > cp && eol[-1] == '\r')
+            eol[-1] = '\0';
+        if(n == size)
+        {
+            char **nlines = (char **) realloc(lines, (size *= 2) * sizeof(char *));
+            if(nlines == NULL)
+                free(lines);
+            if((lines = nlines) == NULL)
+                break;
+        }
+        lines[n++] = cp;
+        cp = eol + 1;
+    }
+    *linesp = lines;
+    return lines ? n : -1;
+}
+
+/*
+ * Write a value to a report, with tabs, newlines and backslashes escaped.
+ */
+static void put_value(FILE *f, char *val) {
+    for(; val && *val; val++)
+    {
+        if(*val == '\t')
+            fputs("\\t", f);
+        else if(*val == '\n')
+            fputs("\\n", f);
+        else if(*val == '\\')
+            fputs("\\\\", f);
+        else
+            fputc(*val, f);
+    }
+}
+
+/*
+ * Run the script for one row, in a worker, and write a line with the
+ * number of the row and its results to the worker's file.
+ */
+static void run_row(long row, char **names, long ncols, char *line,
+                    STMT **stmts, long nstmts, char **vars, long nvars,
+                    FILE *out) {
+    jobs_init();
+    for(long i = 0; i < ncols && line != NULL; i++)
+    {
+        char *field = strsep(&line, "\t");
+        if(*names[i] != '\0')
+            store_set_string(names[i], field);
+    }
+    store_set_int(ROW_VAR, row + 1);
+    for(long i = 0; i < nstmts; i++)
+    {
+        if(!stmts[i]->lineno)
+            exec_immediate(stmts[i]);
+    }
+    fflush(stdout);
+    fflush(stderr);
+    char *status = store_get_string(STATUS_VAR);
+    fprintf(out, "%ld\t%s", row, status ? status : "0");
+    for(long i = 0; i < nvars; i++)
+    {
+        fputc('\t', out);
+        put_value(out, store_get_string(vars[i]));
+    }
+    fputc('\n', out);
+    jobs_fini();
+    exec_fini();
+    store_fini();
+}
+
+/**
+ * @brief  Run a script once for each row of a table of inputs.
+ * @details  This function runs a script for each row of a table, in a
+ * number of worker processes, and prints a report of the results of all
+ * the rows to the standard output once they are all done.
+ *
+ * @param  script  The name of the file holding the script.
+ * @param  table  The name of the file holding the table of inputs, or "-"
+ * for the standard input.
+ * @param  nworkers  The number of workers to run at the same time, or 0
+ * for one per processor.
+ * @param  report  The names of the variables to report for each row,
+ * separated by commas or spaces, or NULL.
+ * @return  0 if the script was run for every row and left STATUS set to
+ * zero, 1 if it was run for every row but not always successfully, and -1
+ * if it could not be run for every row.
+ */
+int parallel_run(char *script, char *table, int nworkers, char *report) {
+    size_t script_len, table_len;
+    char *text = read_file(script, &script_len);
+    char *data = text ? read_file(table, &table_len) : NULL;
+
+    if(data == NULL)
+    {
+        fprintf(stderr, "mush: %s: %s\n", text ? table : script,
+                strerror(errno));
+        free(text);
+        return -1;
+    }
+
+    /* Parse and link the program once, for all the workers. */
+    long nstmts;
+    STMT **stmts = exec_parse(text, script_len, 0, &nstmts);
+    if(stmts == NULL)
+    {
+        fprintf(stderr, "mush: %s: Cannot run this script in parallel\n",
+                script);
+        return -1;
+    }
+    for(long i = 0; i < nstmts; i++)
+    {
+        if(stmts[i]->lineno)
+            prog_insert(stmts[i]);
+    }
+
+    char **lines, **names;
+    long nlines = split_lines(data, table_len, &lines), ncols = 1;
+    if(nlines < 1)
+    {
+        fprintf(stderr, "mush: %s: No header line\n", table);
+        return -1;
+    }
+    for(char *cp = lines[0]; *cp; cp++)
+        ncols += *cp == '\t';
+    names = (char **) malloc(ncols * sizeof(char *));
+    for(long i = 0; i < ncols; i++)
+        names[i] = strsep(&lines[0], "\t");
+    long nrows = nlines - 1;
+
+    char *copy = report ? strdup(report) : NULL, *save, **vars = NULL;
+    long nvars = 0;
+    for(char *var = copy ? strtok_r(copy, ", ", &save) : NULL; var;
+        var = strtok_r(NULL, ", ", &save))
+    {
+        vars = (char **) realloc(vars, (nvars + 1) * sizeof(char *));
+        vars[nvars++] = var;
+    }
+
+    if(nworkers <= 0)
+        nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+    if(nworkers > nrows)
+        nworkers = nrows;
+    debug("%ld rows, %d workers", nrows, nworkers);
+
+    /* The number of the next row to be taken by a worker. */
+    long *next = mmap(NULL, sizeof(long), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    FILE **outs = (FILE **) calloc(nworkers ? nworkers : 1, sizeof(FILE *));
+    pid_t *pids = (pid_t *) calloc(nworkers ? nworkers : 1, sizeof(pid_t));
+    if(next == MAP_FAILED || outs == NULL || pids == NULL)
+    {
+        perror("mush");
+        return -1;
+    }
+    *next = 0;
+    fflush(stdout);
+    fflush(stderr);
+    for(int w = 0; w < nworkers; w++)
+    {
+        if((outs[w] = tmpfile()) == NULL || (pids[w] = fork()) < 0)
+        {
+            perror("mush");
+            nworkers = w;
+            break;
+        }
+        if(pids[w] == 0)
+        {
+            long row;
+            while((row = __atomic_fetch_add(next, 1, __ATOMIC_RELAXED)) < nrows)
+                run_row(row, names, ncols, lines[row + 1], stmts, nstmts,
+                        vars, nvars, outs[w]);
+            fflush(outs[w]);
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    /* Collect the results of the workers, and report them in order. */
+    char **results = (char **) calloc(nrows ? nrows : 1, sizeof(char *));
+    char *line = NULL;
+    size_t size = 0;
+    int ret = 0;
+    for(int w = 0; w < nworkers; w++)
+    {
+        while(waitpid(pids[w], NULL, 0) < 0 && errno == EINTR)
+            ;
+        rewind(outs[w]);
+        while(getline(&line, &size, outs[w]) > 0)
+        {
+            char *rest;
+            long row = strtol(line, &rest, 10);
+            if(row >= 0 && row < nrows && *rest == '\t' && !results[row])
+                results[row] = strdup(rest + 1);
+        }
+        fclose(outs[w]);
+    }
+    printf("%s\t%s", ROW_VAR, STATUS_VAR);
+    for(long i = 0; i < nvars; i++)
+        printf("\t%s", vars[i]);
+    printf("\n");
+    for(long row = 0; row < nrows; row++)
+    {
+        if(results[row] == NULL)
+        {
+            /* The worker that took the row did not finish it. */
+            printf("%ld\t-\n", row + 1);
+            ret = -1;
+            continue;
+        }
+        printf("%ld\t%s", row + 1, results[row]);
+        if(ret == 0 && strtol(results[row], NULL, 10) != 0)
+            ret = 1;
+        free(results[row]);
+    }
+    fflush(stdout);
+
+    free(line);
+    free(results);
+    free(pids);
+    free(outs);
+    munmap(next, sizeof(long));
+    free(vars);
+    free(copy);
+    free(names);
+    free(lines);
+    for(long i = 0; i < nstmts; i++)
+    {
+        if(!stmts[i]->lineno)
+            free_stmt(stmts[i]);
+    }
+    free(stmts);
+    prog_fini();
+    free(data);
+    free(text);
+    return ret;
+}
@@ -23,7 +23,47 @@ typedef struct prog_store{
     PROG_LINE *counter;
 }PROG_STORE;
 
-PROG_STORE *pstorage = NULL;
+/*
+ * Each thread that hosts an interpreter has a program store of its own.
+ */
+__thread PROG_STORE *pstorage = NULL;
+
+/*
+ * Count of modifications made to the program store.  Positions obtained
+ * from prog_tell() are only valid as long as this count does not change.
+ */
+__thread int pepoch = 0;
+
+/*
+ * Initialize the program store, which is empty and has not been run.
+ */
+static void prog_init(void) {
+    pstorage = (PROG_STORE *) malloc(sizeof(PROG_STORE));
+    /* Set dummy head and dummy tail, and counter to the dummy head. */
+    PROG_LINE *dummy_head = (PROG_LINE *) malloc(sizeof(PROG_LINE));
+    pstorage->head = dummy_head;
+    pstorage->counter = NULL;
+
+    /* Link head to head. */
+    pstorage->head->prev = dummy_head;
+    pstorage->head->next = dummy_head;
+    pstorage->head->content = NULL;
+}
+
+/*
+ * Free all the statements in the program store, keeping the dummy head.
+ */
+static void prog_clear(void) {
+    while(pstorage->head->next != pstorage->head)
+    {
+        PROG_LINE *remove_line = pstorage->head->next;
+        pstorage->head->next = remove_line->next;
+        free_stmt(remove_line->content);
+        free(remove_line);
+    }
+    pstorage->head->prev = pstorage->head;
+    pstorage->counter = NULL;
+}
 
 /**
  * @brief  Output a listing of the current contents of the program store.
@@ -89,23 +129,15 @@ int prog_list(FILE *out) {
 int prog_insert(STMT *stmt) {
 
     /* Initialize program store. */
-    if(pstorage == NULL){
-        pstorage = (PROG_STORE *) malloc(sizeof(PROG_STORE));
-        /* Set dummy head and dummy tail, and counter to the dummy head. */
-        PROG_LINE *dummy_head = (PROG_LINE *) malloc(sizeof(PROG_LINE));
-        pstorage->head = dummy_head;
-        pstorage->counter = NULL;
-
-        /* Link head to head. */
-        pstorage->head->prev = dummy_head;
-        pstorage->head->next = dummy_head;
-        pstorage->head->content = NULL;
-    }
+    if(pstorage == NULL)
+        prog_init();
 
     /* If statement has no line number, return -1*/
     if(stmt->lineno <=0)
         return -1;
 
+    pepoch++;
+
     /* Iterate Program Store. */
     PROG_LINE *current_line = pstorage->head->next;
     while(current_line != pstorage->head)
@@ -166,6 +198,8 @@ int prog_delete(int min, int max) {
     if(pstorage == NULL)
         return 0;
 
+    pepoch++;
+
     /* Iterate Program Store. */
     PROG_LINE *remove_line = NULL;
     PROG_LINE *current_line = pstorage->head->next;
@@ -293,3 +327,171 @@ STMT *prog_goto(int lineno) {
 
     return NULL;
 }
+
+/**
+ * @brief  Get the current modification count of the program store.
+ * @details  This function returns a number that changes every time
+ * a statement is inserted into or deleted from the program store.
+ * A caller that has saved a position with prog_tell() can compare the
+ * values returned before and after to find out whether the position
+ * may still be used.
+ *
+ * @return  The current modification count.
+ */
+int prog_epoch(void) {
+    return pepoch;
+}
+
+/**
+ * @brief  Save the current position of the program counter.
+ * @details  This function returns an opaque handle for the current
+ * position of the program counter, which can later be passed to
+ * prog_seek() to return to that position without searching for
+ * a line number.  The handle should not be used after any subsequent
+ * insertion into or deletion from the program store, which can be
+ * detected by a change in the value returned by prog_epoch().
+ *
+ * @return  A handle for the current program counter position, or NULL
+ * if the program store is empty.
+ */
+PROG_POS prog_tell(void) {
+    /* The Program Store is empty. */
+    if(pstorage == NULL)
+        return NULL;
+    return pstorage->counter;
+}
+
+/**
+ * @brief  Return the program counter to a saved position.
+ * @details  This function sets the program counter to a position that
+ * was previously obtained from prog_tell().  The statement just after
+ * the new position is returned.
+ *
+ * @param pos  The position to return to.
+ * @return  The first program statement after the new program counter
+ * position, if any, otherwise NULL.
+ */
+STMT *prog_seek(PROG_POS pos) {
+    if(pstorage == NULL || pos == NULL)
+        return NULL;
+    pstorage->counter = pos;
+    return pstorage->counter->content;
+}
+
+/**
+ * @brief  Write the program store to a snapshot.
+ * @details  This function writes the number of statements, each of the
+ * statements in order, and then the position of the program counter as
+ * the index of the statement just after it: the number of statements if
+ * it is at the end of the program, or -1 if the program has not been run.
+ *
+ * @param f  The stream to which the snapshot is being written.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int prog_save(FILE *f) {
+    long count = 0, counter = -1;
+    PROG_LINE *current_line;
+
+    if(pstorage != NULL)
+    {
+        for(current_line = pstorage->head->next; current_line != pstorage->head;
+            current_line = current_line->next)
+            count++;
+    }
+    snap_put_num(f, count);
+    if(pstorage == NULL)
+    {
+        snap_put_num(f, counter);
+        return ferror(f) ? -1 : 0;
+    }
+    long index = 0;
+    for(current_line = pstorage->head->next; current_line != pstorage->head;
+        current_line = current_line->next)
+    {
+        if(current_line == pstorage->counter)
+            counter = index;
+        save_stmt(f, current_line->content);
+        index++;
+    }
+    if(pstorage->counter == pstorage->head)
+        counter = count;
+    snap_put_num(f, counter);
+    return ferror(f) ? -1 : 0;
+}
+
+/**
+ * @brief  Replace the program store with one read from a snapshot.
+ * @details  This function reads what prog_save() wrote.  The statements
+ * are all read before anything is changed, so that if the snapshot turns
+ * out to be damaged the program store is left as it was.  Otherwise the
+ * old statements are freed, and the program counter is set to the saved
+ * position.  This counts as a modification of the program store.
+ *
+ * @param snap  The snapshot being read.
+ * @return  0 if successful, -1 if the snapshot was damaged.
+ */
+int prog_restore(SNAP *snap) {
+    long count = snap_get_num(snap);
+    if(count < 0 || count > snap->end - snap->pos)
+        return -1;
+
+    STMT **stmts = (STMT **) malloc((count ? count : 1) * sizeof(STMT *));
+    if(stmts == NULL)
+        return -1;
+    long n;
+    for(n = 0; n < count && !snap->error; n++)
+    {
+        if((stmts[n] = load_stmt(snap)) == NULL)
+            break;
+    }
+    long counter = snap_get_num(snap);
+    if(snap->error || n < count || counter < -1 || counter > count)
+    {
+        while(n > 0)
+            free_stmt(stmts[--n]);
+        free(stmts);
+        return -1;
+    }
+
+    if(pstorage == NULL)
+        prog_init();
+    prog_clear();
+
+    for(long i = 0; i < count; i++)
+    {
+        PROG_LINE *new_line = (PROG_LINE *) malloc(sizeof(PROG_LINE));
+        new_line->content = stmts[i];
+        new_line->next = pstorage->head;
+        new_line->prev = pstorage->head->prev;
+        pstorage->head->prev->next = new_line;
+        pstorage->head->prev = new_line;
+    }
+    free(stmts);
+    pepoch++;
+
+    pstorage->counter = NULL;
+    if(counter >= 0)
+    {
+        PROG_LINE *current_line = pstorage->head->next;
+        for(long i = 0; i < counter; i++)
+            current_line = current_line->next;
+        pstorage->counter = current_line;
+    }
+    return 0;
+}
+
+/**
+ * @brief  Finalize the program store.
+ * @details  This function frees all the statements in the program store
+ * of the calling thread, and the store itself.  The store is created
+ * again, empty, if it is used afterwards.
+ */
+void prog_fini(void) {
+    if(pstorage == NULL)
+        return;
+    prog_clear();
+    free(pstorage->head);
+    free(pstorage);
+    pstorage = NULL;
+    pepoch++;
+}
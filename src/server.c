@@ -0,0 +1,453 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "mush.h"
+#include "debug.h"
+
+/*
+ * This is the "server" module for Mush.
+ * It lets a long-lived Mush process run scripts on behalf of clients that
+ * connect to it over a Unix-domain socket, so that running a short script
+ * does not cost starting up and initializing an interpreter each time.
+ *
+ * A client sends a request made of a header, followed by the text of the
+ * script and then the environment in which it is to run, as a sequence of
+ * null-terminated strings.  Along with the header it passes, as ancillary
+ * data, its current directory and its standard input, output and error.
+ * The server forks a child for each request, which takes these on as its
+ * own and runs the script in a fresh interpreter, so that scripts cannot
+ * see each other's programs, variables or jobs, and their output goes
+ * straight to where the output of the client would have gone.  When the
+ * script is done, the child sends back its exit status as four bytes and
+ * exits.  The client exits with that status, or 1 if the connection is
+ * closed without one.
+ *
+ * Scripts are parsed by the server itself, before forking, and the parsed
+ * statements are kept in a cache keyed by the text of the script, so that
+ * a script that is run again is not parsed again: the child gets its own
+ * copy of the statements as part of its copy of the server's memory.  A
+ * script with syntax errors, or that uses "source", is instead parsed by
+ * the child as it runs, so that errors are reported to the client and
+ * sourced files are read at the right time.
+ */
+
+#define SERVER_BACKLOG 64
+#define SERVER_FDS 4            /* Current directory, stdin, stdout, stderr */
+#define CACHE_SCRIPTS 64        /* Maximum number of scripts cached */
+
+extern __thread FILE *yyin;
+extern char **environ;
+
+typedef struct request_header{
+    uint64_t script_len;
+    uint64_t env_len;
+}REQUEST_HEADER;
+
+/*
+ * A parsed script in the cache.  A script that must be parsed as it runs
+ * is cached with "stmts" NULL, so that it is not parsed ahead again.
+ */
+typedef struct script_entry{
+    struct script_entry *next;
+    unsigned long hash;
+    char *text;
+    size_t len;
+    STMT **stmts;
+    long nstmts;
+}SCRIPT_ENTRY;
+
+static SCRIPT_ENTRY *scripts;   /* Most recently added first */
+static long nscripts;
+static long script_hits, script_misses;
+
+static unsigned long hash_text(char *str, size_t len) {
+    unsigned long hash = 14695981039346656037UL;
+    for(size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char) str[i];
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+static void free_script(SCRIPT_ENTRY *entry) {
+    for(long i = 0; i < entry->nstmts; i++)
+        free_stmt(entry->stmts[i]);
+    free(entry->stmts);
+    free(entry->text);
+    free(entry);
+}
+
+/*
+ * Find a script in the cache, parsing it and adding it if it is not there.
+ * When the cache is full, the script added longest ago is dropped.
+ */
+static SCRIPT_ENTRY *lookup_script(char *text, size_t len) {
+    unsigned long hash = hash_text(text, len);
+    SCRIPT_ENTRY *entry, **pp;
+
+    for(entry = scripts; entry != NULL; entry = entry->next)
+    {
+        if(entry->hash == hash && entry->len == len
+           && memcmp(entry->text, text, len) == 0)
+        {
+            script_hits++;
+            return entry;
+        }
+    }
+    script_misses++;
+    if((entry = (SCRIPT_ENTRY *) calloc(1, sizeof(SCRIPT_ENTRY))) == NULL)
+        return NULL;
+    if((entry->text = (char *) malloc(len ? len : 1)) == NULL)
+    {
+        free(entry);
+        return NULL;
+    }
+    memcpy(entry->text, text, len);
+    entry->len = len;
+    entry->hash = hash;
+    entry->stmts = exec_parse(text, len, 1, &entry->nstmts);
+    if(nscripts == CACHE_SCRIPTS)
+    {
+        for(pp = &scripts; (*pp)->next != NULL; pp = &(*pp)->next)
+            ;
+        free_script(*pp);
+        *pp = NULL;
+        nscripts--;
+    }
+    entry->next = scripts;
+    scripts = entry;
+    nscripts++;
+    return entry;
+}
+
+/*
+ * Read exactly "len" bytes, returning -1 if the connection is closed
+ * first or an error occurs.
+ */
+static int read_full(int fd, char *buf, size_t len) {
+    while(len > 0)
+    {
+        ssize_t n = read(fd, buf, len);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return -1;
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int write_full(int fd, char *buf, size_t len) {
+    while(len > 0)
+    {
+        ssize_t n = write(fd, buf, len);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return -1;
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*
+ * Receive the header of a request together with the descriptors passed
+ * with it, returning the number of descriptors received, or -1.
+ */
+static int recv_header(int conn, REQUEST_HEADER *hdr, int *fds) {
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(SERVER_FDS * sizeof(int))];
+    } control;
+    struct iovec iov = { hdr, sizeof(*hdr) };
+    struct msghdr msg = { 0 };
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n;
+    while((n = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC)) < 0 && errno == EINTR)
+        ;
+    int nfds = 0;
+    for(struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != NULL;
+        cm = CMSG_NXTHDR(&msg, cm))
+    {
+        if(cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS)
+        {
+            nfds = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(cm), nfds * sizeof(int));
+        }
+    }
+    if(n <= 0 || nfds != SERVER_FDS)
+    {
+        for(int i = 0; i < nfds; i++)
+            close(fds[i]);
+        return -1;
+    }
+    /* The rest of the header may come separately. */
+    if((size_t) n < sizeof(*hdr)
+       && read_full(conn, (char *) hdr + n, sizeof(*hdr) - n) < 0)
+    {
+        for(int i = 0; i < nfds; i++)
+            close(fds[i]);
+        return -1;
+    }
+    return nfds;
+}
+
+/*
+ * Split an environment received from a client into a vector in the form
+ * of "environ".
+ */
+static char **make_environ(char *buf, size_t len) {
+    long n = 0;
+    for(size_t i = 0; i < len; i++)
+        n += buf[i] == '\0';
+    char **envp = (char **) malloc((n + 1) * sizeof(char *));
+    if(envp == NULL)
+        return NULL;
+    long k = 0;
+    for(char *p = buf; p < buf + len && k < n; p += strlen(p) + 1)
+        envp[k++] = p;
+    envp[k] = NULL;
+    return envp;
+}
+
+/*
+ * Run a request in the child: take on the client's descriptors, current
+ * directory and environment, and run the script in the fresh interpreter
+ * that this process has as a copy of the server's.
+ */
+static void serve_child(int conn, int *fds, char *text, size_t len,
+                        char **envp, SCRIPT_ENTRY *entry) {
+    signal(SIGCHLD, SIG_DFL);
+    if(fchdir(fds[0]) < 0 || dup2(fds[1], STDIN_FILENO) < 0
+       || dup2(fds[2], STDOUT_FILENO) < 0 || dup2(fds[3], STDERR_FILENO) < 0)
+        _exit(EXIT_FAILURE);
+    for(int i = 0; i < SERVER_FDS; i++)
+        close(fds[i]);
+    if(envp != NULL)
+        environ = envp;
+    jobs_init();
+    if(entry != NULL && entry->stmts != NULL)
+    {
+        /* The statements are this process's own copy of those cached. */
+        exec_script(entry->stmts, entry->nstmts);
+    }
+    else if(len > 0 && (yyin = fmemopen(text, len, "r")) != NULL)
+        exec_interactive();
+    jobs_fini();
+    fflush(stdout);
+    fflush(stderr);
+    int32_t status = EXIT_SUCCESS;
+    write_full(conn, (char *) &status, sizeof(status));
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * Handle one connection: read the request, find the script in the cache
+ * and fork a child to run it.
+ */
+static void serve_request(int listen_fd, int conn) {
+    REQUEST_HEADER hdr;
+    int fds[SERVER_FDS];
+    char *text = NULL, *env = NULL;
+
+    if(recv_header(conn, &hdr, fds) < 0)
+        return;
+    if(hdr.script_len > SIZE_MAX / 2 || hdr.env_len > SIZE_MAX / 2
+       || (text = (char *) malloc(hdr.script_len + 1)) == NULL
+       || (env = (char *) malloc(hdr.env_len + 1)) == NULL
+       || read_full(conn, text, hdr.script_len) < 0
+       || read_full(conn, env, hdr.env_len) < 0)
+        goto out;
+    text[hdr.script_len] = '\0';
+    env[hdr.env_len] = '\0';
+
+    SCRIPT_ENTRY *entry = lookup_script(text, hdr.script_len);
+    debug("script of %lu bytes, %s", (unsigned long) hdr.script_len,
+          entry && entry->stmts ? "parsed" : "not parsed");
+    char **envp = hdr.env_len ? make_environ(env, hdr.env_len) : NULL;
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        close(listen_fd);
+        serve_child(conn, fds, text, hdr.script_len, envp, entry);
+    }
+    free(envp);
+ out:
+    for(int i = 0; i < SERVER_FDS; i++)
+        close(fds[i]);
+    free(text);
+    free(env);
+}
+
+/**
+ * @brief  Run as a server for clients that connect to a Unix-domain socket.
+ * @details  This function creates a socket with the given name, replacing
+ * any file of that name, and then serves requests from clients, each of
+ * which runs one script, until it is killed.  Only the user running the
+ * server may connect to the socket.
+ *
+ * @param  path  The name of the socket.
+ * @return  -1 if the socket could not be created; otherwise the function
+ * does not return.
+ */
+int server_run(char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if(strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "mush: socket name too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+    {
+        perror("mush: socket");
+        return -1;
+    }
+    unlink(path);
+    mode_t mask = umask(0077);
+    int err = bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+    umask(mask);
+    if(err < 0 || listen(fd, SERVER_BACKLOG) < 0)
+    {
+        fprintf(stderr, "mush: %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    /* Children report to their clients; there is nothing to wait for. */
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+    while(1)
+    {
+        int conn = accept(fd, NULL, NULL);
+        if(conn < 0)
+        {
+            if(errno != EINTR && errno != ECONNABORTED)
+                perror("mush: accept");
+            continue;
+        }
+        /* Commands run by the script must not hold the connection open. */
+        fcntl(conn, F_SETFD, FD_CLOEXEC);
+        serve_request(fd, conn);
+        close(conn);
+    }
+}
+
+/**
+ * @brief  Run a script in a server started by server_run().
+ * @details  This function reads a script from a file, or from the standard
+ * input if no file is given, and has it run by the server listening on the
+ * given socket, in the current directory and environment, with the same
+ * standard input, output and error as this process.  It waits until the
+ * script is done.
+ *
+ * @param  path  The name of the server's socket.
+ * @param  file  The name of the file holding the script, or NULL.
+ * @return  The exit status with which the script finished, or 1 if the
+ * script could not be run.
+ */
+int client_run(char *path, char *file) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    size_t len = 0, size = 4096;
+    char *text = (char *) malloc(size);
+    int in = file ? open(file, O_RDONLY) : STDIN_FILENO;
+    ssize_t n;
+
+    if(in < 0 || text == NULL)
+    {
+        fprintf(stderr, "mush: %s: %s\n", file, strerror(errno));
+        return 1;
+    }
+    while((n = read(in, text + len, size - len)) != 0)
+    {
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            perror("mush: read");
+            return 1;
+        }
+        if((len += n) == size && (text = (char *) realloc(text, size *= 2)) == NULL)
+            return 1;
+    }
+    if(file)
+        close(in);
+
+    size_t env_len = 0;
+    for(char **ep = environ; *ep != NULL; ep++)
+        env_len += strlen(*ep) + 1;
+    char *env = (char *) malloc(env_len ? env_len : 1), *sp = env;
+    if(env == NULL)
+        return 1;
+    for(char **ep = environ; *ep != NULL; ep++)
+    {
+        size_t l = strlen(*ep) + 1;
+        memcpy(sp, *ep, l);
+        sp += l;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if(fd < 0 || connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        fprintf(stderr, "mush: %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    int fds[SERVER_FDS] = { open(".", O_RDONLY | O_DIRECTORY),
+                            STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    if(fds[0] < 0)
+    {
+        perror("mush: .");
+        return 1;
+    }
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(fds))];
+    } control;
+    REQUEST_HEADER hdr = { len, env_len };
+    struct iovec iov = { &hdr, sizeof(hdr) };
+    struct msghdr msg = { 0 };
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+    int32_t status;
+    if(sendmsg(fd, &msg, 0) != sizeof(hdr) || write_full(fd, text, len) < 0
+       || write_full(fd, env, env_len) < 0)
+    {
+        perror("mush: send");
+        return 1;
+    }
+    close(fds[0]);
+    free(text);
+    free(env);
+    if(read_full(fd, (char *) &status, sizeof(status)) < 0)
+        return 1;
+    close(fd);
+    return status;
+}
@@ -0,0 +1,677 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mush.h"
+
+/*
+ * This is the "snapshot" module for Mush.
+ * It provides the means to write the state of the interpreter to a file
+ * and to read it back later, possibly in another process, so that a long
+ * computation can be stopped and resumed.  The program store, the data
+ * store and the jobs module each write and read their own part of the
+ * state, using the functions here to encode numbers, strings and syntax
+ * trees.  A snapshot is read back by mapping the file into memory and
+ * decoding it where it lies, so that nothing has to be parsed again.
+ *
+ * A snapshot file begins with a header of HEADER_SIZE bytes:
+ *
+ *   magic      the eight bytes "MUSHSNAP";
+ *   version    four bytes, least significant first: SNAP_VERSION;
+ *   reserved   four bytes of zero;
+ *   length     eight bytes: the length of the data after the header;
+ *   check      eight bytes: an FNV-1a hash of that data.
+ *
+ * In the data, numbers are written in a variable number of bytes, seven
+ * bits to a byte with the high bit set in all but the last, after mapping
+ * negative numbers to odd ones so that small numbers of either sign are
+ * short.  A string is written as its length plus one, followed by its
+ * bytes, so that a NULL string can be written as 0.
+ */
+
+#define SNAP_MAGIC "MUSHSNAP"
+#define SNAP_VERSION 1
+#define HEADER_SIZE 32
+
+static void put_fixed(unsigned char *p, uint64_t v, int n) {
+    for(int i = 0; i < n; i++)
+    {
+        p[i] = v & 0xff;
+        v >>= 8;
+    }
+}
+
+static uint64_t get_fixed(unsigned char *p, int n) {
+    uint64_t v = 0;
+    for(int i = n - 1; i >= 0; i--)
+        v = v << 8 | p[i];
+    return v;
+}
+
+static uint64_t snap_hash(char *data, size_t len) {
+    uint64_t hash = 14695981039346656037UL;
+    for(size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char) data[i];
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+/**
+ * @brief  Write a number to a snapshot.
+ *
+ * @param  f  The stream to which the snapshot is being written.
+ * @param  n  The number to be written.
+ */
+void snap_put_num(FILE *f, long n) {
+    unsigned long v = ((unsigned long) n << 1) ^ (unsigned long) (n >> 63);
+    while(v >= 0x80)
+    {
+        putc((v & 0x7f) | 0x80, f);
+        v >>= 7;
+    }
+    putc(v, f);
+}
+
+/**
+ * @brief  Write a string of a given length to a snapshot.
+ * @details  The string need not be terminated by a null character and may
+ * contain them.  A NULL string is written as one of length zero.
+ *
+ * @param  f  The stream to which the snapshot is being written.
+ * @param  buf  The string to be written.
+ * @param  len  The length of the string.
+ */
+void snap_put_bytes(FILE *f, char *buf, size_t len) {
+    snap_put_num(f, len);
+    if(len > 0)
+        fwrite(buf, 1, len, f);
+}
+
+/**
+ * @brief  Write a null-terminated string, or NULL, to a snapshot.
+ *
+ * @param  f  The stream to which the snapshot is being written.
+ * @param  str  The string to be written, or NULL.
+ */
+void snap_put_str(FILE *f, char *str) {
+    if(str == NULL)
+    {
+        snap_put_num(f, 0);
+        return;
+    }
+    size_t len = strlen(str);
+    snap_put_num(f, len + 1);
+    fwrite(str, 1, len, f);
+}
+
+/**
+ * @brief  Read a number from a snapshot.
+ *
+ * @param  snap  The snapshot being read.
+ * @return  The number read, or 0 if there was none.
+ */
+long snap_get_num(SNAP *snap) {
+    unsigned long v = 0;
+    int shift = 0;
+    while(!snap->error)
+    {
+        if(snap->pos >= snap->end || shift > 63)
+        {
+            snap->error = 1;
+            break;
+        }
+        unsigned char c = *snap->pos++;
+        v |= (unsigned long) (c & 0x7f) << shift;
+        if(!(c & 0x80))
+            return (long) (v >> 1) ^ -(long) (v & 1);
+        shift += 7;
+    }
+    return 0;
+}
+
+/*
+ * Check that a count read from a snapshot is no more than the number of
+ * bytes left, each of the things counted taking at least one byte.
+ */
+static long get_count(SNAP *snap) {
+    long n = snap_get_num(snap);
+    if(n < 0 || n > snap->end - snap->pos)
+    {
+        snap->error = 1;
+        return 0;
+    }
+    return n;
+}
+
+/**
+ * @brief  Read a string written by snap_put_bytes() from a snapshot.
+ * @details  The string is not copied: the pointer returned points into
+ * the snapshot, and the string is not terminated by a null character.
+ *
+ * @param  snap  The snapshot being read.
+ * @param  lenp  Pointer at which the length of the string is to be stored.
+ * @return  The string read, or NULL if there was none.
+ */
+char *snap_get_bytes(SNAP *snap, size_t *lenp) {
+    long len = get_count(snap);
+    char *buf = snap->pos;
+    *lenp = len;
+    if(snap->error)
+        return NULL;
+    snap->pos += len;
+    return buf;
+}
+
+/**
+ * @brief  Read a string written by snap_put_str() from a snapshot.
+ *
+ * @param  snap  The snapshot being read.
+ * @return  A copy of the string, obtained from malloc(), or NULL if the
+ * string written was NULL or there was none.
+ */
+char *snap_get_str(SNAP *snap) {
+    long len = snap_get_num(snap);
+    if(len == 0 || snap->error)
+        return NULL;
+    if(len < 0 || len - 1 > snap->end - snap->pos)
+    {
+        snap->error = 1;
+        return NULL;
+    }
+    char *str = strndup(snap->pos, len - 1);
+    snap->pos += len - 1;
+    return str;
+}
+
+/**
+ * @brief  Begin writing a snapshot.
+ * @details  The snapshot is written to a temporary file beside the one
+ * named, which only replaces it once snap_finish() has completed it, so
+ * that an existing snapshot is never left half overwritten.
+ *
+ * @param  file  The name of the snapshot file.
+ * @return  The stream to which the contents of the snapshot are to be
+ * written, or NULL if the file could not be created.
+ */
+FILE *snap_create(char *file) {
+    char tmp[strlen(file) + 5];
+    sprintf(tmp, "%s.tmp", file);
+    FILE *f = fopen(tmp, "w+");
+    if(f == NULL)
+        return NULL;
+    unsigned char header[HEADER_SIZE] = { 0 };
+    memcpy(header, SNAP_MAGIC, 8);
+    put_fixed(header + 8, SNAP_VERSION, 4);
+    fwrite(header, 1, HEADER_SIZE, f);
+    return f;
+}
+
+/**
+ * @brief  Finish writing a snapshot.
+ * @details  The length and check of the contents are filled in, the file
+ * is flushed to the disk and then renamed to the name of the snapshot.
+ * The stream is closed in any case.
+ *
+ * @param  f  The stream returned by snap_create().
+ * @param  file  The name of the snapshot file.
+ * @return  0 if the snapshot was written successfully, otherwise -1.
+ */
+int snap_finish(FILE *f, char *file) {
+    char tmp[strlen(file) + 5];
+    sprintf(tmp, "%s.tmp", file);
+    int fd = fileno(f);
+    long end = ftell(f);
+    int err = fflush(f) != 0 || ferror(f) || end < HEADER_SIZE;
+    if(!err)
+    {
+        size_t len = end - HEADER_SIZE;
+        unsigned char fields[16];
+        uint64_t check = snap_hash("", 0);
+        if(len > 0)
+        {
+            char *map = mmap(NULL, end, PROT_READ, MAP_SHARED, fd, 0);
+            if(map == MAP_FAILED)
+                err = 1;
+            else
+            {
+                check = snap_hash(map + HEADER_SIZE, len);
+                munmap(map, end);
+            }
+        }
+        put_fixed(fields, len, 8);
+        put_fixed(fields + 8, check, 8);
+        if(!err && (pwrite(fd, fields, 16, 16) != 16 || fsync(fd) < 0))
+            err = 1;
+    }
+    if(fclose(f) != 0)
+        err = 1;
+    if(!err && rename(tmp, file) < 0)
+        err = 1;
+    if(err)
+    {
+        int saved = errno;
+        unlink(tmp);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief  Open a snapshot to be read.
+ * @details  The file is mapped into memory, and its header and check are
+ * verified before anything is read from it, so that a damaged snapshot
+ * is refused before any state is replaced.
+ *
+ * @param  file  The name of the snapshot file.
+ * @param  snap  Set to the contents of the snapshot.
+ * @param  sizep  Pointer at which the size of the mapping is to be stored.
+ * @return  The mapping, to be passed to snap_close() once the snapshot has
+ * been read, or NULL if it could not be opened, in which case errno is
+ * set to 0 if the file is not a snapshot of this version.
+ */
+char *snap_open(char *file, SNAP *snap, size_t *sizep) {
+    struct stat sb;
+    int fd = open(file, O_RDONLY);
+    if(fd < 0)
+        return NULL;
+    if(fstat(fd, &sb) < 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    if(!S_ISREG(sb.st_mode) || sb.st_size < HEADER_SIZE)
+    {
+        close(fd);
+        errno = 0;
+        return NULL;
+    }
+    char *map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        return NULL;
+    unsigned char *header = (unsigned char *) map;
+    size_t len = sb.st_size - HEADER_SIZE;
+    if(memcmp(header, SNAP_MAGIC, 8) != 0
+       || get_fixed(header + 8, 4) != SNAP_VERSION
+       || get_fixed(header + 16, 8) != len
+       || get_fixed(header + 24, 8) != snap_hash(map + HEADER_SIZE, len))
+    {
+        munmap(map, sb.st_size);
+        errno = 0;
+        return NULL;
+    }
+    snap->pos = map + HEADER_SIZE;
+    snap->end = map + sb.st_size;
+    snap->error = 0;
+    *sizep = sb.st_size;
+    return map;
+}
+
+/**
+ * @brief  Close a snapshot opened by snap_open().
+ *
+ * @param  map  The mapping returned by snap_open().
+ * @param  size  The size of the mapping.
+ */
+void snap_close(char *map, size_t size) {
+    munmap(map, size);
+}
+
+/*
+ * Syntax trees are written in prefix order: the class of each node first,
+ * then its fields.  An expression of class NO_EXPR_CLASS stands for NULL.
+ */
+static void save_expr(FILE *f, EXPR *expr);
+
+static void save_args(FILE *f, ARG *args) {
+    long n = 0;
+    for(ARG *ap = args; ap != NULL; ap = ap->next)
+        n++;
+    snap_put_num(f, n);
+    for(ARG *ap = args; ap != NULL; ap = ap->next)
+        save_expr(f, ap->expr);
+}
+
+static void save_expr(FILE *f, EXPR *expr) {
+    if(expr == NULL)
+    {
+        snap_put_num(f, NO_EXPR_CLASS);
+        return;
+    }
+    snap_put_num(f, expr->class);
+    snap_put_num(f, expr->type);
+    switch(expr->class) {
+    case LIT_EXPR_CLASS:
+        snap_put_str(f, expr->members.value);
+        break;
+    case NUM_EXPR_CLASS:
+    case STRING_EXPR_CLASS:
+        snap_put_str(f, expr->members.variable);
+        break;
+    case UNARY_EXPR_CLASS:
+        snap_put_num(f, expr->members.unary_expr.oprtr);
+        save_expr(f, expr->members.unary_expr.arg);
+        break;
+    case BINARY_EXPR_CLASS:
+        snap_put_num(f, expr->members.binary_expr.oprtr);
+        save_expr(f, expr->members.binary_expr.arg1);
+        save_expr(f, expr->members.binary_expr.arg2);
+        break;
+    case FUNC_EXPR_CLASS:
+        snap_put_num(f, expr->members.func_expr.oprtr);
+        save_args(f, expr->members.func_expr.args);
+        break;
+    case INDEX_EXPR_CLASS:
+        snap_put_str(f, expr->members.index_expr.variable);
+        save_expr(f, expr->members.index_expr.index);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief  Write a pipeline to a snapshot.
+ *
+ * @param  f  The stream to which the snapshot is being written.
+ * @param  pline  The pipeline to be written.
+ */
+void save_pipeline(FILE *f, PIPELINE *pline) {
+    long n = 0;
+    for(COMMAND *cmd = pline->commands; cmd != NULL; cmd = cmd->next)
+        n++;
+    snap_put_num(f, n);
+    for(COMMAND *cmd = pline->commands; cmd != NULL; cmd = cmd->next)
+        save_args(f, cmd->args);
+    snap_put_str(f, pline->input_file);
+    snap_put_str(f, pline->output_file);
+    snap_put_num(f, pline->capture_output);
+    snap_put_num(f, pline->cached);
+}
+
+/**
+ * @brief  Write a statement to a snapshot.
+ *
+ * @param  f  The stream to which the snapshot is being written.
+ * @param  stmt  The statement to be written.
+ */
+void save_stmt(FILE *f, STMT *stmt) {
+    snap_put_num(f, stmt->class);
+    snap_put_num(f, stmt->lineno);
+    switch(stmt->class) {
+    case DELETE_STMT_CLASS:
+        snap_put_num(f, stmt->members.delete_stmt.from);
+        snap_put_num(f, stmt->members.delete_stmt.to);
+        break;
+    case FG_STMT_CLASS:
+    case BG_STMT_CLASS:
+        save_pipeline(f, stmt->members.sys_stmt.pipeline);
+        break;
+    case WAIT_STMT_CLASS:
+    case POLL_STMT_CLASS:
+    case CANCEL_STMT_CLASS:
+        save_expr(f, stmt->members.jobctl_stmt.expr);
+        break;
+    case SET_STMT_CLASS:
+    case APPEND_STMT_CLASS:
+    case PUSH_STMT_CLASS:
+    case EXPORT_STMT_CLASS:
+        snap_put_str(f, stmt->members.set_stmt.name);
+        save_expr(f, stmt->members.set_stmt.expr);
+        save_expr(f, stmt->members.set_stmt.index);
+        break;
+    case UNSET_STMT_CLASS:
+        snap_put_str(f, stmt->members.unset_stmt.name);
+        save_expr(f, stmt->members.unset_stmt.index);
+        break;
+    case IF_STMT_CLASS:
+        save_expr(f, stmt->members.if_stmt.expr);
+        snap_put_num(f, stmt->members.if_stmt.lineno);
+        break;
+    case GOTO_STMT_CLASS:
+        snap_put_num(f, stmt->members.goto_stmt.lineno);
+        break;
+    case SOURCE_STMT_CLASS:
+    case SAVE_STMT_CLASS:
+    case RESTORE_STMT_CLASS:
+        snap_put_str(f, stmt->members.source_stmt.file);
+        break;
+    case FOR_STMT_CLASS:
+        snap_put_str(f, stmt->members.for_stmt.name);
+        save_expr(f, stmt->members.for_stmt.from);
+        save_expr(f, stmt->members.for_stmt.to);
+        save_expr(f, stmt->members.for_stmt.step);
+        break;
+    case NEXT_STMT_CLASS:
+        snap_put_str(f, stmt->members.next_stmt.name);
+        break;
+    case READ_STMT_CLASS:
+    case WRITE_STMT_CLASS:
+        snap_put_str(f, stmt->members.file_stmt.name);
+        snap_put_str(f, stmt->members.file_stmt.file);
+        snap_put_num(f, stmt->members.file_stmt.append);
+        break;
+    case POP_STMT_CLASS:
+    case KEYS_STMT_CLASS:
+        snap_put_str(f, stmt->members.pop_stmt.name);
+        snap_put_str(f, stmt->members.pop_stmt.target);
+        break;
+    case SPLIT_STMT_CLASS:
+        snap_put_str(f, stmt->members.split_stmt.name);
+        snap_put_str(f, stmt->members.split_stmt.target);
+        save_expr(f, stmt->members.split_stmt.delim);
+        snap_put_num(f, stmt->members.split_stmt.numeric);
+        break;
+    case IMPORT_STMT_CLASS:
+        snap_put_str(f, stmt->members.import_stmt.name);
+        snap_put_str(f, stmt->members.import_stmt.file);
+        snap_put_str(f, stmt->members.import_stmt.prefix);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * When a syntax tree is read back, a string or expression that must be
+ * present but is missing from a damaged snapshot is replaced by an empty
+ * one, so that the tree can always be freed in the usual way; the error
+ * flag of the snapshot tells the caller to do so.
+ */
+static char *need_str(SNAP *snap, char *str) {
+    if(str != NULL)
+        return str;
+    snap->error = 1;
+    return strdup("");
+}
+
+static EXPR *load_expr(SNAP *snap, int required);
+
+static ARG *load_args(SNAP *snap) {
+    long n = get_count(snap);
+    ARG *args = NULL, **app = &args;
+    for(long i = 0; i < n; i++)
+    {
+        ARG *ap = calloc(1, sizeof(ARG));
+        ap->expr = load_expr(snap, 1);
+        *app = ap;
+        app = &ap->next;
+    }
+    return args;
+}
+
+static EXPR *load_expr(SNAP *snap, int required) {
+    long class = snap_get_num(snap);
+    if(class == NO_EXPR_CLASS && !required)
+        return NULL;
+    EXPR *expr = calloc(1, sizeof(EXPR));
+    expr->class = class;
+    expr->type = snap_get_num(snap);
+    switch(class) {
+    case LIT_EXPR_CLASS:
+        expr->members.value = need_str(snap, snap_get_str(snap));
+        break;
+    case NUM_EXPR_CLASS:
+    case STRING_EXPR_CLASS:
+        expr->members.variable = need_str(snap, snap_get_str(snap));
+        break;
+    case UNARY_EXPR_CLASS:
+        expr->members.unary_expr.oprtr = snap_get_num(snap);
+        expr->members.unary_expr.arg = load_expr(snap, 1);
+        break;
+    case BINARY_EXPR_CLASS:
+        expr->members.binary_expr.oprtr = snap_get_num(snap);
+        expr->members.binary_expr.arg1 = load_expr(snap, 1);
+        expr->members.binary_expr.arg2 = load_expr(snap, 1);
+        break;
+    case FUNC_EXPR_CLASS:
+        expr->members.func_expr.oprtr = snap_get_num(snap);
+        expr->members.func_expr.args = load_args(snap);
+        break;
+    case INDEX_EXPR_CLASS:
+        expr->members.index_expr.variable = need_str(snap, snap_get_str(snap));
+        expr->members.index_expr.index = load_expr(snap, 1);
+        break;
+    default:
+        snap->error = 1;
+        expr->class = LIT_EXPR_CLASS;
+        expr->members.value = strdup("");
+        break;
+    }
+    return expr;
+}
+
+/**
+ * @brief  Read a pipeline written by save_pipeline() from a snapshot.
+ *
+ * @param  snap  The snapshot being read.
+ * @return  The pipeline read.  If the snapshot was damaged, its error flag
+ * is set, and the pipeline returned may be incomplete but can be freed.
+ */
+PIPELINE *load_pipeline(SNAP *snap) {
+    PIPELINE *pline = calloc(1, sizeof(PIPELINE));
+    long n = get_count(snap);
+    COMMAND **cpp = &pline->commands;
+    for(long i = 0; i < n || pline->commands == NULL; i++)
+    {
+        COMMAND *cmd = calloc(1, sizeof(COMMAND));
+        cmd->args = i < n ? load_args(snap) : NULL;
+        if(cmd->args == NULL)
+        {
+            snap->error = 1;
+            cmd->args = calloc(1, sizeof(ARG));
+            cmd->args->expr = load_expr(snap, 1);
+        }
+        *cpp = cmd;
+        cpp = &cmd->next;
+    }
+    pline->input_file = snap_get_str(snap);
+    pline->output_file = snap_get_str(snap);
+    pline->capture_output = snap_get_num(snap);
+    pline->cached = snap_get_num(snap);
+    return pline;
+}
+
+/**
+ * @brief  Read a statement written by save_stmt() from a snapshot.
+ *
+ * @param  snap  The snapshot being read.
+ * @return  The statement read, or NULL if the snapshot was damaged.
+ */
+STMT *load_stmt(SNAP *snap) {
+    STMT *stmt = calloc(1, sizeof(STMT));
+    stmt->class = snap_get_num(snap);
+    stmt->lineno = snap_get_num(snap);
+    switch(stmt->class) {
+    case LIST_STMT_CLASS:
+    case RUN_STMT_CLASS:
+    case CONT_STMT_CLASS:
+    case STOP_STMT_CLASS:
+    case PAUSE_STMT_CLASS:
+    case CACHE_STMT_CLASS:
+        break;
+    case DELETE_STMT_CLASS:
+        stmt->members.delete_stmt.from = snap_get_num(snap);
+        stmt->members.delete_stmt.to = snap_get_num(snap);
+        break;
+    case FG_STMT_CLASS:
+    case BG_STMT_CLASS:
+        stmt->members.sys_stmt.pipeline = load_pipeline(snap);
+        break;
+    case WAIT_STMT_CLASS:
+    case POLL_STMT_CLASS:
+    case CANCEL_STMT_CLASS:
+        stmt->members.jobctl_stmt.expr = load_expr(snap, 1);
+        break;
+    case SET_STMT_CLASS:
+    case APPEND_STMT_CLASS:
+    case PUSH_STMT_CLASS:
+    case EXPORT_STMT_CLASS:
+        stmt->members.set_stmt.name = need_str(snap, snap_get_str(snap));
+        stmt->members.set_stmt.expr =
+            load_expr(snap, stmt->class != EXPORT_STMT_CLASS);
+        stmt->members.set_stmt.index = load_expr(snap, 0);
+        break;
+    case UNSET_STMT_CLASS:
+        stmt->members.unset_stmt.name = need_str(snap, snap_get_str(snap));
+        stmt->members.unset_stmt.index = load_expr(snap, 0);
+        break;
+    case IF_STMT_CLASS:
+        stmt->members.if_stmt.expr = load_expr(snap, 1);
+        stmt->members.if_stmt.lineno = snap_get_num(snap);
+        break;
+    case GOTO_STMT_CLASS:
+        stmt->members.goto_stmt.lineno = snap_get_num(snap);
+        break;
+    case SOURCE_STMT_CLASS:
+    case SAVE_STMT_CLASS:
+    case RESTORE_STMT_CLASS:
+        stmt->members.source_stmt.file = need_str(snap, snap_get_str(snap));
+        break;
+    case FOR_STMT_CLASS:
+        stmt->members.for_stmt.name = need_str(snap, snap_get_str(snap));
+        stmt->members.for_stmt.from = load_expr(snap, 1);
+        stmt->members.for_stmt.to = load_expr(snap, 1);
+        stmt->members.for_stmt.step = load_expr(snap, 0);
+        break;
+    case NEXT_STMT_CLASS:
+        stmt->members.next_stmt.name = snap_get_str(snap);
+        break;
+    case READ_STMT_CLASS:
+    case WRITE_STMT_CLASS:
+        stmt->members.file_stmt.name = need_str(snap, snap_get_str(snap));
+        stmt->members.file_stmt.file = need_str(snap, snap_get_str(snap));
+        stmt->members.file_stmt.append = snap_get_num(snap);
+        break;
+    case POP_STMT_CLASS:
+    case KEYS_STMT_CLASS:
+        stmt->members.pop_stmt.name = need_str(snap, snap_get_str(snap));
+        stmt->members.pop_stmt.target = snap_get_str(snap);
+        break;
+    case SPLIT_STMT_CLASS:
+        stmt->members.split_stmt.name = need_str(snap, snap_get_str(snap));
+        stmt->members.split_stmt.target = need_str(snap, snap_get_str(snap));
+        stmt->members.split_stmt.delim = load_expr(snap, 0);
+        stmt->members.split_stmt.numeric = snap_get_num(snap);
+        break;
+    case IMPORT_STMT_CLASS:
+        stmt->members.import_stmt.name = snap_get_str(snap);
+        stmt->members.import_stmt.file = snap_get_str(snap);
+        stmt->members.import_stmt.prefix = snap_get_str(snap);
+        break;
+    default:
+        snap->error = 1;
+        free(stmt);
+        return NULL;
+    }
+    return stmt;
+}
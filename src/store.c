@@ -1,6 +1,18 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define X86_KERNELS
+#endif
+
+#include "mush.h"
 
 /*
  * This is the "data store" module for Mush.
@@ -12,330 +24,2690 @@
  * a string representation of that integer.  Retrieving the value of
  * a variable as an integer is possible if the current value of the
  * variable is the string representation of an integer.
+ *
+ * A variable may instead hold an array of values, which are stored
+ * contiguously so that any element can be retrieved or replaced in
+ * constant time.  Each element is tagged with the kind of value it holds,
+ * so that integers stored in an array are kept in binary form and need
+ * not be converted to and from strings when they are used as integers.
+ *
+ * A variable may also hold a map from string keys to values of the same
+ * kind, kept in a hash table with open addressing and linear probing.
+ *
+ * Large string values are shared between variables that hold the same
+ * value, so that copying one from variable to another takes constant time
+ * and does not use more memory.
+ *
+ * Large string values that have not been used for a while may also be
+ * kept compressed, and are expanded again the next time they are used.
+ *
+ * Variables may be marked for export, so that their values are placed in
+ * the environment of the commands that are run.
+ */
+
+typedef enum {
+    ELEM_INT,
+    ELEM_STRING
+} ELEM_TAG;
+
+typedef union elem_value{
+    long num;
+    char *str;
+}ELEM_VALUE;
+
+typedef struct var_elem{
+    ELEM_TAG tag;
+    ELEM_VALUE u;
+}VAR_ELEM;
+
+/*
+ * The tags and values of the elements of an array are kept in separate
+ * vectors, so that the values of an array of integers form a plain vector
+ * of longs, which the aggregate functions can process a block at a time.
+ */
+typedef struct var_array{
+    unsigned char *tags;
+    ELEM_VALUE *vals;
+    long len;
+    long size;
+    long nstrings;          /* Number of elements that hold strings */
+}VAR_ARRAY;
+
+typedef struct map_entry{
+    char *key;              /* NULL if the slot has never been used */
+    unsigned long hash;
+    VAR_ELEM value;
+}MAP_ENTRY;
+
+typedef struct var_map{
+    MAP_ENTRY *slots;
+    long size;              /* Number of slots, always a power of two */
+    long count;             /* Number of keys in the map */
+    long used;              /* Number of slots used, including deleted keys */
+}VAR_MAP;
+
+/* Key of a slot whose entry has been deleted. */
+static char deleted_key[] = "";
+
+typedef struct shared_str{
+    struct shared_str *next;    /* Next buffer in the same hash chain */
+    unsigned long hash;
+    long refs;                  /* Number of variables holding the value */
+    size_t len;
+    char *data;
+}SHARED_STR;
+
+typedef struct var_node{
+    struct var_node *prev;
+    struct var_node *next;
+    struct var_node *chain;     /* Next variable in the same hash chain */
+    unsigned long hash;         /* Hash of the name */
+    char *var_name;
+    char *var_value;
+    /*
+     * Length of the value, and size of the buffer that holds it.
+     * The buffer may be larger than the value, so that values can be
+     * appended to and replaced without copying or reallocating each time.
+     */
+    size_t var_len;
+    size_t var_size;
+    /* Array value, or NULL if the variable does not hold an array. */
+    VAR_ARRAY *var_array;
+    /* Map value, or NULL if the variable does not hold a map. */
+    VAR_MAP *var_map;
+    /* Shared buffer holding the value, or NULL if the value is private. */
+    SHARED_STR *var_shared;
+    /*
+     * Compressed value, or NULL if the value is not compressed.  While it
+     * is, "var_value" is NULL and "var_len" is the length of the value.
+     */
+    char *var_packed;
+    size_t var_packed_len;
+    /* Sweep clock when the variable was last used. */
+    long var_used;
+    /* Value of "var_used" when compressing the value last did not pay. */
+    long var_tried;
+    /* Nonzero if the variable is exported to the environment of commands. */
+    int var_exported;
+}VAR_NODE;
+
+/*
+ * The variables are kept in a list, in the order in which they were
+ * created, and are also indexed by a hash table of their names, so that
+ * finding one takes constant time however many variables there are.
+ */
+typedef struct var_store{
+    VAR_NODE *head;
+    VAR_NODE **table;
+    long size;                  /* Number of hash chains, a power of two */
+    long count;                 /* Number of variables */
+}VAR_STORE;
+
+/*
+ * Each thread that hosts an interpreter has a data store of its own, so
+ * this and the other state of the module below is kept per thread.
+ */
+__thread VAR_STORE *vstorage = NULL;
+
+/* Number of statements executed, as counted by store_sweep(). */
+static __thread long store_clock;
+
+/*
+ * Number of times the variables of the store have been discarded, which
+ * is kept across store_fini(), so that references obtained from
+ * store_ref() are never mistaken for valid afterwards.
+ */
+static __thread long store_gen;
+
+/* Nonzero if an exported variable may have changed since store_environ(). */
+static __thread int env_dirty;
+
+static void unpack_value(VAR_NODE *variable);
+static unsigned long hash_bytes(char *str, size_t len);
+
+/*
+ * Double the number of hash chains of the store, returning -1 if there
+ * is not enough memory.
+ */
+static int grow_store(void) {
+    long size = vstorage->size ? 2 * vstorage->size : 64;
+    VAR_NODE **table = (VAR_NODE **) calloc(size, sizeof(VAR_NODE *));
+    if(table == NULL)
+        return -1;
+    for(VAR_NODE *variable = vstorage->head->next; variable != vstorage->head;
+        variable = variable->next)
+    {
+        variable->chain = table[variable->hash & (size - 1)];
+        table[variable->hash & (size - 1)] = variable;
+    }
+    free(vstorage->table);
+    vstorage->table = table;
+    vstorage->size = size;
+    return 0;
+}
+
+/*
+ * Create the empty store, returning -1 if there is not enough memory.
+ */
+static int init_store(void) {
+    vstorage = (VAR_STORE *) calloc(1, sizeof(VAR_STORE));
+    if(vstorage == NULL)
+        return -1;
+    /* Set a dummy head. */
+    VAR_NODE *dummy_head = (VAR_NODE *) malloc(sizeof(VAR_NODE));
+    vstorage->head = dummy_head;
+    if(dummy_head != NULL)
+        dummy_head->next = dummy_head->prev = dummy_head;
+    if(dummy_head == NULL || grow_store() < 0)
+    {
+        free(dummy_head);
+        free(vstorage);
+        vstorage = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Find the node for a variable whose name has a given length and hash,
+ * or return NULL if there is none.  Unlike lookup_variable(), this does
+ * not count as a use of the variable.
+ */
+static VAR_NODE *probe_variable(char *var, size_t len, unsigned long hash) {
+    VAR_NODE *current_variable = vstorage->table[hash & (vstorage->size - 1)];
+    while(current_variable != NULL)
+    {
+        if(current_variable->hash == hash
+           && strncmp(var, current_variable->var_name, len) == 0
+           && current_variable->var_name[len] == '\0')
+            return current_variable;
+        current_variable = current_variable->chain;
+    }
+    return NULL;
+}
+
+/*
+ * Add a node with no value for a variable that is not in the store, at
+ * the end of the list and in its hash chain.  The caller must make sure
+ * that the store has enough hash chains beforehand.
+ */
+static VAR_NODE *add_variable(char *var, size_t len, unsigned long hash) {
+    VAR_NODE *new_variable = (VAR_NODE *) calloc(1, sizeof(VAR_NODE));
+    if(new_variable == NULL)
+        return NULL;
+    new_variable->var_name = strndup(var, len);
+    new_variable->hash = hash;
+    new_variable->var_used = store_clock;
+    new_variable->var_tried = -1;
+
+    VAR_NODE *head = vstorage->head;
+    head->prev->next = new_variable;
+    new_variable->prev = head->prev;
+    new_variable->next = head;
+    head->prev = new_variable;
+    new_variable->chain = vstorage->table[hash & (vstorage->size - 1)];
+    vstorage->table[hash & (vstorage->size - 1)] = new_variable;
+    vstorage->count++;
+    return new_variable;
+}
+
+/*
+ * Find the node for a variable whose name has a given length.  If there is
+ * none and "create" is nonzero, a new node with no value is added to the
+ * store (initializing the store if necessary), otherwise NULL is returned.
+ * The variable counts as used, and a compressed value is expanded again.
+ */
+static VAR_NODE *lookup_variable(char *var, size_t len, int create) {
+    if(vstorage == NULL && (!create || init_store() < 0))
+        return NULL;
+
+    unsigned long hash = hash_bytes(var, len);
+    VAR_NODE *variable = probe_variable(var, len, hash);
+    if(variable != NULL)
+    {
+        /* Looking up a variable to change it invalidates the environment. */
+        if(create && variable->var_exported)
+            env_dirty = 1;
+        variable->var_used = store_clock;
+        if(variable->var_packed != NULL)
+            unpack_value(variable);
+        return variable;
+    }
+    if(!create)
+        return NULL;
+    if(vstorage->count >= vstorage->size && grow_store() < 0)
+        return NULL;
+    return add_variable(var, len, hash);
+}
+
+/*
+ * Find the node for a variable, as for lookup_variable().
+ */
+static VAR_NODE *find_variable(char *var, int create) {
+    return lookup_variable(var, strlen(var), create);
+}
+
+/*
+ * Discard the value of an element of a map, leaving it holding the
+ * integer 0.
+ */
+static void clear_elem(VAR_ELEM *elem) {
+    if(elem->tag == ELEM_STRING)
+        free(elem->u.str);
+    elem->tag = ELEM_INT;
+    elem->u.num = 0;
+}
+
+/*
+ * Get the value of an element of an array or map as a string.  For an
+ * integer element, the string is only valid until the next call.
+ */
+static char *elem_string(int tag, ELEM_VALUE *val) {
+    static __thread char buf[24];
+    if(tag == ELEM_STRING)
+        return val->str;
+    sprintf(buf, "%ld", val->num);
+    return buf;
+}
+
+/*
+ * Get the value of an element as an integer, returning -1 if it cannot
+ * be interpreted as one.
+ */
+static int elem_int(int tag, ELEM_VALUE *val, long *valp) {
+    long result;
+    char *end_ptr;
+
+    if(tag == ELEM_INT)
+    {
+        *valp = val->num;
+        return 0;
+    }
+    if(*val->str == 0)
+        return -1;
+    result = strtol(val->str, &end_ptr, 10);
+    if(*end_ptr != 0)
+        return -1;
+    *valp = result;
+    return 0;
+}
+
+/*
+ * Free an array and the strings held by its elements.
+ */
+static void free_array(VAR_ARRAY *array) {
+    for(long i = 0; array->nstrings > 0 && i < array->len; i++)
+    {
+        if(array->tags[i] == ELEM_STRING)
+        {
+            free(array->vals[i].str);
+            array->nstrings--;
+        }
+    }
+    free(array->tags);
+    free(array->vals);
+    free(array);
+}
+
+/*
+ * Free a map and the keys and strings held by its entries.
+ */
+static void free_map(VAR_MAP *map) {
+    for(long i = 0; i < map->size; i++)
+    {
+        if(map->slots[i].key != NULL && map->slots[i].key != deleted_key)
+        {
+            free(map->slots[i].key);
+            clear_elem(&map->slots[i].value);
+        }
+    }
+    free(map->slots);
+    free(map);
+}
+
+static void drop_packed(VAR_NODE *variable);
+
+/*
+ * Discard the array or map held by a variable, if any, or a compressed
+ * value that could not be expanded.
+ */
+static void free_elements(VAR_NODE *variable) {
+    VAR_ARRAY *array = variable->var_array;
+    VAR_MAP *map = variable->var_map;
+    if(variable->var_packed != NULL)
+        drop_packed(variable);
+    if(array != NULL)
+    {
+        free_array(array);
+        variable->var_array = NULL;
+    }
+    if(map != NULL)
+    {
+        free_map(map);
+        variable->var_map = NULL;
+    }
+}
+
+/*
+ * Large string values are kept in shared buffers, found by a hash of their
+ * contents and counted by reference, so that variables with the same value
+ * (as when a captured output is copied into another variable) share one
+ * copy of it.  A variable whose value is shared has "var_shared" set and
+ * a "var_size" of zero, and it makes a private copy of the value before
+ * changing it in place.
+ */
+#define SHARE_MIN 4096
+
+static __thread SHARED_STR **shared_table;
+static __thread long shared_size;        /* Number of hash chains, a power of two */
+static __thread long shared_count;       /* Number of shared buffers */
+static __thread size_t shared_bytes;     /* Total length of the shared buffers */
+
+/*
+ * FNV-1a hash of a string of a given length.
+ */
+static unsigned long hash_bytes(char *str, size_t len) {
+    unsigned long hash = 14695981039346656037UL;
+    for(size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char) str[i];
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+/*
+ * Drop a variable's reference to its shared buffer, freeing the buffer
+ * if no other variable refers to it.
+ */
+static void release_shared(VAR_NODE *variable) {
+    SHARED_STR *shared = variable->var_shared;
+    variable->var_shared = NULL;
+    variable->var_value = NULL;
+    variable->var_len = 0;
+    variable->var_size = 0;
+    if(--shared->refs > 0)
+        return;
+    SHARED_STR **pp = &shared_table[shared->hash & (shared_size - 1)];
+    while(*pp != shared)
+        pp = &(*pp)->next;
+    *pp = shared->next;
+    shared_count--;
+    shared_bytes -= shared->len;
+    free(shared->data);
+    free(shared);
+}
+
+/*
+ * Find the shared buffer holding a string, or NULL if there is none.
+ */
+static SHARED_STR *find_shared(char *val, size_t len, unsigned long hash) {
+    if(shared_size == 0)
+        return NULL;
+    SHARED_STR *shared = shared_table[hash & (shared_size - 1)];
+    while(shared != NULL && (shared->hash != hash || shared->len != len
+                             || memcmp(shared->data, val, len) != 0))
+        shared = shared->next;
+    return shared;
+}
+
+/*
+ * Make a variable's value the contents of a shared buffer, in place of
+ * whatever value it had.
+ */
+static void attach_shared(VAR_NODE *variable, SHARED_STR *shared) {
+    shared->refs++;
+    if(variable->var_shared != NULL)
+        release_shared(variable);
+    else
+        free(variable->var_value);
+    variable->var_shared = shared;
+    variable->var_value = shared->data;
+    variable->var_len = shared->len;
+    variable->var_size = 0;
+}
+
+/*
+ * Add a shared buffer for a string held in a buffer obtained from malloc(),
+ * which becomes owned by the new shared buffer.
+ */
+static SHARED_STR *add_shared(char *data, size_t len, unsigned long hash) {
+    SHARED_STR *shared = (SHARED_STR *) malloc(sizeof(SHARED_STR));
+    if(shared == NULL)
+        return NULL;
+    if(shared_count >= shared_size)
+    {
+        /* Keep the chains short by doubling the number of them. */
+        long size = shared_size ? 2 * shared_size : 64;
+        SHARED_STR **table = (SHARED_STR **) calloc(size, sizeof(SHARED_STR *));
+        if(table == NULL)
+        {
+            free(shared);
+            return NULL;
+        }
+        for(long i = 0; i < shared_size; i++)
+        {
+            while(shared_table[i] != NULL)
+            {
+                SHARED_STR *sp = shared_table[i];
+                shared_table[i] = sp->next;
+                sp->next = table[sp->hash & (size - 1)];
+                table[sp->hash & (size - 1)] = sp;
+            }
+        }
+        free(shared_table);
+        shared_table = table;
+        shared_size = size;
+    }
+    shared->hash = hash;
+    shared->refs = 0;
+    shared->len = len;
+    shared->data = data;
+    shared->next = shared_table[hash & (shared_size - 1)];
+    shared_table[hash & (shared_size - 1)] = shared;
+    shared_count++;
+    shared_bytes += len;
+    return shared;
+}
+
+/*
+ * Set a variable to a large string value, sharing the buffer of any other
+ * variable that has the same value.
+ */
+static int share_value(VAR_NODE *variable, char *val, size_t len) {
+    unsigned long hash = hash_bytes(val, len);
+    SHARED_STR *shared = find_shared(val, len, hash);
+    if(shared == NULL)
+    {
+        char *data = (char *) malloc(len + 1);
+        if(data == NULL)
+            return -1;
+        memcpy(data, val, len);
+        data[len] = '\0';
+        if((shared = add_shared(data, len, hash)) == NULL)
+        {
+            free(data);
+            return -1;
+        }
+    }
+    if(shared != variable->var_shared)
+        attach_shared(variable, shared);
+    return 0;
+}
+
+/*
+ * Discard any value of a variable, leaving it un-set.
+ */
+static void clear_value(VAR_NODE *variable) {
+    free_elements(variable);
+    if(variable->var_shared != NULL)
+        release_shared(variable);
+    free(variable->var_value);
+    variable->var_value = NULL;
+    variable->var_len = 0;
+    variable->var_size = 0;
+}
+
+/*
+ * Replace the value of a variable with a copy of a string of a given length.
+ * Large values are shared; otherwise the existing buffer is reused if it
+ * is private and large enough.  The string may be (part of) the old value.
+ */
+static int set_value(VAR_NODE *variable, char *val, size_t len) {
+    free_elements(variable);
+    if(len >= SHARE_MIN)
+        return share_value(variable, val, len);
+    if(variable->var_value == NULL || variable->var_size < len + 1)
+    {
+        char *buf = (char *) malloc(len + 1);
+        if(buf == NULL)
+            return -1;
+        memcpy(buf, val, len);
+        if(variable->var_shared != NULL)
+            release_shared(variable);
+        free(variable->var_value);
+        variable->var_value = buf;
+        variable->var_size = len + 1;
+    }
+    else
+        memmove(variable->var_value, val, len);
+    variable->var_value[len] = '\0';
+    variable->var_len = len;
+    return 0;
+}
+
+/*
+ * Make a string held in a buffer obtained from malloc(), with room for a
+ * null character after it, the value of a variable that has no value.
+ * If the same large value is already held by some variable, the buffer is
+ * freed and the value shared.
+ */
+static void adopt_value(VAR_NODE *variable, char *buf, size_t len) {
+    buf[len] = '\0';
+    if(len >= SHARE_MIN)
+    {
+        unsigned long hash = hash_bytes(buf, len);
+        SHARED_STR *shared = find_shared(buf, len, hash);
+        if(shared != NULL)
+            free(buf);
+        else
+            shared = add_shared(buf, len, hash);
+        if(shared != NULL)
+        {
+            attach_shared(variable, shared);
+            return;
+        }
+    }
+    variable->var_value = buf;
+    variable->var_len = len;
+    variable->var_size = len + 1;
+}
+
+/*
+ * Large values that have not been used for COMPRESS_AGE statements are
+ * compressed by store_sweep(), if they are at least COMPRESS_MIN bytes
+ * long, no other variable shares them and they are not exported.  The
+ * sweep only looks at the
+ * variables once every SWEEP_INTERVAL statements, so that it costs little
+ * when there is nothing to do.  A value that does not shrink by at least
+ * an eighth is left alone, and not tried again until it has been used.
+ */
+#define SWEEP_INTERVAL 64
+#define COMPRESS_DEFAULT_AGE 1000
+
+static __thread long packed_count;       /* Number of values now compressed */
+static __thread size_t packed_bytes;     /* Total length of the compressed data */
+static __thread long compress_count;     /* Number of values ever compressed */
+static __thread size_t compress_in;      /* Total length of those values */
+static __thread size_t compress_out;     /* Total length of their compressed data */
+static __thread double compress_time;    /* Seconds spent compressing */
+static __thread long expand_count;       /* Number of values expanded again */
+static __thread double expand_time;      /* Seconds spent expanding */
+
+static double store_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Replace the value of a variable by its compressed form, if that is
+ * enough smaller to be worth it.
+ */
+static void pack_value(VAR_NODE *variable) {
+    double start = store_now();
+    size_t len = variable->var_len;
+    char *buf = (char *) malloc(lz_bound(len));
+    if(buf == NULL)
+        return;
+    size_t n = lz_compress(variable->var_value, len, buf);
+    if(n == 0 || n > len - len / 8)
+    {
+        free(buf);
+        variable->var_tried = variable->var_used;
+        return;
+    }
+    char *packed = (char *) realloc(buf, n);
+    if(packed == NULL)
+        packed = buf;
+    if(variable->var_shared != NULL)
+        release_shared(variable);
+    free(variable->var_value);
+    variable->var_value = NULL;
+    variable->var_size = 0;
+    variable->var_len = len;
+    variable->var_packed = packed;
+    variable->var_packed_len = n;
+    packed_count++;
+    packed_bytes += n;
+    compress_count++;
+    compress_in += len;
+    compress_out += n;
+    compress_time += store_now() - start;
+}
+
+/*
+ * Expand the compressed value of a variable into a buffer obtained from
+ * malloc(), returning NULL if this cannot be done.
+ */
+static char *expand_value(VAR_NODE *variable) {
+    char *buf = (char *) malloc(variable->var_len + 1);
+    if(buf == NULL)
+        return NULL;
+    if(lz_decompress(variable->var_packed, variable->var_packed_len,
+                     buf, variable->var_len) < 0)
+    {
+        free(buf);
+        return NULL;
+    }
+    buf[variable->var_len] = '\0';
+    return buf;
+}
+
+/*
+ * Discard the compressed value of a variable, leaving it un-set.
+ */
+static void drop_packed(VAR_NODE *variable) {
+    packed_count--;
+    packed_bytes -= variable->var_packed_len;
+    free(variable->var_packed);
+    variable->var_packed = NULL;
+    variable->var_packed_len = 0;
+    variable->var_len = 0;
+}
+
+/*
+ * Make the compressed value of a variable its ordinary value again, as a
+ * private value that is shared again if it is copied.  If there is not
+ * enough memory, the value stays compressed and the
+ * variable behaves as if it had no value.
+ */
+static void unpack_value(VAR_NODE *variable) {
+    double start = store_now();
+    size_t len = variable->var_len;
+    char *buf = expand_value(variable);
+    if(buf == NULL)
+        return;
+    expand_count++;
+    expand_time += store_now() - start;
+    drop_packed(variable);
+    variable->var_value = buf;
+    variable->var_len = len;
+    variable->var_size = len + 1;
+}
+
+/**
+ * @brief  Compress large values that have not been used recently.
+ * @details  This function is to be called once before each statement is
+ * executed, at a point where no string previously returned by the data
+ * store module is still in use.  It counts the statement, and every so
+ * often compresses the values of variables that are at least as long as
+ * the value of COMPRESS_MIN and have not been used for the number of
+ * statements given by COMPRESS_AGE.  Nothing is compressed unless
+ * COMPRESS_MIN is set to a positive integer.  A compressed value is
+ * expanded again as soon as its variable is used.
+ */
+void store_sweep(void) {
+    long min, age;
+
+    if(++store_clock % SWEEP_INTERVAL != 0 || vstorage == NULL)
+        return;
+    if(store_get_int(COMPRESS_MIN_VAR, &min) < 0 || min <= 0)
+        return;
+    if(store_get_int(COMPRESS_AGE_VAR, &age) < 0 || age < 0)
+        age = COMPRESS_DEFAULT_AGE;
+    for(VAR_NODE *variable = vstorage->head->next; variable != vstorage->head;
+        variable = variable->next)
+    {
+        if(variable->var_value == NULL || variable->var_len < (size_t) min
+           || store_clock - variable->var_used < age
+           || variable->var_tried == variable->var_used
+           || variable->var_exported
+           || (variable->var_shared != NULL && variable->var_shared->refs > 1))
+            continue;
+        pack_value(variable);
+    }
+}
+
+/*
+ * Get the value of a variable as an integer, returning -1 if it has no
+ * value or the value cannot be interpreted as one.
  */
+static int node_int(VAR_NODE *variable, long *valp) {
+    long result;
+    char *end_ptr;
+
+    if(variable == NULL || variable->var_value == NULL || *(variable->var_value) == 0)
+        return -1;
+    result = strtol(variable->var_value, &end_ptr, 10);
+    if(*end_ptr != 0)
+        return -1;
+    *valp = result;
+    return 0;
+}
+
+/**
+ * @brief  Get the current value of a variable as a string.
+ * @details  This function retrieves the current value of a variable
+ * as a string.  If the variable has no value, then NULL is returned.
+ * Any string returned remains "owned" by the data store module;
+ * the caller should not attempt to free the string or to use it
+ * after any subsequent call that would modify the value of the variable
+ * whose value was retrieved.  If the caller needs to use the string for
+ * an indefinite period, a copy should be made immediately.
+ *
+ * @param  var  The variable whose value is to be retrieved.
+ * @return  A string that is the current value of the variable, if any,
+ * otherwise NULL.
+ */
+char *store_get_string(char *var) {
+    VAR_NODE *variable = find_variable(var, 0);
+
+    /* Not find same variable name, return NULL. */
+    if(variable == NULL)
+        return NULL;
+    return variable->var_value;
+}
+
+/**
+ * @brief  Get the current value of a variable as an integer.
+ * @details  This retrieves the current value of a variable and
+ * attempts to interpret it as an integer.  If this is possible,
+ * then the integer value is stored at the pointer provided by
+ * the caller.
+ *
+ * @param  var  The variable whose value is to be retrieved.
+ * @param  valp  Pointer at which the returned value is to be stored.
+ * @return  If the specified variable has no value or the value
+ * cannot be interpreted as an integer, then -1 is returned,
+ * otherwise 0 is returned.
+ */
+int store_get_int(char *var, long *valp) {
+    return node_int(find_variable(var, 0), valp);
+}
+
+/**
+ * @brief  Set the value of a variable as a string.
+ * @details  This function sets the current value of a specified
+ * variable to be a specified string.  If the variable already
+ * has a value, then that value is replaced.  If the specified
+ * value is NULL, then any existing value of the variable is removed
+ * and the variable becomes un-set.  Ownership of the variable and
+ * the value strings is not transferred to the data store module as
+ * a result of this call; the data store module makes such copies of
+ * these strings as it may require.
+ *
+ * @param  var  The variable whose value is to be set.
+ * @param  val  The value to set, or NULL if the variable is to become
+ * un-set.
+ */
+int store_set_string(char *var, char *val) {
+
+    /* If var name is NULL, return -1. */
+    if(var == NULL)
+        return -1;
+
+    VAR_NODE *variable = find_variable(var, 1);
+    if(val == NULL)
+    {
+        /* Un-set the variable. */
+        clear_value(variable);
+        return 0;
+    }
+    return set_value(variable, val, strlen(val));
+}
+
+/**
+ * @brief  Set the value of a variable from a buffer of known length.
+ * @details  This function is like store_set_string(), except that the
+ * value is given as a pointer and a length and need not be terminated by
+ * a null character.  If the buffer contains a null character, then the
+ * value ends there.  Ownership of the buffer is not transferred to the
+ * data store module.
+ *
+ * @param  var  The variable whose value is to be set.
+ * @param  val  The buffer holding the value to set.
+ * @param  len  The number of bytes in the buffer.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int store_set_buffer(char *var, char *val, size_t len) {
+
+    /* If var name or value is NULL, return -1. */
+    if(var == NULL || val == NULL)
+        return -1;
+
+    char *nul = memchr(val, '\0', len);
+    if(nul != NULL)
+        len = nul - val;
+    return set_value(find_variable(var, 1), val, len);
+}
+
+/**
+ * @brief  Set the value of a variable to a buffer, taking ownership of it.
+ * @details  This function is like store_set_buffer(), except that instead
+ * of being copied, the buffer itself becomes the value of the variable and
+ * is owned by the data store module from then on.  The buffer must have
+ * been obtained from malloc() and have room for at least len + 1 bytes;
+ * a null character is stored after the value.  If the same large value is
+ * already held by some variable, the buffer is freed and the value shared.
+ * If the buffer is NULL, then the variable becomes un-set.
+ *
+ * @param  var  The variable whose value is to be set.
+ * @param  buf  The buffer holding the value to set, or NULL.
+ * @param  len  The length of the value.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int store_set_owned(char *var, char *buf, size_t len) {
+
+    /* If var name is NULL, return -1. */
+    if(var == NULL)
+    {
+        free(buf);
+        return -1;
+    }
+    if(buf == NULL)
+        return store_set_string(var, NULL);
+
+    VAR_NODE *variable = find_variable(var, 1);
+    clear_value(variable);
+    adopt_value(variable, buf, len);
+    return 0;
+}
+
+/**
+ * @brief  Set the value of a variable as an integer.
+ * @details  This function sets the current value of a specified
+ * variable to be a specified integer.  If the variable already
+ * has a value, then that value is replaced.  Ownership of the variable
+ * string is not transferred to the data store module as a result of
+ * this call; the data store module makes such copies of this string
+ * as it may require.
+ *
+ * @param  var  The variable whose value is to be set.
+ * @param  val  The value to set.
+ */
+int store_set_int(char *var, long val) {
+
+    /* If var name is NULL, return -1. */
+    if(var == NULL)
+        return -1;
+
+    char buf[24];
+    int len = sprintf(buf, "%ld", val);
+    return set_value(find_variable(var, 1), buf, len);
+}
+
+/**
+ * @brief  Get a reference to a variable, for repeated use.
+ * @details  This function finds a variable once, so that its value can
+ * then be retrieved and set through the reference without looking up its
+ * name each time.  A reference remains valid for as long as
+ * store_generation() returns the same value as it did when the reference
+ * was obtained.
+ *
+ * @param  var  The variable to refer to.
+ * @return  A reference to the variable, or NULL if it does not exist.
+ */
+STORE_REF store_ref(char *var) {
+    if(var == NULL)
+        return NULL;
+    return find_variable(var, 0);
+}
+
+/**
+ * @brief  Get the current generation of the data store.
+ * @details  This function returns a number that changes every time the
+ * variables of the store are discarded, which makes any references to
+ * them obtained from store_ref() invalid.
+ *
+ * @return  The current generation.
+ */
+long store_generation(void) {
+    return store_gen;
+}
+
+/**
+ * @brief  Get the current value of a referenced variable as an integer.
+ * @details  This function behaves as store_get_int() does for the
+ * variable to which the reference refers.
+ *
+ * @param  ref  The reference, obtained from store_ref().
+ * @param  valp  Pointer at which the returned value is to be stored.
+ * @return  -1 if the variable has no value or the value cannot be
+ * interpreted as an integer, otherwise 0.
+ */
+int store_ref_get_int(STORE_REF ref, long *valp) {
+    ref->var_used = store_clock;
+    if(ref->var_packed != NULL)
+        unpack_value(ref);
+    return node_int(ref, valp);
+}
+
+/**
+ * @brief  Set a referenced variable to an integer value.
+ * @details  This function behaves as store_set_int() does for the
+ * variable to which the reference refers.
+ *
+ * @param  ref  The reference, obtained from store_ref().
+ * @param  val  The value to set.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int store_ref_set_int(STORE_REF ref, long val) {
+    char buf[24];
+    if(ref->var_exported)
+        env_dirty = 1;
+    ref->var_used = store_clock;
+    return set_value(ref, buf, sprintf(buf, "%ld", val));
+}
+
+/**
+ * @brief  Append a string to the value of a variable.
+ * @details  This function appends a specified string to the current value
+ * of a variable, which is treated as empty if the variable has no value.
+ * The buffer holding the value grows geometrically, so that building up
+ * a long value by repeated appends takes time proportional to its final
+ * length rather than to the square of it.  The string to be appended may
+ * be (part of) the current value of the same variable.  Ownership of the
+ * strings is not transferred to the data store module.
+ *
+ * @param  var  The variable whose value is to be extended.
+ * @param  val  The string to append.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int store_append_string(char *var, char *val) {
+
+    /* If var name or value is NULL, return -1. */
+    if(var == NULL || val == NULL)
+        return -1;
+
+    VAR_NODE *variable = find_variable(var, 1);
+    free_elements(variable);
+    size_t len = strlen(val);
+    size_t newlen = variable->var_len + len;
+    if(variable->var_shared != NULL)
+    {
+        /* Make a private copy of a shared value before extending it. */
+        SHARED_STR *shared = variable->var_shared;
+        size_t size = 16;
+        while(size < newlen + 1)
+            size *= 2;
+        char *buf = (char *) malloc(size);
+        if(buf == NULL)
+            return -1;
+        memcpy(buf, shared->data, shared->len);
+        memcpy(buf + shared->len, val, len);
+        buf[newlen] = '\0';
+        release_shared(variable);
+        variable->var_value = buf;
+        variable->var_size = size;
+        variable->var_len = newlen;
+        return 0;
+    }
+    if(newlen + 1 > variable->var_size)
+    {
+        /* The appended string may point into the buffer being moved. */
+        char *old = variable->var_value;
+        int alias = old != NULL && val >= old && val < old + variable->var_size;
+        size_t offset = alias ? (size_t) (val - old) : 0;
+        size_t size = variable->var_size ? variable->var_size : 16;
+        while(size < newlen + 1)
+            size *= 2;
+        char *buf = (char *) realloc(old, size);
+        if(buf == NULL)
+            return -1;
+        if(alias)
+            val = buf + offset;
+        variable->var_value = buf;
+        variable->var_size = size;
+        if(old == NULL)
+            buf[0] = '\0';
+    }
+    memmove(variable->var_value + variable->var_len, val, len);
+    variable->var_value[newlen] = '\0';
+    variable->var_len = newlen;
+    return 0;
+}
+
+/**
+ * @brief  Set the value of a variable to the value of another.
+ * @details  This function makes a variable hold the same string as another
+ * variable, replacing any existing value.  A large value is shared rather
+ * than copied, so this takes constant time once the value is shared; a
+ * large value that was built up by appending becomes shared the first
+ * time it is copied.
+ *
+ * @param  var  The variable whose value is to be set.
+ * @param  src  The variable whose value is to be copied.
+ * @return  0 if successful, -1 if the source variable does not hold a
+ * string or any other error occurred.
+ */
+int store_copy(char *var, char *src) {
+    VAR_NODE *from = find_variable(src, 0);
+
+    if(var == NULL || from == NULL || from->var_value == NULL)
+        return -1;
+    VAR_NODE *variable = find_variable(var, 1);
+    if(variable == from)
+        return 0;
+    if(from->var_shared == NULL && from->var_len >= SHARE_MIN)
+    {
+        /* Share the private buffer of the source, or a copy already shared. */
+        unsigned long hash = hash_bytes(from->var_value, from->var_len);
+        SHARED_STR *shared = find_shared(from->var_value, from->var_len, hash);
+        if(shared == NULL
+           && (shared = add_shared(from->var_value, from->var_len, hash)) != NULL)
+        {
+            from->var_value = NULL;
+            from->var_size = 0;
+        }
+        if(shared == NULL)
+            return -1;
+        attach_shared(from, shared);
+    }
+    if(from->var_shared == NULL)
+        return set_value(variable, from->var_value, from->var_len);
+    free_elements(variable);
+    if(variable->var_shared != from->var_shared)
+        attach_shared(variable, from->var_shared);
+    return 0;
+}
+
+/**
+ * @brief  Set variables from lines of the form "key=value".
+ * @details  This function parses a buffer holding lines of the form
+ * "key=value" and sets, for each of them, the variable whose name is the
+ * key (with a prefix, if one is given) to the value, replacing any value
+ * it had.  White space around a key is ignored, but a value is taken as
+ * it is, up to the end of the line.  Blank lines, lines that begin with
+ * "#" and lines without "=" are skipped; a line ending "\r\n" is treated
+ * like one ending "\n".  The pairs are set in a single pass over the
+ * buffer, which need not be terminated by a null character, and without
+ * copying the names or values more than once, so that very many pairs
+ * can be loaded quickly.  Ownership of the buffer is not transferred to
+ * the data store module.
+ *
+ * @param  buf  The buffer holding the lines.
+ * @param  len  The length of the buffer.
+ * @param  prefix  String to put before each key to form a variable name,
+ * or NULL.
+ * @return  The number of variables set, or -1 if an error occurred, in
+ * which case some of the variables may have been set.
+ */
+long store_import(char *buf, size_t len, char *prefix) {
+    size_t plen = prefix ? strlen(prefix) : 0;
+    size_t name_size = plen + 64;
+    char *name = (char *) malloc(name_size);
+    char *end = buf + len, *line, *next;
+    long count = 0;
+
+    if(name == NULL)
+        return -1;
+    if(plen > 0)
+        memcpy(name, prefix, plen);
+
+    /*
+     * Make room in the hash index for a variable on every line at once,
+     * so that new variables can be linked in directly as they are met.
+     */
+    long lines = 1;
+    for(line = buf; (line = memchr(line, '\n', end - line)) != NULL; line++)
+        lines++;
+    if(vstorage == NULL && init_store() < 0)
+    {
+        free(name);
+        return -1;
+    }
+    while(vstorage->size < vstorage->count + lines)
+    {
+        if(grow_store() < 0)
+        {
+            free(name);
+            return -1;
+        }
+    }
+
+    for(line = buf; line < end; line = next)
+    {
+        char *eol = memchr(line, '\n', end - line);
+        if(eol == NULL)
+            eol = end;
+        next = eol < end ? eol + 1 : end;
+        if(eol > line && eol[-1] == '\r')
+            eol--;
+        while(line < eol && (*line == ' ' || *line == '\t'))
+            line++;
+        char *eq = line < eol && *line != '#' ? memchr(line, '=', eol - line) : NULL;
+        if(eq == NULL)
+            continue;
+        char *key_end = eq;
+        while(key_end > line && (key_end[-1] == ' ' || key_end[-1] == '\t'))
+            key_end--;
+        size_t klen = key_end - line;
+        if(klen == 0 || memchr(line, '\0', klen) != NULL)
+            continue;
+
+        /* Without a prefix, the key is looked up where it lies. */
+        char *key = line;
+        if(plen > 0)
+        {
+            if(plen + klen > name_size)
+            {
+                char *nname = (char *) realloc(name, name_size = 2 * (plen + klen));
+                if(nname == NULL)
+                    break;
+                name = nname;
+            }
+            memcpy(name + plen, line, klen);
+            key = name;
+        }
+        char *val = eq + 1;
+        char *nul = memchr(val, '\0', eol - val);
+        unsigned long hash = hash_bytes(key, plen + klen);
+        VAR_NODE *variable = probe_variable(key, plen + klen, hash);
+        if(variable == NULL)
+            variable = add_variable(key, plen + klen, hash);
+        else
+        {
+            if(variable->var_exported)
+                env_dirty = 1;
+            variable->var_used = store_clock;
+            if(variable->var_packed != NULL)
+                unpack_value(variable);
+        }
+        if(variable == NULL || set_value(variable, val, (nul ? nul : eol) - val) < 0)
+            break;
+        count++;
+    }
+    free(name);
+    return line < end ? -1 : count;
+}
+
+/*
+ * Find the array held by a variable.  If the variable has no value and
+ * "create" is nonzero, it is given an empty array.  NULL is returned if
+ * the variable does not (or cannot be made to) hold an array.
+ */
+static VAR_ARRAY *find_array(char *var, int create) {
+    if(var == NULL)
+        return NULL;
+    VAR_NODE *variable = find_variable(var, create);
+    if(variable == NULL)
+        return NULL;
+    if(variable->var_array == NULL && create && variable->var_value == NULL
+       && variable->var_map == NULL)
+        variable->var_array = (VAR_ARRAY *) calloc(1, sizeof(VAR_ARRAY));
+    return variable->var_array;
+}
+
+/*
+ * Prepare the element of an array at a given index to receive a new value,
+ * discarding its old value and leaving it holding the integer 0.  An index
+ * equal to the length of the array adds a new element at the end.
+ * The index is returned, or -1 if it is out of range.
+ */
+static long clear_slot(VAR_ARRAY *array, long index) {
+    if(array == NULL || index < 0 || index > array->len)
+        return -1;
+    if(index == array->len)
+    {
+        if(array->len == array->size)
+        {
+            long size = array->size ? 2 * array->size : 8;
+            unsigned char *tags = (unsigned char *) realloc(array->tags, size);
+            if(tags == NULL)
+                return -1;
+            array->tags = tags;
+            ELEM_VALUE *vals =
+                (ELEM_VALUE *) realloc(array->vals, size * sizeof(ELEM_VALUE));
+            if(vals == NULL)
+                return -1;
+            array->vals = vals;
+            array->size = size;
+        }
+        array->len++;
+    }
+    else if(array->tags[index] == ELEM_STRING)
+    {
+        free(array->vals[index].str);
+        array->nstrings--;
+    }
+    array->tags[index] = ELEM_INT;
+    array->vals[index].num = 0;
+    return index;
+}
+
+/*
+ * Store a string, which becomes owned by the array, in an element
+ * prepared by clear_slot().
+ */
+static void set_slot_string(VAR_ARRAY *array, long index, char *str) {
+    array->tags[index] = ELEM_STRING;
+    array->vals[index].str = str;
+    array->nstrings++;
+}
+
+/**
+ * @brief  Make a variable hold an empty array.
+ * @details  Any existing value of the variable is discarded.
+ *
+ * @param  var  The variable that is to hold an empty array.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int store_array_clear(char *var) {
+    if(var == NULL)
+        return -1;
+    VAR_NODE *variable = find_variable(var, 1);
+    clear_value(variable);
+    variable->var_array = (VAR_ARRAY *) calloc(1, sizeof(VAR_ARRAY));
+    return variable->var_array ? 0 : -1;
+}
+
+/*
+ * Parse a field as a decimal integer, returning 0 if it is not one.
+ */
+static int parse_field(char *start, char *stop, long *valp) {
+    char buf[24], *end_ptr;
+    size_t len = stop - start;
+
+    if(len == 0 || len >= sizeof(buf)
+       || !(isdigit((unsigned char) *start) || *start == '-' || *start == '+'))
+        return 0;
+    memcpy(buf, start, len);
+    buf[len] = '\0';
+    errno = 0;
+    *valp = strtol(buf, &end_ptr, 10);
+    return *end_ptr == '\0' && errno == 0;
+}
+
+/**
+ * @brief  Set a variable to an array of the fields of a string.
+ * @details  This function splits a string at each occurrence of a
+ * delimiter, and makes a variable hold an array of the resulting fields,
+ * replacing any existing value.  If the delimiter is empty, then fields
+ * are separated by runs of white space, and white space at the start and
+ * end of the string is ignored.  Otherwise, a delimiter at the very end of
+ * the string does not begin another field, so that text split at newlines
+ * gives one element per line.  If "numeric" is nonzero, then fields that
+ * are decimal integers are stored as integers.  The string may be the
+ * current value of the variable itself.
+ *
+ * @param  var  The variable that is to hold the fields.
+ * @param  str  The string to split.
+ * @param  delim  The delimiter, or the empty string to split at white space.
+ * @param  numeric  Nonzero if integer fields are to be stored as integers.
+ * @return  The number of fields, or -1 if any error occurred.
+ */
+long store_array_split(char *var, char *str, char *delim, int numeric) {
+    if(var == NULL || str == NULL || delim == NULL)
+        return -1;
+
+    VAR_ARRAY *array = (VAR_ARRAY *) calloc(1, sizeof(VAR_ARRAY));
+    size_t dlen = strlen(delim);
+    char *end = str + strlen(str);
+    char *p = str;
+    if(array == NULL)
+        return -1;
+    while(1)
+    {
+        char *start, *stop;
+        if(dlen == 0)
+        {
+            while(p < end && isspace((unsigned char) *p))
+                p++;
+            if(p == end)
+                break;
+            start = p;
+            while(p < end && !isspace((unsigned char) *p))
+                p++;
+            stop = p;
+        }
+        else
+        {
+            if(p == end)
+                break;
+            start = p;
+            stop = dlen == 1 ? memchr(p, *delim, end - p) : strstr(p, delim);
+            if(stop == NULL)
+                stop = end;
+            p = stop == end ? end : stop + dlen;
+        }
+        long i = clear_slot(array, array->len);
+        if(i < 0)
+            goto fail;
+        if(!numeric || !parse_field(start, stop, &array->vals[i].num))
+        {
+            char *field = strndup(start, stop - start);
+            if(field == NULL)
+                goto fail;
+            set_slot_string(array, i, field);
+        }
+    }
+
+    /* The string is no longer needed, so the old value can be freed. */
+    VAR_NODE *variable = find_variable(var, 1);
+    clear_value(variable);
+    variable->var_array = array;
+    return array->len;
+
+ fail:
+    free_array(array);
+    return -1;
+}
+
+/**
+ * @brief  Get the number of elements of an array variable.
+ *
+ * @param  var  The variable whose length is to be retrieved.
+ * @return  The number of elements in the array held by the variable,
+ * or -1 if the variable does not hold an array.
+ */
+long store_array_length(char *var) {
+    VAR_ARRAY *array = find_array(var, 0);
+    return array ? array->len : -1;
+}
+
+/**
+ * @brief  Get an element of an array variable as a string.
+ * @details  This function retrieves the element at a specified index
+ * (counting from zero) of the array held by a variable.  The string
+ * returned is "owned" by the data store module, as for store_get_string().
+ * If the element holds an integer, the string is a representation of it
+ * that is only valid until the next call of this function.
+ *
+ * @param  var  The variable whose element is to be retrieved.
+ * @param  index  The index of the element.
+ * @return  The value of the element, or NULL if the variable does not
+ * hold an array or the index is out of range.
+ */
+char *store_array_get_string(char *var, long index) {
+    VAR_ARRAY *array = find_array(var, 0);
+
+    if(array == NULL || index < 0 || index >= array->len)
+        return NULL;
+    return elem_string(array->tags[index], &array->vals[index]);
+}
+
+/**
+ * @brief  Get an element of an array variable as an integer.
+ *
+ * @param  var  The variable whose element is to be retrieved.
+ * @param  index  The index of the element.
+ * @param  valp  Pointer at which the returned value is to be stored.
+ * @return  If the variable does not hold an array, the index is out of
+ * range or the element cannot be interpreted as an integer, then -1 is
+ * returned, otherwise 0 is returned.
+ */
+int store_array_get_int(char *var, long index, long *valp) {
+    VAR_ARRAY *array = find_array(var, 0);
+
+    if(array == NULL || index < 0 || index >= array->len)
+        return -1;
+    return elem_int(array->tags[index], &array->vals[index], valp);
+}
+
+/**
+ * @brief  Set an element of an array variable to a string.
+ * @details  This function sets the element at a specified index of the
+ * array held by a variable.  If the index is equal to the length of the
+ * array, then a new element is added at the end.  A variable that has no
+ * value is first given an empty array.  Ownership of the strings is not
+ * transferred to the data store module.
+ *
+ * @param  var  The variable whose element is to be set.
+ * @param  index  The index of the element.
+ * @param  val  The value to set.
+ * @return  0 if successful, -1 if the variable holds a value that is not
+ * an array, the index is out of range or any other error occurred.
+ */
+int store_array_set_string(char *var, long index, char *val) {
+    if(val == NULL)
+        return -1;
+    char *str = strdup(val);
+    VAR_ARRAY *array = find_array(var, 1);
+    if(str == NULL || (index = clear_slot(array, index)) < 0)
+    {
+        free(str);
+        return -1;
+    }
+    set_slot_string(array, index, str);
+    return 0;
+}
+
+/**
+ * @brief  Set an element of an array variable to an integer.
+ * @details  This function is like store_array_set_string(), except that
+ * the value is an integer.
+ *
+ * @param  var  The variable whose element is to be set.
+ * @param  index  The index of the element.
+ * @param  val  The value to set.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int store_array_set_int(char *var, long index, long val) {
+    VAR_ARRAY *array = find_array(var, 1);
+    if((index = clear_slot(array, index)) < 0)
+        return -1;
+    array->vals[index].num = val;
+    return 0;
+}
+
+/**
+ * @brief  Remove the last element of an array variable.
+ *
+ * @param  var  The variable whose last element is to be removed.
+ * @return  0 if successful, -1 if the variable does not hold an array
+ * or the array is empty.
+ */
+int store_array_pop(char *var) {
+    VAR_ARRAY *array = find_array(var, 0);
+
+    if(array == NULL || array->len == 0)
+        return -1;
+    clear_slot(array, array->len - 1);
+    array->len--;
+    return 0;
+}
+
+/*
+ * Kernels for the aggregate functions, which process a plain vector of
+ * longs.  On x86-64, SSE2 is always available and AVX2 is used if the
+ * processor supports it.  There is no 64-bit comparison in SSE2, so the
+ * minimum and maximum are found with a scalar loop if AVX2 is missing.
+ * Sums wrap around on overflow, as they would in a script.
+ */
+static long sum_scalar(long *vals, long n) {
+    unsigned long sum = 0;
+    for(long i = 0; i < n; i++)
+        sum += vals[i];
+    return sum;
+}
+
+static void minmax_scalar(long *vals, long n, long *minp, long *maxp) {
+    long min = vals[0], max = vals[0];
+    for(long i = 1; i < n; i++)
+    {
+        if(vals[i] < min)
+            min = vals[i];
+        if(vals[i] > max)
+            max = vals[i];
+    }
+    *minp = min;
+    *maxp = max;
+}
+
+#ifdef X86_KERNELS
+static long sum_sse2(long *vals, long n) {
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    long i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_epi64(acc0, _mm_loadu_si128((__m128i *) (vals + i)));
+        acc1 = _mm_add_epi64(acc1, _mm_loadu_si128((__m128i *) (vals + i + 2)));
+    }
+    long lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, _mm_add_epi64(acc0, acc1));
+    return (unsigned long) lanes[0] + lanes[1] + sum_scalar(vals + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static long sum_avx2(long *vals, long n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    long i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_add_epi64(acc0,
+                   _mm256_loadu_si256((__m256i *) (vals + i)));
+        acc1 = _mm256_add_epi64(acc1,
+                   _mm256_loadu_si256((__m256i *) (vals + i + 4)));
+    }
+    long lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, _mm256_add_epi64(acc0, acc1));
+    return (unsigned long) lanes[0] + lanes[1] + lanes[2] + lanes[3]
+        + sum_scalar(vals + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void minmax_avx2(long *vals, long n, long *minp, long *maxp) {
+    if(n < 4)
+    {
+        minmax_scalar(vals, n, minp, maxp);
+        return;
+    }
+    __m256i min = _mm256_loadu_si256((__m256i *) vals), max = min;
+    long i = 4;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256((__m256i *) (vals + i));
+        min = _mm256_blendv_epi8(min, v, _mm256_cmpgt_epi64(min, v));
+        max = _mm256_blendv_epi8(max, v, _mm256_cmpgt_epi64(v, max));
+    }
+    long lo[4], hi[4], unused;
+    _mm256_storeu_si256((__m256i *) lo, min);
+    _mm256_storeu_si256((__m256i *) hi, max);
+    minmax_scalar(lo, 4, minp, &unused);
+    minmax_scalar(hi, 4, &unused, maxp);
+    for(; i < n; i++)
+    {
+        if(vals[i] < *minp)
+            *minp = vals[i];
+        if(vals[i] > *maxp)
+            *maxp = vals[i];
+    }
+}
+#endif
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+static long (*sum_kernel)(long *vals, long n);
+static void (*minmax_kernel)(long *vals, long n, long *minp, long *maxp);
+
+/*
+ * Choose the kernels for the processor we are running on.  This is done
+ * once for all the interpreters in the process.
+ */
+static void select_kernels(void) {
+    sum_kernel = sum_scalar;
+    minmax_kernel = minmax_scalar;
+#ifdef X86_KERNELS
+    sum_kernel = sum_sse2;
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+        sum_kernel = sum_avx2;
+        minmax_kernel = minmax_avx2;
+    }
+#endif
+}
+
+/**
+ * @brief  Compute aggregate values of the integer elements of an array.
+ * @details  This function finds the number, sum, minimum and maximum of
+ * those elements of the array held by a variable that are integers, or
+ * strings that can be interpreted as integers.  Other elements are
+ * ignored.  If every element holds an integer, as after splitting with
+ * integer conversion, the values are processed as a vector without
+ * looking at the elements individually.  Any of the pointers may be NULL
+ * if the corresponding value is not needed.  The minimum and maximum
+ * are only stored if there is at least one integer element.
+ *
+ * @param  var  The variable whose elements are to be aggregated.
+ * @param  countp  Pointer at which the number of integers is stored.
+ * @param  sump  Pointer at which their sum is stored.
+ * @param  minp  Pointer at which their minimum is stored.
+ * @param  maxp  Pointer at which their maximum is stored.
+ * @return  0 if successful, -1 if the variable does not hold an array.
+ */
+int store_array_aggregate(char *var, long *countp, long *sump,
+                          long *minp, long *maxp) {
+    VAR_ARRAY *array = find_array(var, 0);
+    unsigned long sum = 0;
+    long count = 0, min = 0, max = 0, val;
+
+    if(array == NULL)
+        return -1;
+    pthread_once(&kernels_once, select_kernels);
+    if(array->nstrings == 0 && array->len > 0)
+    {
+        /* Integers only: the values are a vector of longs. */
+        count = array->len;
+        if(sump != NULL)
+            sum = sum_kernel(&array->vals[0].num, count);
+        if(minp != NULL || maxp != NULL)
+            minmax_kernel(&array->vals[0].num, count, &min, &max);
+    }
+    else
+    {
+        for(long i = 0; i < array->len; i++)
+        {
+            if(elem_int(array->tags[i], &array->vals[i], &val))
+                continue;
+            if(count == 0 || val < min)
+                min = val;
+            if(count == 0 || val > max)
+                max = val;
+            sum += val;
+            count++;
+        }
+    }
+    if(countp != NULL)
+        *countp = count;
+    if(sump != NULL)
+        *sump = sum;
+    if(count > 0 && minp != NULL)
+        *minp = min;
+    if(count > 0 && maxp != NULL)
+        *maxp = max;
+    return 0;
+}
+
+/*
+ * Find the map held by a variable.  If the variable has no value and
+ * "create" is nonzero, it is given an empty map.  NULL is returned if
+ * the variable does not (or cannot be made to) hold a map.
+ */
+static VAR_MAP *find_map(char *var, int create) {
+    if(var == NULL)
+        return NULL;
+    VAR_NODE *variable = find_variable(var, create);
+    if(variable == NULL)
+        return NULL;
+    if(variable->var_map == NULL && create && variable->var_value == NULL
+       && variable->var_array == NULL)
+        variable->var_map = (VAR_MAP *) calloc(1, sizeof(VAR_MAP));
+    return variable->var_map;
+}
+
+/*
+ * FNV-1a hash of a key.
+ */
+static unsigned long hash_key(char *key) {
+    unsigned long hash = 14695981039346656037UL;
+    while(*key)
+    {
+        hash ^= (unsigned char) *key++;
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+/*
+ * Find the slot of a map that holds a key.  If the key is not present,
+ * the slot where it would be inserted is returned instead, which is the
+ * first slot on its probe sequence that is unused or holds a deleted key.
+ * The map must have at least one unused slot.
+ */
+static MAP_ENTRY *find_slot(VAR_MAP *map, char *key, unsigned long hash) {
+    MAP_ENTRY *free_slot = NULL;
+    unsigned long mask = map->size - 1;
+    for(unsigned long i = hash & mask; ; i = (i + 1) & mask)
+    {
+        MAP_ENTRY *slot = &map->slots[i];
+        if(slot->key == NULL)
+            return free_slot ? free_slot : slot;
+        if(slot->key == deleted_key)
+        {
+            if(free_slot == NULL)
+                free_slot = slot;
+        }
+        else if(slot->hash == hash && strcmp(slot->key, key) == 0)
+            return slot;
+    }
+}
+
+/*
+ * Find the entry for a key in a map, returning NULL if it is not present.
+ */
+static MAP_ENTRY *find_entry(VAR_MAP *map, char *key) {
+    if(map == NULL || key == NULL || map->count == 0)
+        return NULL;
+    MAP_ENTRY *slot = find_slot(map, key, hash_key(key));
+    return slot->key == NULL || slot->key == deleted_key ? NULL : slot;
+}
+
+/*
+ * Rehash a map into a new table, leaving room for it to grow to twice
+ * its present size before the table is more than half full.  Deleted
+ * entries are dropped in the process.
+ */
+static int rehash_map(VAR_MAP *map) {
+    long size = 8;
+    while(size < 4 * (map->count + 1))
+        size *= 2;
+    MAP_ENTRY *old = map->slots;
+    long old_size = map->size;
+    map->slots = (MAP_ENTRY *) calloc(size, sizeof(MAP_ENTRY));
+    if(map->slots == NULL)
+    {
+        map->slots = old;
+        return -1;
+    }
+    map->size = size;
+    map->used = map->count;
+    for(long i = 0; i < old_size; i++)
+    {
+        if(old[i].key != NULL && old[i].key != deleted_key)
+            *find_slot(map, old[i].key, old[i].hash) = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+/*
+ * Find the entry for a key in a map, adding it with the value 0 if it is
+ * not present.  Any existing value is discarded.
+ */
+static VAR_ELEM *insert_entry(VAR_MAP *map, char *key) {
+    if(map == NULL || key == NULL)
+        return NULL;
+    if(2 * (map->used + 1) > map->size && rehash_map(map) < 0)
+        return NULL;
+    unsigned long hash = hash_key(key);
+    MAP_ENTRY *slot = find_slot(map, key, hash);
+    if(slot->key == NULL || slot->key == deleted_key)
+    {
+        char *copy = strdup(key);
+        if(copy == NULL)
+            return NULL;
+        if(slot->key == NULL)
+            map->used++;
+        slot->key = copy;
+        slot->hash = hash;
+        slot->value.tag = ELEM_INT;
+        map->count++;
+    }
+    clear_elem(&slot->value);
+    return &slot->value;
+}
+
+/**
+ * @brief  Get the number of keys of a map variable.
+ *
+ * @param  var  The variable whose size is to be retrieved.
+ * @return  The number of keys in the map held by the variable,
+ * or -1 if the variable does not hold a map.
+ */
+long store_map_size(char *var) {
+    VAR_MAP *map = find_map(var, 0);
+    return map ? map->count : -1;
+}
+
+/**
+ * @brief  Get the value for a key of a map variable as a string.
+ * @details  The string returned is "owned" by the data store module,
+ * as for store_array_get_string().
+ *
+ * @param  var  The variable whose value is to be retrieved.
+ * @param  key  The key whose value is to be retrieved.
+ * @return  The value for the key, or NULL if the variable does not
+ * hold a map or the key is not present.
+ */
+char *store_map_get_string(char *var, char *key) {
+    MAP_ENTRY *entry = find_entry(find_map(var, 0), key);
+    return entry ? elem_string(entry->value.tag, &entry->value.u) : NULL;
+}
+
+/**
+ * @brief  Get the value for a key of a map variable as an integer.
+ *
+ * @param  var  The variable whose value is to be retrieved.
+ * @param  key  The key whose value is to be retrieved.
+ * @param  valp  Pointer at which the returned value is to be stored.
+ * @return  If the variable does not hold a map, the key is not present
+ * or its value cannot be interpreted as an integer, then -1 is returned,
+ * otherwise 0 is returned.
+ */
+int store_map_get_int(char *var, char *key, long *valp) {
+    MAP_ENTRY *entry = find_entry(find_map(var, 0), key);
+    return entry ? elem_int(entry->value.tag, &entry->value.u, valp) : -1;
+}
+
+/**
+ * @brief  Set the value for a key of a map variable to a string.
+ * @details  This function sets the value for a key in the map held by a
+ * variable, adding the key if it is not present.  A variable that has no
+ * value is first given an empty map.  Ownership of the strings is not
+ * transferred to the data store module.
+ *
+ * @param  var  The variable whose value is to be set.
+ * @param  key  The key whose value is to be set.
+ * @param  val  The value to set.
+ * @return  0 if successful, -1 if the variable holds a value that is not
+ * a map or any other error occurred.
+ */
+int store_map_set_string(char *var, char *key, char *val) {
+    if(val == NULL)
+        return -1;
+    char *str = strdup(val);
+    VAR_ELEM *elem = insert_entry(find_map(var, 1), key);
+    if(str == NULL || elem == NULL)
+    {
+        free(str);
+        return -1;
+    }
+    elem->tag = ELEM_STRING;
+    elem->u.str = str;
+    return 0;
+}
+
+/**
+ * @brief  Set the value for a key of a map variable to an integer.
+ * @details  This function is like store_map_set_string(), except that
+ * the value is an integer.
+ *
+ * @param  var  The variable whose value is to be set.
+ * @param  key  The key whose value is to be set.
+ * @param  val  The value to set.
+ * @return  0 if successful, -1 if any error occurred.
+ */
+int store_map_set_int(char *var, char *key, long val) {
+    VAR_ELEM *elem = insert_entry(find_map(var, 1), key);
+    if(elem == NULL)
+        return -1;
+    elem->u.num = val;
+    return 0;
+}
+
+/**
+ * @brief  Remove a key from a map variable.
+ *
+ * @param  var  The variable from which the key is to be removed.
+ * @param  key  The key to remove.
+ * @return  0 if successful, -1 if the variable does not hold a map
+ * or the key is not present.
+ */
+int store_map_delete(char *var, char *key) {
+    VAR_MAP *map = find_map(var, 0);
+    MAP_ENTRY *entry = find_entry(map, key);
+
+    if(entry == NULL)
+        return -1;
+    free(entry->key);
+    clear_elem(&entry->value);
+    entry->key = deleted_key;
+    map->count--;
+    return 0;
+}
+
+/**
+ * @brief  Iterate over the keys of a map variable.
+ * @details  This function returns the key that follows a given key in
+ * the map held by a variable, or the first key if the given key is NULL.
+ * The order of the keys is not specified, and is only stable as long
+ * as no keys are added to the map.  The string returned is "owned" by
+ * the data store module.
+ *
+ * @param  var  The variable whose keys are to be retrieved.
+ * @param  key  The previous key, or NULL to get the first key.
+ * @return  The next key, or NULL if there are no more keys, the previous
+ * key is not present or the variable does not hold a map.
+ */
+char *store_map_next_key(char *var, char *key) {
+    VAR_MAP *map = find_map(var, 0);
+    long i = 0;
+
+    if(map == NULL)
+        return NULL;
+    if(key != NULL)
+    {
+        MAP_ENTRY *entry = find_entry(map, key);
+        if(entry == NULL)
+            return NULL;
+        i = entry - map->slots + 1;
+    }
+    for(; i < map->size; i++)
+    {
+        if(map->slots[i].key != NULL && map->slots[i].key != deleted_key)
+            return map->slots[i].key;
+    }
+    return NULL;
+}
+
+/*
+ * Get the array that an operation on the elements of one variable is to
+ * store in another.  If the variables are different, the target is given
+ * a copy of the array of the source, so that the operation can work on
+ * the target's array in place.  NULL is returned if the source does not
+ * hold an array or a copy cannot be made.
+ */
+static VAR_ARRAY *target_array(char *var, char *src) {
+    VAR_ARRAY *from = find_array(src, 0);
+
+    if(var == NULL || from == NULL)
+        return NULL;
+    if(strcmp(var, src) == 0)
+        return from;
+    VAR_ARRAY *array = (VAR_ARRAY *) calloc(1, sizeof(VAR_ARRAY));
+    if(array == NULL)
+        return NULL;
+    for(long i = 0; i < from->len; i++)
+    {
+        if(clear_slot(array, i) < 0)
+            goto fail;
+        if(from->tags[i] == ELEM_INT)
+            array->vals[i].num = from->vals[i].num;
+        else
+        {
+            char *str = strdup(from->vals[i].str);
+            if(str == NULL)
+                goto fail;
+            set_slot_string(array, i, str);
+        }
+    }
+    VAR_NODE *variable = find_variable(var, 1);
+    clear_value(variable);
+    variable->var_array = array;
+    return array;
+
+ fail:
+    free_array(array);
+    return NULL;
+}
+
+/*
+ * An element of an array being sorted.  The key is the string compared
+ * in a lexicographic sort; in a numeric sort, elements that are integers
+ * are compared by "num" instead and come before all other elements.
+ */
+typedef struct sort_rec{
+    char *key;
+    long num;
+    int isnum;
+    unsigned char tag;
+    ELEM_VALUE val;
+}SORT_REC;
+
+static int compare_recs(SORT_REC *a, SORT_REC *b) {
+    if(a->isnum && b->isnum)
+        return (a->num > b->num) - (a->num < b->num);
+    if(a->isnum != b->isnum)
+        return b->isnum - a->isnum;
+    return strcmp(a->key, b->key);
+}
+
+/*
+ * Merge the sorted runs recs[0..mid) and recs[mid..n) into out.
+ * Ties are taken from the first run, so that the sort is stable.
+ */
+static void merge_recs(SORT_REC *recs, long mid, long n, SORT_REC *out) {
+    long i = 0, j = mid, k = 0;
+    while(i < mid && j < n)
+        out[k++] = compare_recs(&recs[j], &recs[i]) < 0 ? recs[j++] : recs[i++];
+    memcpy(out + k, recs + i, (mid - i) * sizeof(SORT_REC));
+    k += mid - i;
+    memcpy(out + k, recs + j, (n - j) * sizeof(SORT_REC));
+}
+
+/*
+ * Sort records with a merge sort, using "tmp", which has room for as
+ * many records, as scratch space.  Short runs are sorted by insertion.
+ */
+#define INSERTION_SORT_MAX 16
+
+static void merge_sort(SORT_REC *recs, SORT_REC *tmp, long n) {
+    if(n <= INSERTION_SORT_MAX)
+    {
+        for(long i = 1; i < n; i++)
+        {
+            SORT_REC rec = recs[i];
+            long j = i;
+            for(; j > 0 && compare_recs(&rec, &recs[j - 1]) < 0; j--)
+                recs[j] = recs[j - 1];
+            recs[j] = rec;
+        }
+        return;
+    }
+    long mid = n / 2;
+    merge_sort(recs, tmp, mid);
+    merge_sort(recs + mid, tmp + mid, n - mid);
+    if(compare_recs(&recs[mid], &recs[mid - 1]) >= 0)
+        return;
+    merge_recs(recs, mid, n, tmp);
+    memcpy(recs, tmp, n * sizeof(SORT_REC));
+}
+
+/*
+ * Large arrays are sorted by several threads.  Each thread sorts a chunk
+ * of the records, then the sorted chunks are merged in pairs, with the
+ * merges of each round also done in parallel, until one run remains.
+ */
+#define PARALLEL_SORT_MIN 65536
+#define MAX_SORT_THREADS 16
+
+typedef struct sort_task{
+    SORT_REC *recs;
+    SORT_REC *tmp;
+    long lo, mid, hi;       /* mid is 0 for a chunk to be sorted */
+}SORT_TASK;
+
+static void *sort_task(void *arg) {
+    SORT_TASK *task = (SORT_TASK *) arg;
+    SORT_REC *recs = task->recs + task->lo, *tmp = task->tmp + task->lo;
+    long n = task->hi - task->lo;
+
+    if(task->mid == 0)
+        merge_sort(recs, tmp, n);
+    else
+    {
+        merge_recs(recs, task->mid - task->lo, n, tmp);
+        memcpy(recs, tmp, n * sizeof(SORT_REC));
+    }
+    return NULL;
+}
+
+/*
+ * Run tasks in threads of their own, running any task whose thread
+ * cannot be created in the calling thread instead.
+ */
+static void run_tasks(SORT_TASK *tasks, int ntasks) {
+    pthread_t threads[MAX_SORT_THREADS];
+    int started[MAX_SORT_THREADS];
+
+    for(int i = 0; i < ntasks; i++)
+    {
+        started[i] = i > 0
+            && pthread_create(&threads[i], NULL, sort_task, &tasks[i]) == 0;
+        if(!started[i] && i > 0)
+            sort_task(&tasks[i]);
+    }
+    sort_task(&tasks[0]);
+    for(int i = 1; i < ntasks; i++)
+    {
+        if(started[i])
+            pthread_join(threads[i], NULL);
+    }
+}
 
-typedef struct var_node{
-    struct var_node *prev;
-    struct var_node *next;
-    char *var_name;
-    char *var_value;
-}VAR_NODE;
+static void parallel_sort(SORT_REC *recs, SORT_REC *tmp, long n) {
+    long bounds[MAX_SORT_THREADS + 1];
+    SORT_TASK tasks[MAX_SORT_THREADS];
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int nchunks = ncpus > MAX_SORT_THREADS ? MAX_SORT_THREADS : ncpus;
 
-typedef struct var_store{
-    VAR_NODE *head;
-}VAR_STORE;
+    if(n < PARALLEL_SORT_MIN || nchunks < 2)
+    {
+        merge_sort(recs, tmp, n);
+        return;
+    }
+    for(int i = 0; i <= nchunks; i++)
+        bounds[i] = n * i / nchunks;
+    for(int i = 0; i < nchunks; i++)
+        tasks[i] = (SORT_TASK) { recs, tmp, bounds[i], 0, bounds[i + 1] };
+    run_tasks(tasks, nchunks);
+    while(nchunks > 1)
+    {
+        int ntasks = 0;
+        for(int i = 0; i + 1 < nchunks; i += 2)
+            tasks[ntasks++] = (SORT_TASK) { recs, tmp, bounds[i],
+                                            bounds[i + 1], bounds[i + 2] };
+        run_tasks(tasks, ntasks);
+        /* An odd chunk at the end is carried into the next round. */
+        int nruns = 0;
+        for(int i = 0; i < nchunks; i += 2)
+            bounds[nruns++] = bounds[i];
+        bounds[nruns] = n;
+        nchunks = nruns;
+    }
+}
 
-VAR_STORE *vstorage = NULL;
+/**
+ * @brief  Set a variable to the sorted elements of an array variable.
+ * @details  This function sorts the elements of the array held by one
+ * variable, and makes another variable (which may be the same one) hold
+ * an array of them in sorted order, replacing any existing value.  If
+ * "numeric" is zero, then elements are compared as strings, byte by byte.
+ * Otherwise, elements that are integers, or strings that can be
+ * interpreted as integers, are compared as integers and come before all
+ * other elements, which are compared as strings.  The sort is stable.
+ * Large arrays are sorted in parallel, using one thread per processor.
+ *
+ * @param  var  The variable that is to hold the sorted array.
+ * @param  src  The variable whose elements are to be sorted.
+ * @param  numeric  Nonzero if integers are to be compared as integers.
+ * @return  0 if successful, -1 if the source variable does not hold an
+ * array or any other error occurred.
+ */
+int store_array_sort(char *var, char *src, int numeric) {
+    VAR_ARRAY *array = target_array(var, src);
+    if(array == NULL)
+        return -1;
+    long n = array->len;
+    SORT_REC *recs = (SORT_REC *) malloc(2 * n * sizeof(SORT_REC) + 1);
+    /* A lexicographic sort needs the decimal form of integer elements. */
+    char (*digits)[24] = numeric ? NULL
+        : (char (*)[24]) malloc((n - array->nstrings) * 24 + 1);
+    if(recs == NULL || (!numeric && digits == NULL))
+    {
+        free(recs);
+        free(digits);
+        return -1;
+    }
+    long ndigits = 0;
+    for(long i = 0; i < n; i++)
+    {
+        SORT_REC *rec = &recs[i];
+        rec->tag = array->tags[i];
+        rec->val = array->vals[i];
+        rec->isnum = numeric
+            && elem_int(rec->tag, &rec->val, &rec->num) == 0;
+        if(rec->tag == ELEM_STRING)
+            rec->key = rec->val.str;
+        else if(!numeric)
+        {
+            rec->key = digits[ndigits++];
+            sprintf(rec->key, "%ld", rec->val.num);
+        }
+    }
+    parallel_sort(recs, recs + n, n);
+    for(long i = 0; i < n; i++)
+    {
+        array->tags[i] = recs[i].tag;
+        array->vals[i] = recs[i].val;
+    }
+    free(recs);
+    free(digits);
+    return 0;
+}
 
 /**
- * @brief  Get the current value of a variable as a string.
- * @details  This function retrieves the current value of a variable
- * as a string.  If the variable has no value, then NULL is returned.
- * Any string returned remains "owned" by the data store module;
- * the caller should not attempt to free the string or to use it
- * after any subsequent call that would modify the value of the variable
- * whose value was retrieved.  If the caller needs to use the string for
- * an indefinite period, a copy should be made immediately.
+ * @brief  Set a variable to the distinct elements of an array variable.
+ * @details  This function makes a variable (which may be the same one)
+ * hold an array of the elements of the array held by another variable,
+ * leaving out every element whose string form is the same as that of an
+ * earlier element.  The elements that remain keep their order.  A hash
+ * table of the elements seen so far is used, so the array need not be
+ * sorted first.
  *
- * @param  var  The variable whose value is to be retrieved.
- * @return  A string that is the current value of the variable, if any,
- * otherwise NULL.
+ * @param  var  The variable that is to hold the distinct elements.
+ * @param  src  The variable whose elements are to be examined.
+ * @return  The number of distinct elements, or -1 if the source variable
+ * does not hold an array or any other error occurred.
  */
-char *store_get_string(char *var) {
-    /* The data store is empty, return NULL. */
-    if(vstorage == NULL)
-        return NULL;
+long store_array_unique(char *var, char *src) {
+    VAR_MAP *seen = (VAR_MAP *) calloc(1, sizeof(VAR_MAP));
+    VAR_ARRAY *array = seen ? target_array(var, src) : NULL;
+    long n = 0;
 
-    /* Iterate the vstorage. */
-    VAR_NODE *current_variable = vstorage->head->next;
-    while(current_variable != vstorage->head)
+    if(array == NULL)
+    {
+        free(seen);
+        return -1;
+    }
+    for(long i = 0; i < array->len; i++)
     {
-        /* If find a same variable name, return its value. */
-        if(strcmp(var, current_variable->var_name) == 0)
+        long count = seen->count;
+        if(insert_entry(seen, elem_string(array->tags[i], &array->vals[i]))
+           == NULL)
         {
-            return current_variable->var_value;
+            /* Keep the elements not yet examined. */
+            memmove(array->tags + n, array->tags + i, array->len - i);
+            memmove(array->vals + n, array->vals + i,
+                    (array->len - i) * sizeof(ELEM_VALUE));
+            array->len = n + array->len - i;
+            free_map(seen);
+            return -1;
+        }
+        if(seen->count > count)
+        {
+            array->tags[n] = array->tags[i];
+            array->vals[n++] = array->vals[i];
+        }
+        else if(array->tags[i] == ELEM_STRING)
+        {
+            free(array->vals[i].str);
+            array->nstrings--;
         }
-        current_variable = current_variable->next;
     }
-
-    /* Not find same variable name, return NULL. */
-    return NULL;
+    array->len = n;
+    free_map(seen);
+    return n;
 }
 
 /**
- * @brief  Get the current value of a variable as an integer.
- * @details  This retrieves the current value of a variable and
- * attempts to interpret it as an integer.  If this is possible,
- * then the integer value is stored at the pointer provided by
- * the caller.
+ * @brief  Count the occurrences of each element of an array variable.
+ * @details  This function makes a variable hold a map from the string
+ * form of each distinct element of the array held by another variable
+ * (which may be the same one) to the number of times it occurs, like
+ * "sort | uniq -c", but with the counting done in a hash table.
  *
- * @param  var  The variable whose value is to be retrieved.
- * @param  valp  Pointer at which the returned value is to be stored.
- * @return  If the specified variable has no value or the value
- * cannot be interpreted as an integer, then -1 is returned,
- * otherwise 0 is returned.
+ * @param  var  The variable that is to hold the counts.
+ * @param  src  The variable whose elements are to be counted.
+ * @return  The number of distinct elements, or -1 if the source variable
+ * does not hold an array or any other error occurred.
  */
-int store_get_int(char *var, long *valp) {
-    if(vstorage == NULL)
-        return -1;
+long store_array_count(char *var, char *src) {
+    VAR_ARRAY *array = find_array(src, 0);
+    VAR_MAP *map;
 
-    long result;
-    char *end_ptr;
-    VAR_NODE *current_variable = vstorage->head->next;
-    while(current_variable != vstorage->head)
+    if(var == NULL || array == NULL
+       || (map = (VAR_MAP *) calloc(1, sizeof(VAR_MAP))) == NULL)
+        return -1;
+    for(long i = 0; i < array->len; i++)
     {
-        if(strcmp(var, current_variable->var_name) == 0)
+        char *str = elem_string(array->tags[i], &array->vals[i]);
+        MAP_ENTRY *entry = find_entry(map, str);
+        VAR_ELEM *elem;
+        if(entry != NULL)
+            entry->value.u.num++;
+        else if((elem = insert_entry(map, str)) != NULL)
+            elem->u.num = 1;
+        else
         {
-            if(current_variable->var_value == NULL || *(current_variable->var_value) == 0)
-            {
-                return -1;
-            }
-            result = strtol(current_variable->var_value, &end_ptr, 10);
-            if(*end_ptr == 0)
-            {
-                *valp = result;
-                return 0;
-            }
-            else
-            {
-                return -1;
-            }
+            free_map(map);
+            return -1;
         }
-        current_variable = current_variable->next;
     }
+    VAR_NODE *variable = find_variable(var, 1);
+    clear_value(variable);
+    variable->var_map = map;
+    return map->count;
+}
 
-    return -1;
+/*
+ * The environment passed to commands is kept built, as an array in the
+ * form of "environ" that holds a string "name=value" for each exported
+ * variable with a string value followed by those strings of the original
+ * environment of this process whose names are not exported.  It is only
+ * built again when an exported variable may have changed, so running many
+ * commands does not cost formatting the environment each time.
+ */
+extern char **environ;
+
+static __thread char **env_array;        /* Environment last built, or NULL */
+static __thread char *env_strings;       /* Strings for the exported variables */
+static __thread long env_exported;       /* Number of variables marked for export */
+static __thread long env_builds;         /* Number of times it has been built */
+
+/*
+ * Determine whether an entry "name=value" of the original environment
+ * is for an exported variable.
+ */
+static int env_overridden(char *entry) {
+    size_t len = strcspn(entry, "=");
+    VAR_NODE *variable = probe_variable(entry, len, hash_bytes(entry, len));
+    return variable != NULL && variable->var_exported;
 }
 
 /**
- * @brief  Set the value of a variable as a string.
- * @details  This function sets the current value of a specified
- * variable to be a specified string.  If the variable already
- * has a value, then that value is replaced.  If the specified
- * value is NULL, then any existing value of the variable is removed
- * and the variable becomes un-set.  Ownership of the variable and
- * the value strings is not transferred to the data store module as
- * a result of this call; the data store module makes such copies of
- * these strings as it may require.
+ * @brief  Mark a variable for export to the environment of commands.
+ * @details  This function marks a variable so that, from then on, its
+ * value is placed in the environment of every command that is run,
+ * replacing any variable of the same name in the environment that was
+ * inherited.  The variable need not have a value; it is left out of the
+ * environment while it has none or while it holds an array or map.
  *
- * @param  var  The variable whose value is to be set.
- * @param  val  The value to set, or NULL if the variable is to become
- * un-set.
+ * @param  var  The variable to be exported.
+ * @return  0 if successful, -1 if any error occurred.
  */
-int store_set_string(char *var, char *val) {
+int store_export(char *var) {
 
     /* If var name is NULL, return -1. */
     if(var == NULL)
         return -1;
 
-    /* Initialize vstorage.*/
-    if(vstorage==NULL)
+    VAR_NODE *variable = find_variable(var, 1);
+    if(!variable->var_exported)
     {
-        vstorage = (VAR_STORE *) malloc(sizeof(VAR_STORE));
-        /* Set a dummy head. */
-        VAR_NODE *dummy_head = (VAR_NODE *) malloc(sizeof(VAR_NODE));
-        vstorage->head = dummy_head;
-        vstorage->head->next = dummy_head;
-        vstorage->head->prev = dummy_head;
+        variable->var_exported = 1;
+        env_exported++;
+        env_dirty = 1;
     }
+    return 0;
+}
 
-    int len;
-    char *varcpy, *valcpy;
-    /* Iterate vstorage. */
-    VAR_NODE *current_variable = vstorage->head->next;
-    while(current_variable != vstorage->head)
-    {
-        /* If find the variable with same name. */
-        if(strcmp(var, current_variable->var_name) == 0)
-        {
-            if(current_variable->var_value != NULL)
-            {
-                free(current_variable->var_value);
-            }
+/**
+ * @brief  Determine whether a variable is marked for export.
+ *
+ * @param  var  The variable to be checked.
+ * @return  Nonzero if the variable is exported, otherwise 0.
+ */
+int store_exported(char *var) {
+    VAR_NODE *variable = find_variable(var, 0);
+    return variable != NULL && variable->var_exported;
+}
 
-            if(val == NULL)
-            {
-                valcpy = NULL;
-            }
-            else
-            {
-                /* Make a string copy of val. */
-                len = strlen(val) + 1; // + 1 for '\0'
-                valcpy = (char *) malloc(len*sizeof(char));
-                strncpy(valcpy, val, len);
-            }
-            current_variable->var_value = valcpy;
-            return 0;
+/**
+ * @brief  Get the environment to be passed to commands.
+ * @details  This function returns an environment, in the same form as
+ * "environ", holding the values of the exported variables together with
+ * the rest of the environment of this process.  The environment returned
+ * remains owned by the data store module, and is only valid until the
+ * next call that changes an exported variable.  As long as no exported
+ * variable changes, the same environment is returned each time, so that
+ * it can be passed to many commands without being built each time.
+ *
+ * @return  The environment to be passed to commands.
+ */
+char **store_environ(void) {
+    if(env_exported == 0)
+        return environ;
+    if(env_array != NULL && !env_dirty)
+        return env_array;
 
+    long count = 0, nenv = 0;
+    size_t total = 0;
+    VAR_NODE *variable;
+    for(variable = vstorage->head->next; variable != vstorage->head;
+        variable = variable->next)
+    {
+        if(variable->var_exported && variable->var_value != NULL)
+        {
+            count++;
+            total += strlen(variable->var_name) + variable->var_len + 2;
         }
-        current_variable = current_variable->next;
+    }
+    while(environ[nenv] != NULL)
+        nenv++;
+    char **array = (char **) malloc((count + nenv + 1) * sizeof(char *));
+    char *strings = (char *) malloc(total ? total : 1);
+    if(array == NULL || strings == NULL)
+    {
+        free(array);
+        free(strings);
+        return env_array != NULL ? env_array : environ;
     }
 
-    /* If not find same variable name, make copy of both var and val. */
-    len = strlen(var) + 1; // + 1 for '\0'
-    varcpy = (char *) malloc(len*sizeof(char));
-    strncpy(varcpy, var, len);
-
-    if(val == NULL)
+    long n = 0;
+    char *sp = strings;
+    for(variable = vstorage->head->next; variable != vstorage->head;
+        variable = variable->next)
     {
-        valcpy = NULL;
+        if(variable->var_exported && variable->var_value != NULL)
+        {
+            array[n++] = sp;
+            size_t len = strlen(variable->var_name);
+            memcpy(sp, variable->var_name, len);
+            sp[len] = '=';
+            memcpy(sp + len + 1, variable->var_value, variable->var_len + 1);
+            sp += len + variable->var_len + 2;
+        }
     }
-    else
+    for(long i = 0; i < nenv; i++)
     {
-        /* Make a string copy of val. */
-        len = strlen(val) + 1; // + 1 for '\0'
-        valcpy = (char *) malloc(len*sizeof(char));
-        strncpy(valcpy, val, len);
+        if(!env_overridden(environ[i]))
+            array[n++] = environ[i];
     }
+    array[n] = NULL;
+    free(env_array);
+    free(env_strings);
+    env_array = array;
+    env_strings = strings;
+    env_dirty = 0;
+    env_builds++;
+    return env_array;
+}
 
-    VAR_NODE *new_variable = (VAR_NODE *) malloc(sizeof(VAR_NODE));
-    new_variable->var_name = varcpy;
-    new_variable->var_value = valcpy;
+/*
+ * In a snapshot, each variable is written as its name, whether it is
+ * exported, and the kind of value it holds, followed by the value: the
+ * string itself, the length and compressed data of a compressed value,
+ * or the number of elements of an array or map followed by the elements
+ * (and the key of each element of a map).  Compressed values are written
+ * as they are, so that saving them costs no more than saving the rest.
+ */
+typedef enum {
+    SNAP_NONE,
+    SNAP_STRING,
+    SNAP_PACKED,
+    SNAP_ARRAY,
+    SNAP_MAP
+} SNAP_KIND;
 
-    /* Insert the node . */
-    current_variable->prev->next = new_variable;
-    new_variable->prev = current_variable->prev;
-    new_variable->next = current_variable;
-    current_variable->prev = new_variable;
+/*
+ * Write an element of an array or map.
+ */
+static void save_elem(FILE *f, int tag, ELEM_VALUE *val) {
+    snap_put_num(f, tag);
+    if(tag == ELEM_STRING)
+        snap_put_str(f, val->str);
+    else
+        snap_put_num(f, val->num);
+}
 
-    return 0;
+/*
+ * Read an element written by save_elem(), returning its tag.
+ */
+static int load_elem(SNAP *snap, ELEM_VALUE *val) {
+    int tag = snap_get_num(snap);
+    if(tag == ELEM_STRING && (val->str = snap_get_str(snap)) != NULL)
+        return ELEM_STRING;
+    if(tag != ELEM_INT)
+        snap->error = 1;
+    val->num = snap_get_num(snap);
+    return ELEM_INT;
 }
 
 /**
- * @brief  Set the value of a variable as an integer.
- * @details  This function sets the current value of a specified
- * variable to be a specified integer.  If the variable already
- * has a value, then that value is replaced.  Ownership of the variable
- * string is not transferred to the data store module as a result of
- * this call; the data store module makes such copies of this string
- * as it may require.
+ * @brief  Write the data store to a snapshot.
+ * @details  This function writes every variable, in the order in which
+ * they were created, with its value and whether it is exported.
  *
- * @param  var  The variable whose value is to be set.
- * @param  val  The value to set.
+ * @param f  The stream to which the snapshot is being written.
+ * @return  0 if successful, -1 if any error occurred.
  */
-int store_set_int(char *var, long val) {
+int store_save(FILE *f) {
+    snap_put_num(f, vstorage ? vstorage->count : 0);
+    if(vstorage == NULL)
+        return ferror(f) ? -1 : 0;
+    for(VAR_NODE *variable = vstorage->head->next; variable != vstorage->head;
+        variable = variable->next)
+    {
+        snap_put_str(f, variable->var_name);
+        snap_put_num(f, variable->var_exported);
+        if(variable->var_packed != NULL)
+        {
+            snap_put_num(f, SNAP_PACKED);
+            snap_put_num(f, variable->var_len);
+            snap_put_bytes(f, variable->var_packed, variable->var_packed_len);
+        }
+        else if(variable->var_array != NULL)
+        {
+            VAR_ARRAY *array = variable->var_array;
+            snap_put_num(f, SNAP_ARRAY);
+            snap_put_num(f, array->len);
+            for(long i = 0; i < array->len; i++)
+                save_elem(f, array->tags[i], &array->vals[i]);
+        }
+        else if(variable->var_map != NULL)
+        {
+            VAR_MAP *map = variable->var_map;
+            snap_put_num(f, SNAP_MAP);
+            snap_put_num(f, map->count);
+            for(long i = 0; i < map->size; i++)
+            {
+                MAP_ENTRY *entry = &map->slots[i];
+                if(entry->key == NULL || entry->key == deleted_key)
+                    continue;
+                snap_put_str(f, entry->key);
+                save_elem(f, entry->value.tag, &entry->value.u);
+            }
+        }
+        else if(variable->var_value != NULL)
+        {
+            snap_put_num(f, SNAP_STRING);
+            snap_put_bytes(f, variable->var_value, variable->var_len);
+        }
+        else
+            snap_put_num(f, SNAP_NONE);
+    }
+    return ferror(f) ? -1 : 0;
+}
 
-    /* If var name is NULL, return -1. */
-    if(var == NULL)
-        return -1;
+/*
+ * Discard all the variables of the store.
+ */
+static void clear_store(void) {
+    if(vstorage == NULL)
+        return;
+    while(vstorage->head->next != vstorage->head)
+    {
+        VAR_NODE *variable = vstorage->head->next;
+        vstorage->head->next = variable->next;
+        clear_value(variable);
+        free(variable->var_name);
+        free(variable);
+    }
+    vstorage->head->prev = vstorage->head;
+    store_gen++;
+    memset(vstorage->table, 0, vstorage->size * sizeof(VAR_NODE *));
+    vstorage->count = 0;
+    env_exported = 0;
+    env_dirty = 1;
+}
 
-    /* Initialize vstorage.*/
-    if(vstorage==NULL)
+/*
+ * Read the array value of a variable from a snapshot.
+ */
+static int load_array(SNAP *snap, VAR_NODE *variable) {
+    long len = snap_get_num(snap);
+    if(len < 0 || len > snap->end - snap->pos)
+        return -1;
+    VAR_ARRAY *array = (VAR_ARRAY *) calloc(1, sizeof(VAR_ARRAY));
+    if(array == NULL)
+        return -1;
+    variable->var_array = array;
+    if(len == 0)
+        return 0;
+    array->tags = (unsigned char *) malloc(len);
+    array->vals = (ELEM_VALUE *) malloc(len * sizeof(ELEM_VALUE));
+    if(array->tags == NULL || array->vals == NULL)
+        return -1;
+    array->size = len;
+    for(long i = 0; i < len && !snap->error; i++)
     {
-        vstorage = (VAR_STORE *) malloc(sizeof(VAR_STORE));
-        /* Set a dummy head. */
-        VAR_NODE *dummy_head = (VAR_NODE *) malloc(sizeof(VAR_NODE));
-        vstorage->head = dummy_head;
-        vstorage->head->next = dummy_head;
-        vstorage->head->prev = dummy_head;
+        array->tags[i] = load_elem(snap, &array->vals[i]);
+        if(array->tags[i] == ELEM_STRING)
+            array->nstrings++;
+        array->len++;
     }
+    return 0;
+}
 
-    int len;
-    long tempval;
-    char *varcpy, *valcpy;
-    /* Iterate vstorage. */
-    VAR_NODE *current_variable = vstorage->head->next;
-    while(current_variable != vstorage->head)
+/*
+ * Read the map value of a variable from a snapshot.  The table is made
+ * large enough for all the keys at once, so that it is never rehashed.
+ */
+static int load_map(SNAP *snap, VAR_NODE *variable) {
+    long count = snap_get_num(snap);
+    if(count < 0 || count > snap->end - snap->pos)
+        return -1;
+    VAR_MAP *map = (VAR_MAP *) calloc(1, sizeof(VAR_MAP));
+    if(map == NULL)
+        return -1;
+    variable->var_map = map;
+    if(count == 0)
+        return 0;
+    long size = 8;
+    while(size < 4 * (count + 1))
+        size *= 2;
+    if((map->slots = (MAP_ENTRY *) calloc(size, sizeof(MAP_ENTRY))) == NULL)
+        return -1;
+    map->size = size;
+    for(long i = 0; i < count && !snap->error; i++)
     {
-        /* If find the variable with same name. */
-        if(strcmp(var, current_variable->var_name) == 0)
+        char *key = snap_get_str(snap);
+        if(key == NULL)
+            return -1;
+        unsigned long hash = hash_key(key);
+        MAP_ENTRY *slot = find_slot(map, key, hash);
+        if(slot->key != NULL)
         {
-            if(current_variable->var_value != NULL)
-            {
-                free(current_variable->var_value);
-            }
-
-            /* Make a string copy of val. */
+            /* The same key twice: keep the later value. */
+            free(key);
+            clear_elem(&slot->value);
+        }
+        else
+        {
+            slot->key = key;
+            slot->hash = hash;
+            map->count++;
+            map->used++;
+        }
+        slot->value.tag = load_elem(snap, &slot->value.u);
+    }
+    return 0;
+}
 
-            /* Count the long length. */
-            tempval = val;
-            if(val == 0){
-                len = 1;
-                tempval = val;
-            }
-            else if(val < 0)
-            {
-                len = 1;
-                tempval = -val;
-            }
-            else
-            {
-                len = 0;
-                tempval = val;
-            }
-            while(tempval != 0)
+/**
+ * @brief  Replace the data store with one read from a snapshot.
+ * @details  This function reads what store_save() wrote.  All existing
+ * variables are discarded first.  If the snapshot turns out to be damaged,
+ * the variables read before the damage was found are kept.
+ *
+ * @param snap  The snapshot being read.
+ * @return  0 if successful, -1 if the snapshot was damaged.
+ */
+int store_restore(SNAP *snap) {
+    long count = snap_get_num(snap);
+    if(count < 0 || count > snap->end - snap->pos)
+        return -1;
+    clear_store();
+    for(long i = 0; i < count && !snap->error; i++)
+    {
+        char *name = snap_get_str(snap);
+        if(name == NULL)
+            return -1;
+        VAR_NODE *variable = find_variable(name, 1);
+        free(name);
+        if(variable == NULL)
+            return -1;
+        if(snap_get_num(snap) && !variable->var_exported)
+        {
+            variable->var_exported = 1;
+            env_exported++;
+        }
+        clear_value(variable);
+        char *buf;
+        size_t len;
+        switch(snap_get_num(snap))
+        {
+        case SNAP_NONE:
+            break;
+        case SNAP_STRING:
+            buf = snap_get_bytes(snap, &len);
+            if(buf == NULL || set_value(variable, buf, len) < 0)
+                return -1;
+            break;
+        case SNAP_PACKED:
+            variable->var_len = snap_get_num(snap);
+            buf = snap_get_bytes(snap, &len);
+            if(buf == NULL || (variable->var_packed = (char *) malloc(len)) == NULL)
             {
-                len++;
-                tempval = tempval/10;
-            }
-            /* Count the long length. */
-            len++; // for '\0'
-            valcpy = (char *) malloc(len*sizeof(char));
-            if(sprintf(valcpy, "%ld%c", val, '\0') != len){
+                variable->var_len = 0;
                 return -1;
             }
-
-            current_variable->var_value = valcpy;
-            return 0;
-
+            memcpy(variable->var_packed, buf, len);
+            variable->var_packed_len = len;
+            packed_count++;
+            packed_bytes += len;
+            break;
+        case SNAP_ARRAY:
+            if(load_array(snap, variable) < 0)
+                return -1;
+            break;
+        case SNAP_MAP:
+            if(load_map(snap, variable) < 0)
+                return -1;
+            break;
+        default:
+            return -1;
         }
-        current_variable = current_variable->next;
     }
+    return snap->error ? -1 : 0;
+}
 
-    /* If not find same variable name, make copy of both var and val. */
-    len = strlen(var);
-    len++;
-    varcpy = (char *) malloc(len*sizeof(char));
-    strncpy(varcpy, var, len);
-
-    /* Make a string copy of val. */
+/*
+ * Print an array variable, showing its length and only the first few
+ * of its elements, so that large arrays do not flood the output.
+ */
+#define SHOW_ELEMS 8
 
-    /* Count the long length. */
-    tempval = val;
-    if(val == 0){
-        len = 1;
-        tempval = val;
-    }
-    else if(val < 0)
-    {
-        len = 1;
-        tempval = -val;
-    }
-    else
+static void show_array(FILE *f, VAR_NODE *variable) {
+    VAR_ARRAY *array = variable->var_array;
+    fprintf(f, "%s[%ld]=[", variable->var_name, array->len);
+    for(long i = 0; i < array->len && i < SHOW_ELEMS; i++)
     {
-        len = 0;
-        tempval = val;
+        if(i > 0)
+            fprintf(f, ", ");
+        fprintf(f, "%s", elem_string(array->tags[i], &array->vals[i]));
     }
-    while(tempval != 0)
+    if(array->len > SHOW_ELEMS)
+        fprintf(f, ", ...");
+    fprintf(f, "]");
+}
+
+/*
+ * Print a map variable in the same way, showing at most a few of its keys.
+ */
+static void show_map(FILE *f, VAR_NODE *variable) {
+    VAR_MAP *map = variable->var_map;
+    long shown = 0;
+    fprintf(f, "%s{%ld}={", variable->var_name, map->count);
+    for(long i = 0; i < map->size && shown <= SHOW_ELEMS; i++)
     {
-        len++;
-        tempval = tempval/10;
-    }
-    /* Count the long length. */
-    len++; // for '\0'
-    valcpy = (char *) malloc(len*sizeof(char));
-    if(sprintf(valcpy, "%ld%c", val, '\0') != len){
-        return -1;
+        MAP_ENTRY *entry = &map->slots[i];
+        if(entry->key == NULL || entry->key == deleted_key)
+            continue;
+        if(shown > 0)
+            fprintf(f, ", ");
+        if(shown++ == SHOW_ELEMS)
+            fprintf(f, "...");
+        else
+            fprintf(f, "%s: %s", entry->key, elem_string(entry->value.tag, &entry->value.u));
     }
-
-    VAR_NODE *new_variable = (VAR_NODE *) malloc(sizeof(VAR_NODE));
-    new_variable->var_name = varcpy;
-    new_variable->var_value = valcpy;
-
-    /* Insert the node . */
-    current_variable->prev->next = new_variable;
-    new_variable->prev = current_variable->prev;
-    new_variable->next = current_variable;
-    current_variable->prev = new_variable;
-
-    return 0;
+    fprintf(f, "}");
 }
 
 /**
  * @brief  Print the current contents of the data store.
  * @details  This function prints the current contents of the data store
  * to the specified output stream.  The format is not specified; this
- * function is intended to be used for debugging purposes.
+ * function is intended to be used for debugging purposes.  The total
+ * length of the string values is shown after the variables, along with
+ * the number of bytes actually used to hold them once shared values are
+ * only counted once and compressed values are counted at their compressed
+ * length.  Once any value has been compressed, the number of values now
+ * compressed is shown too, with the overall compression ratio and the time
+ * spent compressing and expanding values.  Once any variable has been
+ * exported, the number of times the environment was built is also shown.
  *
  * @param f  The stream to which the store contents are to be printed.
  */
@@ -348,10 +2720,28 @@ void store_show(FILE *f) {
     }
 
     VAR_NODE *current_variable = vstorage->head->next;
+    size_t logical = 0, unique = shared_bytes;
     fprintf(f, "{");
     while(current_variable != vstorage->head)
     {
-        if(current_variable->var_value == NULL){
+        logical += current_variable->var_len;
+        if(current_variable->var_packed != NULL)
+            unique += current_variable->var_packed_len;
+        else if(current_variable->var_shared == NULL)
+            unique += current_variable->var_len;
+        if(current_variable->var_array != NULL){
+            show_array(f, current_variable);
+        }
+        else if(current_variable->var_map != NULL){
+            show_map(f, current_variable);
+        }
+        else if(current_variable->var_packed != NULL){
+            /* Show a compressed value without making it count as used. */
+            char *value = expand_value(current_variable);
+            fprintf(f, "%s=%s", current_variable->var_name, value ? value : "");
+            free(value);
+        }
+        else if(current_variable->var_value == NULL){
             fprintf(f, "%s ", current_variable->var_name);
         }
         else{
@@ -362,7 +2752,48 @@ void store_show(FILE *f) {
         }
         current_variable = current_variable->next;
     }
-    fprintf(f, "}");
+    fprintf(f, "} [%zu bytes, %zu unique", logical, unique);
+    if(compress_count > 0)
+        fprintf(f, ", %ld compressed: %zu -> %zu bytes (%.1fx) in %.3fs,"
+                " %ld expanded in %.3fs", packed_count, compress_in,
+                compress_out, (double) compress_in / compress_out,
+                compress_time, expand_count, expand_time);
+    if(env_exported > 0)
+        fprintf(f, ", %ld exported, environment built %ld times",
+                env_exported, env_builds);
+    fprintf(f, "]");
 
     return;
 }
+
+/**
+ * @brief  Finalize the data store.
+ * @details  This function frees all the variables of the data store of
+ * the calling thread, along with the environment built from them, and
+ * resets the statistics of the store.  The store is created again, empty,
+ * if it is used afterwards.
+ */
+void store_fini(void) {
+    if(vstorage != NULL)
+    {
+        clear_store();
+        free(vstorage->table);
+        free(vstorage->head);
+        free(vstorage);
+        vstorage = NULL;
+    }
+    free(shared_table);
+    shared_table = NULL;
+    shared_size = shared_count = 0;
+    shared_bytes = 0;
+    free(env_array);
+    free(env_strings);
+    env_array = NULL;
+    env_strings = NULL;
+    env_exported = env_builds = 0;
+    env_dirty = 1;
+    store_clock = 0;
+    packed_count = compress_count = expand_count = 0;
+    packed_bytes = compress_in = compress_out = 0;
+    compress_time = expand_time = 0;
+}
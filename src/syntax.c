@@ -13,6 +13,42 @@
  * Mush: Functions for manipulating syntax trees.
  */
 
+static FUNC_INFO functions[] = {
+    { "len",    LENGTH_OPRTR, 1, 1, NUM_VALUE_TYPE,    NO_EXPR_CLASS },
+    { "substr", SUBSTR_OPRTR, 2, 3, STRING_VALUE_TYPE, NO_EXPR_CLASS },
+    { "index",  INDEX_OPRTR,  2, 2, NUM_VALUE_TYPE,    NO_EXPR_CLASS },
+    { "trim",   TRIM_OPRTR,   1, 1, STRING_VALUE_TYPE, NO_EXPR_CLASS },
+    { "upper",  UPPER_OPRTR,  1, 1, STRING_VALUE_TYPE, NO_EXPR_CLASS },
+    { "lower",  LOWER_OPRTR,  1, 1, STRING_VALUE_TYPE, NO_EXPR_CLASS },
+    { "field",  FIELD_OPRTR,  3, 3, STRING_VALUE_TYPE, NO_EXPR_CLASS },
+    { "exists", EXISTS_OPRTR, 1, 1, NUM_VALUE_TYPE,    INDEX_EXPR_CLASS },
+    { "sum",    SUM_OPRTR,    1, 1, NUM_VALUE_TYPE,    NUM_EXPR_CLASS },
+    { "min",    MIN_OPRTR,    1, 1, NUM_VALUE_TYPE,    NUM_EXPR_CLASS },
+    { "max",    MAX_OPRTR,    1, 1, NUM_VALUE_TYPE,    NUM_EXPR_CLASS },
+    { "count",  COUNT_OPRTR,  1, 1, NUM_VALUE_TYPE,    NUM_EXPR_CLASS },
+    { "mean",   MEAN_OPRTR,   1, 1, NUM_VALUE_TYPE,    NUM_EXPR_CLASS },
+    { "sort",   SORT_OPRTR,   1, 1, ARRAY_VALUE_TYPE,  STRING_EXPR_CLASS },
+    { "unique", UNIQUE_OPRTR, 1, 1, ARRAY_VALUE_TYPE,  STRING_EXPR_CLASS },
+    { "counts", COUNTS_OPRTR, 1, 1, ARRAY_VALUE_TYPE,  STRING_EXPR_CLASS },
+    { NULL,     NO_OPRTR,     0, 0, NO_VALUE_TYPE }
+};
+
+FUNC_INFO *find_function(char *name) {
+    for(FUNC_INFO *fp = functions; fp->name; fp++) {
+	if(!strcmp(fp->name, name))
+	    return fp;
+    }
+    return NULL;
+}
+
+FUNC_INFO *function_info(OPRTR oprtr) {
+    for(FUNC_INFO *fp = functions; fp->name; fp++) {
+	if(fp->oprtr == oprtr)
+	    return fp;
+    }
+    return NULL;
+}
+
 void show_stmt(FILE *file, STMT *stmt) {
     show_lineno(file, stmt->lineno);
     switch(stmt->class) {
@@ -57,12 +93,58 @@ void show_stmt(FILE *file, STMT *stmt) {
 	break;
     case SET_STMT_CLASS:
 	fprintf(file, "set ");
+	fprintf(file, "%s", stmt->members.set_stmt.name);
+	if(stmt->members.set_stmt.index) {
+	    fprintf(file, "[");
+	    show_expr(file, stmt->members.set_stmt.index, 0);
+	    fprintf(file, "]");
+	}
+	fprintf(file, " = ");
+	show_expr(file, stmt->members.set_stmt.expr, 0);
+	break;
+    case APPEND_STMT_CLASS:
+	fprintf(file, "append ");
+	fprintf(file, "%s = ", stmt->members.set_stmt.name);
+	show_expr(file, stmt->members.set_stmt.expr, 0);
+	break;
+    case EXPORT_STMT_CLASS:
+	fprintf(file, "export %s", stmt->members.set_stmt.name);
+	if(stmt->members.set_stmt.expr) {
+	    fprintf(file, " = ");
+	    show_expr(file, stmt->members.set_stmt.expr, 0);
+	}
+	break;
+    case PUSH_STMT_CLASS:
+	fprintf(file, "push ");
 	fprintf(file, "%s = ", stmt->members.set_stmt.name);
 	show_expr(file, stmt->members.set_stmt.expr, 0);
 	break;
+    case POP_STMT_CLASS:
+	fprintf(file, "pop %s", stmt->members.pop_stmt.name);
+	if(stmt->members.pop_stmt.target)
+	    fprintf(file, " > %s", stmt->members.pop_stmt.target);
+	break;
+    case KEYS_STMT_CLASS:
+	fprintf(file, "keys %s > %s", stmt->members.pop_stmt.name,
+		stmt->members.pop_stmt.target);
+	break;
+    case SPLIT_STMT_CLASS:
+	fprintf(file, "split %s > %s%s", stmt->members.split_stmt.name,
+		stmt->members.split_stmt.numeric ? "#" : "",
+		stmt->members.split_stmt.target);
+	if(stmt->members.split_stmt.delim) {
+	    fprintf(file, " by ");
+	    show_expr(file, stmt->members.split_stmt.delim, 0);
+	}
+	break;
     case UNSET_STMT_CLASS:
 	fprintf(file, "unset ");
 	fprintf(file, "%s", stmt->members.unset_stmt.name);
+	if(stmt->members.unset_stmt.index) {
+	    fprintf(file, "[");
+	    show_expr(file, stmt->members.unset_stmt.index, 0);
+	    fprintf(file, "]");
+	}
 	break;
     case IF_STMT_CLASS:
 	fprintf(file, "if ");
@@ -75,6 +157,47 @@ void show_stmt(FILE *file, STMT *stmt) {
     case SOURCE_STMT_CLASS:
 	fprintf(file, "source %s", stmt->members.source_stmt.file);
 	break;
+    case FOR_STMT_CLASS:
+	fprintf(file, "for %s = ", stmt->members.for_stmt.name);
+	show_expr(file, stmt->members.for_stmt.from, 0);
+	fprintf(file, " to ");
+	show_expr(file, stmt->members.for_stmt.to, 0);
+	if(stmt->members.for_stmt.step) {
+	    fprintf(file, " step ");
+	    show_expr(file, stmt->members.for_stmt.step, 0);
+	}
+	break;
+    case NEXT_STMT_CLASS:
+	fprintf(file, "next");
+	if(stmt->members.next_stmt.name)
+	    fprintf(file, " %s", stmt->members.next_stmt.name);
+	break;
+    case READ_STMT_CLASS:
+	fprintf(file, "read %s < %s", stmt->members.file_stmt.name,
+		stmt->members.file_stmt.file);
+	break;
+    case WRITE_STMT_CLASS:
+	fprintf(file, "write %s %s %s", stmt->members.file_stmt.name,
+		stmt->members.file_stmt.append ? ">>" : ">",
+		stmt->members.file_stmt.file);
+	break;
+    case IMPORT_STMT_CLASS:
+	if(stmt->members.import_stmt.file)
+	    fprintf(file, "import < %s", stmt->members.import_stmt.file);
+	else
+	    fprintf(file, "import %s", stmt->members.import_stmt.name);
+	if(stmt->members.import_stmt.prefix)
+	    fprintf(file, " as %s", stmt->members.import_stmt.prefix);
+	break;
+    case SAVE_STMT_CLASS:
+	fprintf(file, "save %s", stmt->members.source_stmt.file);
+	break;
+    case RESTORE_STMT_CLASS:
+	fprintf(file, "restore %s", stmt->members.source_stmt.file);
+	break;
+    case CACHE_STMT_CLASS:
+	fprintf(file, "cached");
+	break;
     default:
 	fprintf(stderr, "Unknown statement class: %d\n", stmt->class);
 	abort();
@@ -84,6 +207,8 @@ void show_stmt(FILE *file, STMT *stmt) {
 
 void show_pipeline(FILE *file, PIPELINE *pline) {
     COMMAND *cmds = pline->commands;
+    if(pline->cached)
+	fprintf(file, "cached ");
     while(cmds) {
 	show_command(file, cmds);
 	if(cmds->next)
@@ -139,6 +264,22 @@ void show_expr(FILE *file, EXPR *expr, int parens) {
 	if(parens)
 	    fprintf(file, ")");
 	break;
+    case FUNC_EXPR_CLASS:
+	show_oprtr(file, expr->members.func_expr.oprtr);
+	fprintf(file, "(");
+	for(ARG *arg = expr->members.func_expr.args; arg; arg = arg->next) {
+	    show_expr(file, arg->expr, 0);
+	    if(arg->next)
+		fprintf(file, ", ");
+	}
+	fprintf(file, ")");
+	break;
+    case INDEX_EXPR_CLASS:
+	fprintf(file, "%c%s[", expr->type == NUM_VALUE_TYPE ? '#' : '$',
+		expr->members.index_expr.variable);
+	show_expr(file, expr->members.index_expr.index, 0);
+	fprintf(file, "]");
+	break;
     default:
 	fprintf(stderr, "Unknown expression class: %d\n", expr->class);
 	abort();
@@ -186,7 +327,20 @@ void show_oprtr(FILE *file, OPRTR oprtr) {
     case GREATEQ_OPRTR:
 	fprintf(file, ">=");
 	break;
+    case CONCAT_OPRTR:
+	fprintf(file, ".");
+	break;
+    case CONTAINS_OPRTR:
+	fprintf(file, "contains");
+	break;
+    case MATCHES_OPRTR:
+	fprintf(file, "matches");
+	break;
     default:
+	if(function_info(oprtr)) {
+	    fprintf(file, "%s", function_info(oprtr)->name);
+	    break;
+	}
 	fprintf(stderr, "Unknown operator: %d\n", oprtr);
 	abort();
     }
@@ -223,11 +377,34 @@ void free_stmt(STMT *stmt) {
 	free_expr(stmt->members.jobctl_stmt.expr);
 	break;
     case SET_STMT_CLASS:
+    case APPEND_STMT_CLASS:
+    case PUSH_STMT_CLASS:
 	free(stmt->members.set_stmt.name);
 	free_expr(stmt->members.set_stmt.expr);
+	if(stmt->members.set_stmt.index)
+	    free_expr(stmt->members.set_stmt.index);
+	break;
+    case SPLIT_STMT_CLASS:
+	free(stmt->members.split_stmt.name);
+	free(stmt->members.split_stmt.target);
+	if(stmt->members.split_stmt.delim)
+	    free_expr(stmt->members.split_stmt.delim);
+	break;
+    case EXPORT_STMT_CLASS:
+	free(stmt->members.set_stmt.name);
+	if(stmt->members.set_stmt.expr)
+	    free_expr(stmt->members.set_stmt.expr);
+	break;
+    case POP_STMT_CLASS:
+    case KEYS_STMT_CLASS:
+	free(stmt->members.pop_stmt.name);
+	if(stmt->members.pop_stmt.target)
+	    free(stmt->members.pop_stmt.target);
 	break;
     case UNSET_STMT_CLASS:
 	free(stmt->members.unset_stmt.name);
+	if(stmt->members.unset_stmt.index)
+	    free_expr(stmt->members.unset_stmt.index);
 	break;
     case IF_STMT_CLASS:
 	free_expr(stmt->members.if_stmt.expr);
@@ -237,10 +414,38 @@ void free_stmt(STMT *stmt) {
 	break;
     case PAUSE_STMT_CLASS:
 	break;
+    case FOR_STMT_CLASS:
+	free(stmt->members.for_stmt.name);
+	free_expr(stmt->members.for_stmt.from);
+	free_expr(stmt->members.for_stmt.to);
+	if(stmt->members.for_stmt.step)
+	    free_expr(stmt->members.for_stmt.step);
+	break;
+    case NEXT_STMT_CLASS:
+	if(stmt->members.next_stmt.name)
+	    free(stmt->members.next_stmt.name);
+	break;
+    case READ_STMT_CLASS:
+    case WRITE_STMT_CLASS:
+	free(stmt->members.file_stmt.name);
+	free(stmt->members.file_stmt.file);
+	break;
+    case IMPORT_STMT_CLASS:
+	free(stmt->members.import_stmt.name);
+	free(stmt->members.import_stmt.file);
+	free(stmt->members.import_stmt.prefix);
+	break;
+    case SAVE_STMT_CLASS:
+    case RESTORE_STMT_CLASS:
+	free(stmt->members.source_stmt.file);
+	break;
+    case CACHE_STMT_CLASS:
+	break;
     default:
 	fprintf(stderr, "Unknown statement class: %d\n", stmt->class);
 	abort();
     }
+    free(stmt->quick);
     free(stmt);
 }
 
@@ -286,6 +491,14 @@ void free_expr(EXPR *expr) {
 	free_expr(expr->members.binary_expr.arg1);
 	free_expr(expr->members.binary_expr.arg2);
 	break;
+    case FUNC_EXPR_CLASS:
+	if(expr->members.func_expr.args)
+	    free_args(expr->members.func_expr.args);
+	break;
+    case INDEX_EXPR_CLASS:
+	free(expr->members.index_expr.variable);
+	free_expr(expr->members.index_expr.index);
+	break;
     default:
 	fprintf(stderr, "Unknown expression class: %d\n", expr->class);
 	abort();
@@ -299,6 +512,7 @@ PIPELINE *copy_pipeline(PIPELINE *pline) {
     PIPELINE *copy = calloc(sizeof(PIPELINE), 1);
     copy->commands = copy_commands(pline->commands);
     copy->capture_output = pline->capture_output;
+    copy->cached = pline->cached;
     if(pline->input_file)
 	copy->input_file = strdup(pline->input_file);
     if(pline->output_file)
@@ -349,6 +563,16 @@ EXPR *copy_expr(EXPR *expr) {
 	copy->members.binary_expr.arg1 = copy_expr(expr->members.binary_expr.arg1);
 	copy->members.binary_expr.arg2 = copy_expr(expr->members.binary_expr.arg2);
 	break;
+    case FUNC_EXPR_CLASS:
+	copy->members.func_expr.oprtr = expr->members.func_expr.oprtr;
+	copy->members.func_expr.args = copy_args(expr->members.func_expr.args);
+	break;
+    case INDEX_EXPR_CLASS:
+	copy->members.index_expr.variable =
+	    strdup(expr->members.index_expr.variable);
+	copy->members.index_expr.index =
+	    copy_expr(expr->members.index_expr.index);
+	break;
     default:
 	fprintf(stderr, "Unknown expression class: %d\n", expr->class);
 	abort();
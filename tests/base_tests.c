@@ -1,8 +1,38 @@
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 #include <sys/stat.h>
 #include <criterion/criterion.h>
 
+#include "mush.h"
+
+/*
+ * Runs mush on the statements that a shell command writes, and determines
+ * whether the lines it prints, each followed by a space instead of a
+ * newline, are exactly the expected text.  EXIT_SUCCESS is returned if
+ * they are.
+ */
+static int mush_prints(char *input, char *expect)
+{
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "ulimit -t 10; %s | bin/mush 2>/dev/null"
+	     " | tr '\\n' ' ' | grep -qxF -- '%s'", input, expect);
+    return WEXITSTATUS(system(cmd));
+}
+
+/*
+ * Runs mush as mush_prints() does, and determines whether its error
+ * messages contain some text.
+ */
+static int mush_complains(char *input, char *text)
+{
+    char cmd[1024];
+    snprintf(cmd, sizeof(cmd), "ulimit -t 10; %s | bin/mush 2>&1 >/dev/null"
+	     " | grep -qF -- '%s'", input, text);
+    return WEXITSTATUS(system(cmd)) == EXIT_SUCCESS;
+}
+
 /*
  * This just checks if mush exits normally on an empty input.
  * It is not very interesting, unfortunately.
@@ -17,3 +47,313 @@ Test(basecode_suite, mush_eof_test, .timeout=20)
                  "Program exited with %d instead of EXIT_SUCCESS",
 		 code);
 }
+
+/*
+ * Runs a nested "for" loop, including a loop with a negative step
+ * and one that runs zero times, and checks the final loop variables.
+ */
+Test(basecode_suite, for_loop_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/for_test.mush",
+			     "1 10 1 5 1 0 2 10 2 5 2 0 3 10 3 5 3 0"
+			     " done 4 -5 k 5 "),
+		 EXIT_SUCCESS, "Loop output was not as expected");
+}
+
+/*
+ * Checks that "for" and "next" are only reserved at the start of a
+ * statement, so that they can still be command arguments and names.
+ */
+Test(basecode_suite, for_words_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("printf 'echo for next\\n"
+			     "10 set next = 3\\n20 echo #next\\nrun\\n'",
+			     "for next 3 "),
+		 EXIT_SUCCESS, "Words \"for\" and \"next\" were not accepted");
+}
+
+/*
+ * Checks that builtin function names are only calls within expressions,
+ * so that they can still be command arguments followed by "(".
+ */
+Test(basecode_suite, function_words_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/function_words_test.mush",
+			     "upper 2 sort 3 lower 4 len abc count"
+			     " trim u U sum 1 min max "),
+		 EXIT_SUCCESS,
+		 "Function names were not accepted as command words");
+}
+
+/*
+ * Checks the string operators and the builtin string functions.
+ */
+Test(basecode_suite, string_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/string_test.mush",
+			     "[Hello, World] 12 7 -1 HELLO, WORLD hello, world"
+			     " World Hello bb ccc [  ] [  ] Hello, World!12"
+			     " right "),
+		 EXIT_SUCCESS, "String functions gave the wrong results");
+}
+
+/*
+ * Checks that appending to a variable, in place or with "set", builds
+ * the whole value.
+ */
+Test(basecode_suite, append_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/append_test.mush",
+			     "report: 1 2 3 4 5 end.22 aaa "),
+		 EXIT_SUCCESS, "Appending gave the wrong value");
+}
+
+/*
+ * Checks that "append" is only a statement when it is followed by a name
+ * and "=", so that it can still be a command argument.
+ */
+Test(basecode_suite, append_word_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("echo 'echo append this'", "append this "),
+		 EXIT_SUCCESS, "Word \"append\" was not accepted");
+}
+
+/*
+ * Checks that a "set" that extends a variable in place leaves it as it
+ * was if one of the operands cannot be evaluated.
+ */
+Test(basecode_suite, append_failed_set_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("printf 'set r = \"abc\"\\n"
+			     "set r = $r . \"X\" . #nope\\necho $r\\n'", "abc "),
+		 EXIT_SUCCESS, "Failed set changed the variable");
+}
+
+/*
+ * Checks that "read" and "write" move values between variables and files.
+ */
+Test(basecode_suite, file_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/file_test.mush",
+			     "line one and more 0 1 [  ] 0 "),
+		 EXIT_SUCCESS, "Reading or writing a file went wrong");
+}
+
+/*
+ * Checks that array elements can be set, pushed, popped and indexed.
+ */
+Test(basecode_suite, array_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/array_test.mush",
+			     "6 host0 last 30 last 4 host0 host1 host2 host3"
+			     " host1-host2 "),
+		 EXIT_SUCCESS, "Array operations gave the wrong results");
+}
+
+/*
+ * Checks that map entries can be set, tested, removed and listed.
+ */
+Test(basecode_suite, map_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/map_test.mush",
+			     "3 10 30 down 1 0 2 0 2 40 "),
+		 EXIT_SUCCESS, "Map operations gave the wrong results");
+}
+
+/*
+ * Checks that "split" makes arrays of words, numbers and fields.
+ */
+Test(basecode_suite, split_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/split_test.mush",
+			     "4 alpha beta 5 4 b d 1 one two 3 z "),
+		 EXIT_SUCCESS, "Splitting gave the wrong arrays");
+}
+
+/*
+ * Checks the sum, minimum, maximum, count and mean of arrays.
+ */
+Test(basecode_suite, aggregate_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/aggregate_test.mush",
+			     "45 -8 12 11 4 14 -3 12 3 4 6 0 "),
+		 EXIT_SUCCESS, "Aggregates gave the wrong results");
+}
+
+/*
+ * Checks sorting by number and by text, and removing and counting
+ * duplicates.
+ */
+Test(basecode_suite, sort_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/sort_test.mush",
+			     "-2 10 100 9 9 apple apple fig pear pear"
+			     " -2 9 9 10 100 apple apple fig pear pear pear"
+			     " 10 apple 9 100 fig -2 7 2 2 2 7"
+			     " -2 9 10 100 apple fig pear after "),
+		 EXIT_SUCCESS, "Sorting gave the wrong results");
+}
+
+/*
+ * Checks the pattern operators and the groups they capture.
+ */
+Test(basecode_suite, match_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/match_test.mush",
+			     "1 1 error /dev/sda1 97 4 matched item1"
+			     " matched item3 1 0 1 done "),
+		 EXIT_SUCCESS, "Matching gave the wrong results");
+}
+
+/*
+ * Checks that a cached pipeline is replayed until its result expires,
+ * and the counters that "cached" shows.
+ */
+Test(basecode_suite, cache_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/cache_test.mush",
+			     "256 ttl honored done"
+			     " 3 hits, 4 misses, 1 entries, 21 bytes "),
+		 EXIT_SUCCESS, "Cached pipelines were not replayed as expected");
+}
+
+/*
+ * Checks that variables sharing one large value can change independently.
+ */
+Test(basecode_suite, share_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/share_test.mush",
+			     "6000 6000 6001 6000 1 6000 short 89! "),
+		 EXIT_SUCCESS, "Shared values were mixed up");
+}
+
+/*
+ * Checks that large values that are kept compressed read back as they were.
+ */
+Test(basecode_suite, compress_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/compress_test.mush",
+			     "9892 9893  500 of the log  9894  500 of the log"
+			     " !? 0 "),
+		 EXIT_SUCCESS, "A compressed value did not read back correctly");
+}
+
+/*
+ * Checks that exported variables reach the environment of commands.
+ */
+Test(basecode_suite, export_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/export_test.mush",
+			     "hello bye 3 1 2 3 256 elsewhere "),
+		 EXIT_SUCCESS, "Exported variables did not reach commands");
+}
+
+/*
+ * Checks that "import" loads variables from a value and from a file.
+ */
+Test(basecode_suite, import_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/import_test.mush",
+			     "0 2 two words [  x=y ] [  ] 4 0 1 two words"
+			     " 1  x=y 1 "),
+		 EXIT_SUCCESS, "Imported variables had the wrong values");
+}
+
+/*
+ * Checks that a program restored from a snapshot resumes where it was
+ * saved, with its variables and loops.
+ */
+Test(basecode_suite, snapshot_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/snapshot_test.mush",
+			     "i 1 0 i 2 0 i 3 0 2 seven v done  env"
+			     " i 3 0 2 seven v done  env 1 "),
+		 EXIT_SUCCESS, "A restored program did not resume as saved");
+}
+
+/*
+ * Checks that specialized statements are remade when the program or the
+ * types of their variables change.
+ */
+Test(basecode_suite, quick_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/quick_test.mush",
+			     "45 10 first 45 10 first 45 10 first 46 4"
+			     " 45 10 second 46 4 45 10 second 44 4"
+			     " 45 10 second 46 4 "),
+		 EXIT_SUCCESS, "Specialized statements gave the wrong results");
+}
+
+/*
+ * Runs loops translated into machine code, each checked against the
+ * interpreter, and checks that no difference was found.
+ */
+Test(basecode_suite, jit_test, .timeout=20)
+{
+    cr_assert_eq(mush_prints("cat rsrc/jit_test.mush",
+			     "2 1000 -50 100 -50 1000 6"
+			     " 2 1000 -50 100 -50 1000 100 "),
+		 EXIT_SUCCESS, "Translated loops gave the wrong results");
+    cr_assert(!mush_complains("cat rsrc/jit_test.mush", "JIT check"),
+	      "Translated loops differed from the interpreter");
+}
+
+/*
+ * Each thread of the stress test hosts a series of interpreters, one
+ * after the other.  Each interpreter runs a job whose output it captures,
+ * and a job in the background that it waits for, and checks that it only
+ * sees its own variables.  The threads all run at the same time, so their
+ * jobs terminate in any order, and each must still reap only its own.
+ */
+#define STRESS_THREADS 16
+#define STRESS_ROUNDS 20
+
+static void *stress_thread(void *arg)
+{
+    long id = (long) arg;
+    char script[256], want[64];
+    for(int round = 0; round < STRESS_ROUNDS; round++) {
+	MUSH *mush = mush_open();
+	if(mush == NULL || mush_get(mush, "out") != NULL)
+	    return (void *) 1;
+	snprintf(script, sizeof(script),
+		 "set id = %ld\n"
+		 "echo thread %ld round %d >@\n"
+		 "set out = $OUTPUT\n"
+		 "sleep 0 &\n"
+		 "wait #JOB\n", id, id, round);
+	snprintf(want, sizeof(want), "thread %ld round %d\n", id, round);
+	int err = mush_eval(mush, script);
+	char *out = mush_get(mush, "out"), *idv = mush_get(mush, "id");
+	char *status = mush_get(mush, "STATUS");
+	int ok = !err && out && !strcmp(out, want) && idv && atol(idv) == id
+	    && status && !strcmp(status, "0");
+	free(out);
+	free(idv);
+	free(status);
+	if(mush_close(mush) < 0 || !ok)
+	    return (void *) 1;
+    }
+    return NULL;
+}
+
+/*
+ * Runs many interpreters at once in this process, using the library.
+ */
+Test(basecode_suite, multi_instance_test, .timeout=60)
+{
+    pthread_t threads[STRESS_THREADS];
+    int failed = 0;
+
+    for(long i = 0; i < STRESS_THREADS; i++)
+	cr_assert_eq(pthread_create(&threads[i], NULL, stress_thread,
+				    (void *) i), 0,
+		     "Could not create thread %ld", i);
+    for(int i = 0; i < STRESS_THREADS; i++) {
+	void *ret;
+	pthread_join(threads[i], &ret);
+	failed += ret != NULL;
+    }
+    cr_assert_eq(failed, 0, "%d of %d interpreters went wrong",
+		 failed, STRESS_THREADS);
+}